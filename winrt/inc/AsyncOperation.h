@@ -133,3 +133,102 @@ protected:
         m_result = nullptr;
     }
 };
+
+
+// Implements the WinRT IAsyncAction interface.
+class AsyncAction : public Microsoft::WRL::RuntimeClass<
+                        Microsoft::WRL::AsyncBase<ABI::Windows::Foundation::IAsyncActionCompletedHandler>,
+                        ABI::Windows::Foundation::IAsyncAction>
+{
+    InspectableClass(L"Windows.Foundation.IAsyncAction", BaseTrust)
+
+public:
+    // Constructor starts the async action.
+    AsyncAction(std::function<void()> const& workerFunction)
+    {
+        using namespace Microsoft::WRL;
+        using namespace ABI::Windows::Foundation;
+        using namespace ABI::Windows::System::Threading;
+
+        Start();
+
+        ComPtr<AsyncAction> keepThisAliveUntilTaskCompletion(this);
+
+        // Agile callback, as in AsyncOperation.
+        typedef Implements<RuntimeClassFlags<ClassicCom>, IWorkItemHandler, FtmBase> CallbackType;
+
+        auto threadPoolFunction = Callback<CallbackType>([=](IAsyncAction*)
+        {
+            // Run the worker function.
+            HRESULT hr = ExceptionBoundary([&]
+            {
+                workerFunction();
+            });
+
+            // Capture the success or failure state.
+            if (SUCCEEDED(hr))
+            {
+                (void)TryTransitionToCompleted();
+            }
+            else
+            {
+                (void)TryTransitionToError(hr);
+            }
+
+            // Notify listeners that the task is complete.
+            keepThisAliveUntilTaskCompletion->FireCompletion();
+
+            return S_OK;
+        });
+
+        CheckMakeResult(threadPoolFunction);
+
+        // Start our task running on the system threadpool.
+        ComPtr<IThreadPoolStatics> threadPool;
+        ThrowIfFailed(GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_System_Threading_ThreadPool).Get(), &threadPool));
+
+        ComPtr<IAsyncAction> threadPoolTask;
+        ThrowIfFailed(threadPool->RunAsync(threadPoolFunction.Get(), &threadPoolTask));
+    }
+
+
+    // An action has no results, but this still reports whether it succeeded.
+    virtual HRESULT STDMETHODCALLTYPE GetResults()
+    {
+        return CheckValidStateForResultsCall();
+    }
+
+
+    // Sets the completion callback. If the async action has already completed, the handler will be called straight away.
+    virtual HRESULT STDMETHODCALLTYPE put_Completed(ABI::Windows::Foundation::IAsyncActionCompletedHandler* handler)
+    {
+        return PutOnComplete(handler);
+    }
+
+
+    // Gets the completion callback.
+    virtual HRESULT STDMETHODCALLTYPE get_Completed(ABI::Windows::Foundation::IAsyncActionCompletedHandler** handler)
+    {
+        return GetOnComplete(handler);
+    }
+
+
+protected:
+    // Start notification (unused).
+    virtual HRESULT OnStart()
+    {
+        return S_OK;
+    }
+
+
+    // Cancel notification (unused).
+    virtual void OnCancel()
+    {
+    }
+
+
+    // Close notification (unused).
+    virtual void OnClose()
+    {
+    }
+};
@@ -96,6 +96,15 @@ public:
         return m_ptr;
     }
 
+    //
+    // Non-throwing alternative to EnsureNotClosed, for fast paths that fall
+    // back to a path that does throw.  Returns null if closed.
+    //
+    T* GetIfNotClosed() const throw()
+    {
+        return m_ptr.Get();
+    }
+
     explicit operator bool() const
     {
         return static_cast<bool>(m_ptr);
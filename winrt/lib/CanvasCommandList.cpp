@@ -0,0 +1,262 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#include "pch.h"
+
+#include "CanvasCommandList.h"
+#include "CanvasDevice.h"
+#include "CanvasDrawingSession.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // Ends drawing on the command list's device context, and closes the
+    // command list so that it can be drawn, when the drawing session that
+    // records it is closed.
+    //
+    class CanvasCommandListDrawingSessionAdapter : public ICanvasDrawingSessionAdapter
+    {
+        ComPtr<CanvasCommandList> m_owner;
+        ComPtr<ID2D1DeviceContext1> m_deviceContext;
+        ComPtr<ID2D1CommandList> m_commandList;
+
+    public:
+        CanvasCommandListDrawingSessionAdapter(
+            CanvasCommandList* owner,
+            ID2D1DeviceContext1* deviceContext,
+            ID2D1CommandList* commandList)
+            : m_owner(owner)
+            , m_deviceContext(deviceContext)
+            , m_commandList(commandList)
+        {
+        }
+
+        virtual D2D1_POINT_2F GetRenderingSurfaceOffset() override
+        {
+            return D2D1::Point2F(0, 0);
+        }
+
+        virtual void EndDraw() override
+        {
+            //
+            // Anyone waiting for the recording must be released even if
+            // EndDraw fails, otherwise they would wait forever.
+            //
+            auto finishedWarden = MakeScopeWarden([&] { m_owner->OnRecordingFinished(); });
+
+            ThrowIfFailed(m_deviceContext->EndDraw());
+            ThrowIfFailed(m_commandList->Close());
+        }
+    };
+
+
+    IFACEMETHODIMP CanvasCommandListFactory::Create(
+        ICanvasResourceCreator* resourceCreator,
+        ICanvasCommandList** commandList)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(resourceCreator);
+                CheckAndClearOutPointer(commandList);
+
+                ComPtr<ICanvasDevice> device;
+                ThrowIfFailed(resourceCreator->get_Device(&device));
+
+                auto newCommandList = Make<CanvasCommandList>(
+                    device.Get(),
+                    CanvasDrawingSessionFactory::GetOrCreateManager());
+                CheckMakeResult(newCommandList);
+
+                ThrowIfFailed(newCommandList.CopyTo(commandList));
+            });
+    }
+
+
+    CanvasCommandList::CanvasCommandList(
+        ICanvasDevice* device,
+        std::shared_ptr<CanvasDrawingSessionManager> drawingSessionManager)
+        : m_device(device)
+        , m_drawingSessionManager(drawingSessionManager)
+        , m_recordingState(RecordingState::NotStarted)
+        , m_isPendingDraw(false)
+    {
+        CheckInPointer(device);
+        CheckInPointer(drawingSessionManager.get());
+
+        ComPtr<ICanvasDeviceInternal> deviceInternal;
+        ThrowIfFailed(device->QueryInterface(deviceInternal.GetAddressOf()));
+
+        auto deviceContext = deviceInternal->CreateDeviceContext();
+
+        ComPtr<ID2D1CommandList> commandList;
+        ThrowIfFailed(deviceContext->CreateCommandList(&commandList));
+
+        m_d2dDeviceContext = deviceContext;
+        m_d2dCommandList = commandList;
+    }
+
+
+    IFACEMETHODIMP CanvasCommandList::CreateDrawingSession(
+        ICanvasDrawingSession** drawingSession)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckAndClearOutPointer(drawingSession);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                auto& commandList = m_d2dCommandList.EnsureNotClosed();
+
+                // D2D command lists can only be recorded once
+                if (m_recordingState != RecordingState::NotStarted)
+                    ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+                auto deviceContext = m_d2dDeviceContext;
+
+                deviceContext->SetTarget(commandList.Get());
+                deviceContext->BeginDraw();
+
+                auto endDrawWarden = MakeScopeWarden([&] { deviceContext->EndDraw(); });
+
+                auto adapter = std::make_shared<CanvasCommandListDrawingSessionAdapter>(
+                    this,
+                    deviceContext.Get(),
+                    commandList.Get());
+
+                auto newDrawingSession = m_drawingSessionManager->Create(
+                    m_device.Get(),
+                    deviceContext.Get(),
+                    adapter);
+
+                endDrawWarden.Dismiss();
+
+                m_recordingState = RecordingState::Recording;
+                m_d2dDeviceContext.Reset();
+
+                ThrowIfFailed(newDrawingSession.CopyTo(drawingSession));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasCommandList::Close()
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    m_d2dCommandList.Close();
+                    m_d2dDeviceContext.Reset();
+                }
+
+                // Anyone waiting for a pending command list to be recorded
+                // now has nothing to wait for.
+                m_recordingFinished.notify_all();
+            });
+    }
+
+
+    ComPtr<ID2D1Image> CanvasCommandList::GetD2DImage(ID2D1DeviceContext* deviceContext)
+    {
+        CheckInPointer(deviceContext);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto& commandList = m_d2dCommandList.EnsureNotClosed();
+
+        switch (m_recordingState)
+        {
+        case RecordingState::NotStarted:
+            // Something else is going to record and then draw this
+            if (m_isPendingDraw)
+                ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+            // Nothing was recorded, so this draws nothing.  D2D needs the
+            // command list closed before it can be drawn.
+            ThrowIfFailed(commandList->Close());
+            m_recordingState = RecordingState::Finished;
+            m_d2dDeviceContext.Reset();
+            break;
+
+        case RecordingState::Recording:
+            // D2D can't draw a command list that is still being recorded
+            ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+        case RecordingState::Finished:
+            break;
+        }
+
+        return commandList;
+    }
+
+
+    void CanvasCommandList::MarkAsPendingDraw()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_isPendingDraw = true;
+    }
+
+
+    bool CanvasCommandList::WaitForRecordingToFinish(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        bool isFinished = m_recordingFinished.wait_for(
+            lock,
+            timeout,
+            [&]
+            {
+                if (!m_d2dCommandList)
+                    return true;
+
+                switch (m_recordingState)
+                {
+                case RecordingState::NotStarted:
+                    return !m_isPendingDraw;
+
+                case RecordingState::Recording:
+                    return false;
+
+                default:
+                    return true;
+                }
+            });
+
+        if (!isFinished)
+        {
+            // Whatever was going to draw this has given up on it
+            m_isPendingDraw = false;
+            return false;
+        }
+
+        return static_cast<bool>(m_d2dCommandList);
+    }
+
+
+    void CanvasCommandList::OnRecordingFinished()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_recordingState = RecordingState::Finished;
+        }
+
+        m_recordingFinished.notify_all();
+    }
+
+
+    ActivatableClassWithFactory(CanvasCommandList, CanvasCommandListFactory);
+}}}}
@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+
+#include "CanvasImage.h"
+#include "ClosablePtr.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+    using namespace ABI::Microsoft::Graphics::Canvas::Effects;
+
+    class CanvasDrawingSessionManager;
+
+    [uuid(4D0B8E0A-73B2-4E5C-9A61-2B35E6C7A1F4)]
+    class ICanvasCommandListInternal : public IUnknown
+    {
+    public:
+        //
+        // Called when the command list is handed to something that will draw
+        // it once it has been recorded (CanvasDrawEventArgs.AddCommandList).
+        // From then on it can't be drawn until it has been recorded, and
+        // WaitForRecordingToFinish waits for recording to start as well.
+        //
+        virtual void MarkAsPendingDraw() = 0;
+
+        //
+        // Blocks until the drawing session returned by CreateDrawingSession
+        // has been closed.  If no drawing session has been created this
+        // returns immediately, unless the command list is pending, in which
+        // case it waits for one to be created and closed, or for the command
+        // list to be closed.
+        //
+        // Gives up after timeout, so that a worker thread that fails, or
+        // never gets round to recording, can't hang the caller.  The
+        // command list then stops being pending.
+        //
+        // Returns false if the command list has been closed or the wait
+        // timed out, since there is then nothing to draw.
+        //
+        virtual bool WaitForRecordingToFinish(std::chrono::milliseconds timeout) = 0;
+    };
+
+
+    class CanvasCommandListFactory : public ActivationFactory<ICanvasCommandListFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasCommandList, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            ICanvasResourceCreator* resourceCreator,
+            ICanvasCommandList** commandList) override;
+    };
+
+
+    //
+    // Each command list has its own device context to record through.  The
+    // D2D factory is multithreaded, so command lists on the same device can
+    // be recorded concurrently.
+    //
+    class CanvasCommandList : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasCommandList,
+        ICanvasImage,
+        IEffectInput,
+        ABI::Windows::Foundation::IClosable,
+        CloakedIid<ICanvasImageInternal>,
+        CloakedIid<ICanvasCommandListInternal>>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasCommandList, BaseTrust);
+
+        enum class RecordingState
+        {
+            NotStarted,
+            Recording,
+            Finished
+        };
+
+        ComPtr<ICanvasDevice> m_device;
+        std::shared_ptr<CanvasDrawingSessionManager> m_drawingSessionManager;
+
+        std::mutex m_mutex;
+        std::condition_variable m_recordingFinished;
+        RecordingState m_recordingState;
+        bool m_isPendingDraw;
+
+        ClosablePtr<ID2D1CommandList> m_d2dCommandList;
+
+        // Released once recording starts; the drawing session owns it after that.
+        ComPtr<ID2D1DeviceContext1> m_d2dDeviceContext;
+
+    public:
+        CanvasCommandList(
+            ICanvasDevice* device,
+            std::shared_ptr<CanvasDrawingSessionManager> drawingSessionManager);
+
+        IFACEMETHOD(CreateDrawingSession)(
+            ICanvasDrawingSession** drawingSession) override;
+
+        // IClosable
+        IFACEMETHOD(Close)() override;
+
+        // ICanvasImageInternal
+        virtual ComPtr<ID2D1Image> GetD2DImage(ID2D1DeviceContext* deviceContext) override;
+
+        // ICanvasCommandListInternal
+        virtual void MarkAsPendingDraw() override;
+        virtual bool WaitForRecordingToFinish(std::chrono::milliseconds timeout) override;
+
+        // Called when the drawing session recording this command list is closed.
+        void OnRecordingFinished();
+    };
+}}}}
@@ -13,7 +13,9 @@
 #include "pch.h"
 
 #include "CanvasControl.h"
+#include "CanvasCommandList.h"
 #include "CanvasDevice.h"
+#include "CanvasDrawingSession.h"
 #include "CanvasImageSource.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
@@ -55,6 +57,75 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             });
     }
 
+    IFACEMETHODIMP CanvasDrawEventArgs::AddCommandList(ICanvasCommandList* commandList)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(commandList);
+                m_drawingSession.EnsureNotClosed();
+
+                ComPtr<ICanvasCommandListInternal> commandListInternal;
+                ThrowIfFailed(commandList->QueryInterface(commandListInternal.GetAddressOf()));
+
+                // Makes DrawCommandLists wait even if recording hasn't started yet
+                commandListInternal->MarkAsPendingDraw();
+
+                std::lock_guard<std::mutex> lock(m_commandListsMutex);
+                m_commandLists.push_back(commandList);
+            });
+    }
+
+    //
+    // How long the UI thread waits for a command list to be recorded.  This
+    // is far longer than any frame should take, and only bounds the damage
+    // done by a recording thread that fails or never records at all.
+    //
+    static const std::chrono::milliseconds CommandListRecordingTimeout(1000);
+
+    void CanvasDrawEventArgs::DrawCommandLists()
+    {
+        DrawCommandLists(CommandListRecordingTimeout);
+    }
+
+    void CanvasDrawEventArgs::DrawCommandLists(std::chrono::milliseconds timeout)
+    {
+        std::vector<ComPtr<ICanvasCommandList>> commandLists;
+
+        {
+            std::lock_guard<std::mutex> lock(m_commandListsMutex);
+            std::swap(commandLists, m_commandLists);
+        }
+
+        if (commandLists.empty())
+            return;
+
+        auto& drawingSession = m_drawingSession.EnsureNotClosed();
+
+        // The app's transform is put back afterwards, even if drawing fails
+        Numerics::Matrix3x2 originalTransform;
+        ThrowIfFailed(drawingSession->get_Transform(&originalTransform));
+
+        auto restoreTransformWarden = MakeScopeWarden([&] { drawingSession->put_Transform(originalTransform); });
+
+        ThrowIfFailed(drawingSession->put_Transform(Numerics::Matrix3x2{ 1, 0, 0, 1, 0, 0 }));
+
+        for (auto& commandList : commandLists)
+        {
+            ComPtr<ICanvasCommandListInternal> commandListInternal;
+            ThrowIfFailed(commandList.As(&commandListInternal));
+
+            // Command lists closed, or not recorded in time, have nothing to draw
+            if (!commandListInternal->WaitForRecordingToFinish(timeout))
+                continue;
+
+            ComPtr<ICanvasImage> image;
+            ThrowIfFailed(commandList.As(&image));
+
+            ThrowIfFailed(drawingSession->DrawImageAtOrigin(image.Get()));
+        }
+    }
+
 
     class CanvasControlAdapter : public ICanvasControlAdapter
     {
@@ -227,6 +298,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         , m_isLoaded(false)
         , m_currentWidth(0)
         , m_currentHeight(0)
+        , m_lastFrameStatistics()
     {
         CreateBaseClass();
         CreateImageControl();
@@ -352,6 +424,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                 return;
         }
 
+        m_recycledDrawingSession.Reset();
+        m_recycledDrawEventArgs.Reset();
+
         m_canvasImageSource = m_adapter->CreateCanvasImageSource(
             m_canvasDevice.Get(),
             width,
@@ -376,18 +451,79 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         }
 
         ComPtr<ICanvasDrawingSession> drawingSession;
+        ComPtr<CanvasDrawEventArgs> drawEventArgs;
         ComPtr<CanvasImageSource> imageSourceImplementation = 
             static_cast<CanvasImageSource*>(m_canvasImageSource.Get());
 
-        ThrowIfFailed(imageSourceImplementation->CreateDrawingSessionWithDpi(m_adapter->GetLogicalDpi(), &drawingSession));
-        ComPtr<CanvasDrawEventArgs> drawEventArgs = Make<CanvasDrawEventArgs>(drawingSession.Get());
-        CheckMakeResult(drawEventArgs);
+        if (m_recycledDrawingSession)
+        {
+            //
+            // Steady state: the drawing session wrapper and the event args
+            // are reused rather than allocated again.  (The image source
+            // still makes a new adapter for each BeginDraw.)
+            //
+            // These are taken out of the members while drawing so that, if
+            // anything fails, they're released (and so closed) as usual.
+            //
+            ComPtr<ICanvasDrawingSessionInternal> recycledDrawingSession;
+            recycledDrawingSession.Swap(m_recycledDrawingSession);
+            drawEventArgs.Swap(m_recycledDrawEventArgs);
+
+            imageSourceImplementation->ReopenDrawingSessionWithDpi(m_adapter->GetLogicalDpi(), recycledDrawingSession.Get());
+            ThrowIfFailed(recycledDrawingSession.As(&drawingSession));
+        }
+        else
+        {
+            ThrowIfFailed(imageSourceImplementation->CreateDrawingSessionWithDpi(m_adapter->GetLogicalDpi(), &drawingSession));
+            drawEventArgs = Make<CanvasDrawEventArgs>(drawingSession.Get());
+            CheckMakeResult(drawEventArgs);
+        }
 
         ThrowIfFailed(m_drawEventList.InvokeAll(this, drawEventArgs.Get()));
 
-        ComPtr<IClosable> drawingSessionClosable;
-        ThrowIfFailed(drawingSession.As(&drawingSessionClosable));
-        ThrowIfFailed(drawingSessionClosable->Close()); // Device removal should be handled here.
+        //
+        // Command lists recorded on other threads are drawn after all the
+        // handlers have run, in the order they were added, so the frame is
+        // the same however the recording threads were scheduled.
+        //
+        drawEventArgs->DrawCommandLists();
+
+        ComPtr<ICanvasDrawingSessionInternal> recyclableDrawingSession;
+        if (SUCCEEDED(drawingSession.As(&recyclableDrawingSession)))
+        {
+            //
+            // Keep the session for next frame.  It behaves as if it was
+            // closed until then, so handlers that hang on to it can't draw
+            // outside of a Draw event.
+            //
+            recyclableDrawingSession->CloseForReuse(); // Device removal should be handled here.
+
+            m_recycledDrawingSession = recyclableDrawingSession;
+            m_recycledDrawEventArgs = drawEventArgs;
+        }
+        else
+        {
+            ComPtr<IClosable> drawingSessionClosable;
+            ThrowIfFailed(drawingSession.As(&drawingSessionClosable));
+            ThrowIfFailed(drawingSessionClosable->Close()); // Device removal should be handled here.
+        }
+
+        //
+        // The statistics are read after closing the drawing session so that
+        // they include the time spent in EndDraw.  Drawing sessions that
+        // don't come from CanvasDrawingSession (eg in tests) may not provide
+        // statistics.
+        //
+        m_lastFrameStatistics = CanvasDrawingSessionStatistics{};
+
+        ComPtr<ICanvasDrawingSessionStatistics> drawingSessionStatistics;
+        if (SUCCEEDED(drawingSession.As(&drawingSessionStatistics)))
+        {
+            CanvasDrawingSessionStatistics statistics;
+            ThrowIfFailed(drawingSessionStatistics->get_Statistics(&statistics));
+
+            AddStatistics(&m_lastFrameStatistics, statistics);
+        }
     }
 
     HRESULT CanvasControl::OnLoaded(IInspectable* sender, IRoutedEventArgs* args)
@@ -501,6 +637,17 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             });
     }
 
+    IFACEMETHODIMP CanvasControl::get_LastFrameStatistics(CanvasDrawingSessionStatistics* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                *value = m_lastFrameStatistics;
+            });
+    }
+
     IFACEMETHODIMP CanvasControl::Invalidate()
     {
         return ExceptionBoundary(
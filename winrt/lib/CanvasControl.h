@@ -39,10 +39,24 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         ClosablePtr<ICanvasDrawingSession> m_drawingSession;
 
+        std::mutex m_commandListsMutex;
+        std::vector<ComPtr<ICanvasCommandList>> m_commandLists;
+
      public:
          CanvasDrawEventArgs(ICanvasDrawingSession* drawingSession);
 
          IFACEMETHODIMP get_DrawingSession(ICanvasDrawingSession** value);
+
+         IFACEMETHODIMP AddCommandList(ICanvasCommandList* commandList);
+
+         //
+         // Waits for each added command list to finish recording, and then
+         // draws it into the drawing session.  Command lists are drawn in
+         // the order they were added, without any transform.  A command
+         // list that hasn't been recorded within timeout is skipped.
+         //
+         void DrawCommandLists();
+         void DrawCommandLists(std::chrono::milliseconds timeout);
     };
 
     typedef ITypedEventHandler<CanvasControl*, IInspectable*> CreateResourcesEventHandlerType;
@@ -83,11 +97,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         ComPtr<ICanvasDevice> m_canvasDevice;
         ComPtr<IImage> m_imageControl;
         ComPtr<ICanvasImageSource> m_canvasImageSource;
+
+        //
+        // When the image source's drawing sessions support it, the drawing
+        // session and the draw event args are reused from one frame to the
+        // next rather than being created each frame.  They are released
+        // whenever the image source is recreated.
+        //
+        ComPtr<ICanvasDrawingSessionInternal> m_recycledDrawingSession;
+        ComPtr<CanvasDrawEventArgs> m_recycledDrawEventArgs;
+
         bool m_drawNeeded;
         bool m_isLoaded;
 
         int m_currentWidth;
         int m_currentHeight;
+
+        CanvasDrawingSessionStatistics m_lastFrameStatistics;
         
     public:
         CanvasControl(
@@ -119,6 +145,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         IFACEMETHODIMP Invalidate();
 
+        IFACEMETHODIMP get_LastFrameStatistics(CanvasDrawingSessionStatistics* value);
+
         //
         // IFrameworkElementOverrides
         //
@@ -534,5 +534,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return imageInternal->GetD2DImage(deviceContext.Get());
     }
 
+    ComPtr<ID2D1PathGeometry1> CanvasDevice::CreatePathGeometry()
+    {
+        ComPtr<ID2D1PathGeometry1> pathGeometry;
+        ThrowIfFailed(GetD2DFactory()->CreatePathGeometry(&pathGeometry));
+
+        return pathGeometry;
+    }
+
+    ComPtr<ID2D1DeviceContext1> CanvasDevice::CreateDeviceContext()
+    {
+        ComPtr<ID2D1DeviceContext1> deviceContext;
+        ThrowIfFailed(GetD2DDevice()->CreateDeviceContext(
+            D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
+            &deviceContext));
+
+        return deviceContext;
+    }
+
     ActivatableClassWithFactory(CanvasDevice, CanvasDeviceFactory);
 }}}}
@@ -125,6 +125,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         virtual ComPtr<ID2D1BitmapBrush1> CreateBitmapBrush(ID2D1Bitmap1* bitmap) = 0;
         virtual ComPtr<ID2D1ImageBrush> CreateImageBrush(ID2D1Image* image) = 0;
         virtual ComPtr<ID2D1Image> GetD2DImage(ICanvasImage* canvasImage) = 0;
+        virtual ComPtr<ID2D1PathGeometry1> CreatePathGeometry() = 0;
+        virtual ComPtr<ID2D1DeviceContext1> CreateDeviceContext() = 0;
     };
 
 
@@ -193,6 +195,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         virtual ComPtr<ID2D1BitmapBrush1> CreateBitmapBrush(ID2D1Bitmap1* bitmap) override;
         virtual ComPtr<ID2D1ImageBrush> CreateImageBrush(ID2D1Image* image) override;
         virtual ComPtr<ID2D1Image> GetD2DImage(ICanvasImage* canvasImage) override;
+        virtual ComPtr<ID2D1PathGeometry1> CreatePathGeometry() override;
+        virtual ComPtr<ID2D1DeviceContext1> CreateDeviceContext() override;
 
     private:
         ComPtr<ID2D1Factory2> GetD2DFactory();
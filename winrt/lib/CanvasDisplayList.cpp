@@ -0,0 +1,620 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#include "pch.h"
+
+#include "CanvasDisplayList.h"
+#include "CanvasDrawingSession.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using ABI::Windows::Foundation::IClosable;
+    using ABI::Windows::Foundation::Rect;
+    using ABI::Windows::UI::Color;
+
+    IFACEMETHODIMP CanvasDisplayListFactory::Create(
+        ICanvasResourceCreator* resourceCreator,
+        ICanvasDisplayList** displayList)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(resourceCreator);
+                CheckAndClearOutPointer(displayList);
+
+                ComPtr<ICanvasDevice> device;
+                ThrowIfFailed(resourceCreator->get_Device(&device));
+
+                auto newDisplayList = Make<CanvasDisplayList>(
+                    device.Get(),
+                    CanvasDrawingSessionFactory::GetOrCreateManager());
+                CheckMakeResult(newDisplayList);
+
+                ThrowIfFailed(newDisplayList.CopyTo(displayList));
+            });
+    }
+
+
+    DisplayListNode::DisplayListNode()
+        : Type(DisplayListNodeType::Free)
+        , Parent(CanvasDisplayList::Root)
+        , Transform()
+        , HasTransform(false)
+        , IsVisible(true)
+        , Point0()
+        , Point1()
+        , Rect()
+        , RadiusX(0)
+        , RadiusY(0)
+        , StrokeWidth(0)
+        , Color()
+        , CleanDrawCount(0)
+    {
+        Transform.M11 = 1;
+        Transform.M22 = 1;
+    }
+
+
+    CanvasDisplayList::CanvasDisplayList(
+        ICanvasDevice* device,
+        std::shared_ptr<CanvasDrawingSessionManager> drawingSessionManager)
+        : m_device(device)
+        , m_drawingSessionManager(drawingSessionManager)
+        , m_nodes(1)
+    {
+        CheckInPointer(device);
+        CheckInPointer(drawingSessionManager.get());
+
+        m_nodes[Root].Type = DisplayListNodeType::Group;
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::get_RootNode(uint32_t* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                *value = Root;
+            });
+    }
+
+
+    template<typename FN>
+    HRESULT CanvasDisplayList::AddNode(uint32_t parentNode, DisplayListNodeType type, uint32_t* node, FN&& fn)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(node);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                if (GetNode(parentNode).Type != DisplayListNodeType::Group)
+                    ThrowHR(E_INVALIDARG);
+
+                DisplayListNode newNode;
+                newNode.Type = type;
+                newNode.Parent = parentNode;
+                fn(newNode);
+
+                uint32_t id;
+
+                if (m_freeNodes.empty())
+                {
+                    id = static_cast<uint32_t>(m_nodes.size());
+                    m_nodes.push_back(std::move(newNode));
+                }
+                else
+                {
+                    id = m_freeNodes.back();
+                    m_nodes[id] = std::move(newNode);
+                    m_freeNodes.pop_back();
+                }
+
+                m_nodes[parentNode].Children.push_back(id);
+                InvalidateGroup(parentNode);
+
+                *node = id;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddGroup(
+        uint32_t parentNode,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::Group, node,
+            [&](DisplayListNode&) {});
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddLine(
+        uint32_t parentNode,
+        Numerics::Vector2 point0,
+        Numerics::Vector2 point1,
+        Color color,
+        float strokeWidth,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::Line, node,
+            [&](DisplayListNode& newNode)
+            {
+                newNode.Point0 = point0;
+                newNode.Point1 = point1;
+                newNode.Color = color;
+                newNode.StrokeWidth = strokeWidth;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddRectangle(
+        uint32_t parentNode,
+        Rect rect,
+        Color color,
+        float strokeWidth,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::Rectangle, node,
+            [&](DisplayListNode& newNode)
+            {
+                newNode.Rect = rect;
+                newNode.Color = color;
+                newNode.StrokeWidth = strokeWidth;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddFilledRectangle(
+        uint32_t parentNode,
+        Rect rect,
+        Color color,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::FilledRectangle, node,
+            [&](DisplayListNode& newNode)
+            {
+                newNode.Rect = rect;
+                newNode.Color = color;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddFilledEllipse(
+        uint32_t parentNode,
+        Numerics::Vector2 centerPoint,
+        float radiusX,
+        float radiusY,
+        Color color,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::FilledEllipse, node,
+            [&](DisplayListNode& newNode)
+            {
+                newNode.Point0 = centerPoint;
+                newNode.RadiusX = radiusX;
+                newNode.RadiusY = radiusY;
+                newNode.Color = color;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddText(
+        uint32_t parentNode,
+        HSTRING text,
+        Numerics::Vector2 point,
+        Color color,
+        ICanvasTextFormat* format,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::Text, node,
+            [&](DisplayListNode& newNode)
+            {
+                newNode.Text = text;
+                newNode.Point0 = point;
+                newNode.Color = color;
+                newNode.TextFormat = format;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::AddImage(
+        uint32_t parentNode,
+        ICanvasImage* image,
+        Numerics::Vector2 offset,
+        uint32_t* node)
+    {
+        return AddNode(parentNode, DisplayListNodeType::Image, node,
+            [&](DisplayListNode& newNode)
+            {
+                CheckInPointer(image);
+
+                newNode.Image = image;
+                newNode.Point0 = offset;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::RemoveNode(uint32_t node)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                GetNode(node);
+
+                if (node == Root)
+                    ThrowHR(E_INVALIDARG);
+
+                auto parentNode = m_nodes[node].Parent;
+                auto& siblings = m_nodes[parentNode].Children;
+                siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+
+                InvalidateGroup(parentNode);
+                FreeNode(node);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::SetTransform(
+        uint32_t node,
+        Numerics::Matrix3x2 transform)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                auto& target = GetNode(node);
+                target.Transform = transform;
+                target.HasTransform = !ToD2DMatrix(transform).IsIdentity();
+
+                // The node's own recording, if it has one, doesn't include
+                // its transform.
+                if (node != Root)
+                    InvalidateGroup(target.Parent);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::GetTransform(
+        uint32_t node,
+        Numerics::Matrix3x2* transform)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(transform);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                *transform = GetNode(node).Transform;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::SetIsVisible(
+        uint32_t node,
+        boolean isVisible)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                auto& target = GetNode(node);
+
+                if (target.IsVisible == !!isVisible)
+                    return;
+
+                target.IsVisible = !!isVisible;
+
+                if (node != Root)
+                    InvalidateGroup(target.Parent);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::SetColor(
+        uint32_t node,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                auto& target = GetNode(node);
+
+                if (target.Type == DisplayListNodeType::Group ||
+                    target.Type == DisplayListNodeType::Image)
+                {
+                    ThrowHR(E_INVALIDARG);
+                }
+
+                target.Color = color;
+                InvalidateContents(node);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::SetText(
+        uint32_t node,
+        HSTRING text)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                auto& target = GetNode(node);
+
+                if (target.Type != DisplayListNodeType::Text)
+                    ThrowHR(E_INVALIDARG);
+
+                target.Text = text;
+                InvalidateContents(node);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::Invalidate(uint32_t node)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                GetNode(node);
+                InvalidateContents(node);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::Draw(ICanvasDrawingSession* drawingSession)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(drawingSession);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_device.EnsureNotClosed();
+
+                DrawNode(drawingSession, Root, CanDrawRecordingsInto(drawingSession));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDisplayList::Close()
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                m_device.Close();
+                m_nodes.clear();
+                m_freeNodes.clear();
+            });
+    }
+
+
+    DisplayListNode& CanvasDisplayList::GetNode(uint32_t node)
+    {
+        if (node >= m_nodes.size() || m_nodes[node].Type == DisplayListNodeType::Free)
+            ThrowHR(E_INVALIDARG);
+
+        return m_nodes[node];
+    }
+
+
+    void CanvasDisplayList::FreeNode(uint32_t node)
+    {
+        auto children = std::move(m_nodes[node].Children);
+
+        for (auto child : children)
+            FreeNode(child);
+
+        // Releases the node's text, format, image and recording.
+        m_nodes[node] = DisplayListNode();
+        m_freeNodes.push_back(node);
+    }
+
+
+    void CanvasDisplayList::InvalidateGroup(uint32_t group)
+    {
+        for (;;)
+        {
+            auto& node = m_nodes[group];
+
+            node.Recording.Reset();
+            node.CleanDrawCount = 0;
+
+            if (group == Root)
+                break;
+
+            group = node.Parent;
+        }
+    }
+
+
+    void CanvasDisplayList::InvalidateContents(uint32_t node)
+    {
+        if (m_nodes[node].Type == DisplayListNodeType::Group)
+            InvalidateGroup(node);
+        else
+            InvalidateGroup(m_nodes[node].Parent);
+    }
+
+
+    //
+    // Recordings are made in a drawing session in its default state, and
+    // then drawn as a single image.  That only looks the same as drawing the
+    // children directly if the target session is in its default state too:
+    // eg with CanvasBlend.Copy the transparent parts of the recording would
+    // overwrite the target, and the antialiasing modes and units would
+    // differ from those the children were recorded with.
+    //
+    bool CanvasDisplayList::CanDrawRecordingsInto(ICanvasDrawingSession* drawingSession)
+    {
+        CanvasBlend blend;
+        CanvasAntialiasing antialiasing;
+        CanvasTextAntialiasing textAntialiasing;
+        CanvasUnits units;
+
+        ThrowIfFailed(drawingSession->get_Blend(&blend));
+        ThrowIfFailed(drawingSession->get_Antialiasing(&antialiasing));
+        ThrowIfFailed(drawingSession->get_TextAntialiasing(&textAntialiasing));
+        ThrowIfFailed(drawingSession->get_Units(&units));
+
+        return blend == CanvasBlend::SourceOver &&
+               antialiasing == CanvasAntialiasing::Antialiased &&
+               textAntialiasing == CanvasTextAntialiasing::Default &&
+               units == CanvasUnits::Dips;
+    }
+
+
+    void CanvasDisplayList::DrawNode(ICanvasDrawingSession* drawingSession, uint32_t id, bool canUseRecordings)
+    {
+        auto& node = m_nodes[id];
+
+        if (!node.IsVisible)
+            return;
+
+        if (node.HasTransform)
+            ThrowIfFailed(drawingSession->PushTransform(node.Transform));
+
+        // Leaves the app's transform stack balanced if drawing fails
+        auto popTransformWarden = MakeScopeWarden([&] { drawingSession->PopTransform(); });
+
+        if (!node.HasTransform)
+            popTransformWarden.Dismiss();
+
+        switch (node.Type)
+        {
+        case DisplayListNodeType::Group:
+            DrawGroup(drawingSession, node, canUseRecordings);
+            break;
+
+        case DisplayListNodeType::Line:
+            ThrowIfFailed(drawingSession->DrawLineWithColorAndStrokeWidth(node.Point0, node.Point1, node.Color, node.StrokeWidth));
+            break;
+
+        case DisplayListNodeType::Rectangle:
+            ThrowIfFailed(drawingSession->DrawRectangleWithColorAndStrokeWidth(node.Rect, node.Color, node.StrokeWidth));
+            break;
+
+        case DisplayListNodeType::FilledRectangle:
+            ThrowIfFailed(drawingSession->FillRectangleWithColor(node.Rect, node.Color));
+            break;
+
+        case DisplayListNodeType::FilledEllipse:
+            ThrowIfFailed(drawingSession->FillEllipseWithColor(node.Point0, node.RadiusX, node.RadiusY, node.Color));
+            break;
+
+        case DisplayListNodeType::Text:
+            ThrowIfFailed(drawingSession->DrawTextAtPointWithColorAndFormat(node.Text, node.Point0, node.Color, node.TextFormat.Get()));
+            break;
+
+        case DisplayListNodeType::Image:
+            ThrowIfFailed(drawingSession->DrawImage(node.Image.Get(), node.Point0));
+            break;
+
+        default:
+            assert(false);
+            ThrowHR(E_UNEXPECTED);
+        }
+
+        if (node.HasTransform)
+        {
+            popTransformWarden.Dismiss();
+            ThrowIfFailed(drawingSession->PopTransform());
+        }
+    }
+
+
+    void CanvasDisplayList::DrawGroup(ICanvasDrawingSession* drawingSession, DisplayListNode& group, bool canUseRecordings)
+    {
+        //
+        // When the recordings can't be used they are kept, rather than
+        // discarded, for the next time the display list is drawn into a
+        // session in its default state.
+        //
+        if (canUseRecordings &&
+            !group.Recording &&
+            group.CleanDrawCount >= DrawsBeforeRecording &&
+            group.Children.size() >= MinimumChildrenToRecord)
+        {
+            group.Recording = RecordGroup(group);
+        }
+
+        if (canUseRecordings && group.Recording)
+        {
+            ThrowIfFailed(drawingSession->DrawImageAtOrigin(group.Recording.Get()));
+        }
+        else
+        {
+            for (auto child : group.Children)
+                DrawNode(drawingSession, child, canUseRecordings);
+        }
+
+        if (group.CleanDrawCount < DrawsBeforeRecording)
+            ++group.CleanDrawCount;
+    }
+
+
+    ComPtr<CanvasCommandList> CanvasDisplayList::RecordGroup(DisplayListNode& group)
+    {
+        auto commandList = Make<CanvasCommandList>(m_device.EnsureNotClosed().Get(), m_drawingSessionManager);
+        CheckMakeResult(commandList);
+
+        ComPtr<ICanvasDrawingSession> recordingSession;
+        ThrowIfFailed(commandList->CreateDrawingSession(&recordingSession));
+
+        ComPtr<IClosable> closable;
+        ThrowIfFailed(recordingSession.As(&closable));
+
+        {
+            // Recording finishes even if drawing a child fails, so that
+            // the command list's device context isn't left mid-draw.
+            auto closeWarden = MakeScopeWarden([&] { closable->Close(); });
+
+            // The recording session is in its default state
+            for (auto child : group.Children)
+                DrawNode(recordingSession.Get(), child, true);
+
+            closeWarden.Dismiss();
+        }
+
+        ThrowIfFailed(closable->Close());
+
+        return commandList;
+    }
+
+
+    ActivatableClassWithFactory(CanvasDisplayList, CanvasDisplayListFactory);
+}}}}
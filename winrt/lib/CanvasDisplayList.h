@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include "CanvasCommandList.h"
+#include "ClosablePtr.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    class CanvasDrawingSessionManager;
+
+    class CanvasDisplayListFactory : public ActivationFactory<ICanvasDisplayListFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasDisplayList, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            ICanvasResourceCreator* resourceCreator,
+            ICanvasDisplayList** displayList) override;
+    };
+
+
+    enum class DisplayListNodeType
+    {
+        Free,
+        Group,
+        Line,
+        Rectangle,
+        FilledRectangle,
+        FilledEllipse,
+        Text,
+        Image
+    };
+
+
+    //
+    // Nodes are stored by value, indexed by id, with removed slots kept on a
+    // free list.  Each kind of node only uses the fields that it needs:
+    //
+    //  - Line:            Point0, Point1, Color, StrokeWidth
+    //  - Rectangle:       Rect, Color, StrokeWidth
+    //  - FilledRectangle: Rect, Color
+    //  - FilledEllipse:   Point0 (center), RadiusX, RadiusY, Color
+    //  - Text:            Point0, Color, Text, TextFormat
+    //  - Image:           Point0 (offset), Image
+    //  - Group:           Children, Recording, CleanDrawCount
+    //
+    struct DisplayListNode
+    {
+        DisplayListNode();
+
+        DisplayListNodeType Type;
+        uint32_t Parent;
+
+        Numerics::Matrix3x2 Transform;
+        bool HasTransform;
+        bool IsVisible;
+
+        Numerics::Vector2 Point0;
+        Numerics::Vector2 Point1;
+        ABI::Windows::Foundation::Rect Rect;
+        float RadiusX;
+        float RadiusY;
+        float StrokeWidth;
+        ABI::Windows::UI::Color Color;
+        WinString Text;
+        ComPtr<ICanvasTextFormat> TextFormat;
+        ComPtr<ICanvasImage> Image;
+
+        std::vector<uint32_t> Children;
+
+        // The group's children, as drawn the last time the group was drawn,
+        // or null if the group has changed since then.
+        ComPtr<CanvasCommandList> Recording;
+
+        // Number of times the group has been drawn since it last changed.
+        uint32_t CleanDrawCount;
+    };
+
+
+    //
+    // A group is only recorded once it has been drawn unchanged, since
+    // recording a group that changes every frame would cost more than
+    // drawing its children directly.  Groups with fewer than two children
+    // aren't worth recording at all.
+    //
+    // Recordings are made with the display list's device, through drawing
+    // sessions in their default state, and then drawn as images.  They are
+    // only used when the target session's blend, antialiasing and units are
+    // in their default state too; otherwise groups are drawn directly.  All
+    // methods are thread-safe.
+    //
+    class CanvasDisplayList : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasDisplayList,
+        ABI::Windows::Foundation::IClosable>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasDisplayList, BaseTrust);
+
+        ClosablePtr<ICanvasDevice> m_device;
+        std::shared_ptr<CanvasDrawingSessionManager> m_drawingSessionManager;
+
+        std::mutex m_mutex;
+        std::vector<DisplayListNode> m_nodes;
+        std::vector<uint32_t> m_freeNodes;
+
+    public:
+        static const uint32_t Root = 0;
+        static const uint32_t DrawsBeforeRecording = 1;
+        static const size_t MinimumChildrenToRecord = 2;
+
+        CanvasDisplayList(
+            ICanvasDevice* device,
+            std::shared_ptr<CanvasDrawingSessionManager> drawingSessionManager);
+
+        IFACEMETHOD(get_RootNode)(uint32_t* value) override;
+
+        IFACEMETHOD(AddGroup)(
+            uint32_t parentNode,
+            uint32_t* node) override;
+
+        IFACEMETHOD(AddLine)(
+            uint32_t parentNode,
+            Numerics::Vector2 point0,
+            Numerics::Vector2 point1,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            uint32_t* node) override;
+
+        IFACEMETHOD(AddRectangle)(
+            uint32_t parentNode,
+            ABI::Windows::Foundation::Rect rect,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            uint32_t* node) override;
+
+        IFACEMETHOD(AddFilledRectangle)(
+            uint32_t parentNode,
+            ABI::Windows::Foundation::Rect rect,
+            ABI::Windows::UI::Color color,
+            uint32_t* node) override;
+
+        IFACEMETHOD(AddFilledEllipse)(
+            uint32_t parentNode,
+            Numerics::Vector2 centerPoint,
+            float radiusX,
+            float radiusY,
+            ABI::Windows::UI::Color color,
+            uint32_t* node) override;
+
+        IFACEMETHOD(AddText)(
+            uint32_t parentNode,
+            HSTRING text,
+            Numerics::Vector2 point,
+            ABI::Windows::UI::Color color,
+            ICanvasTextFormat* format,
+            uint32_t* node) override;
+
+        IFACEMETHOD(AddImage)(
+            uint32_t parentNode,
+            ICanvasImage* image,
+            Numerics::Vector2 offset,
+            uint32_t* node) override;
+
+        IFACEMETHOD(RemoveNode)(uint32_t node) override;
+
+        IFACEMETHOD(SetTransform)(
+            uint32_t node,
+            Numerics::Matrix3x2 transform) override;
+
+        IFACEMETHOD(GetTransform)(
+            uint32_t node,
+            Numerics::Matrix3x2* transform) override;
+
+        IFACEMETHOD(SetIsVisible)(
+            uint32_t node,
+            boolean isVisible) override;
+
+        IFACEMETHOD(SetColor)(
+            uint32_t node,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(SetText)(
+            uint32_t node,
+            HSTRING text) override;
+
+        IFACEMETHOD(Invalidate)(uint32_t node) override;
+
+        IFACEMETHOD(Draw)(ICanvasDrawingSession* drawingSession) override;
+
+        // IClosable
+        IFACEMETHOD(Close)() override;
+
+    private:
+        //
+        // Adds a node of the given type to parentNode, and returns its id.
+        // The node is only added if fn, which fills in the node's fields,
+        // succeeds.
+        //
+        template<typename FN>
+        HRESULT AddNode(uint32_t parentNode, DisplayListNodeType type, uint32_t* node, FN&& fn);
+
+        DisplayListNode& GetNode(uint32_t node);
+        void FreeNode(uint32_t node);
+
+        // Discards the recordings of group and all of its ancestors.
+        void InvalidateGroup(uint32_t group);
+
+        // Discards the recordings that include node's contents.
+        void InvalidateContents(uint32_t node);
+
+        static bool CanDrawRecordingsInto(ICanvasDrawingSession* drawingSession);
+
+        void DrawNode(ICanvasDrawingSession* drawingSession, uint32_t node, bool canUseRecordings);
+        void DrawGroup(ICanvasDrawingSession* drawingSession, DisplayListNode& group, bool canUseRecordings);
+        ComPtr<CanvasCommandList> RecordGroup(DisplayListNode& group);
+    };
+}}}}
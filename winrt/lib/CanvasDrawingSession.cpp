@@ -15,28 +15,49 @@
 #include "CanvasDrawingSession.h"
 #include "CanvasStrokeStyle.h"
 #include "CanvasTextFormat.h"
+#include "CanvasTextLayout.h"
+#include "CanvasTextDocument.h"
 #include "CanvasImage.h"
 #include "CanvasDevice.h"
+#include "CanvasGeometry.h"
+#include "CanvasBitmap.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
     using namespace ABI::Windows::Foundation;
     using namespace ABI::Windows::UI;
 
-    ComPtr<ID2D1StrokeStyle1> ToD2DStrokeStyle(ICanvasStrokeStyle* strokeStyle, ID2D1DeviceContext* deviceContext)
+    static D2D1_RECT_F GetEllipseBounds(const Vector2& centerPoint, float radiusX, float radiusY)
     {
-        if (!strokeStyle) return nullptr;
+        return D2D1::RectF(
+            centerPoint.X - fabs(radiusX),
+            centerPoint.Y - fabs(radiusY),
+            centerPoint.X + fabs(radiusX),
+            centerPoint.Y + fabs(radiusY));
+    }
 
-        ComPtr<ID2D1Factory> d2dBaseFactory;
-        deviceContext->GetFactory(&d2dBaseFactory);
 
-        ComPtr<ID2D1Factory2> d2dFactory;
-        ThrowIfFailed(d2dBaseFactory.As(&d2dFactory));
+    static D2D1_RECT_F TransformBounds(const D2D1::Matrix3x2F& transform, const D2D1_RECT_F& rect)
+    {
+        D2D1_POINT_2F corners[] = 
+        {
+            transform.TransformPoint(D2D1::Point2F(rect.left, rect.top)),
+            transform.TransformPoint(D2D1::Point2F(rect.right, rect.top)),
+            transform.TransformPoint(D2D1::Point2F(rect.left, rect.bottom)),
+            transform.TransformPoint(D2D1::Point2F(rect.right, rect.bottom)),
+        };
 
-        ComPtr<ICanvasStrokeStyleInternal> internal;
-        ThrowIfFailed(strokeStyle->QueryInterface(internal.GetAddressOf()));
+        D2D1_RECT_F bounds = D2D1::RectF(corners[0].x, corners[0].y, corners[0].x, corners[0].y);
+
+        for (auto& corner : corners)
+        {
+            bounds.left = std::min(bounds.left, corner.x);
+            bounds.top = std::min(bounds.top, corner.y);
+            bounds.right = std::max(bounds.right, corner.x);
+            bounds.bottom = std::max(bounds.bottom, corner.y);
+        }
 
-        return internal->GetRealizedD2DStrokeStyle(d2dFactory.Get());
+        return bounds;
     }
     
     IFACEMETHODIMP CanvasDrawingSessionFactory::GetOrCreate(
@@ -83,7 +104,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     CanvasDrawingSessionManager::CanvasDrawingSessionManager()
         : m_adapter(std::make_shared<NoopCanvasDrawingSessionAdapter>())
+        , m_textLayoutCache(std::make_shared<CanvasTextLayoutCache>())
+    {
+    }
+
+
+    const std::shared_ptr<CanvasTextLayoutCache>& CanvasDrawingSessionManager::GetTextLayoutCache()
     {
+        return m_textLayoutCache;
     }
 
     ComPtr<CanvasDrawingSession> CanvasDrawingSessionManager::CreateNew(
@@ -127,8 +155,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         : ResourceWrapper(manager, deviceContext)
         , m_owner(owner)
         , m_adapter(adapter)
+        , m_isTransformDirty(false)
+        , m_isCullingEnabled(false)
+        , m_hasTargetBounds(false)
+        , m_isBatchingEnabled(false)
+        , m_batchType(BatchType::None)
+        , m_batchColor()
+        , m_batchStrokeWidth(0)
+        , m_solidColor()
+        , m_isPixelAlignedAliasingEnabled(false)
+        , m_isAliasedForPixelAlignment(false)
+        , m_hasPixelScale(false)
+        , m_isTracingEnabled(false)
     {
         CheckInPointer(adapter.get());
+
+        ResetStatisticsImpl();
     }
 
 
@@ -141,6 +183,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     IFACEMETHODIMP CanvasDrawingSession::Close()
     {
+        PrepareToClose();
+
         // Base class Close() called outside of ExceptionBoundary since this
         // already has its own boundary.
         HRESULT hr = ResourceWrapper::Close();
@@ -150,16 +194,131 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return ExceptionBoundary(
             [&]
             {
-                if (m_adapter)
+                EndDraw();
+            });
+    }
+
+
+    void CanvasDrawingSession::CloseForReuse()
+    {
+        PrepareToClose();
+
+        Detach();
+
+        EndDraw();
+    }
+
+
+    void CanvasDrawingSession::Reopen(
+        ID2D1DeviceContext1* deviceContext,
+        std::shared_ptr<ICanvasDrawingSessionAdapter> drawingSessionAdapter)
+    {
+        CheckInPointer(deviceContext);
+        CheckInPointer(drawingSessionAdapter.get());
+
+        if (m_adapter)
+            ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+        bool isNewDeviceContext = Attach(deviceContext);
+
+        //
+        // The solid color brush belongs to the device context it was created
+        // on, so it can only be kept if we're drawing to the same one again.
+        // This is the usual case for a SurfaceImageSource.
+        //
+        if (isNewDeviceContext)
+        {
+            m_solidColorBrush.Reset();
+            m_batchBrush.Reset();
+        }
+
+        m_adapter = drawingSessionAdapter;
+
+        m_isTransformDirty = false;
+        m_transformStack.clear();
+        m_clipStack.clear();
+        m_isCullingEnabled = false;
+        m_hasTargetBounds = false;
+        m_isBatchingEnabled = false;
+        ClearBatch();
+
+        m_isPixelAlignedAliasingEnabled = false;
+        m_isAliasedForPixelAlignment = false;
+        m_hasPixelScale = false;
+
+        m_isTracingEnabled = false;
+        m_trace.reset();
+
+        ResetStatisticsImpl();
+    }
+
+
+    void CanvasDrawingSession::PrepareToClose()
+    {
+        //
+        // Anything still batched needs drawing before EndDraw.  Errors are
+        // ignored here, as for the clips below; the drawing session is
+        // closed regardless.
+        //
+        if (m_batchType != BatchType::None)
+        {
+            (void)ExceptionBoundary(
+                [&]
                 {
-                    // Arrange it so that m_adapter will always get
-                    // reset, even if EndDraw throws.
-                    auto adapter = m_adapter;
-                    m_adapter.reset();
+                    FlushBatch();
+                });
 
-                    adapter->EndDraw();
-                }        
-            });
+            ClearBatch();
+        }
+
+        //
+        // The device context may be reused by a later drawing session, or
+        // by the app, so it is left in the antialias mode the app chose.
+        //
+        SetAliasedForPixelAlignment(false);
+
+        //
+        // D2D fails EndDraw if any clips or layers are still pushed, so we
+        // pop them on the app's behalf.  This must happen before the base
+        // class releases the device context.
+        //
+        if (m_adapter && !m_clipStack.empty())
+        {
+            // Ignore errors here; the adapter's EndDraw will report them.
+            (void)ExceptionBoundary(
+                [&]
+                {
+                    PopAllClipsAndLayers();
+                });
+        }
+
+        // The trace is read before the session closes, so there's no need to
+        // keep its resources alive any longer.
+        if (m_trace)
+            m_trace->ReleaseResources();
+    }
+
+
+    void CanvasDrawingSession::EndDraw()
+    {
+        if (!m_adapter)
+            return;
+
+        // Arrange it so that m_adapter will always get reset, even if
+        // EndDraw throws.
+        auto adapter = m_adapter;
+        m_adapter.reset();
+
+        LARGE_INTEGER frequency, start, end;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&start);
+
+        adapter->EndDraw();
+
+        QueryPerformanceCounter(&end);
+
+        // TimeSpan is measured in 100ns units
+        m_statistics.EndDrawDuration.Duration = (end.QuadPart - start.QuadPart) * 10000000 / frequency.QuadPart;
     }
 
 
@@ -169,10 +328,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return ExceptionBoundary(
             [&]
             {
-                auto& deviceContext = GetResource();
+                auto& deviceContext = GetResourceForDrawing();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::Clear))
+                    trace->Write(color);
 
                 auto d2dColor = ToD2DColor(color);
                 deviceContext->Clear(&d2dColor);
+                ++m_statistics.ClearCount;
             });
     }
 
@@ -188,13 +351,36 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return ExceptionBoundary(
             [&]
             {
-                auto& deviceContext = GetResource();
+                auto& deviceContext = GetResourceForDrawing();
                 CheckInPointer(image);
 
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawImage))
+                {
+                    trace->WriteResource(image);
+                    trace->Write(offset);
+                }
+
                 ComPtr<ICanvasImageInternal> internal;
                 ThrowIfFailed(image->QueryInterface(IID_PPV_ARGS(&internal)));
 
-                deviceContext->DrawImage(internal->GetD2DImage(deviceContext.Get()).Get(), ToD2DPoint(offset));
+                auto d2dImage = internal->GetD2DImage(deviceContext.Get());
+
+                if (m_isCullingEnabled)
+                {
+                    D2D1_RECT_F bounds;
+                    ThrowIfFailed(deviceContext->GetImageLocalBounds(d2dImage.Get(), &bounds));
+
+                    bounds.left += offset.X;
+                    bounds.right += offset.X;
+                    bounds.top += offset.Y;
+                    bounds.bottom += offset.Y;
+
+                    if (IsCulled(bounds))
+                        return;
+                }
+
+                deviceContext->DrawImage(d2dImage.Get(), ToD2DPoint(offset));
+                ++m_statistics.DrawImageCount;
             });
     }
 
@@ -219,6 +405,197 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
+    //
+    // DrawSprites
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawSprites(
+        ICanvasBitmap* bitmap,
+        uint32_t destinationRectCount,
+        Rect* destinationRects,
+        uint32_t sourceRectCount,
+        Rect* sourceRects,
+        uint32_t opacityCount,
+        float* opacities)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawSpritesImpl(
+                    bitmap,
+                    destinationRectCount,
+                    destinationRects,
+                    nullptr,
+                    sourceRectCount,
+                    sourceRects,
+                    opacityCount,
+                    opacities);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawSpritesWithTransforms(
+        ICanvasBitmap* bitmap,
+        uint32_t transformCount,
+        Numerics::Matrix3x2* transforms,
+        uint32_t sourceRectCount,
+        Rect* sourceRects,
+        uint32_t opacityCount,
+        float* opacities)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawSpritesImpl(
+                    bitmap,
+                    transformCount,
+                    nullptr,
+                    ReinterpretAs<D2D1_MATRIX_3X2_F*>(transforms),
+                    sourceRectCount,
+                    sourceRects,
+                    opacityCount,
+                    opacities);
+            });
+    }
+
+
+    //
+    // Sprites are positioned by either destinationRects or transforms; the
+    // caller passes null for the other.
+    //
+    void CanvasDrawingSession::DrawSpritesImpl(
+        ICanvasBitmap* bitmap,
+        uint32_t spriteCount,
+        const Rect* destinationRects,
+        const D2D1_MATRIX_3X2_F* transforms,
+        uint32_t sourceRectCount,
+        const Rect* sourceRects,
+        uint32_t opacityCount,
+        const float* opacities)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(bitmap);
+
+        if (spriteCount != 0 && !destinationRects && !transforms)
+            ThrowHR(E_INVALIDARG);
+
+        if (sourceRectCount != 0 && sourceRectCount != spriteCount)
+            ThrowHR(E_INVALIDARG);
+
+        if (opacityCount != 0 && opacityCount != spriteCount)
+            ThrowHR(E_INVALIDARG);
+
+        if (sourceRectCount)
+            CheckInPointer(sourceRects);
+        else
+            sourceRects = nullptr;
+
+        if (opacityCount)
+            CheckInPointer(opacities);
+        else
+            opacities = nullptr;
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawSprites))
+        {
+            trace->WriteResource(bitmap);
+            trace->Write<uint8_t>(transforms ? 1 : 0);
+
+            if (transforms)
+                trace->WriteArray(spriteCount, transforms);
+            else
+                trace->WriteArray(spriteCount, destinationRects);
+
+            trace->WriteArray(sourceRectCount, sourceRects);
+            trace->WriteArray(opacityCount, opacities);
+        }
+
+        ComPtr<ICanvasBitmapInternal> bitmapInternal;
+        ThrowIfFailed(bitmap->QueryInterface(bitmapInternal.GetAddressOf()));
+
+        auto d2dBitmap = bitmapInternal->GetD2DBitmap();
+
+        auto bitmapSize = d2dBitmap->GetSize();
+        auto bitmapRect = D2D1::RectF(0, 0, bitmapSize.width, bitmapSize.height);
+
+        //
+        // Transformed sprites are drawn by setting the device context's
+        // transform directly, restoring the session's transform once at the
+        // end rather than going through the deferred transform state for
+        // each sprite.  The transform is restored even if drawing a sprite
+        // throws.
+        //
+        auto sessionTransform = GetCurrentTransform();
+
+        const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
+        auto deviceTransform = sessionTransform * D2D1::Matrix3x2F::Translation(renderingSurfaceOffset.x, renderingSurfaceOffset.y);
+
+        bool isDeviceTransformChanged = false;
+        int drawCount = 0;
+
+        auto restoreTransformWarden = MakeScopeWarden(
+            [&]
+            {
+                if (isDeviceTransformChanged)
+                {
+                    deviceContext->SetTransform(deviceTransform);
+                    ++m_statistics.StateChangeCount;
+                }
+
+                m_statistics.DrawSpriteCount += drawCount;
+            });
+
+        for (uint32_t i = 0; i < spriteCount; ++i)
+        {
+            float opacity = opacities ? opacities[i] : 1.0f;
+            if (!(opacity > 0))
+                continue;
+
+            D2D1_RECT_F sourceRect;
+            const D2D1_RECT_F* sourceRectOrNull = nullptr;
+            if (sourceRects)
+            {
+                sourceRect = ToD2DRect(sourceRects[i]);
+                sourceRectOrNull = &sourceRect;
+            }
+
+            D2D1_RECT_F destinationRect;
+
+            if (transforms)
+            {
+                auto& spriteTransform = *D2D1::Matrix3x2F::ReinterpretBaseType(&transforms[i]);
+
+                destinationRect = sourceRects
+                    ? D2D1::RectF(0, 0, sourceRect.right - sourceRect.left, sourceRect.bottom - sourceRect.top)
+                    : bitmapRect;
+
+                if (m_isCullingEnabled && IsWorldBoundsCulled(TransformBounds(spriteTransform * sessionTransform, destinationRect)))
+                    continue;
+
+                deviceContext->SetTransform(spriteTransform * deviceTransform);
+                isDeviceTransformChanged = true;
+                ++m_statistics.StateChangeCount;
+            }
+            else
+            {
+                destinationRect = ToD2DRect(destinationRects[i]);
+
+                if (m_isCullingEnabled && IsWorldBoundsCulled(TransformBounds(sessionTransform, destinationRect)))
+                    continue;
+            }
+
+            deviceContext->DrawBitmap(
+                d2dBitmap.Get(),
+                &destinationRect,
+                opacity,
+                D2D1_INTERPOLATION_MODE_LINEAR,
+                sourceRectOrNull,
+                nullptr);
+
+            ++drawCount;
+        }
+    }
+
+
     //
     // DrawLine
     //
@@ -392,6 +769,19 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float strokeWidth,
         ICanvasStrokeStyle* strokeStyle)
     {
+        if (!strokeStyle)
+        {
+            if (auto deviceContext = TryGetResourceForDirectDrawing())
+            {
+                if (auto brush = TryGetColorBrush(color))
+                {
+                    deviceContext->DrawLine(ToD2DPoint(point0), ToD2DPoint(point1), brush, strokeWidth);
+                    ++m_statistics.DrawLineCount;
+                    return S_OK;
+                }
+            }
+        }
+
         return ExceptionBoundary(
             [&]
             {
@@ -430,15 +820,45 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float strokeWidth,
         ICanvasStrokeStyle* strokeStyle)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForBatchableDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawLine))
+        {
+            trace->Write(point0);
+            trace->Write(point1);
+            WriteTraceBrush(trace, brush);
+            trace->Write(strokeWidth);
+            trace->WriteResource(strokeStyle);
+        }
+
+        auto bounds = D2D1::RectF(
+            std::min(point0.X, point1.X),
+            std::min(point0.Y, point1.Y),
+            std::max(point0.X, point1.X),
+            std::max(point0.Y, point1.Y));
+
+        if (IsStrokeCulled(bounds, strokeWidth, strokeStyle))
+            return;
+
+        auto d2dStrokeStyle = ToD2DStrokeStyle(strokeStyle, deviceContext.Get());
+
+        ++m_statistics.DrawLineCount;
+
+        if (AddToBatch(BatchType::Stroke, brush, strokeWidth, d2dStrokeStyle.Get()))
+        {
+            m_batchedLines.push_back(BatchedLine{ ToD2DPoint(point0), ToD2DPoint(point1) });
+            return;
+        }
+
+        SetAliasedForPixelAlignment(false);
+
         deviceContext->DrawLine(
             ToD2DPoint(point0),
             ToD2DPoint(point1),
             brush,
             strokeWidth,
-            ToD2DStrokeStyle(strokeStyle, deviceContext.Get()).Get());
+            d2dStrokeStyle.Get());
     }
 
 
@@ -599,6 +1019,19 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float strokeWidth,
         ICanvasStrokeStyle* strokeStyle)
     {
+        if (!strokeStyle)
+        {
+            if (auto deviceContext = TryGetResourceForDirectDrawing())
+            {
+                if (auto brush = TryGetColorBrush(color))
+                {
+                    deviceContext->DrawRectangle(&ToD2DRect(rect), brush, strokeWidth);
+                    ++m_statistics.DrawRectangleCount;
+                    return S_OK;
+                }
+            }
+        }
+
         return ExceptionBoundary(
             [&]
             {
@@ -634,14 +1067,33 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float strokeWidth,
         ICanvasStrokeStyle* strokeStyle)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForBatchableDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawRectangle))
+        {
+            trace->Write(rect);
+            WriteTraceBrush(trace, brush);
+            trace->Write(strokeWidth);
+            trace->WriteResource(strokeStyle);
+        }
+
+        if (IsStrokeCulled(ToD2DRect(rect), strokeWidth, strokeStyle))
+            return;
+
+        FlushBatch();
+
+        // Custom stroke styles can round or dash the corners, which aliasing
+        // would change.
+        SetAliasedForPixelAlignment(!strokeStyle && IsPixelAligned(ToD2DRect(rect), strokeWidth));
+
         deviceContext->DrawRectangle(
             &ToD2DRect(rect),
             brush,
             strokeWidth,
             ToD2DStrokeStyle(strokeStyle, deviceContext.Get()).Get());
+
+        ++m_statistics.DrawRectangleCount;
     }
 
 
@@ -680,6 +1132,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         Rect rect,
         Color color)
     {
+        if (auto deviceContext = TryGetResourceForDirectDrawing())
+        {
+            if (auto brush = TryGetColorBrush(color))
+            {
+                deviceContext->FillRectangle(&ToD2DRect(rect), brush);
+                ++m_statistics.FillRectangleCount;
+                return S_OK;
+            }
+        }
+
         return ExceptionBoundary(
             [&]
             {
@@ -707,9 +1169,35 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         const Rect& rect,
         ID2D1Brush* brush)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForBatchableDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::FillRectangle))
+        {
+            trace->Write(rect);
+            WriteTraceBrush(trace, brush);
+        }
+
+        if (IsCulled(ToD2DRect(rect)))
+            return;
+
+        ++m_statistics.FillRectangleCount;
+
+        if (AddToBatch(BatchType::Fill, brush, 0, nullptr))
+        {
+            // Normalized so that every figure in the batch has the same
+            // winding direction.
+            auto d2dRect = ToD2DRect(rect);
+            m_batchedRectangles.push_back(D2D1::RectF(
+                std::min(d2dRect.left, d2dRect.right),
+                std::min(d2dRect.top, d2dRect.bottom),
+                std::max(d2dRect.left, d2dRect.right),
+                std::max(d2dRect.top, d2dRect.bottom)));
+            return;
+        }
+
+        SetAliasedForPixelAlignment(IsPixelAligned(ToD2DRect(rect), 0));
+
         deviceContext->FillRectangle(
             &ToD2DRect(rect),
             brush);
@@ -958,14 +1446,29 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float strokeWidth,
         ICanvasStrokeStyle* strokeStyle)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawRoundedRectangle))
+        {
+            trace->Write(rect);
+            trace->Write(radiusX);
+            trace->Write(radiusY);
+            WriteTraceBrush(trace, brush);
+            trace->Write(strokeWidth);
+            trace->WriteResource(strokeStyle);
+        }
+
+        if (IsStrokeCulled(ToD2DRect(rect), strokeWidth, strokeStyle))
+            return;
+
         deviceContext->DrawRoundedRectangle(
             &ToD2DRoundedRect(rect, radiusX, radiusY),
             brush,
             strokeWidth,
             ToD2DStrokeStyle(strokeStyle, deviceContext.Get()).Get());
+
+        ++m_statistics.DrawRoundedRectangleCount;
     }
 
 
@@ -1049,12 +1552,25 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float radiusY,
         ID2D1Brush* brush)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::FillRoundedRectangle))
+        {
+            trace->Write(rect);
+            trace->Write(radiusX);
+            trace->Write(radiusY);
+            WriteTraceBrush(trace, brush);
+        }
+
+        if (IsCulled(ToD2DRect(rect)))
+            return;
+
         deviceContext->FillRoundedRectangle(
             &ToD2DRoundedRect(rect, radiusX, radiusY),
             brush);
+
+        ++m_statistics.FillRoundedRectangleCount;
     }
 
 
@@ -1288,14 +1804,29 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float strokeWidth,
         ICanvasStrokeStyle* strokeStyle)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawEllipse))
+        {
+            trace->Write(centerPoint);
+            trace->Write(radiusX);
+            trace->Write(radiusY);
+            WriteTraceBrush(trace, brush);
+            trace->Write(strokeWidth);
+            trace->WriteResource(strokeStyle);
+        }
+
+        if (IsStrokeCulled(GetEllipseBounds(centerPoint, radiusX, radiusY), strokeWidth, strokeStyle))
+            return;
+
         deviceContext->DrawEllipse(
             &ToD2DEllipse(centerPoint, radiusX, radiusY),
             brush,
             strokeWidth,
             ToD2DStrokeStyle(strokeStyle, deviceContext.Get()).Get());
+
+        ++m_statistics.DrawEllipseCount;
     }
 
 
@@ -1342,6 +1873,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float radiusY,
         Color color)
     {
+        if (auto deviceContext = TryGetResourceForDirectDrawing())
+        {
+            if (auto brush = TryGetColorBrush(color))
+            {
+                deviceContext->FillEllipse(&ToD2DEllipse(centerPoint, radiusX, radiusY), brush);
+                ++m_statistics.FillEllipseCount;
+                return S_OK;
+            }
+        }
+
         return ExceptionBoundary(
             [&]
             {
@@ -1375,9 +1916,30 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         float radiusY,
         ID2D1Brush* brush)
     {
-        auto& deviceContext = GetResource();
+        auto& deviceContext = GetResourceForBatchableDrawing();
         CheckInPointer(brush);
 
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::FillEllipse))
+        {
+            trace->Write(centerPoint);
+            trace->Write(radiusX);
+            trace->Write(radiusY);
+            WriteTraceBrush(trace, brush);
+        }
+
+        if (IsCulled(GetEllipseBounds(centerPoint, radiusX, radiusY)))
+            return;
+
+        ++m_statistics.FillEllipseCount;
+
+        if (AddToBatch(BatchType::Fill, brush, 0, nullptr))
+        {
+            m_batchedEllipses.push_back(ToD2DEllipse(centerPoint, fabs(radiusX), fabs(radiusY)));
+            return;
+        }
+
+        SetAliasedForPixelAlignment(false);
+
         deviceContext->FillEllipse(
             &ToD2DEllipse(centerPoint, radiusX, radiusY),
             brush);
@@ -1645,402 +2207,2659 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
 
     //
-    // DrawText
+    // DrawGeometry
     //
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointWithColor(
-        HSTRING text,
-        Vector2 point,
-        Color color)
+    IFACEMETHODIMP CanvasDrawingSession::DrawGeometryWithBrush(
+        ICanvasGeometry* geometry,
+        ICanvasBrush* brush)
     {
-        return DrawTextAtPointWithColorAndFormat(
-            text, 
-            point, 
-            color, 
+        return DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle(
+            geometry,
+            brush,
+            1.0f,
             nullptr);
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointCoordsWithColor(
-        HSTRING text,
-        float x,
-        float y,
+    IFACEMETHODIMP CanvasDrawingSession::DrawGeometryWithColor(
+        ICanvasGeometry* geometry,
         Color color)
     {
-        return DrawTextAtPointWithColorAndFormat(
-            text, 
-            Vector2{ x, y }, 
-            color, 
+        return DrawGeometryWithColorAndStrokeWidthAndStrokeStyle(
+            geometry,
+            color,
+            1.0f,
             nullptr);
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointWithBrushAndFormat(
-        HSTRING text,
-        Vector2 point,
+    IFACEMETHODIMP CanvasDrawingSession::DrawGeometryWithBrushAndStrokeWidth(
+        ICanvasGeometry* geometry,
         ICanvasBrush* brush,
-        ICanvasTextFormat* format)
+        float strokeWidth)
     {
-        return ExceptionBoundary(
+        return DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle(
+            geometry,
+            brush,
+            strokeWidth,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawGeometryWithColorAndStrokeWidth(
+        ICanvasGeometry* geometry,
+        Color color,
+        float strokeWidth)
+    {
+        return DrawGeometryWithColorAndStrokeWidthAndStrokeStyle(
+            geometry,
+            color,
+            strokeWidth,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle(
+        ICanvasGeometry* geometry,
+        ICanvasBrush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
             [&]
             {
-                DrawTextAtPointImpl(
-                    text, 
-                    point, 
-                    ToD2DBrush(brush).Get(), 
-                    format);
+                DrawGeometryImpl(
+                    geometry,
+                    ToD2DBrush(brush).Get(),
+                    strokeWidth,
+                    strokeStyle);
             });
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectWithBrushAndFormat(
-        HSTRING text,
-        Rect rectangle,
+    IFACEMETHODIMP CanvasDrawingSession::DrawGeometryWithColorAndStrokeWidthAndStrokeStyle(
+        ICanvasGeometry* geometry,
+        Color color,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawGeometryImpl(
+                    geometry,
+                    GetColorBrush(color),
+                    strokeWidth,
+                    strokeStyle);
+            });
+    }
+
+
+    void CanvasDrawingSession::DrawGeometryImpl(
+        ICanvasGeometry* geometry,
+        ID2D1Brush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(geometry);
+        CheckInPointer(brush);
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawGeometry))
+        {
+            trace->WriteResource(geometry);
+            WriteTraceBrush(trace, brush);
+            trace->Write(strokeWidth);
+            trace->WriteResource(strokeStyle);
+        }
+
+        ComPtr<ICanvasGeometryInternal> geometryInternal;
+        ThrowIfFailed(geometry->QueryInterface(geometryInternal.GetAddressOf()));
+
+        if (m_isCullingEnabled && IsPathStrokeCulled(geometryInternal->GetBounds(), strokeWidth, strokeStyle))
+            return;
+
+        auto d2dStrokeStyle = ToD2DStrokeStyle(strokeStyle, deviceContext.Get());
+
+        auto realization = geometryInternal->GetRealization(
+            deviceContext.Get(),
+            true,
+            strokeWidth,
+            d2dStrokeStyle.Get());
+
+        if (realization)
+        {
+            deviceContext->DrawGeometryRealization(realization.Get(), brush);
+        }
+        else
+        {
+            deviceContext->DrawGeometry(
+                geometryInternal->GetD2DGeometry().Get(),
+                brush,
+                strokeWidth,
+                d2dStrokeStyle.Get());
+        }
+
+        ++m_statistics.DrawGeometryCount;
+    }
+
+
+    //
+    // FillGeometry
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::FillGeometryWithBrush(
+        ICanvasGeometry* geometry,
+        ICanvasBrush* brush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                FillGeometryImpl(
+                    geometry,
+                    ToD2DBrush(brush).Get());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillGeometryWithColor(
+        ICanvasGeometry* geometry,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                FillGeometryImpl(
+                    geometry,
+                    GetColorBrush(color));
+            });
+    }
+
+
+    void CanvasDrawingSession::FillGeometryImpl(
+        ICanvasGeometry* geometry,
+        ID2D1Brush* brush)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(geometry);
+        CheckInPointer(brush);
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::FillGeometry))
+        {
+            trace->WriteResource(geometry);
+            WriteTraceBrush(trace, brush);
+        }
+
+        ComPtr<ICanvasGeometryInternal> geometryInternal;
+        ThrowIfFailed(geometry->QueryInterface(geometryInternal.GetAddressOf()));
+
+        if (m_isCullingEnabled && IsCulled(geometryInternal->GetBounds()))
+            return;
+
+        auto realization = geometryInternal->GetRealization(
+            deviceContext.Get(),
+            false,
+            0,
+            nullptr);
+
+        if (realization)
+        {
+            deviceContext->DrawGeometryRealization(realization.Get(), brush);
+        }
+        else
+        {
+            deviceContext->FillGeometry(
+                geometryInternal->GetD2DGeometry().Get(),
+                brush,
+                nullptr);
+        }
+
+        ++m_statistics.FillGeometryCount;
+    }
+
+
+    //
+    // DrawPolyline
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithBrush(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush)
+    {
+        return DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
+            brush,
+            1.0f,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithColor(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color)
+    {
+        return DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
+            color,
+            1.0f,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithBrushAndStrokeWidth(
+        uint32_t pointCount,
+        Vector2* points,
         ICanvasBrush* brush,
-        ICanvasTextFormat* format)
+        float strokeWidth)
+    {
+        return DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
+            brush,
+            strokeWidth,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithColorAndStrokeWidth(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth)
+    {
+        return DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
+            color,
+            strokeWidth,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
     {
         return ExceptionBoundary(
             [&]
             {
-                DrawTextAtRectImpl(
-                    text,
-                    rectangle,
+                DrawPolygonImpl(
+                    pointCount,
+                    points,
+                    D2D1_FIGURE_END_OPEN,
                     ToD2DBrush(brush).Get(),
-                    format);
+                    strokeWidth,
+                    strokeStyle);
             });
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointCoordsWithBrushAndFormat(
-        HSTRING text,
-        float x,
-        float y,
-        ICanvasBrush* brush,
-        ICanvasTextFormat* format)
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
     {
-        return DrawTextAtPointWithBrushAndFormat(
-            text,
-            Vector2{ x, y },
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawPolygonImpl(
+                    pointCount,
+                    points,
+                    D2D1_FIGURE_END_OPEN,
+                    GetColorBrush(color),
+                    strokeWidth,
+                    strokeStyle);
+            });
+    }
+
+
+    //
+    // DrawPolygon
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolygonWithBrush(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush)
+    {
+        return DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
             brush,
-            format);
+            1.0f,
+            nullptr);
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectCoordsWithBrushAndFormat(
-        HSTRING text,
-        float x,
-        float y,
-        float w,
-        float h,
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolygonWithColor(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color)
+    {
+        return DrawPolygonWithColorAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
+            color,
+            1.0f,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolygonWithBrushAndStrokeWidth(
+        uint32_t pointCount,
+        Vector2* points,
         ICanvasBrush* brush,
-        ICanvasTextFormat* format)
+        float strokeWidth)
     {
-        return DrawTextAtRectWithBrushAndFormat(
-            text,
-            Rect{ x, y, w, h },
+        return DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
             brush,
-            format);
+            strokeWidth,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolygonWithColorAndStrokeWidth(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth)
+    {
+        return DrawPolygonWithColorAndStrokeWidthAndStrokeStyle(
+            pointCount,
+            points,
+            color,
+            strokeWidth,
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawPolygonImpl(
+                    pointCount,
+                    points,
+                    D2D1_FIGURE_END_CLOSED,
+                    ToD2DBrush(brush).Get(),
+                    strokeWidth,
+                    strokeStyle);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolygonWithColorAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawPolygonImpl(
+                    pointCount,
+                    points,
+                    D2D1_FIGURE_END_CLOSED,
+                    GetColorBrush(color),
+                    strokeWidth,
+                    strokeStyle);
+            });
+    }
+
+
+    //
+    // FillPolygon
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::FillPolygonWithBrush(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                FillPolygonImpl(
+                    pointCount,
+                    points,
+                    ToD2DBrush(brush).Get());
+            });
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointWithColorAndFormat(
-        HSTRING text,
-        Vector2 point,
-        Color color,
-        ICanvasTextFormat* format)
+    IFACEMETHODIMP CanvasDrawingSession::FillPolygonWithColor(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                FillPolygonImpl(
+                    pointCount,
+                    points,
+                    GetColorBrush(color));
+            });
+    }
+
+
+    static D2D1_RECT_F GetBoundsOfPoints(uint32_t pointCount, const Vector2* points)
+    {
+        auto bounds = D2D1::RectF(points[0].X, points[0].Y, points[0].X, points[0].Y);
+
+        for (uint32_t i = 1; i < pointCount; ++i)
+        {
+            bounds.left = std::min(bounds.left, points[i].X);
+            bounds.top = std::min(bounds.top, points[i].Y);
+            bounds.right = std::max(bounds.right, points[i].X);
+            bounds.bottom = std::max(bounds.bottom, points[i].Y);
+        }
+
+        return bounds;
+    }
+
+
+    void CanvasDrawingSession::DrawPolygonImpl(
+        uint32_t pointCount,
+        const Vector2* points,
+        D2D1_FIGURE_END figureEnd,
+        ID2D1Brush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(brush);
+
+        if (pointCount == 0)
+            return;
+
+        CheckInPointer(points);
+
+        auto traceOp = (figureEnd == D2D1_FIGURE_END_OPEN) ? CanvasTraceOp::DrawPolyline : CanvasTraceOp::DrawPolygon;
+
+        if (auto trace = BeginTraceRecord(traceOp))
+        {
+            trace->WriteArray(pointCount, points);
+            WriteTraceBrush(trace, brush);
+            trace->Write(strokeWidth);
+            trace->WriteResource(strokeStyle);
+        }
+
+        if (m_isCullingEnabled && IsPathStrokeCulled(GetBoundsOfPoints(pointCount, points), strokeWidth, strokeStyle))
+            return;
+
+        auto d2dStrokeStyle = ToD2DStrokeStyle(strokeStyle, deviceContext.Get());
+
+        auto pathGeometry = CreatePathFromPoints(
+            deviceContext.Get(),
+            pointCount,
+            points,
+            D2D1_FIGURE_BEGIN_HOLLOW,
+            figureEnd);
+
+        deviceContext->DrawGeometry(
+            pathGeometry.Get(),
+            brush,
+            strokeWidth,
+            d2dStrokeStyle.Get());
+
+        ++m_statistics.DrawGeometryCount;
+    }
+
+
+    void CanvasDrawingSession::FillPolygonImpl(
+        uint32_t pointCount,
+        const Vector2* points,
+        ID2D1Brush* brush)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(brush);
+
+        if (pointCount == 0)
+            return;
+
+        CheckInPointer(points);
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::FillPolygon))
+        {
+            trace->WriteArray(pointCount, points);
+            WriteTraceBrush(trace, brush);
+        }
+
+        if (m_isCullingEnabled && IsCulled(GetBoundsOfPoints(pointCount, points)))
+            return;
+
+        auto pathGeometry = CreatePathFromPoints(
+            deviceContext.Get(),
+            pointCount,
+            points,
+            D2D1_FIGURE_BEGIN_FILLED,
+            D2D1_FIGURE_END_CLOSED);
+
+        deviceContext->FillGeometry(
+            pathGeometry.Get(),
+            brush,
+            nullptr);
+
+        ++m_statistics.FillGeometryCount;
+    }
+
+
+    //
+    // The points become a single figure, added with one AddLines call.
+    //
+    ComPtr<ID2D1PathGeometry> CanvasDrawingSession::CreatePathFromPoints(
+        ID2D1DeviceContext1* deviceContext,
+        uint32_t pointCount,
+        const Vector2* points,
+        D2D1_FIGURE_BEGIN figureBegin,
+        D2D1_FIGURE_END figureEnd)
+    {
+        auto d2dPoints = ReinterpretAs<const D2D1_POINT_2F*>(points);
+
+        ComPtr<ID2D1Factory> factory;
+        deviceContext->GetFactory(&factory);
+
+        ComPtr<ID2D1PathGeometry> pathGeometry;
+        ThrowIfFailed(factory->CreatePathGeometry(&pathGeometry));
+
+        ComPtr<ID2D1GeometrySink> sink;
+        ThrowIfFailed(pathGeometry->Open(&sink));
+
+        sink->BeginFigure(d2dPoints[0], figureBegin);
+
+        if (pointCount > 1)
+            sink->AddLines(d2dPoints + 1, pointCount - 1);
+
+        sink->EndFigure(figureEnd);
+
+        ThrowIfFailed(sink->Close());
+
+        return pathGeometry;
+    }
+
+
+    //
+    // DrawText
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointWithColor(
+        HSTRING text,
+        Vector2 point,
+        Color color)
+    {
+        return DrawTextAtPointWithColorAndFormat(
+            text, 
+            point, 
+            color, 
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointCoordsWithColor(
+        HSTRING text,
+        float x,
+        float y,
+        Color color)
+    {
+        return DrawTextAtPointWithColorAndFormat(
+            text, 
+            Vector2{ x, y }, 
+            color, 
+            nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointWithBrushAndFormat(
+        HSTRING text,
+        Vector2 point,
+        ICanvasBrush* brush,
+        ICanvasTextFormat* format)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextAtPointImpl(
+                    text, 
+                    point, 
+                    ToD2DBrush(brush).Get(), 
+                    format);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectWithBrushAndFormat(
+        HSTRING text,
+        Rect rectangle,
+        ICanvasBrush* brush,
+        ICanvasTextFormat* format)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextAtRectImpl(
+                    text,
+                    rectangle,
+                    ToD2DBrush(brush).Get(),
+                    format);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointCoordsWithBrushAndFormat(
+        HSTRING text,
+        float x,
+        float y,
+        ICanvasBrush* brush,
+        ICanvasTextFormat* format)
+    {
+        return DrawTextAtPointWithBrushAndFormat(
+            text,
+            Vector2{ x, y },
+            brush,
+            format);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectCoordsWithBrushAndFormat(
+        HSTRING text,
+        float x,
+        float y,
+        float w,
+        float h,
+        ICanvasBrush* brush,
+        ICanvasTextFormat* format)
+    {
+        return DrawTextAtRectWithBrushAndFormat(
+            text,
+            Rect{ x, y, w, h },
+            brush,
+            format);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointWithColorAndFormat(
+        HSTRING text,
+        Vector2 point,
+        Color color,
+        ICanvasTextFormat* format)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextAtPointImpl(
+                    text, 
+                    point, 
+                    GetColorBrush(color), 
+                    format);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectWithColorAndFormat(
+        HSTRING text,
+        Rect rectangle,
+        Color color,
+        ICanvasTextFormat* format)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextAtRectImpl(
+                    text, 
+                    rectangle, 
+                    GetColorBrush(color), 
+                    format);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointCoordsWithColorAndFormat(
+        HSTRING text,
+        float x,
+        float y,
+        Color color,
+        ICanvasTextFormat* format)
+    {
+        return DrawTextAtPointWithColorAndFormat(
+            text,
+            Vector2{ x, y },
+            color,
+            format);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectCoordsWithColorAndFormat(
+        HSTRING text,
+        float x,
+        float y,
+        float w,
+        float h,
+        Color color,
+        ICanvasTextFormat* format)
+    {
+        return DrawTextAtRectWithColorAndFormat(
+            text,
+            Rect{ x, y, w, h },
+            color,
+            format);
+    }
+
+
+    void CanvasDrawingSession::DrawTextAtRectImpl(
+        HSTRING text,
+        const Rect& rect,
+        ID2D1Brush* brush,
+        ICanvasTextFormat* format)
+    {
+        DrawTextImpl(text, rect, brush, format, false);
+    }
+
+
+    void CanvasDrawingSession::DrawTextAtPointImpl(
+        HSTRING text,
+        const Vector2& point,
+        ID2D1Brush* brush,
+        ICanvasTextFormat* format)
+    {
+        // When drawing using just a point we specify a zero sized rectangle and
+        // disable word wrapping.  Word wrapping is disabled on the text layout
+        // rather than the format, so the format is never modified here.
+        Rect rect{ point.X, point.Y, 0, 0 };
+
+        DrawTextImpl(text, rect, brush, format, true);
+    }
+
+
+    //
+    // The overhang metrics describe how far the ink extends beyond the
+    // layout box, so these bounds account for text that overflows its box as
+    // well as point text (which has an empty box).
+    //
+    static D2D1_RECT_F GetTextLayoutBounds(IDWriteTextLayout* layout, float x, float y)
+    {
+        DWRITE_OVERHANG_METRICS overhang;
+        ThrowIfFailed(layout->GetOverhangMetrics(&overhang));
+
+        return D2D1::RectF(
+            x - overhang.left,
+            y - overhang.top,
+            x + layout->GetMaxWidth() + overhang.right,
+            y + layout->GetMaxHeight() + overhang.bottom);
+    }
+
+
+    void CanvasDrawingSession::DrawTextImpl(
+        HSTRING text,
+        const Rect& rect,
+        ID2D1Brush* brush,
+        ICanvasTextFormat* format,
+        bool noWrap)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(brush);
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawText))
+        {
+            trace->WriteString(text);
+            trace->Write(rect);
+            trace->Write<uint8_t>(noWrap ? 1 : 0);
+            WriteTraceBrush(trace, brush);
+            trace->WriteResource(format);
+        }
+
+        if (!format)
+        {
+            format = GetDefaultTextFormat();
+        }
+
+        ComPtr<ICanvasTextFormatInternal> formatInternal;
+        ThrowIfFailed(format->QueryInterface(formatInternal.GetAddressOf()));
+
+        // The format may be changed by another thread while we draw with it
+        auto formatSnapshot = GetTextFormatSnapshot(formatInternal.Get());
+
+        uint32_t textLength;
+        auto textBuffer = WindowsGetStringRawBuffer(text, &textLength);
+        ThrowIfNullPointer(textBuffer, E_INVALIDARG);
+
+        //
+        // Drawing a cached layout is equivalent to DrawText, which lays out
+        // the text in a box the size of the rectangle and draws it at the
+        // rectangle's top-left corner.
+        //
+        auto layout = Manager()->GetTextLayoutCache()->GetOrCreate(
+            formatSnapshot->Format.Get(),
+            formatSnapshot->RealizationId,
+            textBuffer,
+            textLength,
+            std::max(0.0f, rect.Width),
+            std::max(0.0f, rect.Height),
+            noWrap);
+
+        if (m_isCullingEnabled && IsCulled(GetTextLayoutBounds(layout.Get(), rect.X, rect.Y)))
+            return;
+
+        deviceContext->DrawTextLayout(
+            D2D1::Point2F(rect.X, rect.Y),
+            layout.Get(),
+            brush,
+            static_cast<D2D1_DRAW_TEXT_OPTIONS>(formatSnapshot->DrawTextOptions));
+
+        ++m_statistics.DrawTextCount;
+    }
+
+
+    //
+    // DrawTextBatch
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextBatch(
+        uint32_t textCount,
+        HSTRING* text,
+        uint32_t pointCount,
+        Vector2* points,
+        uint32_t colorCount,
+        Color* colors,
+        ICanvasTextFormat* format)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextBatchImpl(
+                    textCount,
+                    text,
+                    nullptr,
+                    nullptr,
+                    pointCount,
+                    points,
+                    colorCount,
+                    colors,
+                    format);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextBatchFromBuffer(
+        HSTRING text,
+        uint32_t offsetCount,
+        int32_t* offsets,
+        uint32_t pointCount,
+        Vector2* points,
+        uint32_t colorCount,
+        Color* colors,
+        ICanvasTextFormat* format)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                // An empty batch may pass no offsets at all.
+                auto labelCount = (offsetCount > 0) ? offsetCount - 1 : 0;
+
+                if (offsetCount)
+                    CheckInPointer(offsets);
+                else
+                    offsets = nullptr;
+
+                DrawTextBatchImpl(
+                    labelCount,
+                    nullptr,
+                    text,
+                    offsets,
+                    pointCount,
+                    points,
+                    colorCount,
+                    colors,
+                    format);
+            });
+    }
+
+
+    static bool IsSameColor(const Color& a, const Color& b)
+    {
+        return a.A == b.A && a.R == b.R && a.G == b.G && a.B == b.B;
+    }
+
+
+    //
+    // Labels come from either texts, or offsets into buffer; the caller
+    // passes null for the other.
+    //
+    void CanvasDrawingSession::DrawTextBatchImpl(
+        uint32_t labelCount,
+        const HSTRING* texts,
+        HSTRING buffer,
+        const int32_t* offsets,
+        uint32_t pointCount,
+        const Vector2* points,
+        uint32_t colorCount,
+        const Color* colors,
+        ICanvasTextFormat* format)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+
+        if (pointCount != labelCount)
+            ThrowHR(E_INVALIDARG);
+
+        if (colorCount != labelCount && colorCount != 1)
+            ThrowHR(E_INVALIDARG);
+
+        if (labelCount)
+        {
+            if (!offsets)
+                CheckInPointer(texts);
+
+            CheckInPointer(points);
+        }
+
+        if (colorCount)
+            CheckInPointer(colors);
+
+        uint32_t bufferLength = 0;
+        auto bufferText = WindowsGetStringRawBuffer(buffer, &bufferLength);
+
+        if (offsets)
+        {
+            if (offsets[0] < 0 || static_cast<uint32_t>(offsets[labelCount]) > bufferLength)
+                ThrowHR(E_INVALIDARG);
+
+            for (uint32_t i = 0; i < labelCount; ++i)
+            {
+                if (offsets[i + 1] < offsets[i])
+                    ThrowHR(E_INVALIDARG);
+            }
+        }
+
+        auto getLabel =
+            [&](uint32_t index, uint32_t* length) -> const wchar_t*
+            {
+                if (texts)
+                    return WindowsGetStringRawBuffer(texts[index], length);
+
+                *length = static_cast<uint32_t>(offsets[index + 1] - offsets[index]);
+                return bufferText + offsets[index];
+            };
+
+        //
+        // Labels are always traced as separate strings, so a batch drawn from
+        // a buffer replays as a call to DrawTextBatch.
+        //
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawTextBatch))
+        {
+            trace->Write(labelCount);
+
+            for (uint32_t i = 0; i < labelCount; ++i)
+            {
+                uint32_t length;
+                auto label = getLabel(i, &length);
+                trace->WriteArray(length, label);
+            }
+
+            trace->WriteArray(pointCount, points);
+            trace->WriteArray(colorCount, colors);
+            trace->WriteResource(format);
+        }
+
+        if (labelCount == 0)
+            return;
+
+        if (!format)
+        {
+            format = GetDefaultTextFormat();
+        }
+
+        ComPtr<ICanvasTextFormatInternal> formatInternal;
+        ThrowIfFailed(format->QueryInterface(formatInternal.GetAddressOf()));
+
+        // The format may be changed by another thread while we draw with it
+        auto formatSnapshot = GetTextFormatSnapshot(formatInternal.Get());
+        auto options = static_cast<D2D1_DRAW_TEXT_OPTIONS>(formatSnapshot->DrawTextOptions);
+
+        auto& layoutCache = Manager()->GetTextLayoutCache();
+
+        //
+        // Axis labels repeat a lot ("0", "10", "20"...), so each distinct
+        // string is looked up in the shared layout cache once per batch, and
+        // its layout (and so its shaped glyph runs) reused for every label
+        // that shows it.  The distinct labels are kept in a session-owned
+        // vector, so once it has grown this doesn't allocate.
+        //
+        auto clearBatchLayoutsWarden = MakeScopeWarden([&] { m_textBatchLayouts.clear(); });
+
+        auto findBatchLayout =
+            [&](const wchar_t* label, uint32_t length) -> TextBatchLayout*
+            {
+                for (auto& batchLayout : m_textBatchLayouts)
+                {
+                    if (batchLayout.Length == length && wmemcmp(batchLayout.Label, label, length) == 0)
+                        return &batchLayout;
+                }
+
+                return nullptr;
+            };
+
+        auto sessionTransform = m_isCullingEnabled ? GetCurrentTransform() : D2D1::Matrix3x2F::Identity();
+
+        ID2D1Brush* brush = nullptr;
+        Color brushColor{};
+        int drawCount = 0;
+
+        for (uint32_t i = 0; i < labelCount; ++i)
+        {
+            uint32_t length;
+            auto label = getLabel(i, &length);
+
+            // Empty labels have nothing to draw, so aren't worth laying out.
+            if (length == 0)
+                continue;
+
+            TextBatchLayout newBatchLayout;
+            auto batchLayoutPointer = findBatchLayout(label, length);
+
+            if (!batchLayoutPointer)
+            {
+                newBatchLayout.Label = label;
+                newBatchLayout.Length = length;
+                newBatchLayout.Layout = layoutCache->GetOrCreate(
+                    formatSnapshot->Format.Get(),
+                    formatSnapshot->RealizationId,
+                    label,
+                    length,
+                    0,
+                    0,
+                    true);
+
+                if (m_isCullingEnabled)
+                    newBatchLayout.Bounds = GetTextLayoutBounds(newBatchLayout.Layout.Get(), 0, 0);
+
+                // Past the limit the layout cache is still used, just not
+                // remembered here.
+                if (m_textBatchLayouts.size() < MaxTextBatchLayouts)
+                {
+                    m_textBatchLayouts.push_back(newBatchLayout);
+                    batchLayoutPointer = &m_textBatchLayouts.back();
+                }
+                else
+                {
+                    batchLayoutPointer = &newBatchLayout;
+                }
+            }
+
+            auto& batchLayout = *batchLayoutPointer;
+
+            auto& point = points[i];
+
+            if (m_isCullingEnabled)
+            {
+                auto bounds = D2D1::RectF(
+                    batchLayout.Bounds.left + point.X,
+                    batchLayout.Bounds.top + point.Y,
+                    batchLayout.Bounds.right + point.X,
+                    batchLayout.Bounds.bottom + point.Y);
+
+                if (IsWorldBoundsCulled(TransformBounds(sessionTransform, bounds)))
+                    continue;
+            }
+
+            // The brush is only recolored when the color changes.
+            auto& color = colors[(colorCount == 1) ? 0 : i];
+
+            if (!brush || !IsSameColor(color, brushColor))
+            {
+                brush = GetColorBrush(color);
+                brushColor = color;
+            }
+
+            deviceContext->DrawTextLayout(
+                D2D1::Point2F(point.X, point.Y),
+                batchLayout.Layout.Get(),
+                brush,
+                options);
+
+            ++drawCount;
+        }
+
+        m_statistics.DrawTextCount += drawCount;
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextLayoutWithBrush(
+        ICanvasTextLayout* textLayout,
+        Vector2 point,
+        ICanvasBrush* brush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextLayoutImpl(
+                    textLayout,
+                    point,
+                    ToD2DBrush(brush).Get());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextLayoutWithColor(
+        ICanvasTextLayout* textLayout,
+        Vector2 point,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextLayoutImpl(
+                    textLayout,
+                    point,
+                    GetColorBrush(color));
+            });
+    }
+
+
+    void CanvasDrawingSession::DrawTextLayoutImpl(
+        ICanvasTextLayout* textLayout,
+        const Vector2& point,
+        ID2D1Brush* brush)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(textLayout);
+        CheckInPointer(brush);
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawTextLayout))
+        {
+            trace->WriteResource(textLayout);
+            trace->Write(point);
+            WriteTraceBrush(trace, brush);
+        }
+
+        ComPtr<ICanvasTextLayoutInternal> textLayoutInternal;
+        ThrowIfFailed(textLayout->QueryInterface(textLayoutInternal.GetAddressOf()));
+
+        //
+        // The layout culls its paragraphs individually, so that only the
+        // visible part of a long document is drawn.
+        //
+        std::function<bool(const D2D1_RECT_F&)> isCulled;
+
+        if (m_isCullingEnabled)
+            isCulled = [this](const D2D1_RECT_F& bounds) { return IsCulled(bounds); };
+
+        textLayoutInternal->Draw(
+            deviceContext.Get(),
+            D2D1::Point2F(point.X, point.Y),
+            brush,
+            isCulled);
+
+        ++m_statistics.DrawTextCount;
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextDocumentWithBrush(
+        ICanvasTextDocument* textDocument,
+        Rect viewport,
+        float scrollOffset,
+        ICanvasBrush* brush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextDocumentImpl(
+                    textDocument,
+                    viewport,
+                    scrollOffset,
+                    ToD2DBrush(brush).Get());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawTextDocumentWithColor(
+        ICanvasTextDocument* textDocument,
+        Rect viewport,
+        float scrollOffset,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawTextDocumentImpl(
+                    textDocument,
+                    viewport,
+                    scrollOffset,
+                    GetColorBrush(color));
+            });
+    }
+
+
+    void CanvasDrawingSession::DrawTextDocumentImpl(
+        ICanvasTextDocument* textDocument,
+        const Rect& viewport,
+        float scrollOffset,
+        ID2D1Brush* brush)
+    {
+        auto& deviceContext = GetResourceForDrawing();
+        CheckInPointer(textDocument);
+        CheckInPointer(brush);
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::DrawTextDocument))
+        {
+            trace->WriteResource(textDocument);
+            trace->Write(viewport);
+            trace->Write(scrollOffset);
+            WriteTraceBrush(trace, brush);
+        }
+
+        ComPtr<ICanvasTextDocumentInternal> textDocumentInternal;
+        ThrowIfFailed(textDocument->QueryInterface(textDocumentInternal.GetAddressOf()));
+
+        textDocumentInternal->Draw(
+            deviceContext.Get(),
+            ToD2DRect(viewport),
+            scrollOffset,
+            brush);
+
+        ++m_statistics.DrawTextCount;
+    }
+
+
+    ICanvasTextFormat* CanvasDrawingSession::GetDefaultTextFormat()
+    {
+        if (!m_defaultTextFormat)
+        {
+            m_defaultTextFormat = Make<CanvasTextFormat>();
+            CheckMakeResult(m_defaultTextFormat);
+        }
+
+        return m_defaultTextFormat.Get();
+    }
+
+
+    ID2D1SolidColorBrush* CanvasDrawingSession::GetColorBrush(const Color& color)
+    {
+        m_solidColor = ToD2DColor(color);
+
+        if (m_solidColorBrush)
+        {
+            m_solidColorBrush->SetColor(m_solidColor);
+            ++m_statistics.SetColorCount;
+        }
+        else
+        {
+            // TODO #802: pool and reuse this brush along with the device context?
+            auto& deviceContext = GetResource();
+            ThrowIfFailed(deviceContext->CreateSolidColorBrush(m_solidColor, &m_solidColorBrush));
+        }
+
+        return m_solidColorBrush.Get();
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::get_Antialiasing(CanvasAntialiasing* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+                CheckInPointer(value);
+
+                // Report the mode the app set, not the one we switched to.
+                if (m_isAliasedForPixelAlignment)
+                    *value = CanvasAntialiasing::Antialiased;
+                else
+                    *value = static_cast<CanvasAntialiasing>(deviceContext->GetAntialiasMode());
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::put_Antialiasing(CanvasAntialiasing value)
+	{
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+
+                FlushBatch();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetAntialiasing))
+                    trace->Write(static_cast<int32_t>(value));
+
+                m_isAliasedForPixelAlignment = false;
+
+                deviceContext->SetAntialiasMode(static_cast<D2D1_ANTIALIAS_MODE>(value));
+                ++m_statistics.StateChangeCount;
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::get_Blend(CanvasBlend* value)
+	{
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+                CheckInPointer(value);
+
+                *value = static_cast<CanvasBlend>(deviceContext->GetPrimitiveBlend());
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::put_Blend(CanvasBlend value)
+	{
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+
+                FlushBatch();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetBlend))
+                    trace->Write(static_cast<int32_t>(value));
+
+                deviceContext->SetPrimitiveBlend(static_cast<D2D1_PRIMITIVE_BLEND>(value));
+                ++m_statistics.StateChangeCount;
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::get_TextAntialiasing(CanvasTextAntialiasing* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+                CheckInPointer(value);
+
+                *value = static_cast<CanvasTextAntialiasing>(deviceContext->GetTextAntialiasMode());
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::put_TextAntialiasing(CanvasTextAntialiasing value)
+	{
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+
+                FlushBatch();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetTextAntialiasing))
+                    trace->Write(static_cast<int32_t>(value));
+
+                deviceContext->SetTextAntialiasMode(static_cast<D2D1_TEXT_ANTIALIAS_MODE>(value));
+                ++m_statistics.StateChangeCount;
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::get_Transform(ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+                CheckInPointer(value);
+
+                FlushTransform();
+
+                D2D1_MATRIX_3X2_F transform;
+                deviceContext->GetTransform(&transform);
+                
+                //
+                // Un-apply the offset transform. This could be done with a matrix invert, 
+                // but this is cheaper.
+                //
+                // This polls from the wrapped object, rather than stores a local transform 
+                // member. This ensures that any transforms performed in native interop
+                // will be retrievable here.
+                //
+                const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
+                transform._31 -= renderingSurfaceOffset.x;
+                transform._32 -= renderingSurfaceOffset.y;
+
+                *value = *reinterpret_cast<ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2*>(&transform);
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::put_Transform(ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2 value)
+	{
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+
+                FlushBatch();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetTransform))
+                    trace->Write(value);
+
+                m_isTransformDirty = false;
+
+                D2D1_POINT_2F offset = m_adapter->GetRenderingSurfaceOffset();
+
+                D2D1_MATRIX_3X2_F transform = *(ReinterpretAs<D2D1_MATRIX_3X2_F*>(&value));
+                transform._31 += offset.x;
+                transform._32 += offset.y;
+
+                deviceContext->SetTransform(transform);
+                ++m_statistics.StateChangeCount;
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::get_Units(CanvasUnits* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+                CheckInPointer(value);
+
+                *value = static_cast<CanvasUnits>(deviceContext->GetUnitMode());
+            });
+	}
+
+    IFACEMETHODIMP CanvasDrawingSession::put_Units(CanvasUnits value)
+	{
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& deviceContext = GetResource();
+
+                FlushBatch();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetUnits))
+                    trace->Write(static_cast<int32_t>(value));
+
+                deviceContext->SetUnitMode(static_cast<D2D1_UNIT_MODE>(value));
+                ++m_statistics.StateChangeCount;
+
+                // The target's bounds, and the size of a pixel, depend on
+                // the current units.
+                m_hasTargetBounds = false;
+                m_hasPixelScale = false;
+            });
+    }
+
+    //
+    // Transform stack
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::PushTransform(ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2 transform)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                auto current = GetCurrentTransform();
+                m_transformStack.push_back(current);
+
+                SetPendingTransform(ToD2DMatrix(transform) * current);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PopTransform()
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                if (m_transformStack.empty())
+                    ThrowHR(E_FAIL);
+
+                auto previous = m_transformStack.back();
+                m_transformStack.pop_back();
+
+                SetPendingTransform(previous);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::Translate(float x, float y)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                SetPendingTransform(D2D1::Matrix3x2F::Translation(x, y) * GetCurrentTransform());
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::Scale(float x, float y)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                SetPendingTransform(D2D1::Matrix3x2F::Scale(x, y) * GetCurrentTransform());
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::Rotate(float radians)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                // D2D1::Matrix3x2F::Rotation takes degrees, so we build this
+                // one directly.
+                float sine = sinf(radians);
+                float cosine = cosf(radians);
+                D2D1::Matrix3x2F rotation(cosine, sine, -sine, cosine, 0, 0);
+
+                SetPendingTransform(rotation * GetCurrentTransform());
+            });
+    }
+
+
+    //
+    // Clips and layers
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::PushClipRectangle(Rect clipRectangle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                PushClipOrLayer(false, 1.0f, nullptr, &clipRectangle, nullptr);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PopClip()
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                PopClipOrLayer(false);
+
+                BeginTraceRecord(CanvasTraceOp::PopClip);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PushLayerWithOpacity(float opacity)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                PushClipOrLayer(true, opacity, nullptr, nullptr, nullptr);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PushLayerWithOpacityAndClipRectangle(float opacity, Rect clipRectangle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                PushClipOrLayer(true, opacity, nullptr, &clipRectangle, nullptr);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PushLayerWithOpacityBrush(ICanvasBrush* opacityBrush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(opacityBrush);
+
+                PushClipOrLayer(true, 1.0f, ToD2DBrush(opacityBrush).Get(), nullptr, nullptr);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PushLayerWithOpacityBrushAndClipRectangle(ICanvasBrush* opacityBrush, Rect clipRectangle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(opacityBrush);
+
+                PushClipOrLayer(true, 1.0f, ToD2DBrush(opacityBrush).Get(), &clipRectangle, nullptr);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PushLayerWithOpacityAndClipGeometry(float opacity, ICanvasGeometry* clipGeometry)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(clipGeometry);
+
+                PushClipOrLayer(true, opacity, nullptr, nullptr, clipGeometry);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::PopLayer()
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                PopClipOrLayer(true);
+
+                BeginTraceRecord(CanvasTraceOp::PopLayer);
+            });
+    }
+
+
+    static bool IsAxisPreserving(const D2D1_MATRIX_3X2_F& transform)
+    {
+        return (transform._12 == 0 && transform._21 == 0) ||
+               (transform._11 == 0 && transform._22 == 0);
+    }
+
+
+    static D2D1_RECT_F IntersectBounds(const D2D1_RECT_F& a, const D2D1_RECT_F& b)
+    {
+        return D2D1::RectF(
+            std::max(a.left, b.left),
+            std::max(a.top, b.top),
+            std::min(a.right, b.right),
+            std::min(a.bottom, b.bottom));
+    }
+
+
+    static bool ContainsBounds(const D2D1_RECT_F& outer, const D2D1_RECT_F& inner)
+    {
+        return outer.left <= inner.left &&
+               outer.top <= inner.top &&
+               outer.right >= inner.right &&
+               outer.bottom >= inner.bottom;
+    }
+
+
+    void CanvasDrawingSession::PushClipOrLayer(
+        bool isLayer,
+        float opacity,
+        ID2D1Brush* opacityBrush,
+        const Rect* clipRectangle,
+        ICanvasGeometry* clipGeometry)
+    {
+        // Clips and layers pick up the transform at the time they are pushed.
+        auto& deviceContext = GetResourceForDrawing();
+
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::PushClipOrLayer))
+        {
+            trace->Write<uint8_t>(isLayer ? 1 : 0);
+            trace->Write(opacity);
+            trace->WriteResource(opacityBrush);
+            trace->Write<uint8_t>(clipRectangle ? 1 : 0);
+            trace->Write(clipRectangle ? *clipRectangle : Rect{});
+            trace->WriteResource(clipGeometry);
+        }
+
+        ClipStackEntry entry;
+        entry.IsLayer = isLayer;
+        entry.PushedAxisAlignedClip = false;
+        entry.PushedLayer = false;
+        entry.Bounds = m_clipStack.empty() ? D2D1::InfiniteRect() : m_clipStack.back().Bounds;
+
+        bool needsLayer = (opacity != 1.0f) || (opacityBrush != nullptr);
+
+        ComPtr<ID2D1Geometry> geometricMask;
+
+        if (clipRectangle)
+        {
+            auto d2dRect = ToD2DRect(*clipRectangle);
+            auto& transform = GetCurrentTransform();
+            auto clipBounds = TransformBounds(transform, d2dRect);
+
+            if (IsAxisPreserving(transform))
+            {
+                //
+                // The clip is exactly described by its bounds, so if it
+                // contains the current clip region then it has no effect.
+                // Otherwise PushAxisAlignedClip is much cheaper than a layer.
+                //
+                if (!ContainsBounds(clipBounds, entry.Bounds))
+                {
+                    deviceContext->PushAxisAlignedClip(&d2dRect, deviceContext->GetAntialiasMode());
+                    entry.PushedAxisAlignedClip = true;
+                }
+            }
+            else
+            {
+                ComPtr<ID2D1Factory> factory;
+                deviceContext->GetFactory(&factory);
+
+                ComPtr<ID2D1RectangleGeometry> rectangleGeometry;
+                ThrowIfFailed(factory->CreateRectangleGeometry(&d2dRect, &rectangleGeometry));
+
+                geometricMask = rectangleGeometry;
+                needsLayer = true;
+            }
+
+            entry.Bounds = IntersectBounds(entry.Bounds, clipBounds);
+        }
+
+        if (clipGeometry)
+        {
+            ComPtr<ICanvasGeometryInternal> geometryInternal;
+            ThrowIfFailed(clipGeometry->QueryInterface(geometryInternal.GetAddressOf()));
+
+            geometricMask = geometryInternal->GetD2DGeometry();
+            needsLayer = true;
+
+            auto clipBounds = TransformBounds(GetCurrentTransform(), geometryInternal->GetBounds());
+            entry.Bounds = IntersectBounds(entry.Bounds, clipBounds);
+        }
+
+        if (needsLayer)
+        {
+            //
+            // Passing a null layer lets D2D manage the layer's backing store,
+            // which it pools and reuses across PushLayer calls and frames.
+            //
+            auto parameters = D2D1::LayerParameters1(
+                D2D1::InfiniteRect(),
+                geometricMask.Get(),
+                deviceContext->GetAntialiasMode(),
+                D2D1::IdentityMatrix(),
+                opacity,
+                opacityBrush);
+
+            deviceContext->PushLayer(&parameters, nullptr);
+            entry.PushedLayer = true;
+        }
+
+        m_clipStack.push_back(entry);
+    }
+
+
+    void CanvasDrawingSession::PopClipOrLayer(bool isLayer)
+    {
+        auto& deviceContext = GetResource();
+
+        FlushBatch();
+
+        if (m_clipStack.empty() || m_clipStack.back().IsLayer != isLayer)
+            ThrowHR(E_FAIL);
+
+        auto entry = m_clipStack.back();
+        m_clipStack.pop_back();
+
+        if (entry.PushedLayer)
+            deviceContext->PopLayer();
+
+        if (entry.PushedAxisAlignedClip)
+            deviceContext->PopAxisAlignedClip();
+    }
+
+
+    void CanvasDrawingSession::PopAllClipsAndLayers()
+    {
+        while (!m_clipStack.empty())
+        {
+            PopClipOrLayer(m_clipStack.back().IsLayer);
+        }
+    }
+
+
+    //
+    // Culling
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::get_IsCullingEnabled(boolean* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(value);
+
+                *value = m_isCullingEnabled;
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::put_IsCullingEnabled(boolean value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetCullingEnabled))
+                    trace->Write<uint8_t>(value ? 1 : 0);
+
+                m_isCullingEnabled = !!value;
+                m_hasTargetBounds = false;
+            });
+    }
+
+
+    //
+    // Bounds passed to IsCulled are in user space.  They are transformed to
+    // world space (without the rendering surface offset, as for the clip
+    // stack) and compared against the bounds of the render target and the
+    // current clip.  The test is conservative: it allows an extra unit for
+    // antialiasing and never culls anything with NaN or infinite bounds.
+    //
+    bool CanvasDrawingSession::IsCulled(const D2D1_RECT_F& bounds)
+    {
+        if (!m_isCullingEnabled)
+            return false;
+
+        return IsWorldBoundsCulled(TransformBounds(GetCurrentTransform(), bounds));
+    }
+
+
+    // The bounds are in world space, without the rendering surface offset.
+    bool CanvasDrawingSession::IsWorldBoundsCulled(const D2D1_RECT_F& worldBounds)
+    {
+        auto visibleBounds = GetTargetBounds();
+
+        if (!m_clipStack.empty())
+            visibleBounds = IntersectBounds(visibleBounds, m_clipStack.back().Bounds);
+
+        const float antialiasingMargin = 1.0f;
+
+        bool isCulled =
+            worldBounds.right + antialiasingMargin < visibleBounds.left ||
+            worldBounds.bottom + antialiasingMargin < visibleBounds.top ||
+            worldBounds.left - antialiasingMargin > visibleBounds.right ||
+            worldBounds.top - antialiasingMargin > visibleBounds.bottom;
+
+        if (isCulled)
+            ++m_statistics.CulledDrawCount;
+
+        return isCulled;
+    }
+
+
+    static bool IsStrokeWidthInUserSpace(ICanvasStrokeStyle* strokeStyle)
+    {
+        if (!strokeStyle)
+            return true;
+
+        // Fixed and hairline strokes aren't scaled by the transform, so
+        // their width isn't known in user space.
+        CanvasStrokeTransformBehavior transformBehavior;
+        ThrowIfFailed(strokeStyle->get_TransformBehavior(&transformBehavior));
+
+        return transformBehavior == CanvasStrokeTransformBehavior::Normal;
+    }
+
+
+    bool CanvasDrawingSession::IsStrokeCulled(
+        const D2D1_RECT_F& bounds,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        if (!m_isCullingEnabled || !IsStrokeWidthInUserSpace(strokeStyle))
+            return false;
+
+        //
+        // The 90 degree miter joins of rectangles extend half the stroke
+        // width beyond the bounds.  Lines can be at any angle, though, and
+        // the corner of a square cap on a diagonal line is half the
+        // diagonal of a stroke-width square from the end point, so the
+        // worst case is sqrt(2) / 2 times the stroke width.
+        //
+        const float halfDiagonal = 0.7072f;
+        float inflation = fabs(strokeWidth) * halfDiagonal;
+
+        return IsCulled(D2D1::RectF(
+            bounds.left - inflation,
+            bounds.top - inflation,
+            bounds.right + inflation,
+            bounds.bottom + inflation));
+    }
+
+
+    bool CanvasDrawingSession::IsPathStrokeCulled(
+        const D2D1_RECT_F& bounds,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        if (!m_isCullingEnabled || !IsStrokeWidthInUserSpace(strokeStyle))
+            return false;
+
+        //
+        // Unlike the fixed shapes, a path can have arbitrarily sharp
+        // corners, so miter joins may extend up to half the miter limit
+        // times the stroke width beyond the path's bounds.  This is never
+        // less than the reach of a diagonal square cap, so it covers caps
+        // too and the bounds go straight to IsCulled.
+        //
+        float miterLimit = 10.0f;
+        if (strokeStyle)
+            ThrowIfFailed(strokeStyle->get_MiterLimit(&miterLimit));
+
+        const float halfDiagonal = 0.7072f;
+        float inflation = fabs(strokeWidth) * std::max(miterLimit / 2, halfDiagonal);
+
+        return IsCulled(D2D1::RectF(
+            bounds.left - inflation,
+            bounds.top - inflation,
+            bounds.right + inflation,
+            bounds.bottom + inflation));
+    }
+
+
+    const D2D1_RECT_F& CanvasDrawingSession::GetTargetBounds()
+    {
+        if (!m_hasTargetBounds)
+        {
+            auto& deviceContext = GetResource();
+
+            m_targetBounds = D2D1::InfiniteRect();
+
+            ComPtr<ID2D1Image> target;
+            deviceContext->GetTarget(&target);
+
+            if (target)
+            {
+                ThrowIfFailed(deviceContext->GetImageLocalBounds(target.Get(), &m_targetBounds));
+
+                const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
+                m_targetBounds.left -= renderingSurfaceOffset.x;
+                m_targetBounds.right -= renderingSurfaceOffset.x;
+                m_targetBounds.top -= renderingSurfaceOffset.y;
+                m_targetBounds.bottom -= renderingSurfaceOffset.y;
+            }
+
+            m_hasTargetBounds = true;
+        }
+
+        return m_targetBounds;
+    }
+
+
+    ComPtr<ID2D1StrokeStyle1> CanvasDrawingSession::ToD2DStrokeStyle(ICanvasStrokeStyle* strokeStyle, ID2D1DeviceContext* deviceContext)
+    {
+        if (!strokeStyle) return nullptr;
+
+        ComPtr<ID2D1Factory> d2dBaseFactory;
+        deviceContext->GetFactory(&d2dBaseFactory);
+
+        ComPtr<ID2D1Factory2> d2dFactory;
+        ThrowIfFailed(d2dBaseFactory.As(&d2dFactory));
+
+        ComPtr<ICanvasStrokeStyleInternal> internal;
+        ThrowIfFailed(strokeStyle->QueryInterface(internal.GetAddressOf()));
+
+        bool wasRealized;
+        auto d2dStrokeStyle = internal->GetRealizedD2DStrokeStyle(d2dFactory.Get(), &wasRealized);
+
+        if (wasRealized)
+            ++m_statistics.StrokeStyleRealizationCount;
+
+        return d2dStrokeStyle;
+    }
+
+
+    std::shared_ptr<const TextFormatSnapshot> CanvasDrawingSession::GetTextFormatSnapshot(ICanvasTextFormatInternal* format)
+    {
+        bool wasRealized;
+        auto snapshot = format->GetSnapshot(&wasRealized);
+
+        if (wasRealized)
+            ++m_statistics.TextFormatRealizationCount;
+
+        return snapshot;
+    }
+
+
+    //
+    // While there are no deferred changes the device context holds the
+    // current transform, so we read it back from there.  This keeps the stack
+    // consistent with any transform that was set through native interop.
+    //
+    const D2D1::Matrix3x2F& CanvasDrawingSession::GetCurrentTransform()
+    {
+        if (!m_isTransformDirty)
+        {
+            auto& deviceContext = GetResource();
+
+            D2D1_MATRIX_3X2_F transform;
+            deviceContext->GetTransform(&transform);
+
+            const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
+            transform._31 -= renderingSurfaceOffset.x;
+            transform._32 -= renderingSurfaceOffset.y;
+
+            m_transform = *D2D1::Matrix3x2F::ReinterpretBaseType(&transform);
+            m_appliedTransform = m_transform;
+        }
+
+        return m_transform;
+    }
+
+
+    void CanvasDrawingSession::SetPendingTransform(const D2D1::Matrix3x2F& transform)
+    {
+        if (auto trace = BeginTraceRecord(CanvasTraceOp::SetTransform))
+            trace->Write<D2D1_MATRIX_3X2_F>(transform);
+
+        m_transform = transform;
+        m_isTransformDirty = true;
+    }
+
+
+    void CanvasDrawingSession::FlushTransform()
+    {
+        if (!m_isTransformDirty)
+            return;
+
+        m_isTransformDirty = false;
+
+        // Eg a Push/Pop pair with nothing drawn in between.
+        if (memcmp(&m_transform, &m_appliedTransform, sizeof(m_transform)) == 0)
+            return;
+
+        auto& deviceContext = GetResource();
+
+        // Batched primitives were added under the old transform.
+        FlushBatch();
+
+        const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
+
+        D2D1_MATRIX_3X2_F transform = m_transform;
+        transform._31 += renderingSurfaceOffset.x;
+        transform._32 += renderingSurfaceOffset.y;
+
+        deviceContext->SetTransform(transform);
+        ++m_statistics.StateChangeCount;
+
+        m_appliedTransform = m_transform;
+    }
+
+
+    const ComPtr<ID2D1DeviceContext1>& CanvasDrawingSession::GetResourceForDrawing()
+    {
+        auto& deviceContext = GetResource();
+
+        FlushBatch();
+        FlushTransform();
+        SetAliasedForPixelAlignment(false);
+
+        return deviceContext;
+    }
+
+
+    const ComPtr<ID2D1DeviceContext1>& CanvasDrawingSession::GetResourceForBatchableDrawing()
+    {
+        auto& deviceContext = GetResource();
+
+        FlushTransform();
+
+        return deviceContext;
+    }
+
+
+    ID2D1DeviceContext1* CanvasDrawingSession::TryGetResourceForDirectDrawing() throw()
+    {
+        //
+        // With batching disabled there can be no pending batch, and with
+        // pixel aligned aliasing disabled the antialias mode is the app's.
+        //
+        if (m_isTransformDirty ||
+            m_isCullingEnabled ||
+            m_isBatchingEnabled ||
+            m_isPixelAlignedAliasingEnabled ||
+            m_isTracingEnabled)
+        {
+            return nullptr;
+        }
+
+        return TryGetResource();
+    }
+
+
+    ID2D1SolidColorBrush* CanvasDrawingSession::TryGetColorBrush(const Color& color) throw()
+    {
+        // Creating the brush can fail, so that is left to GetColorBrush.
+        if (!m_solidColorBrush)
+            return nullptr;
+
+        m_solidColor = ToD2DColor(color);
+        m_solidColorBrush->SetColor(m_solidColor);
+        ++m_statistics.SetColorCount;
+
+        return m_solidColorBrush.Get();
+    }
+
+
+    //
+    // Batching
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::get_IsBatchingEnabled(boolean* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(value);
+
+                *value = m_isBatchingEnabled;
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::put_IsBatchingEnabled(boolean value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                if (!value)
+                    FlushBatch();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetBatchingEnabled))
+                    trace->Write<uint8_t>(value ? 1 : 0);
+
+                m_isBatchingEnabled = !!value;
+            });
+    }
+
+
+    //
+    // Pixel aligned aliasing
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::get_IsPixelAlignedAliasingEnabled(boolean* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(value);
+
+                *value = m_isPixelAlignedAliasingEnabled;
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::put_IsPixelAlignedAliasingEnabled(boolean value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                if (auto trace = BeginTraceRecord(CanvasTraceOp::SetPixelAlignedAliasingEnabled))
+                    trace->Write<uint8_t>(value ? 1 : 0);
+
+                if (!value)
+                    SetAliasedForPixelAlignment(false);
+
+                m_isPixelAlignedAliasingEnabled = !!value;
+            });
+    }
+
+
+    //
+    // Edges that are this close to a pixel boundary change the coverage of
+    // the pixels they cross by less than one 8-bit step, so antialiasing
+    // them makes no visible difference.
+    //
+    static const float PixelAlignmentTolerance = 1.0f / 256;
+
+    static bool IsOnPixelBoundary(float position, float scale)
+    {
+        float pixels = position * scale;
+
+        return fabs(pixels - floor(pixels + 0.5f)) <= PixelAlignmentTolerance;
+    }
+
+
+    bool CanvasDrawingSession::IsPixelAligned(const D2D1_RECT_F& rect, float strokeWidth)
+    {
+        if (!m_isPixelAlignedAliasingEnabled)
+            return false;
+
+        //
+        // Only pure translations keep rectangles axis aligned and the same
+        // size.  Whether the translation is a whole number of pixels is
+        // covered by checking where the edges end up.
+        //
+        auto& transform = GetCurrentTransform();
+
+        if (transform._11 != 1 || transform._12 != 0 || transform._21 != 0 || transform._22 != 1)
+            return false;
+
+        const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
+        float offsetX = transform._31 + renderingSurfaceOffset.x;
+        float offsetY = transform._32 + renderingSurfaceOffset.y;
+
+        auto& scale = GetPixelScale();
+
+        //
+        // A stroke is centered on the rectangle's edges, so for it to cover
+        // whole pixels both its inner and outer edges need to be aligned.
+        //
+        float halfStroke = strokeWidth / 2;
+
+        return IsOnPixelBoundary(rect.left + offsetX - halfStroke, scale.width) &&
+               IsOnPixelBoundary(rect.left + offsetX + halfStroke, scale.width) &&
+               IsOnPixelBoundary(rect.right + offsetX - halfStroke, scale.width) &&
+               IsOnPixelBoundary(rect.right + offsetX + halfStroke, scale.width) &&
+               IsOnPixelBoundary(rect.top + offsetY - halfStroke, scale.height) &&
+               IsOnPixelBoundary(rect.top + offsetY + halfStroke, scale.height) &&
+               IsOnPixelBoundary(rect.bottom + offsetY - halfStroke, scale.height) &&
+               IsOnPixelBoundary(rect.bottom + offsetY + halfStroke, scale.height);
+    }
+
+
+    void CanvasDrawingSession::SetAliasedForPixelAlignment(bool isAliased)
+    {
+        if (isAliased == m_isAliasedForPixelAlignment)
+            return;
+
+        auto& deviceContext = GetResource();
+
+        if (isAliased)
+        {
+            // If the app has already chosen aliased drawing there is nothing
+            // to do, and nothing to restore afterwards.
+            if (deviceContext->GetAntialiasMode() != D2D1_ANTIALIAS_MODE_PER_PRIMITIVE)
+                return;
+
+            deviceContext->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+        }
+        else
+        {
+            deviceContext->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+        }
+
+        m_isAliasedForPixelAlignment = isAliased;
+        ++m_statistics.StateChangeCount;
+    }
+
+
+    const D2D1_SIZE_F& CanvasDrawingSession::GetPixelScale()
+    {
+        if (!m_hasPixelScale)
+        {
+            auto& deviceContext = GetResource();
+
+            if (deviceContext->GetUnitMode() == D2D1_UNIT_MODE_PIXELS)
+            {
+                m_pixelScale = D2D1::SizeF(1, 1);
+            }
+            else
+            {
+                float dpiX, dpiY;
+                deviceContext->GetDpi(&dpiX, &dpiY);
+
+                m_pixelScale = D2D1::SizeF(dpiX / DEFAULT_DPI, dpiY / DEFAULT_DPI);
+            }
+
+            m_hasPixelScale = true;
+        }
+
+        return m_pixelScale;
+    }
+
+
+    //
+    // Tracing
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::get_IsTracingEnabled(boolean* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(value);
+
+                *value = m_isTracingEnabled;
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::put_IsTracingEnabled(boolean value)
     {
         return ExceptionBoundary(
             [&]
             {
-                DrawTextAtPointImpl(
-                    text, 
-                    point, 
-                    GetColorBrush(color), 
-                    format);
+                GetResource();
+
+                if (value && !m_isTracingEnabled)
+                    m_trace.reset(new CanvasDrawingSessionTraceWriter());
+
+                //
+                // Disabling tracing keeps what has been recorded so far, so
+                // that it can still be read with GetTrace, but releases the
+                // resources the trace was holding on to.
+                //
+                if (!value && m_trace)
+                    m_trace->ReleaseResources();
+
+                m_isTracingEnabled = !!value;
             });
     }
 
-
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectWithColorAndFormat(
-        HSTRING text,
-        Rect rectangle,
-        Color color,
-        ICanvasTextFormat* format)
+    IFACEMETHODIMP CanvasDrawingSession::GetTrace(
+        uint32_t* valueCount,
+        uint8_t** valueElements)
     {
         return ExceptionBoundary(
             [&]
             {
-                DrawTextAtRectImpl(
-                    text, 
-                    rectangle, 
-                    GetColorBrush(color), 
-                    format);
+                GetResource();
+
+                CheckInPointer(valueCount);
+                CheckAndClearOutPointer(valueElements);
+
+                *valueCount = 0;
+
+                if (!m_trace)
+                    return;
+
+                auto& data = m_trace->GetData();
+
+                auto buffer = static_cast<uint8_t*>(CoTaskMemAlloc(data.size()));
+                ThrowIfNullPointer(buffer, E_OUTOFMEMORY);
+
+                memcpy(buffer, data.data(), data.size());
+
+                *valueCount = static_cast<uint32_t>(data.size());
+                *valueElements = buffer;
             });
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtPointCoordsWithColorAndFormat(
-        HSTRING text,
-        float x,
-        float y,
-        Color color,
-        ICanvasTextFormat* format)
+    CanvasDrawingSessionTraceWriter* CanvasDrawingSession::BeginTraceRecord(CanvasTraceOp op)
     {
-        return DrawTextAtPointWithColorAndFormat(
-            text,
-            Vector2{ x, y },
-            color,
-            format);
+        if (!m_isTracingEnabled)
+            return nullptr;
+
+        m_trace->BeginRecord(op);
+        return m_trace.get();
     }
 
 
-    IFACEMETHODIMP CanvasDrawingSession::DrawTextAtRectCoordsWithColorAndFormat(
-        HSTRING text,
-        float x,
-        float y,
-        float w,
-        float h,
-        Color color,
-        ICanvasTextFormat* format)
+    void CanvasDrawingSession::WriteTraceBrush(CanvasDrawingSessionTraceWriter* trace, ID2D1Brush* brush)
     {
-        return DrawTextAtRectWithColorAndFormat(
-            text,
-            Rect{ x, y, w, h },
-            color,
-            format);
+        //
+        // The Color overloads all draw with m_solidColorBrush, set to
+        // m_solidColor, so those are recorded as the color itself.
+        //
+        bool isSolidColor = brush && (brush == m_solidColorBrush.Get());
+
+        trace->WriteBrush(brush, isSolidColor ? &m_solidColor : nullptr);
     }
 
 
-    void CanvasDrawingSession::DrawTextAtRectImpl(
-        HSTRING text,
-        const Rect& rect,
-        ID2D1Brush* brush,
-        ICanvasTextFormat* format)
+    IFACEMETHODIMP CanvasDrawingSession::GetResource(IUnknown** resource)
     {
-        auto& deviceContext = GetResource();
-        CheckInPointer(brush);
-
-        if (!format)
-        {
-            format = GetDefaultTextFormat();
-        }
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckAndClearOutPointer(resource);
 
-        ComPtr<ICanvasTextFormatInternal> formatInternal;
-        ThrowIfFailed(format->QueryInterface(formatInternal.GetAddressOf()));
+                auto& deviceContext = GetResource();
 
-        uint32_t textLength;
-        auto textBuffer = WindowsGetStringRawBuffer(text, &textLength);
-        ThrowIfNullPointer(textBuffer, E_INVALIDARG);
+                FlushBatch();
+                FlushTransform();
+                SetAliasedForPixelAlignment(false);
 
-        deviceContext->DrawText(
-            textBuffer,
-            textLength,
-            formatInternal->GetRealizedTextFormat().Get(),
-            &ToD2DRect(rect),
-            brush,
-            static_cast<D2D1_DRAW_TEXT_OPTIONS>(formatInternal->GetDrawTextOptions()));
+                ThrowIfFailed(deviceContext.CopyTo(resource));
+            });
     }
 
 
-    void CanvasDrawingSession::DrawTextAtPointImpl(
-        HSTRING text,
-        const Vector2& point,
+    bool CanvasDrawingSession::AddToBatch(
+        BatchType type,
         ID2D1Brush* brush,
-        ICanvasTextFormat* format)
+        float strokeWidth,
+        ID2D1StrokeStyle1* strokeStyle)
     {
-        if (!format)
+        if (!m_isBatchingEnabled)
+            return false;
+
+        D2D1_COLOR_F color;
+        bool isBatchable = TryGetOpaqueColor(brush, &color);
+
+        if (m_batchType != BatchType::None)
         {
-            format = GetDefaultTextFormat();
+            size_t batchSize = m_batchedRectangles.size() + m_batchedEllipses.size() + m_batchedLines.size();
+
+            bool isCompatible = isBatchable &&
+                type == m_batchType &&
+                memcmp(&color, &m_batchColor, sizeof(color)) == 0 &&
+                strokeWidth == m_batchStrokeWidth &&
+                strokeStyle == m_batchStrokeStyle.Get() &&
+                batchSize < MaxBatchSize;
+
+            if (isCompatible)
+                return true;
+
+            FlushBatch();
         }
 
-        // When drawing using just a point we specify a zero sized rectangle and
-        // disable word wrapping.
-        Rect rect{ point.X, point.Y, 0, 0 };
+        if (!isBatchable)
+            return false;
 
         //
-        // TODO #802: there's a thread-safety implication since we're modifying state
-        // on something that _may_ be being used on another thread.
+        // Overlapping primitives in a batch are only blended once, which only
+        // gives the same result as drawing them one by one for these blend
+        // modes.
         //
-        CanvasWordWrapping oldWordWrapping{};
-        ThrowIfFailed(format->get_WordWrapping(&oldWordWrapping));
-
-        ThrowIfFailed(format->put_WordWrapping(CanvasWordWrapping::NoWrap));
+        auto blend = GetResource()->GetPrimitiveBlend();
+        if (blend != D2D1_PRIMITIVE_BLEND_SOURCE_OVER && blend != D2D1_PRIMITIVE_BLEND_COPY)
+            return false;
 
-        auto restoreWordWrapping = MakeScopeWarden(
-            [&]
-        {
-            format->put_WordWrapping(oldWordWrapping);
-        });
+        m_batchType = type;
+        m_batchColor = color;
+        m_batchStrokeWidth = strokeWidth;
+        m_batchStrokeStyle = strokeStyle;
 
-        DrawTextAtRectImpl(text, rect, brush, format);
+        return true;
     }
 
 
-    ICanvasTextFormat* CanvasDrawingSession::GetDefaultTextFormat()
+    bool CanvasDrawingSession::TryGetOpaqueColor(ID2D1Brush* brush, D2D1_COLOR_F* color)
     {
-        if (!m_defaultTextFormat)
+        if (brush == m_solidColorBrush.Get())
         {
-            m_defaultTextFormat = Make<CanvasTextFormat>();
-            CheckMakeResult(m_defaultTextFormat);
+            *color = m_solidColor;
         }
+        else
+        {
+            ComPtr<ID2D1SolidColorBrush> solidColorBrush;
+            if (FAILED(brush->QueryInterface(solidColorBrush.GetAddressOf())))
+                return false;
 
-        return m_defaultTextFormat.Get();
+            if (solidColorBrush->GetOpacity() < 1.0f)
+                return false;
+
+            *color = solidColorBrush->GetColor();
+        }
+
+        return color->a >= 1.0f;
     }
 
 
-    ID2D1SolidColorBrush* CanvasDrawingSession::GetColorBrush(const Color& color)
+    void CanvasDrawingSession::FlushBatch()
     {
-        if (m_solidColorBrush)
+        if (m_batchType == BatchType::None)
+            return;
+
+        auto& deviceContext = GetResource();
+
+        auto batchType = m_batchType;
+        m_batchType = BatchType::None;
+
+        // The batch is only ever drawn once, even if drawing it fails.
+        auto clearWarden = MakeScopeWarden([&] { ClearBatch(); });
+
+        // Batches rely on antialiasing to blend where their primitives meet.
+        SetAliasedForPixelAlignment(false);
+
+        if (m_batchBrush)
         {
-            m_solidColorBrush->SetColor(ToD2DColor(color));
+            m_batchBrush->SetColor(m_batchColor);
         }
         else
         {
-            // TODO #802: pool and reuse this brush along with the device context?
-            auto& deviceContext = GetResource();
-            ThrowIfFailed(deviceContext->CreateSolidColorBrush(ToD2DColor(color), &m_solidColorBrush));
+            ThrowIfFailed(deviceContext->CreateSolidColorBrush(m_batchColor, &m_batchBrush));
         }
 
-        return m_solidColorBrush.Get();
-    }
+        size_t batchSize = m_batchedRectangles.size() + m_batchedEllipses.size() + m_batchedLines.size();
 
+        //
+        // A batch of one is drawn directly; building a geometry would only
+        // make it more expensive.
+        //
+        if (batchSize == 1)
+        {
+            if (!m_batchedRectangles.empty())
+                deviceContext->FillRectangle(&m_batchedRectangles[0], m_batchBrush.Get());
+            else if (!m_batchedEllipses.empty())
+                deviceContext->FillEllipse(&m_batchedEllipses[0], m_batchBrush.Get());
+            else
+                deviceContext->DrawLine(m_batchedLines[0].Point0, m_batchedLines[0].Point1, m_batchBrush.Get(), m_batchStrokeWidth, m_batchStrokeStyle.Get());
+
+            return;
+        }
 
-    IFACEMETHODIMP CanvasDrawingSession::get_Antialiasing(CanvasAntialiasing* value)
-    {
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
-                CheckInPointer(value);
+        ComPtr<ID2D1Factory> factory;
+        deviceContext->GetFactory(&factory);
 
-                *value = static_cast<CanvasAntialiasing>(deviceContext->GetAntialiasMode());
-            });
-	}
+        ComPtr<ID2D1PathGeometry> pathGeometry;
+        ThrowIfFailed(factory->CreatePathGeometry(&pathGeometry));
 
-    IFACEMETHODIMP CanvasDrawingSession::put_Antialiasing(CanvasAntialiasing value)
-	{
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
+        ComPtr<ID2D1GeometrySink> sink;
+        ThrowIfFailed(pathGeometry->Open(&sink));
 
-                deviceContext->SetAntialiasMode(static_cast<D2D1_ANTIALIAS_MODE>(value));
-            });
-	}
+        if (batchType == BatchType::Fill)
+        {
+            //
+            // All the figures go clockwise, so with the winding fill mode
+            // overlapping primitives are filled rather than cancelling out.
+            //
+            sink->SetFillMode(D2D1_FILL_MODE_WINDING);
 
-    IFACEMETHODIMP CanvasDrawingSession::get_Blend(CanvasBlend* value)
-	{
-        return ExceptionBoundary(
-            [&]
+            for (auto& rect : m_batchedRectangles)
             {
-                auto& deviceContext = GetResource();
-                CheckInPointer(value);
+                sink->BeginFigure(D2D1::Point2F(rect.left, rect.top), D2D1_FIGURE_BEGIN_FILLED);
+                sink->AddLine(D2D1::Point2F(rect.right, rect.top));
+                sink->AddLine(D2D1::Point2F(rect.right, rect.bottom));
+                sink->AddLine(D2D1::Point2F(rect.left, rect.bottom));
+                sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+            }
+
+            for (auto& ellipse : m_batchedEllipses)
+            {
+                auto left = D2D1::Point2F(ellipse.point.x - ellipse.radiusX, ellipse.point.y);
+                auto right = D2D1::Point2F(ellipse.point.x + ellipse.radiusX, ellipse.point.y);
+                auto size = D2D1::SizeF(ellipse.radiusX, ellipse.radiusY);
+
+                sink->BeginFigure(left, D2D1_FIGURE_BEGIN_FILLED);
+                sink->AddArc(D2D1::ArcSegment(right, size, 0, D2D1_SWEEP_DIRECTION_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+                sink->AddArc(D2D1::ArcSegment(left, size, 0, D2D1_SWEEP_DIRECTION_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+                sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+            }
+        }
+        else
+        {
+            for (auto& line : m_batchedLines)
+            {
+                sink->BeginFigure(line.Point0, D2D1_FIGURE_BEGIN_HOLLOW);
+                sink->AddLine(line.Point1);
+                sink->EndFigure(D2D1_FIGURE_END_OPEN);
+            }
+        }
 
-                *value = static_cast<CanvasBlend>(deviceContext->GetPrimitiveBlend());
-            });
-	}
+        ThrowIfFailed(sink->Close());
 
-    IFACEMETHODIMP CanvasDrawingSession::put_Blend(CanvasBlend value)
-	{
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
+        if (batchType == BatchType::Fill)
+            deviceContext->FillGeometry(pathGeometry.Get(), m_batchBrush.Get());
+        else
+            deviceContext->DrawGeometry(pathGeometry.Get(), m_batchBrush.Get(), m_batchStrokeWidth, m_batchStrokeStyle.Get());
 
-                deviceContext->SetPrimitiveBlend(static_cast<D2D1_PRIMITIVE_BLEND>(value));
-            });
-	}
+        ++m_statistics.BatchCount;
+    }
 
-    IFACEMETHODIMP CanvasDrawingSession::get_TextAntialiasing(CanvasTextAntialiasing* value)
-    {
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
-                CheckInPointer(value);
 
-                *value = static_cast<CanvasTextAntialiasing>(deviceContext->GetTextAntialiasMode());
-            });
-	}
+    void CanvasDrawingSession::ClearBatch()
+    {
+        // clear() keeps the vectors' capacity for the next batch.
+        m_batchType = BatchType::None;
+        m_batchStrokeStyle.Reset();
+        m_batchedRectangles.clear();
+        m_batchedEllipses.clear();
+        m_batchedLines.clear();
+    }
 
-    IFACEMETHODIMP CanvasDrawingSession::put_TextAntialiasing(CanvasTextAntialiasing value)
-	{
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
 
-                deviceContext->SetTextAntialiasMode(static_cast<D2D1_TEXT_ANTIALIAS_MODE>(value));
-            });
-	}
+    //
+    // ICanvasDrawingSessionStatistics
+    //
+    // Statistics are deliberately still available after the session has been
+    // closed, since that is when the EndDraw time is known.
+    //
 
-    IFACEMETHODIMP CanvasDrawingSession::get_Transform(ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2* value)
+    IFACEMETHODIMP CanvasDrawingSession::get_Statistics(CanvasDrawingSessionStatistics* value)
     {
         return ExceptionBoundary(
             [&]
             {
-                auto& deviceContext = GetResource();
                 CheckInPointer(value);
 
-                D2D1_MATRIX_3X2_F transform;
-                deviceContext->GetTransform(&transform);
-                
-                //
-                // Un-apply the offset transform. This could be done with a matrix invert, 
-                // but this is cheaper.
-                //
-                // This polls from the wrapped object, rather than stores a local transform 
-                // member. This ensures that any transforms performed in native interop
-                // will be retrievable here.
-                //
-                const D2D1_POINT_2F renderingSurfaceOffset = m_adapter->GetRenderingSurfaceOffset();
-                transform._31 -= renderingSurfaceOffset.x;
-                transform._32 -= renderingSurfaceOffset.y;
-
-                *value = *reinterpret_cast<ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2*>(&transform);
+                *value = m_statistics;
             });
-	}
+    }
 
-    IFACEMETHODIMP CanvasDrawingSession::put_Transform(ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2 value)
-	{
+    IFACEMETHODIMP CanvasDrawingSession::ResetStatistics()
+    {
         return ExceptionBoundary(
             [&]
             {
-                auto& deviceContext = GetResource();
-                
-                D2D1_POINT_2F offset = m_adapter->GetRenderingSurfaceOffset();
-
-                D2D1_MATRIX_3X2_F transform = *(ReinterpretAs<D2D1_MATRIX_3X2_F*>(&value));
-                transform._31 += offset.x;
-                transform._32 += offset.y;
-
-                deviceContext->SetTransform(transform);
+                ResetStatisticsImpl();
             });
-	}
+    }
 
-    IFACEMETHODIMP CanvasDrawingSession::get_Units(CanvasUnits* value)
-    {
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
-                CheckInPointer(value);
 
-                *value = static_cast<CanvasUnits>(deviceContext->GetUnitMode());
-            });
-	}
+    void CanvasDrawingSession::ResetStatisticsImpl()
+    {
+        m_statistics = CanvasDrawingSessionStatistics{};
+    }
 
-    IFACEMETHODIMP CanvasDrawingSession::put_Units(CanvasUnits value)
-	{
-        return ExceptionBoundary(
-            [&]
-            {
-                auto& deviceContext = GetResource();
 
-                deviceContext->SetUnitMode(static_cast<D2D1_UNIT_MODE>(value));
-            });
+    void AddStatistics(CanvasDrawingSessionStatistics* total, const CanvasDrawingSessionStatistics& value)
+    {
+        total->ClearCount += value.ClearCount;
+        total->DrawImageCount += value.DrawImageCount;
+        total->DrawSpriteCount += value.DrawSpriteCount;
+        total->DrawLineCount += value.DrawLineCount;
+        total->DrawRectangleCount += value.DrawRectangleCount;
+        total->FillRectangleCount += value.FillRectangleCount;
+        total->DrawRoundedRectangleCount += value.DrawRoundedRectangleCount;
+        total->FillRoundedRectangleCount += value.FillRoundedRectangleCount;
+        total->DrawEllipseCount += value.DrawEllipseCount;
+        total->FillEllipseCount += value.FillEllipseCount;
+        total->DrawGeometryCount += value.DrawGeometryCount;
+        total->FillGeometryCount += value.FillGeometryCount;
+        total->DrawTextCount += value.DrawTextCount;
+        total->CulledDrawCount += value.CulledDrawCount;
+        total->BatchCount += value.BatchCount;
+        total->StateChangeCount += value.StateChangeCount;
+        total->SetColorCount += value.SetColorCount;
+        total->StrokeStyleRealizationCount += value.StrokeStyleRealizationCount;
+        total->TextFormatRealizationCount += value.TextFormatRealizationCount;
+        total->EndDrawDuration.Duration += value.EndDrawDuration.Duration;
     }
 
+
     IFACEMETHODIMP CanvasDrawingSession::get_Device(ICanvasDevice** value)
     {
         using namespace ::Microsoft::WRL::Wrappers;
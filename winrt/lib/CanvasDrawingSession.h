@@ -14,6 +14,8 @@
 
 #include "ClosablePtr.h"
 #include "ErrorHandling.h"
+#include "CanvasDrawingSessionTrace.h"
+#include "CanvasTextLayoutCache.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
@@ -21,6 +23,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     using namespace ABI::Windows::Foundation;
     using namespace ::Microsoft::WRL;
 
+    class ICanvasTextFormatInternal;
+    struct TextFormatSnapshot;
+
     class ICanvasDrawingSessionAdapter
     {
     public:
@@ -29,6 +34,32 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         virtual void EndDraw() = 0;
     };
 
+    //
+    // Allows a drawing session to be recycled from one frame to the next,
+    // rather than being created and destroyed each frame.
+    //
+    [uuid(3A3B9DE0-5D5B-4E1C-9C5C-4E2D1B62E5E6)]
+    class ICanvasDrawingSessionInternal : public IUnknown
+    {
+    public:
+        //
+        // Ends drawing as Close() does, but keeps the session object so that
+        // Reopen() can cheaply bring it back into use.  Until then the
+        // session behaves as if it had been closed, and is unregistered from
+        // the resource manager like a closed one.
+        //
+        virtual void CloseForReuse() = 0;
+
+        //
+        // Begins a new drawing session on deviceContext, which must already
+        // be in BeginDraw.  All per-session state (transform stack, clips,
+        // culling and statistics) starts over.
+        //
+        virtual void Reopen(
+            ID2D1DeviceContext1* deviceContext,
+            std::shared_ptr<ICanvasDrawingSessionAdapter> drawingSessionAdapter) = 0;
+    };
+
     class CanvasDrawingSessionManager;
     class CanvasDrawingSession;
 
@@ -58,7 +89,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     class CanvasDrawingSession : RESOURCE_WRAPPER_RUNTIME_CLASS(
         CanvasDrawingSessionTraits,
-        ICanvasResourceCreator)
+        ICanvasResourceCreator,
+        ICanvasDrawingSessionStatistics,
+        ICanvasDrawingSessionTracing,
+        CloakedIid<ICanvasDrawingSessionInternal>)
     {
         InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasDrawingSession, BaseTrust);
 
@@ -79,6 +113,130 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         //
         ComPtr<ICanvasDevice> m_owner;
 
+        //
+        // Changes made through the transform stack are accumulated here, in
+        // user space (ie without the rendering surface offset), and only pushed
+        // to the device context when something is about to be drawn.  This means that a sequence of
+        // Push/Translate/Rotate/Pop calls between draws costs nothing on the
+        // D2D side.
+        //
+        D2D1::Matrix3x2F m_transform;
+        D2D1::Matrix3x2F m_appliedTransform;
+        bool m_isTransformDirty;
+        std::vector<D2D1::Matrix3x2F> m_transformStack;
+
+        //
+        // Clips and layers share a single stack, since D2D requires that they
+        // are properly nested.  An entry may end up pushing an axis aligned
+        // clip, a layer, both or (if it turns out to be redundant) nothing.
+        //
+        struct ClipStackEntry
+        {
+            bool IsLayer;
+            bool PushedAxisAlignedClip;
+            bool PushedLayer;
+
+            // Conservative bounds of the clip region, in world space without
+            // the rendering surface offset.
+            D2D1_RECT_F Bounds;
+        };
+
+        std::vector<ClipStackEntry> m_clipStack;
+
+        //
+        // When culling is enabled, draw calls whose bounds are entirely
+        // outside the render target or the current clip are dropped.  The
+        // target bounds are looked up on first use.
+        //
+        bool m_isCullingEnabled;
+        bool m_hasTargetBounds;
+        D2D1_RECT_F m_targetBounds;
+
+        //
+        // Stroke style and text format realizations are counted where this
+        // session asks for them, so realizations made by other sessions (or
+        // other threads) sharing the same stroke style or format aren't
+        // included.
+        //
+        CanvasDrawingSessionStatistics m_statistics;
+
+        //
+        // When batching is enabled, runs of FillRectangle and FillEllipse
+        // calls with the same opaque solid color, and runs of DrawLine calls
+        // that also share a stroke width and style, are collected here and
+        // drawn as a single path geometry.  The batch is flushed before
+        // anything else touches the device context, so ordering is
+        // preserved.
+        //
+        // Only opaque colors are batched since overlapping primitives in one
+        // geometry are only blended once.
+        //
+        enum class BatchType { None, Fill, Stroke };
+
+        struct BatchedLine
+        {
+            D2D1_POINT_2F Point0;
+            D2D1_POINT_2F Point1;
+        };
+
+        static const size_t MaxBatchSize = 1024;
+
+        bool m_isBatchingEnabled;
+        BatchType m_batchType;
+        D2D1_COLOR_F m_batchColor;
+        float m_batchStrokeWidth;
+        ComPtr<ID2D1StrokeStyle1> m_batchStrokeStyle;
+        std::vector<D2D1_RECT_F> m_batchedRectangles;
+        std::vector<D2D1_ELLIPSE> m_batchedEllipses;
+        std::vector<BatchedLine> m_batchedLines;
+        ComPtr<ID2D1SolidColorBrush> m_batchBrush;
+
+        // The color most recently set on m_solidColorBrush.
+        D2D1_COLOR_F m_solidColor;
+
+        //
+        // The distinct labels seen so far by the current DrawTextBatch call,
+        // each with its layout.  Labels point into the caller's strings, so
+        // this is emptied before the call returns, but its storage is kept
+        // for the next call.  Only the first MaxTextBatchLayouts distinct
+        // labels are remembered, which keeps the linear search cheap.
+        //
+        struct TextBatchLayout
+        {
+            const wchar_t* Label;
+            uint32_t Length;
+            ComPtr<IDWriteTextLayout> Layout;
+            D2D1_RECT_F Bounds;     // relative to the label's point
+        };
+
+        static const size_t MaxTextBatchLayouts = 64;
+
+        std::vector<TextBatchLayout> m_textBatchLayouts;
+
+        //
+        // When pixel aligned aliasing is enabled, FillRectangle and
+        // DrawRectangle calls whose edges land exactly on pixel boundaries
+        // are drawn with aliased antialiasing, which is cheaper and looks
+        // the same.  The device context is left aliased for as long as
+        // consecutive calls qualify, and switched back before anything else
+        // is drawn, so runs of aligned rectangles only change the mode
+        // twice.
+        //
+        // The scale from DIPs to pixels is looked up on first use.
+        //
+        bool m_isPixelAlignedAliasingEnabled;
+        bool m_isAliasedForPixelAlignment;
+        bool m_hasPixelScale;
+        D2D1_SIZE_F m_pixelScale;
+
+        //
+        // When tracing is enabled each call is appended to m_trace.  The
+        // trace is kept when tracing is disabled, so it can be retrieved
+        // afterwards, and replaced when tracing is next enabled.
+        //
+        bool m_isTracingEnabled;
+        std::unique_ptr<CanvasDrawingSessionTraceWriter> m_trace;
+
     public:
         CanvasDrawingSession(
             std::shared_ptr<CanvasDrawingSessionManager> manager,
@@ -113,6 +271,28 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHOD(DrawImageAtOrigin)(
             ICanvasImage* image) override;
 
+        //
+        // DrawSprites
+        //
+
+        IFACEMETHOD(DrawSprites)(
+            ICanvasBitmap* bitmap,
+            uint32_t destinationRectCount,
+            ABI::Windows::Foundation::Rect* destinationRects,
+            uint32_t sourceRectCount,
+            ABI::Windows::Foundation::Rect* sourceRects,
+            uint32_t opacityCount,
+            float* opacities) override;
+
+        IFACEMETHOD(DrawSpritesWithTransforms)(
+            ICanvasBitmap* bitmap,
+            uint32_t transformCount,
+            ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2* transforms,
+            uint32_t sourceRectCount,
+            ABI::Windows::Foundation::Rect* sourceRects,
+            uint32_t opacityCount,
+            float* opacities) override;
+
         //
         // DrawLine
         //
@@ -711,6 +891,164 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             float radius,
             ABI::Windows::UI::Color color) override;
 
+        //
+        // DrawGeometry
+        //
+
+        // 0 additional parameters
+
+        IFACEMETHOD(DrawGeometryWithBrush)(
+            ICanvasGeometry* geometry,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawGeometryWithColor)(
+            ICanvasGeometry* geometry,
+            ABI::Windows::UI::Color color) override;
+
+        // 1 additional parameter (StrokeWidth)
+
+        IFACEMETHOD(DrawGeometryWithBrushAndStrokeWidth)(
+            ICanvasGeometry* geometry,
+            ICanvasBrush* brush,
+            float strokeWidth) override;
+
+        IFACEMETHOD(DrawGeometryWithColorAndStrokeWidth)(
+            ICanvasGeometry* geometry,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        // 2 additional parameters (StrokeWidth, StrokeStyle)
+
+        IFACEMETHOD(DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle)(
+            ICanvasGeometry* geometry,
+            ICanvasBrush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawGeometryWithColorAndStrokeWidthAndStrokeStyle)(
+            ICanvasGeometry* geometry,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        //
+        // FillGeometry
+        //
+
+        IFACEMETHOD(FillGeometryWithBrush)(
+            ICanvasGeometry* geometry,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(FillGeometryWithColor)(
+            ICanvasGeometry* geometry,
+            ABI::Windows::UI::Color color) override;
+
+        //
+        // DrawPolyline
+        //
+
+        // 0 additional parameters
+
+        IFACEMETHOD(DrawPolylineWithBrush)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawPolylineWithColor)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color) override;
+
+        // 1 additional parameter (StrokeWidth)
+
+        IFACEMETHOD(DrawPolylineWithBrushAndStrokeWidth)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth) override;
+
+        IFACEMETHOD(DrawPolylineWithColorAndStrokeWidth)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        // 2 additional parameters (StrokeWidth, StrokeStyle)
+
+        IFACEMETHOD(DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawPolylineWithColorAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        //
+        // DrawPolygon
+        //
+
+        // 0 additional parameters
+
+        IFACEMETHOD(DrawPolygonWithBrush)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawPolygonWithColor)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color) override;
+
+        // 1 additional parameter (StrokeWidth)
+
+        IFACEMETHOD(DrawPolygonWithBrushAndStrokeWidth)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth) override;
+
+        IFACEMETHOD(DrawPolygonWithColorAndStrokeWidth)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        // 2 additional parameters (StrokeWidth, StrokeStyle)
+
+        IFACEMETHOD(DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawPolygonWithColorAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        //
+        // FillPolygon
+        //
+
+        IFACEMETHOD(FillPolygonWithBrush)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(FillPolygonWithColor)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color) override;
+
         //
         // DrawText
         //
@@ -786,6 +1124,59 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             ABI::Windows::UI::Color color,
             ICanvasTextFormat* format) override;
 
+        //
+        // DrawTextBatch
+        //
+
+        IFACEMETHOD(DrawTextBatch)(
+            uint32_t textCount,
+            HSTRING* text,
+            uint32_t pointCount,
+            Vector2* points,
+            uint32_t colorCount,
+            ABI::Windows::UI::Color* colors,
+            ICanvasTextFormat* format) override;
+
+        IFACEMETHOD(DrawTextBatchFromBuffer)(
+            HSTRING text,
+            uint32_t offsetCount,
+            int32_t* offsets,
+            uint32_t pointCount,
+            Vector2* points,
+            uint32_t colorCount,
+            ABI::Windows::UI::Color* colors,
+            ICanvasTextFormat* format) override;
+
+        //
+        // DrawTextLayout
+        //
+
+        IFACEMETHOD(DrawTextLayoutWithBrush)(
+            ICanvasTextLayout* textLayout,
+            Vector2 point,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawTextLayoutWithColor)(
+            ICanvasTextLayout* textLayout,
+            Vector2 point,
+            ABI::Windows::UI::Color color) override;
+
+        //
+        // DrawTextDocument
+        //
+
+        IFACEMETHOD(DrawTextDocumentWithBrush)(
+            ICanvasTextDocument* textDocument,
+            ABI::Windows::Foundation::Rect viewport,
+            float scrollOffset,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawTextDocumentWithColor)(
+            ICanvasTextDocument* textDocument,
+            ABI::Windows::Foundation::Rect viewport,
+            float scrollOffset,
+            ABI::Windows::UI::Color color) override;
+
         //
         // State properties
         //
@@ -805,13 +1196,110 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHOD(get_Units)(CanvasUnits* value);
         IFACEMETHOD(put_Units)(CanvasUnits value);
 
+        //
+        // Transform stack
+        //
+
+        IFACEMETHOD(PushTransform)(ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2 transform) override;
+        IFACEMETHOD(PopTransform)() override;
+        IFACEMETHOD(Translate)(float x, float y) override;
+        IFACEMETHOD(Scale)(float x, float y) override;
+        IFACEMETHOD(Rotate)(float radians) override;
+
+        //
+        // Clips and layers
+        //
+
+        IFACEMETHOD(PushClipRectangle)(ABI::Windows::Foundation::Rect clipRectangle) override;
+        IFACEMETHOD(PopClip)() override;
+
+        IFACEMETHOD(PushLayerWithOpacity)(float opacity) override;
+        IFACEMETHOD(PushLayerWithOpacityAndClipRectangle)(float opacity, ABI::Windows::Foundation::Rect clipRectangle) override;
+        IFACEMETHOD(PushLayerWithOpacityBrush)(ICanvasBrush* opacityBrush) override;
+        IFACEMETHOD(PushLayerWithOpacityBrushAndClipRectangle)(ICanvasBrush* opacityBrush, ABI::Windows::Foundation::Rect clipRectangle) override;
+        IFACEMETHOD(PushLayerWithOpacityAndClipGeometry)(float opacity, ICanvasGeometry* clipGeometry) override;
+        IFACEMETHOD(PopLayer)() override;
+
+        //
+        // Culling
+        //
+
+        IFACEMETHOD(get_IsCullingEnabled)(boolean* value) override;
+        IFACEMETHOD(put_IsCullingEnabled)(boolean value) override;
+
+        //
+        // Batching
+        //
+
+        IFACEMETHOD(get_IsBatchingEnabled)(boolean* value) override;
+        IFACEMETHOD(put_IsBatchingEnabled)(boolean value) override;
+
+        //
+        // Pixel aligned aliasing
+        //
+
+        IFACEMETHOD(get_IsPixelAlignedAliasingEnabled)(boolean* value) override;
+        IFACEMETHOD(put_IsPixelAlignedAliasingEnabled)(boolean value) override;
+
         //
         // ICanvasResourceCreator
         //
 
         IFACEMETHODIMP get_Device(ICanvasDevice** value);
 
+        //
+        // ICanvasDrawingSessionStatistics
+        //
+
+        IFACEMETHOD(get_Statistics)(CanvasDrawingSessionStatistics* value) override;
+        IFACEMETHOD(ResetStatistics)() override;
+
+        //
+        // ICanvasDrawingSessionTracing
+        //
+
+        IFACEMETHOD(get_IsTracingEnabled)(boolean* value) override;
+        IFACEMETHOD(put_IsTracingEnabled)(boolean value) override;
+
+        IFACEMETHOD(GetTrace)(
+            uint32_t* valueCount,
+            uint8_t** valueElements) override;
+
+        //
+        // ICanvasDrawingSessionInternal
+        //
+
+        virtual void CloseForReuse() override;
+
+        virtual void Reopen(
+            ID2D1DeviceContext1* deviceContext,
+            std::shared_ptr<ICanvasDrawingSessionAdapter> drawingSessionAdapter) override;
+
+        //
+        // ICanvasResourceWrapperNative
+        //
+        // Overridden so that any pending batch is drawn before the app
+        // draws to the device context directly.
+        //
+
+        using ResourceWrapper::GetResource;
+
+        IFACEMETHOD(GetResource)(IUnknown** resource) override;
+
     private:
+        void PrepareToClose();
+        void EndDraw();
+
+        void DrawSpritesImpl(
+            ICanvasBitmap* bitmap,
+            uint32_t spriteCount,
+            const ABI::Windows::Foundation::Rect* destinationRects,
+            const D2D1_MATRIX_3X2_F* transforms,
+            uint32_t sourceRectCount,
+            const ABI::Windows::Foundation::Rect* sourceRects,
+            uint32_t opacityCount,
+            const float* opacities);
+
         void DrawLineImpl(
             const Vector2& p0,
             const Vector2& p1,
@@ -857,31 +1345,191 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             float radiusY,
             ID2D1Brush* brush);
 
+        void DrawGeometryImpl(
+            ICanvasGeometry* geometry,
+            ID2D1Brush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle);
+
+        void FillGeometryImpl(
+            ICanvasGeometry* geometry,
+            ID2D1Brush* brush);
+
+        void DrawPolygonImpl(
+            uint32_t pointCount,
+            const Vector2* points,
+            D2D1_FIGURE_END figureEnd,
+            ID2D1Brush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle);
+
+        void FillPolygonImpl(
+            uint32_t pointCount,
+            const Vector2* points,
+            ID2D1Brush* brush);
+
+        ComPtr<ID2D1PathGeometry> CreatePathFromPoints(
+            ID2D1DeviceContext1* deviceContext,
+            uint32_t pointCount,
+            const Vector2* points,
+            D2D1_FIGURE_BEGIN figureBegin,
+            D2D1_FIGURE_END figureEnd);
+
         void DrawTextAtRectImpl(
             HSTRING text,
             const Rect& rect,
             ID2D1Brush* brush,
             ICanvasTextFormat* format);
 
+        void DrawTextImpl(
+            HSTRING text,
+            const Rect& rect,
+            ID2D1Brush* brush,
+            ICanvasTextFormat* format,
+            bool noWrap);
+
         void DrawTextAtPointImpl(
             HSTRING text,
             const Vector2& point,
             ID2D1Brush* brush,
             ICanvasTextFormat* format);
 
+        void DrawTextBatchImpl(
+            uint32_t labelCount,
+            const HSTRING* texts,
+            HSTRING buffer,
+            const int32_t* offsets,
+            uint32_t pointCount,
+            const Vector2* points,
+            uint32_t colorCount,
+            const ABI::Windows::UI::Color* colors,
+            ICanvasTextFormat* format);
+
+        void DrawTextLayoutImpl(
+            ICanvasTextLayout* textLayout,
+            const Vector2& point,
+            ID2D1Brush* brush);
+
+        void DrawTextDocumentImpl(
+            ICanvasTextDocument* textDocument,
+            const ABI::Windows::Foundation::Rect& viewport,
+            float scrollOffset,
+            ID2D1Brush* brush);
+
         ICanvasTextFormat* GetDefaultTextFormat();
 
         ID2D1SolidColorBrush* GetColorBrush(const ABI::Windows::UI::Color& color);
+
+        ComPtr<ID2D1StrokeStyle1> ToD2DStrokeStyle(ICanvasStrokeStyle* strokeStyle, ID2D1DeviceContext* deviceContext);
+        std::shared_ptr<const TextFormatSnapshot> GetTextFormatSnapshot(ICanvasTextFormatInternal* format);
+
+        const D2D1::Matrix3x2F& GetCurrentTransform();
+        void SetPendingTransform(const D2D1::Matrix3x2F& transform);
+        void FlushTransform();
+
+        void PushClipOrLayer(
+            bool isLayer,
+            float opacity,
+            ID2D1Brush* opacityBrush,
+            const ABI::Windows::Foundation::Rect* clipRectangle,
+            ICanvasGeometry* clipGeometry);
+
+        void PopClipOrLayer(bool isLayer);
+        void PopAllClipsAndLayers();
+
+        bool IsCulled(const D2D1_RECT_F& bounds);
+        bool IsWorldBoundsCulled(const D2D1_RECT_F& worldBounds);
+        bool IsStrokeCulled(const D2D1_RECT_F& bounds, float strokeWidth, ICanvasStrokeStyle* strokeStyle);
+        bool IsPathStrokeCulled(const D2D1_RECT_F& bounds, float strokeWidth, ICanvasStrokeStyle* strokeStyle);
+        const D2D1_RECT_F& GetTargetBounds();
+
+        void ResetStatisticsImpl();
+
+        //
+        // Returns the device context after bringing it up to date with any
+        // deferred state.  Methods that draw should use this rather than
+        // GetResource.
+        //
+        const ComPtr<ID2D1DeviceContext1>& GetResourceForDrawing();
+
+        //
+        // As GetResourceForDrawing, but leaves any pending batch, and the
+        // antialias mode set for pixel aligned rectangles, alone.  Only
+        // methods that can add to the batch or draw rectangles should use
+        // this.  Before drawing anything they must call AddToBatch or
+        // FlushBatch, and then SetAliasedForPixelAlignment.
+        //
+        const ComPtr<ID2D1DeviceContext1>& GetResourceForBatchableDrawing();
+
+        //
+        // The hottest draw calls (the Color overloads of DrawLine,
+        // DrawRectangle, FillRectangle and FillEllipse) first try a direct
+        // path that never throws, so it can skip the ExceptionBoundary and
+        // the general Impl functions.  It only applies while the session is
+        // open, has no deferred transform, and has culling, batching, pixel
+        // aligned aliasing and tracing all disabled.  Otherwise, or if
+        // anything needs validating or creating, these return null and the
+        // call takes the general path, which reports any errors.
+        //
+        ID2D1DeviceContext1* TryGetResourceForDirectDrawing() throw();
+        ID2D1SolidColorBrush* TryGetColorBrush(const ABI::Windows::UI::Color& color) throw();
+
+        //
+        // Returns true if rect, stroked with strokeWidth (or filled, if
+        // strokeWidth is zero), covers only whole pixels under the current
+        // transform, so that drawing it aliased gives the same result.
+        //
+        bool IsPixelAligned(const D2D1_RECT_F& rect, float strokeWidth);
+
+        void SetAliasedForPixelAlignment(bool isAliased);
+
+        const D2D1_SIZE_F& GetPixelScale();
+
+        //
+        // Returns true if the primitive should be added to the batch (whose
+        // type and parameters have been set up to match).  Otherwise the
+        // caller draws it directly, after any pending batch has been flushed.
+        //
+        bool AddToBatch(
+            BatchType type,
+            ID2D1Brush* brush,
+            float strokeWidth,
+            ID2D1StrokeStyle1* strokeStyle);
+
+        bool TryGetOpaqueColor(ID2D1Brush* brush, D2D1_COLOR_F* color);
+
+        void FlushBatch();
+        void ClearBatch();
+
+        //
+        // Returns the trace writer, with a record for op started, or null if
+        // tracing is disabled.  The caller then writes the call's arguments.
+        //
+        CanvasDrawingSessionTraceWriter* BeginTraceRecord(CanvasTraceOp op);
+
+        void WriteTraceBrush(CanvasDrawingSessionTraceWriter* trace, ID2D1Brush* brush);
     };
 
 
+    void AddStatistics(CanvasDrawingSessionStatistics* total, const CanvasDrawingSessionStatistics& value);
+
+
     class CanvasDrawingSessionManager : public ResourceManager<CanvasDrawingSessionTraits>
     {
         std::shared_ptr<ICanvasDrawingSessionAdapter> m_adapter;
 
+        //
+        // Text layouts are device independent, so all drawing sessions share
+        // the same cache.  This lets layouts survive from one frame's drawing
+        // session to the next.
+        //
+        std::shared_ptr<CanvasTextLayoutCache> m_textLayoutCache;
+
     public:
         CanvasDrawingSessionManager();
 
+        const std::shared_ptr<CanvasTextLayoutCache>& GetTextLayoutCache();
+
         ComPtr<CanvasDrawingSession> CreateNew(
             ICanvasDevice* owner,
             ID2D1DeviceContext1* deviceContext,
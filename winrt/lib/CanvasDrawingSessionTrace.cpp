@@ -0,0 +1,763 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasDrawingSessionTrace.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using ABI::Windows::Foundation::Rect;
+    using ABI::Windows::UI::Color;
+    using Numerics::Vector2;
+
+    //
+    // CanvasDrawingSessionTraceWriter
+    //
+
+    CanvasDrawingSessionTraceWriter::CanvasDrawingSessionTraceWriter()
+    {
+        QueryPerformanceFrequency(&m_frequency);
+        QueryPerformanceCounter(&m_lastRecordTime);
+
+        CanvasTraceHeader header;
+        header.Magic = CanvasTraceHeader::ExpectedMagic;
+        header.Version = CanvasTraceHeader::CurrentVersion;
+        Write(header);
+    }
+
+
+    void CanvasDrawingSessionTraceWriter::BeginRecord(CanvasTraceOp op)
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+
+        auto microseconds = (now.QuadPart - m_lastRecordTime.QuadPart) * 1000000 / m_frequency.QuadPart;
+        m_lastRecordTime = now;
+
+        Write(op);
+        Write(static_cast<uint32_t>(std::min<int64_t>(microseconds, UINT32_MAX)));
+    }
+
+
+    void CanvasDrawingSessionTraceWriter::WriteString(HSTRING value)
+    {
+        uint32_t length;
+        auto buffer = WindowsGetStringRawBuffer(value, &length);
+
+        WriteArray(length, buffer);
+    }
+
+
+    void CanvasDrawingSessionTraceWriter::WriteResource(IUnknown* resource)
+    {
+        uint32_t id = 0;
+
+        if (resource)
+        {
+            // Different interface pointers on the same object must map to
+            // the same id.
+            ComPtr<IUnknown> identity;
+            ThrowIfFailed(resource->QueryInterface(identity.GetAddressOf()));
+
+            auto it = m_resourceIds.find(identity.Get());
+
+            if (it != m_resourceIds.end())
+            {
+                id = it->second;
+            }
+            else
+            {
+                id = static_cast<uint32_t>(m_resources.size() + 1);
+                m_resourceIds.insert(std::make_pair(identity.Get(), id));
+                m_resources.push_back(identity);
+            }
+        }
+
+        Write(id);
+    }
+
+
+    void CanvasDrawingSessionTraceWriter::WriteBrush(ID2D1Brush* brush, const D2D1_COLOR_F* color)
+    {
+        if (color)
+        {
+            Write(CanvasTraceBrushType::Color);
+            Write(ToWindowsColor(*color));
+        }
+        else
+        {
+            Write(CanvasTraceBrushType::Resource);
+            WriteResource(brush);
+        }
+    }
+
+
+    const std::vector<uint8_t>& CanvasDrawingSessionTraceWriter::GetData() const
+    {
+        return m_data;
+    }
+
+
+    void CanvasDrawingSessionTraceWriter::ReleaseResources()
+    {
+        m_resourceIds.clear();
+        m_resources.clear();
+    }
+
+
+    void CanvasDrawingSessionTraceWriter::WriteBytes(const void* bytes, size_t size)
+    {
+        auto begin = static_cast<const uint8_t*>(bytes);
+
+        m_data.insert(m_data.end(), begin, begin + size);
+    }
+
+
+    //
+    // CanvasDrawingSessionTraceReplayer
+    //
+
+    class CanvasDrawingSessionTraceReplayer::Reader
+    {
+        const uint8_t* m_position;
+        const uint8_t* m_end;
+
+    public:
+        Reader(const std::vector<uint8_t>& data)
+            : m_position(data.empty() ? nullptr : &data[0])
+            , m_end(m_position + data.size())
+        {
+        }
+
+        bool IsAtEnd() const
+        {
+            return m_position == m_end;
+        }
+
+        template<typename T>
+        T Read()
+        {
+            T value;
+            ReadBytes(&value, sizeof(value));
+            return value;
+        }
+
+        template<typename T>
+        std::vector<T> ReadArray()
+        {
+            auto count = Read<uint32_t>();
+
+            if (count > static_cast<size_t>(m_end - m_position) / sizeof(T))
+                ThrowHR(E_INVALIDARG);
+
+            std::vector<T> values(count);
+
+            if (count)
+                ReadBytes(&values[0], count * sizeof(T));
+
+            return values;
+        }
+
+        WinString ReadString()
+        {
+            auto characters = ReadArray<wchar_t>();
+
+            WinString value;
+            ThrowIfFailed(WindowsCreateString(
+                characters.empty() ? nullptr : &characters[0],
+                static_cast<uint32_t>(characters.size()),
+                value.GetAddressOf()));
+
+            return value;
+        }
+
+    private:
+        void ReadBytes(void* destination, size_t size)
+        {
+            if (size > static_cast<size_t>(m_end - m_position))
+                ThrowHR(E_INVALIDARG);
+
+            memcpy(destination, m_position, size);
+            m_position += size;
+        }
+    };
+
+
+    CanvasDrawingSessionTraceReplayer::CanvasDrawingSessionTraceReplayer(
+        std::vector<uint8_t> trace,
+        ResourceResolver resolver)
+        : m_trace(std::move(trace))
+        , m_resolver(resolver)
+    {
+        memset(m_costs, 0, sizeof(m_costs));
+    }
+
+
+    void CanvasDrawingSessionTraceReplayer::Replay(ICanvasDrawingSession* drawingSession)
+    {
+        CheckInPointer(drawingSession);
+
+        Reader reader(m_trace);
+
+        auto header = reader.Read<CanvasTraceHeader>();
+
+        if (header.Magic != CanvasTraceHeader::ExpectedMagic ||
+            header.Version != CanvasTraceHeader::CurrentVersion)
+        {
+            ThrowHR(E_INVALIDARG);
+        }
+
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        CallCost* previousCost = nullptr;
+
+        while (!reader.IsAtEnd())
+        {
+            auto op = reader.Read<CanvasTraceOp>();
+
+            if (op == static_cast<CanvasTraceOp>(0) || op >= CanvasTraceOp::Count)
+                ThrowHR(E_INVALIDARG);
+
+            auto microsecondsSincePreviousCall = reader.Read<uint32_t>();
+
+            if (previousCost)
+                previousCost->RecordedDuration += static_cast<int64_t>(microsecondsSincePreviousCall) * 10;
+
+            auto& cost = m_costs[static_cast<size_t>(op)];
+            previousCost = &cost;
+
+            LARGE_INTEGER start;
+            QueryPerformanceCounter(&start);
+
+            bool skipped = false;
+            HRESULT hr = ReplayRecord(op, reader, drawingSession, &skipped);
+
+            LARGE_INTEGER end;
+            QueryPerformanceCounter(&end);
+
+            if (skipped)
+            {
+                ++cost.SkippedCount;
+                continue;
+            }
+
+            ++cost.CallCount;
+            cost.ReplayDuration += (end.QuadPart - start.QuadPart) * 10000000 / frequency.QuadPart;
+
+            if (FAILED(hr))
+                ++cost.FailedCount;
+        }
+    }
+
+
+    const CanvasDrawingSessionTraceReplayer::CallCost& CanvasDrawingSessionTraceReplayer::GetCost(CanvasTraceOp op) const
+    {
+        if (op >= CanvasTraceOp::Count)
+            ThrowHR(E_INVALIDARG);
+
+        return m_costs[static_cast<size_t>(op)];
+    }
+
+
+    const wchar_t* CanvasDrawingSessionTraceReplayer::GetName(CanvasTraceOp op)
+    {
+        switch (op)
+        {
+        case CanvasTraceOp::Clear:                  return L"Clear";
+        case CanvasTraceOp::DrawImage:              return L"DrawImage";
+        case CanvasTraceOp::DrawSprites:            return L"DrawSprites";
+        case CanvasTraceOp::DrawLine:               return L"DrawLine";
+        case CanvasTraceOp::DrawRectangle:          return L"DrawRectangle";
+        case CanvasTraceOp::FillRectangle:          return L"FillRectangle";
+        case CanvasTraceOp::DrawRoundedRectangle:   return L"DrawRoundedRectangle";
+        case CanvasTraceOp::FillRoundedRectangle:   return L"FillRoundedRectangle";
+        case CanvasTraceOp::DrawEllipse:            return L"DrawEllipse";
+        case CanvasTraceOp::FillEllipse:            return L"FillEllipse";
+        case CanvasTraceOp::DrawGeometry:           return L"DrawGeometry";
+        case CanvasTraceOp::FillGeometry:           return L"FillGeometry";
+        case CanvasTraceOp::DrawPolyline:           return L"DrawPolyline";
+        case CanvasTraceOp::DrawPolygon:            return L"DrawPolygon";
+        case CanvasTraceOp::FillPolygon:            return L"FillPolygon";
+        case CanvasTraceOp::DrawText:               return L"DrawText";
+        case CanvasTraceOp::SetAntialiasing:        return L"Antialiasing";
+        case CanvasTraceOp::SetBlend:               return L"Blend";
+        case CanvasTraceOp::SetTextAntialiasing:    return L"TextAntialiasing";
+        case CanvasTraceOp::SetUnits:               return L"Units";
+        case CanvasTraceOp::SetTransform:           return L"Transform";
+        case CanvasTraceOp::PushClipOrLayer:        return L"PushClipOrLayer";
+        case CanvasTraceOp::PopClip:                return L"PopClip";
+        case CanvasTraceOp::PopLayer:               return L"PopLayer";
+        case CanvasTraceOp::SetCullingEnabled:      return L"IsCullingEnabled";
+        case CanvasTraceOp::SetBatchingEnabled:     return L"IsBatchingEnabled";
+        case CanvasTraceOp::SetPixelAlignedAliasingEnabled: return L"IsPixelAlignedAliasingEnabled";
+        case CanvasTraceOp::DrawTextLayout:         return L"DrawTextLayout";
+        case CanvasTraceOp::DrawTextDocument:       return L"DrawTextDocument";
+        case CanvasTraceOp::DrawTextBatch:          return L"DrawTextBatch";
+        default:                                    return L"Unknown";
+        }
+    }
+
+
+    template<typename T>
+    ComPtr<T> CanvasDrawingSessionTraceReplayer::Resolve(CanvasTraceResourceKind kind, uint32_t id)
+    {
+        if (id == 0 || !m_resolver)
+            return nullptr;
+
+        auto resource = m_resolver(kind, id);
+
+        ComPtr<T> result;
+        if (resource)
+            ThrowIfFailed(resource.As(&result));
+
+        return result;
+    }
+
+
+    //
+    // Either a color or a brush, ready to pass to the matching overload.
+    //
+    struct ReplayBrush
+    {
+        bool IsColor;
+        Color SolidColor;
+        ComPtr<ICanvasBrush> Brush;
+    };
+
+
+    HRESULT CanvasDrawingSessionTraceReplayer::ReplayRecord(
+        CanvasTraceOp op,
+        Reader& reader,
+        ICanvasDrawingSession* ds,
+        bool* skipped)
+    {
+        auto readBrush =
+            [&]
+            {
+                ReplayBrush brush;
+                brush.IsColor = true;
+                brush.SolidColor = Color{ 255, 0, 0, 0 };
+
+                if (reader.Read<CanvasTraceBrushType>() == CanvasTraceBrushType::Color)
+                {
+                    brush.SolidColor = reader.Read<Color>();
+                }
+                else
+                {
+                    brush.Brush = Resolve<ICanvasBrush>(CanvasTraceResourceKind::Brush, reader.Read<uint32_t>());
+                    brush.IsColor = !brush.Brush;
+                }
+
+                return brush;
+            };
+
+        auto readStrokeStyle =
+            [&]
+            {
+                return Resolve<ICanvasStrokeStyle>(CanvasTraceResourceKind::StrokeStyle, reader.Read<uint32_t>());
+            };
+
+        switch (op)
+        {
+        case CanvasTraceOp::Clear:
+            return ds->Clear(reader.Read<Color>());
+
+        case CanvasTraceOp::DrawImage:
+            {
+                auto image = Resolve<ICanvasImage>(CanvasTraceResourceKind::Image, reader.Read<uint32_t>());
+                auto offset = reader.Read<Vector2>();
+
+                if (!image)
+                {
+                    *skipped = true;
+                    return S_OK;
+                }
+
+                return ds->DrawImage(image.Get(), offset);
+            }
+
+        case CanvasTraceOp::DrawSprites:
+            {
+                auto bitmap = Resolve<ICanvasBitmap>(CanvasTraceResourceKind::Image, reader.Read<uint32_t>());
+                bool hasTransforms = reader.Read<uint8_t>() != 0;
+
+                std::vector<Rect> destinationRects;
+                std::vector<Numerics::Matrix3x2> transforms;
+
+                if (hasTransforms)
+                    transforms = reader.ReadArray<Numerics::Matrix3x2>();
+                else
+                    destinationRects = reader.ReadArray<Rect>();
+
+                auto sourceRects = reader.ReadArray<Rect>();
+                auto opacities = reader.ReadArray<float>();
+
+                if (!bitmap)
+                {
+                    *skipped = true;
+                    return S_OK;
+                }
+
+                auto sourceRectsData = sourceRects.empty() ? nullptr : &sourceRects[0];
+                auto opacitiesData = opacities.empty() ? nullptr : &opacities[0];
+
+                if (hasTransforms)
+                {
+                    return ds->DrawSpritesWithTransforms(
+                        bitmap.Get(),
+                        static_cast<uint32_t>(transforms.size()), transforms.empty() ? nullptr : &transforms[0],
+                        static_cast<uint32_t>(sourceRects.size()), sourceRectsData,
+                        static_cast<uint32_t>(opacities.size()), opacitiesData);
+                }
+                else
+                {
+                    return ds->DrawSprites(
+                        bitmap.Get(),
+                        static_cast<uint32_t>(destinationRects.size()), destinationRects.empty() ? nullptr : &destinationRects[0],
+                        static_cast<uint32_t>(sourceRects.size()), sourceRectsData,
+                        static_cast<uint32_t>(opacities.size()), opacitiesData);
+                }
+            }
+
+        case CanvasTraceOp::DrawLine:
+            {
+                auto point0 = reader.Read<Vector2>();
+                auto point1 = reader.Read<Vector2>();
+                auto brush = readBrush();
+                auto strokeWidth = reader.Read<float>();
+                auto strokeStyle = readStrokeStyle();
+
+                if (brush.IsColor)
+                    return ds->DrawLineWithColorAndStrokeWidthAndStrokeStyle(point0, point1, brush.SolidColor, strokeWidth, strokeStyle.Get());
+                else
+                    return ds->DrawLineWithBrushAndStrokeWidthAndStrokeStyle(point0, point1, brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+            }
+
+        case CanvasTraceOp::DrawRectangle:
+            {
+                auto rect = reader.Read<Rect>();
+                auto brush = readBrush();
+                auto strokeWidth = reader.Read<float>();
+                auto strokeStyle = readStrokeStyle();
+
+                if (brush.IsColor)
+                    return ds->DrawRectangleWithColorAndStrokeWidthAndStrokeStyle(rect, brush.SolidColor, strokeWidth, strokeStyle.Get());
+                else
+                    return ds->DrawRectangleWithBrushAndStrokeWidthAndStrokeStyle(rect, brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+            }
+
+        case CanvasTraceOp::FillRectangle:
+            {
+                auto rect = reader.Read<Rect>();
+                auto brush = readBrush();
+
+                if (brush.IsColor)
+                    return ds->FillRectangleWithColor(rect, brush.SolidColor);
+                else
+                    return ds->FillRectangleWithBrush(rect, brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawRoundedRectangle:
+            {
+                auto rect = reader.Read<Rect>();
+                auto radiusX = reader.Read<float>();
+                auto radiusY = reader.Read<float>();
+                auto brush = readBrush();
+                auto strokeWidth = reader.Read<float>();
+                auto strokeStyle = readStrokeStyle();
+
+                if (brush.IsColor)
+                    return ds->DrawRoundedRectangleWithColorAndStrokeWidthAndStrokeStyle(rect, radiusX, radiusY, brush.SolidColor, strokeWidth, strokeStyle.Get());
+                else
+                    return ds->DrawRoundedRectangleWithBrushAndStrokeWidthAndStrokeStyle(rect, radiusX, radiusY, brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+            }
+
+        case CanvasTraceOp::FillRoundedRectangle:
+            {
+                auto rect = reader.Read<Rect>();
+                auto radiusX = reader.Read<float>();
+                auto radiusY = reader.Read<float>();
+                auto brush = readBrush();
+
+                if (brush.IsColor)
+                    return ds->FillRoundedRectangleWithColor(rect, radiusX, radiusY, brush.SolidColor);
+                else
+                    return ds->FillRoundedRectangleWithBrush(rect, radiusX, radiusY, brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawEllipse:
+            {
+                auto centerPoint = reader.Read<Vector2>();
+                auto radiusX = reader.Read<float>();
+                auto radiusY = reader.Read<float>();
+                auto brush = readBrush();
+                auto strokeWidth = reader.Read<float>();
+                auto strokeStyle = readStrokeStyle();
+
+                if (brush.IsColor)
+                    return ds->DrawEllipseWithColorAndStrokeWidthAndStrokeStyle(centerPoint, radiusX, radiusY, brush.SolidColor, strokeWidth, strokeStyle.Get());
+                else
+                    return ds->DrawEllipseWithBrushAndStrokeWidthAndStrokeStyle(centerPoint, radiusX, radiusY, brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+            }
+
+        case CanvasTraceOp::FillEllipse:
+            {
+                auto centerPoint = reader.Read<Vector2>();
+                auto radiusX = reader.Read<float>();
+                auto radiusY = reader.Read<float>();
+                auto brush = readBrush();
+
+                if (brush.IsColor)
+                    return ds->FillEllipseWithColor(centerPoint, radiusX, radiusY, brush.SolidColor);
+                else
+                    return ds->FillEllipseWithBrush(centerPoint, radiusX, radiusY, brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawGeometry:
+            {
+                auto geometry = Resolve<ICanvasGeometry>(CanvasTraceResourceKind::Geometry, reader.Read<uint32_t>());
+                auto brush = readBrush();
+                auto strokeWidth = reader.Read<float>();
+                auto strokeStyle = readStrokeStyle();
+
+                if (!geometry)
+                {
+                    *skipped = true;
+                    return S_OK;
+                }
+
+                if (brush.IsColor)
+                    return ds->DrawGeometryWithColorAndStrokeWidthAndStrokeStyle(geometry.Get(), brush.SolidColor, strokeWidth, strokeStyle.Get());
+                else
+                    return ds->DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle(geometry.Get(), brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+            }
+
+        case CanvasTraceOp::FillGeometry:
+            {
+                auto geometry = Resolve<ICanvasGeometry>(CanvasTraceResourceKind::Geometry, reader.Read<uint32_t>());
+                auto brush = readBrush();
+
+                if (!geometry)
+                {
+                    *skipped = true;
+                    return S_OK;
+                }
+
+                if (brush.IsColor)
+                    return ds->FillGeometryWithColor(geometry.Get(), brush.SolidColor);
+                else
+                    return ds->FillGeometryWithBrush(geometry.Get(), brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawPolyline:
+        case CanvasTraceOp::DrawPolygon:
+            {
+                auto points = reader.ReadArray<Vector2>();
+                auto brush = readBrush();
+                auto strokeWidth = reader.Read<float>();
+                auto strokeStyle = readStrokeStyle();
+
+                auto pointCount = static_cast<uint32_t>(points.size());
+                auto pointsData = points.empty() ? nullptr : &points[0];
+
+                if (op == CanvasTraceOp::DrawPolyline)
+                {
+                    if (brush.IsColor)
+                        return ds->DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(pointCount, pointsData, brush.SolidColor, strokeWidth, strokeStyle.Get());
+                    else
+                        return ds->DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(pointCount, pointsData, brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+                }
+                else
+                {
+                    if (brush.IsColor)
+                        return ds->DrawPolygonWithColorAndStrokeWidthAndStrokeStyle(pointCount, pointsData, brush.SolidColor, strokeWidth, strokeStyle.Get());
+                    else
+                        return ds->DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle(pointCount, pointsData, brush.Brush.Get(), strokeWidth, strokeStyle.Get());
+                }
+            }
+
+        case CanvasTraceOp::FillPolygon:
+            {
+                auto points = reader.ReadArray<Vector2>();
+                auto brush = readBrush();
+
+                auto pointCount = static_cast<uint32_t>(points.size());
+                auto pointsData = points.empty() ? nullptr : &points[0];
+
+                if (brush.IsColor)
+                    return ds->FillPolygonWithColor(pointCount, pointsData, brush.SolidColor);
+                else
+                    return ds->FillPolygonWithBrush(pointCount, pointsData, brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawText:
+            {
+                auto text = reader.ReadString();
+                auto rect = reader.Read<Rect>();
+                bool isPoint = reader.Read<uint8_t>() != 0;
+                auto brush = readBrush();
+                auto format = Resolve<ICanvasTextFormat>(CanvasTraceResourceKind::TextFormat, reader.Read<uint32_t>());
+
+                Vector2 point{ rect.X, rect.Y };
+
+                if (isPoint)
+                {
+                    if (brush.IsColor)
+                        return ds->DrawTextAtPointWithColorAndFormat(text, point, brush.SolidColor, format.Get());
+                    else
+                        return ds->DrawTextAtPointWithBrushAndFormat(text, point, brush.Brush.Get(), format.Get());
+                }
+                else
+                {
+                    if (brush.IsColor)
+                        return ds->DrawTextAtRectWithColorAndFormat(text, rect, brush.SolidColor, format.Get());
+                    else
+                        return ds->DrawTextAtRectWithBrushAndFormat(text, rect, brush.Brush.Get(), format.Get());
+                }
+            }
+
+        case CanvasTraceOp::DrawTextLayout:
+            {
+                auto textLayout = Resolve<ICanvasTextLayout>(CanvasTraceResourceKind::TextLayout, reader.Read<uint32_t>());
+                auto point = reader.Read<Vector2>();
+                auto brush = readBrush();
+
+                if (!textLayout)
+                {
+                    *skipped = true;
+                    return S_OK;
+                }
+
+                if (brush.IsColor)
+                    return ds->DrawTextLayoutWithColor(textLayout.Get(), point, brush.SolidColor);
+                else
+                    return ds->DrawTextLayoutWithBrush(textLayout.Get(), point, brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawTextDocument:
+            {
+                auto textDocument = Resolve<ICanvasTextDocument>(CanvasTraceResourceKind::TextDocument, reader.Read<uint32_t>());
+                auto viewport = reader.Read<Rect>();
+                auto scrollOffset = reader.Read<float>();
+                auto brush = readBrush();
+
+                if (!textDocument)
+                {
+                    *skipped = true;
+                    return S_OK;
+                }
+
+                if (brush.IsColor)
+                    return ds->DrawTextDocumentWithColor(textDocument.Get(), viewport, scrollOffset, brush.SolidColor);
+                else
+                    return ds->DrawTextDocumentWithBrush(textDocument.Get(), viewport, scrollOffset, brush.Brush.Get());
+            }
+
+        case CanvasTraceOp::DrawTextBatch:
+            {
+                auto labelCount = reader.Read<uint32_t>();
+
+                // Each label takes at least the four bytes of its length, so
+                // a corrupt count runs out of data rather than memory.
+                std::vector<WinString> labels;
+
+                for (uint32_t i = 0; i < labelCount; ++i)
+                {
+                    labels.push_back(reader.ReadString());
+                }
+
+                auto points = reader.ReadArray<Vector2>();
+                auto colors = reader.ReadArray<Color>();
+                auto format = Resolve<ICanvasTextFormat>(CanvasTraceResourceKind::TextFormat, reader.Read<uint32_t>());
+
+                std::vector<HSTRING> text;
+                text.reserve(labels.size());
+
+                for (auto& label : labels)
+                {
+                    text.push_back(label);
+                }
+
+                return ds->DrawTextBatch(
+                    static_cast<uint32_t>(text.size()), text.empty() ? nullptr : &text[0],
+                    static_cast<uint32_t>(points.size()), points.empty() ? nullptr : &points[0],
+                    static_cast<uint32_t>(colors.size()), colors.empty() ? nullptr : &colors[0],
+                    format.Get());
+            }
+
+        case CanvasTraceOp::SetAntialiasing:
+            return ds->put_Antialiasing(static_cast<CanvasAntialiasing>(reader.Read<int32_t>()));
+
+        case CanvasTraceOp::SetBlend:
+            return ds->put_Blend(static_cast<CanvasBlend>(reader.Read<int32_t>()));
+
+        case CanvasTraceOp::SetTextAntialiasing:
+            return ds->put_TextAntialiasing(static_cast<CanvasTextAntialiasing>(reader.Read<int32_t>()));
+
+        case CanvasTraceOp::SetUnits:
+            return ds->put_Units(static_cast<CanvasUnits>(reader.Read<int32_t>()));
+
+        case CanvasTraceOp::SetTransform:
+            return ds->put_Transform(reader.Read<Numerics::Matrix3x2>());
+
+        case CanvasTraceOp::PushClipOrLayer:
+            {
+                bool isLayer = reader.Read<uint8_t>() != 0;
+                auto opacity = reader.Read<float>();
+                auto opacityBrushId = reader.Read<uint32_t>();
+                bool hasClipRectangle = reader.Read<uint8_t>() != 0;
+                auto clipRectangle = reader.Read<Rect>();
+                auto clipGeometryId = reader.Read<uint32_t>();
+
+                auto opacityBrush = Resolve<ICanvasBrush>(CanvasTraceResourceKind::Brush, opacityBrushId);
+                auto clipGeometry = Resolve<ICanvasGeometry>(CanvasTraceResourceKind::Geometry, clipGeometryId);
+
+                //
+                // A layer that can't be pushed is still replayed as a plain
+                // layer, so that the PopLayer that follows it balances.
+                //
+                if (!isLayer)
+                    return ds->PushClipRectangle(clipRectangle);
+                else if (clipGeometry)
+                    return ds->PushLayerWithOpacityAndClipGeometry(opacity, clipGeometry.Get());
+                else if (opacityBrush && hasClipRectangle)
+                    return ds->PushLayerWithOpacityBrushAndClipRectangle(opacityBrush.Get(), clipRectangle);
+                else if (opacityBrush)
+                    return ds->PushLayerWithOpacityBrush(opacityBrush.Get());
+                else if (hasClipRectangle)
+                    return ds->PushLayerWithOpacityAndClipRectangle(opacity, clipRectangle);
+                else
+                    return ds->PushLayerWithOpacity(opacity);
+            }
+
+        case CanvasTraceOp::PopClip:
+            return ds->PopClip();
+
+        case CanvasTraceOp::PopLayer:
+            return ds->PopLayer();
+
+        case CanvasTraceOp::SetCullingEnabled:
+            return ds->put_IsCullingEnabled(reader.Read<uint8_t>());
+
+        case CanvasTraceOp::SetBatchingEnabled:
+            return ds->put_IsBatchingEnabled(reader.Read<uint8_t>());
+
+        case CanvasTraceOp::SetPixelAlignedAliasingEnabled:
+            return ds->put_IsPixelAlignedAliasingEnabled(reader.Read<uint8_t>());
+
+        default:
+            ThrowHR(E_INVALIDARG);
+        }
+    }
+}}}}
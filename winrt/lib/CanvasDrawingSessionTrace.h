@@ -0,0 +1,207 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <unordered_map>
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    //
+    // A trace is a compact binary record of the calls made to a drawing
+    // session, captured when CanvasDrawingSession.IsTracingEnabled is set.
+    //
+    // The trace starts with a CanvasTraceHeader.  Each call is then written as a
+    // one byte CanvasTraceOp, the number of microseconds since the previous
+    // call (as a uint32_t), and the call's arguments.  Values are written in
+    // their in-memory representation, so traces are only read back on the
+    // same architecture.
+    //
+    // Brushes, stroke styles, text formats, text layouts, text documents,
+    // images and geometries are written as resource ids rather than by value.  Ids are assigned in
+    // the order that resources are first seen, starting at 1, with 0 for
+    // null.  A solid color drawn via one of the Color overloads is written
+    // as the color itself.
+    //
+    enum class CanvasTraceOp : uint8_t
+    {
+        Clear = 1,
+        DrawImage,
+        DrawSprites,
+        DrawLine,
+        DrawRectangle,
+        FillRectangle,
+        DrawRoundedRectangle,
+        FillRoundedRectangle,
+        DrawEllipse,
+        FillEllipse,
+        DrawGeometry,
+        FillGeometry,
+        DrawPolyline,
+        DrawPolygon,
+        FillPolygon,
+        DrawText,
+        SetAntialiasing,
+        SetBlend,
+        SetTextAntialiasing,
+        SetUnits,
+        SetTransform,
+        PushClipOrLayer,
+        PopClip,
+        PopLayer,
+        SetCullingEnabled,
+        SetBatchingEnabled,
+        SetPixelAlignedAliasingEnabled,
+        DrawTextLayout,
+        DrawTextDocument,
+        DrawTextBatch,
+
+        Count
+    };
+
+    enum class CanvasTraceResourceKind
+    {
+        Brush,
+        StrokeStyle,
+        TextFormat,
+        Image,
+        Geometry,
+        TextLayout,
+        TextDocument
+    };
+
+    enum class CanvasTraceBrushType : uint8_t
+    {
+        Resource,
+        Color
+    };
+
+    struct CanvasTraceHeader
+    {
+        static const uint32_t ExpectedMagic = 0x54443257;   // "W2DT"
+        static const uint32_t CurrentVersion = 1;
+
+        uint32_t Magic;
+        uint32_t Version;
+    };
+
+
+    //
+    // Appends calls to a trace.  The writer holds a reference to each
+    // resource it has assigned an id to, so that a released resource's
+    // address can't be reused by a different resource with the same id.
+    // ReleaseResources drops these references once tracing stops.
+    //
+    class CanvasDrawingSessionTraceWriter
+    {
+    public:
+        CanvasDrawingSessionTraceWriter();
+
+        void BeginRecord(CanvasTraceOp op);
+
+        template<typename T>
+        void Write(const T& value)
+        {
+            WriteBytes(&value, sizeof(value));
+        }
+
+        template<typename T>
+        void WriteArray(uint32_t count, const T* values)
+        {
+            Write(count);
+            WriteBytes(values, count * sizeof(T));
+        }
+
+        void WriteString(HSTRING value);
+        void WriteResource(IUnknown* resource);
+
+        // If color is non-null then the brush is the session's solid color
+        // brush, set to that color.
+        void WriteBrush(ID2D1Brush* brush, const D2D1_COLOR_F* color);
+
+        const std::vector<uint8_t>& GetData() const;
+
+        void ReleaseResources();
+
+    private:
+        void WriteBytes(const void* bytes, size_t size);
+
+        std::vector<uint8_t> m_data;
+
+        std::unordered_map<IUnknown*, uint32_t> m_resourceIds;
+        std::vector<ComPtr<IUnknown>> m_resources;
+
+        LARGE_INTEGER m_frequency;
+        LARGE_INTEGER m_lastRecordTime;
+    };
+
+
+    //
+    // Re-issues the calls in a trace against any ICanvasDrawingSession,
+    // timing each call.
+    //
+    // Resources aren't stored in the trace, so the caller can provide a
+    // resolver to map resource ids back to real objects (eg. recreated by a
+    // test harness).  Without one, or when the resolver returns null:
+    //
+    //  - brushes are replaced with opaque black
+    //  - stroke styles and text formats fall back to the defaults
+    //  - calls that draw an image, geometry or text layout are skipped
+    //  - layers lose their opacity brush or clip geometry, but are still
+    //    pushed so that the matching PopLayer balances
+    //
+    class CanvasDrawingSessionTraceReplayer
+    {
+    public:
+        typedef std::function<ComPtr<IUnknown>(CanvasTraceResourceKind kind, uint32_t id)> ResourceResolver;
+
+        struct CallCost
+        {
+            uint32_t CallCount;
+            uint32_t FailedCount;
+            uint32_t SkippedCount;
+
+            // Time taken to replay the calls, including reading their
+            // arguments from the trace, in 100ns units.
+            int64_t ReplayDuration;
+
+            // Time from each call to the next one when the trace was
+            // captured, in 100ns units.  This includes the app's own work
+            // between calls, so is an upper bound on the original cost.
+            int64_t RecordedDuration;
+        };
+
+        CanvasDrawingSessionTraceReplayer(
+            std::vector<uint8_t> trace,
+            ResourceResolver resolver = nullptr);
+
+        void Replay(ICanvasDrawingSession* drawingSession);
+
+        const CallCost& GetCost(CanvasTraceOp op) const;
+
+        static const wchar_t* GetName(CanvasTraceOp op);
+
+    private:
+        class Reader;
+
+        HRESULT ReplayRecord(CanvasTraceOp op, Reader& reader, ICanvasDrawingSession* drawingSession, bool* skipped);
+
+        template<typename T>
+        ComPtr<T> Resolve(CanvasTraceResourceKind kind, uint32_t id);
+
+        std::vector<uint8_t> m_trace;
+        ResourceResolver m_resolver;
+        CallCost m_costs[static_cast<size_t>(CanvasTraceOp::Count)];
+    };
+}}}}
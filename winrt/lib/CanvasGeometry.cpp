@@ -0,0 +1,508 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasGeometry.h"
+#include "CanvasDevice.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ABI::Windows::Foundation;
+
+    //
+    // CanvasGeometryRealizationCache
+    //
+
+    //
+    // Scale buckets outside this range aren't realized.  Very small scales
+    // gain little from a realization, and very large ones would produce
+    // enormous tessellations.
+    //
+    static const float c_minScaleBucket = 1.0f / 64.0f;
+    static const float c_maxScaleBucket = 64.0f;
+
+
+    float CanvasGeometryRealizationCache::GetScaleBucket(const D2D1_MATRIX_3X2_F& transform, float dpiX, float dpiY)
+    {
+        //
+        // The most that the transform can stretch the geometry by is the
+        // largest singular value of its 2x2 part.
+        //
+        float sumOfSquares =
+            transform._11 * transform._11 +
+            transform._12 * transform._12 +
+            transform._21 * transform._21 +
+            transform._22 * transform._22;
+
+        float determinant = transform._11 * transform._22 - transform._12 * transform._21;
+
+        float discriminant = std::max(0.0f, sumOfSquares * sumOfSquares - 4 * determinant * determinant);
+        float maxStretch = sqrtf((sumOfSquares + sqrtf(discriminant)) / 2);
+
+        float scale = maxStretch * std::max(dpiX, dpiY) / DEFAULT_DPI;
+
+        if (!(scale > c_minScaleBucket))
+            return c_minScaleBucket;
+
+        return powf(2.0f, ceilf(log2f(scale)));
+    }
+
+
+    ComPtr<ID2D1GeometryRealization> CanvasGeometryRealizationCache::GetRealization(
+        ID2D1DeviceContext1* deviceContext,
+        ID2D1Geometry* geometry,
+        bool isStroke,
+        float strokeWidth,
+        ID2D1StrokeStyle1* strokeStyle)
+    {
+        //
+        // Stroked realizations always scale with the transform, so stroke
+        // styles that don't can't be realized.
+        //
+        if (isStroke && strokeStyle && strokeStyle->GetStrokeTransformType() != D2D1_STROKE_TRANSFORM_TYPE_NORMAL)
+            return nullptr;
+
+        D2D1_MATRIX_3X2_F transform;
+        deviceContext->GetTransform(&transform);
+
+        float dpiX, dpiY;
+        deviceContext->GetDpi(&dpiX, &dpiY);
+
+        float scaleBucket = GetScaleBucket(transform, dpiX, dpiY);
+        if (scaleBucket > c_maxScaleBucket)
+            return nullptr;
+
+        ComPtr<ID2D1Device> device;
+        deviceContext->GetDevice(&device);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = std::find_if(m_entries.begin(), m_entries.end(),
+            [&](const Entry& entry)
+            {
+                if (entry.Device.Get() != device.Get() ||
+                    entry.ScaleBucket != scaleBucket ||
+                    entry.IsStroke != isStroke)
+                {
+                    return false;
+                }
+
+                return !isStroke ||
+                    (entry.StrokeWidth == strokeWidth && entry.StrokeStyle.Get() == strokeStyle);
+            });
+
+        if (it == m_entries.end())
+        {
+            //
+            // First use of this key.  Remember it, but let the caller draw
+            // the geometry directly.
+            //
+            Entry entry;
+            entry.Device = device;
+            entry.ScaleBucket = scaleBucket;
+            entry.IsStroke = isStroke;
+            entry.StrokeWidth = strokeWidth;
+            entry.StrokeStyle = strokeStyle;
+
+            m_entries.push_front(entry);
+
+            if (m_entries.size() > MaxEntries)
+                m_entries.pop_back();
+
+            return nullptr;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, it);
+
+        auto& entry = m_entries.front();
+
+        if (!entry.Realization)
+        {
+            float flatteningTolerance = D2D1_DEFAULT_FLATTENING_TOLERANCE / scaleBucket;
+
+            if (isStroke)
+            {
+                ThrowIfFailed(deviceContext->CreateStrokedGeometryRealization(
+                    geometry,
+                    flatteningTolerance,
+                    strokeWidth,
+                    strokeStyle,
+                    &entry.Realization));
+            }
+            else
+            {
+                ThrowIfFailed(deviceContext->CreateFilledGeometryRealization(
+                    geometry,
+                    flatteningTolerance,
+                    &entry.Realization));
+            }
+        }
+
+        return entry.Realization;
+    }
+
+
+    void CanvasGeometryRealizationCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+
+    size_t CanvasGeometryRealizationCache::GetEntryCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+
+    //
+    // CanvasPathBuilder
+    //
+
+    IFACEMETHODIMP CanvasPathBuilderFactory::Create(
+        ICanvasResourceCreator* resourceCreator,
+        ICanvasPathBuilder** canvasPathBuilder)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(resourceCreator);
+                CheckAndClearOutPointer(canvasPathBuilder);
+
+                ComPtr<ICanvasDevice> device;
+                ThrowIfFailed(resourceCreator->get_Device(&device));
+
+                auto pathBuilder = Make<CanvasPathBuilder>(device.Get());
+                CheckMakeResult(pathBuilder);
+
+                ThrowIfFailed(pathBuilder.CopyTo(canvasPathBuilder));
+            });
+    }
+
+
+    CanvasPathBuilder::CanvasPathBuilder(ICanvasDevice* device)
+        : m_isInFigure(false)
+        , m_hasFigures(false)
+    {
+        CheckInPointer(device);
+
+        ComPtr<ICanvasDeviceInternal> deviceInternal;
+        ThrowIfFailed(device->QueryInterface(deviceInternal.GetAddressOf()));
+
+        auto d2dPathGeometry = deviceInternal->CreatePathGeometry();
+
+        ComPtr<ID2D1GeometrySink> d2dGeometrySink;
+        ThrowIfFailed(d2dPathGeometry->Open(&d2dGeometrySink));
+
+        m_d2dPathGeometry = d2dPathGeometry;
+        m_d2dGeometrySink = d2dGeometrySink;
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::BeginFigure(Numerics::Vector2 startPoint)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& sink = m_d2dGeometrySink.EnsureNotClosed();
+
+                if (m_isInFigure)
+                    ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+                sink->BeginFigure(ToD2DPoint(startPoint), D2D1_FIGURE_BEGIN_FILLED);
+
+                m_isInFigure = true;
+                m_hasFigures = true;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::AddLine(Numerics::Vector2 endPoint)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetSinkInFigure()->AddLine(ToD2DPoint(endPoint));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::AddQuadraticBezier(
+        Numerics::Vector2 controlPoint,
+        Numerics::Vector2 endPoint)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetSinkInFigure()->AddQuadraticBezier(D2D1::QuadraticBezierSegment(
+                    ToD2DPoint(controlPoint),
+                    ToD2DPoint(endPoint)));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::AddCubicBezier(
+        Numerics::Vector2 controlPoint1,
+        Numerics::Vector2 controlPoint2,
+        Numerics::Vector2 endPoint)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetSinkInFigure()->AddBezier(D2D1::BezierSegment(
+                    ToD2DPoint(controlPoint1),
+                    ToD2DPoint(controlPoint2),
+                    ToD2DPoint(endPoint)));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::AddArc(
+        Numerics::Vector2 endPoint,
+        float radiusX,
+        float radiusY,
+        float rotationAngle,
+        CanvasSweepDirection sweepDirection,
+        CanvasArcSize arcSize)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                const float degreesPerRadian = 57.2957795f;
+
+                GetSinkInFigure()->AddArc(D2D1::ArcSegment(
+                    ToD2DPoint(endPoint),
+                    D2D1::SizeF(radiusX, radiusY),
+                    rotationAngle * degreesPerRadian,
+                    static_cast<D2D1_SWEEP_DIRECTION>(sweepDirection),
+                    static_cast<D2D1_ARC_SIZE>(arcSize)));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::EndFigure(CanvasFigureLoop figureLoop)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetSinkInFigure()->EndFigure(static_cast<D2D1_FIGURE_END>(figureLoop));
+
+                m_isInFigure = false;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::SetFilledRegionDetermination(CanvasFilledRegionDetermination filledRegionDetermination)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto& sink = m_d2dGeometrySink.EnsureNotClosed();
+
+                // D2D only allows the fill mode to be set before the first figure.
+                if (m_hasFigures)
+                    ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+                sink->SetFillMode(static_cast<D2D1_FILL_MODE>(filledRegionDetermination));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasPathBuilder::Close()
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto sink = m_d2dGeometrySink.Close();
+                if (sink)
+                    sink->Close();
+
+                m_d2dPathGeometry.Close();
+            });
+    }
+
+
+    ComPtr<ID2D1PathGeometry1> CanvasPathBuilder::CloseAndReturnPath()
+    {
+        auto& sink = m_d2dGeometrySink.EnsureNotClosed();
+
+        if (m_isInFigure)
+            ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+        ThrowIfFailed(sink->Close());
+
+        m_d2dGeometrySink.Close();
+        return m_d2dPathGeometry.Close();
+    }
+
+
+    const ComPtr<ID2D1GeometrySink>& CanvasPathBuilder::GetSinkInFigure()
+    {
+        auto& sink = m_d2dGeometrySink.EnsureNotClosed();
+
+        if (!m_isInFigure)
+            ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+        return sink;
+    }
+
+
+    //
+    // CanvasGeometry
+    //
+
+    IFACEMETHODIMP CanvasGeometryFactory::CreatePath(
+        ICanvasPathBuilder* pathBuilder,
+        ICanvasGeometry** geometry)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(pathBuilder);
+                CheckAndClearOutPointer(geometry);
+
+                auto newGeometry = GetManager()->Create(pathBuilder);
+
+                ThrowIfFailed(newGeometry.CopyTo(geometry));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasGeometryFactory::GetOrCreate(
+        IUnknown* resource,
+        IInspectable** wrapper)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(resource);
+                CheckAndClearOutPointer(wrapper);
+
+                ComPtr<ID2D1Geometry> d2dGeometry;
+                ThrowIfFailed(resource->QueryInterface(d2dGeometry.GetAddressOf()));
+
+                auto newGeometry = GetManager()->GetOrCreate(d2dGeometry.Get());
+
+                ThrowIfFailed(newGeometry.CopyTo(wrapper));
+            });
+    }
+
+
+    ComPtr<CanvasGeometry> CanvasGeometryManager::CreateNew(
+        ICanvasPathBuilder* pathBuilder)
+    {
+        ComPtr<ICanvasPathBuilderInternal> pathBuilderInternal;
+        ThrowIfFailed(pathBuilder->QueryInterface(pathBuilderInternal.GetAddressOf()));
+
+        auto d2dPathGeometry = pathBuilderInternal->CloseAndReturnPath();
+
+        auto canvasGeometry = Make<CanvasGeometry>(
+            shared_from_this(),
+            d2dPathGeometry.Get());
+        CheckMakeResult(canvasGeometry);
+
+        return canvasGeometry;
+    }
+
+
+    ComPtr<CanvasGeometry> CanvasGeometryManager::CreateWrapper(
+        ID2D1Geometry* geometry)
+    {
+        auto canvasGeometry = Make<CanvasGeometry>(
+            shared_from_this(),
+            geometry);
+        CheckMakeResult(canvasGeometry);
+
+        return canvasGeometry;
+    }
+
+
+    CanvasGeometry::CanvasGeometry(
+        std::shared_ptr<CanvasGeometryManager> manager,
+        ID2D1Geometry* geometry)
+        : ResourceWrapper(manager, geometry)
+        , m_hasBounds(false)
+    {
+    }
+
+
+    IFACEMETHODIMP CanvasGeometry::ComputeBounds(Rect* bounds)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(bounds);
+
+                *bounds = FromD2DRect(GetBounds());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasGeometry::Close()
+    {
+        m_realizationCache.Clear();
+
+        return ResourceWrapper::Close();
+    }
+
+
+    ComPtr<ID2D1Geometry> CanvasGeometry::GetD2DGeometry()
+    {
+        return GetResource();
+    }
+
+
+    D2D1_RECT_F CanvasGeometry::GetBounds()
+    {
+        auto& geometry = GetResource();
+
+        std::lock_guard<std::mutex> lock(m_boundsMutex);
+
+        // Geometries are immutable, so the bounds only need computing once.
+        if (!m_hasBounds)
+        {
+            ThrowIfFailed(geometry->GetBounds(nullptr, &m_bounds));
+            m_hasBounds = true;
+        }
+
+        return m_bounds;
+    }
+
+
+    ComPtr<ID2D1GeometryRealization> CanvasGeometry::GetRealization(
+        ID2D1DeviceContext1* deviceContext,
+        bool isStroke,
+        float strokeWidth,
+        ID2D1StrokeStyle1* strokeStyle)
+    {
+        auto& geometry = GetResource();
+
+        return m_realizationCache.GetRealization(
+            deviceContext,
+            geometry.Get(),
+            isStroke,
+            strokeWidth,
+            strokeStyle);
+    }
+
+
+    size_t CanvasGeometry::GetRealizationCacheEntryCount()
+    {
+        return m_realizationCache.GetEntryCount();
+    }
+
+
+    ActivatableClassWithFactory(CanvasPathBuilder, CanvasPathBuilderFactory);
+    ActivatableClassWithFactory(CanvasGeometry, CanvasGeometryFactory);
+}}}}
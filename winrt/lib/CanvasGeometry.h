@@ -0,0 +1,255 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <Canvas.abi.h>
+#include <list>
+
+#include "ClosablePtr.h"
+#include "ResourceManager.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    class CanvasGeometry;
+    class CanvasGeometryManager;
+
+    //
+    // Caches ID2D1GeometryRealizations for a single geometry.
+    //
+    // A realization is a tessellation of a fill or a stroke, created for a
+    // specific D2D device at a specific flattening tolerance.  Realizations
+    // are keyed on the device, a power-of-two scale bucket derived from the
+    // transform and DPI, and (for strokes) the stroke width and realized
+    // stroke style.  Rounding the scale up to a power of two means that small
+    // changes in the transform, such as an animated zoom, reuse the same
+    // realization rather than tessellating again.
+    //
+    // Creating a realization costs more than drawing the geometry directly
+    // once, so a key is only realized the second time it is used.
+    //
+    // The cache holds at most MaxEntries entries, evicting the least recently
+    // used.  All methods are thread-safe.
+    //
+    class CanvasGeometryRealizationCache
+    {
+    public:
+        static const size_t MaxEntries = 8;
+
+        //
+        // Returns a realization to draw with DrawGeometryRealization, or null
+        // if the geometry should be drawn directly this time.
+        //
+        ComPtr<ID2D1GeometryRealization> GetRealization(
+            ID2D1DeviceContext1* deviceContext,
+            ID2D1Geometry* geometry,
+            bool isStroke,
+            float strokeWidth,
+            ID2D1StrokeStyle1* strokeStyle);
+
+        void Clear();
+        size_t GetEntryCount();
+
+        static float GetScaleBucket(const D2D1_MATRIX_3X2_F& transform, float dpiX, float dpiY);
+
+    private:
+        struct Entry
+        {
+            ComPtr<ID2D1Device> Device;
+            float ScaleBucket;
+            bool IsStroke;
+            float StrokeWidth;
+            ComPtr<ID2D1StrokeStyle1> StrokeStyle;
+            ComPtr<ID2D1GeometryRealization> Realization;
+        };
+
+        std::mutex m_mutex;
+
+        // Most recently used entries are at the front of the list.
+        std::list<Entry> m_entries;
+    };
+
+
+    [uuid(C05B5659-2437-401C-B81E-0CF06DCF610D)]
+    class ICanvasGeometryInternal : public IUnknown
+    {
+    public:
+        virtual ComPtr<ID2D1Geometry> GetD2DGeometry() = 0;
+
+        // Bounds of the geometry in its own coordinate space.
+        virtual D2D1_RECT_F GetBounds() = 0;
+
+        virtual ComPtr<ID2D1GeometryRealization> GetRealization(
+            ID2D1DeviceContext1* deviceContext,
+            bool isStroke,
+            float strokeWidth,
+            ID2D1StrokeStyle1* strokeStyle) = 0;
+    };
+
+
+    [uuid(6AE7C5CD-85F1-4260-A41B-FCAF668D91C8)]
+    class ICanvasPathBuilderInternal : public IUnknown
+    {
+    public:
+        // Closes the path builder, returning the path it built.
+        virtual ComPtr<ID2D1PathGeometry1> CloseAndReturnPath() = 0;
+    };
+
+
+    class CanvasPathBuilderFactory : public ActivationFactory<ICanvasPathBuilderFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasPathBuilder, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            ICanvasResourceCreator* resourceCreator,
+            ICanvasPathBuilder** canvasPathBuilder) override;
+    };
+
+
+    class CanvasPathBuilder : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasPathBuilder,
+        ABI::Windows::Foundation::IClosable,
+        CloakedIid<ICanvasPathBuilderInternal>>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasPathBuilder, BaseTrust);
+
+        ClosablePtr<ID2D1PathGeometry1> m_d2dPathGeometry;
+        ClosablePtr<ID2D1GeometrySink> m_d2dGeometrySink;
+        bool m_isInFigure;
+        bool m_hasFigures;
+
+    public:
+        CanvasPathBuilder(ICanvasDevice* device);
+
+        IFACEMETHOD(BeginFigure)(Numerics::Vector2 startPoint) override;
+
+        IFACEMETHOD(AddLine)(Numerics::Vector2 endPoint) override;
+
+        IFACEMETHOD(AddQuadraticBezier)(
+            Numerics::Vector2 controlPoint,
+            Numerics::Vector2 endPoint) override;
+
+        IFACEMETHOD(AddCubicBezier)(
+            Numerics::Vector2 controlPoint1,
+            Numerics::Vector2 controlPoint2,
+            Numerics::Vector2 endPoint) override;
+
+        IFACEMETHOD(AddArc)(
+            Numerics::Vector2 endPoint,
+            float radiusX,
+            float radiusY,
+            float rotationAngle,
+            CanvasSweepDirection sweepDirection,
+            CanvasArcSize arcSize) override;
+
+        IFACEMETHOD(EndFigure)(CanvasFigureLoop figureLoop) override;
+
+        IFACEMETHOD(SetFilledRegionDetermination)(CanvasFilledRegionDetermination filledRegionDetermination) override;
+
+        // IClosable
+        IFACEMETHOD(Close)() override;
+
+        // ICanvasPathBuilderInternal
+        virtual ComPtr<ID2D1PathGeometry1> CloseAndReturnPath() override;
+
+    private:
+        const ComPtr<ID2D1GeometrySink>& GetSinkInFigure();
+    };
+
+
+    class CanvasGeometryFactory
+        : public ActivationFactory<
+            ICanvasGeometryStatics,
+            CloakedIid<ICanvasFactoryNative>>,
+          public FactoryWithResourceManager<CanvasGeometryFactory, CanvasGeometryManager>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasGeometry, BaseTrust);
+
+    public:
+        //
+        // ICanvasGeometryStatics
+        //
+
+        IFACEMETHOD(CreatePath)(
+            ICanvasPathBuilder* pathBuilder,
+            ICanvasGeometry** geometry) override;
+
+        //
+        // ICanvasFactoryNative
+        //
+
+        IFACEMETHOD(GetOrCreate)(
+            IUnknown* resource,
+            IInspectable** wrapper) override;
+    };
+
+
+    struct CanvasGeometryTraits
+    {
+        typedef ID2D1Geometry resource_t;
+        typedef CanvasGeometry wrapper_t;
+        typedef ICanvasGeometry wrapper_interface_t;
+        typedef CanvasGeometryManager manager_t;
+    };
+
+
+    class CanvasGeometry : RESOURCE_WRAPPER_RUNTIME_CLASS(
+        CanvasGeometryTraits,
+        CloakedIid<ICanvasGeometryInternal>)
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasGeometry, BaseTrust);
+
+        std::mutex m_boundsMutex;
+        bool m_hasBounds;
+        D2D1_RECT_F m_bounds;
+
+        CanvasGeometryRealizationCache m_realizationCache;
+
+    public:
+        CanvasGeometry(
+            std::shared_ptr<CanvasGeometryManager> manager,
+            ID2D1Geometry* geometry);
+
+        IFACEMETHOD(ComputeBounds)(ABI::Windows::Foundation::Rect* bounds) override;
+
+        // IClosable
+        IFACEMETHOD(Close)() override;
+
+        // ICanvasGeometryInternal
+        virtual ComPtr<ID2D1Geometry> GetD2DGeometry() override;
+
+        virtual D2D1_RECT_F GetBounds() override;
+
+        virtual ComPtr<ID2D1GeometryRealization> GetRealization(
+            ID2D1DeviceContext1* deviceContext,
+            bool isStroke,
+            float strokeWidth,
+            ID2D1StrokeStyle1* strokeStyle) override;
+
+        size_t GetRealizationCacheEntryCount();
+    };
+
+
+    class CanvasGeometryManager : public ResourceManager<CanvasGeometryTraits>
+    {
+    public:
+        ComPtr<CanvasGeometry> CreateNew(
+            ICanvasPathBuilder* pathBuilder);
+
+        ComPtr<CanvasGeometry> CreateWrapper(
+            ID2D1Geometry* resource);
+    };
+}}}}
@@ -13,6 +13,7 @@
 #include "pch.h"
 
 #include "CanvasDevice.h"
+#include "CanvasDrawingSession.h"
 #include "CanvasImageSource.h"
 #include "CanvasImageSourceDrawingSessionAdapter.h"
 
@@ -44,6 +45,31 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             std::move(adapter));
     }
 
+    void CanvasImageSourceDrawingSessionFactory::Reopen(
+        ICanvasDrawingSessionInternal* drawingSession,
+        ISurfaceImageSourceNativeWithD2D* sisNative,
+        const Rect& updateRect,
+        float dpi) const
+    {
+        CheckInPointer(drawingSession);
+        CheckInPointer(sisNative);
+
+        ComPtr<ID2D1DeviceContext1> deviceContext;
+        auto adapter = CanvasImageSourceDrawingSessionAdapter::Create(
+            sisNative,
+            ToRECT(updateRect),
+            dpi,
+            &deviceContext);
+
+        // If the session can't be reopened then nothing else is going to end
+        // the draw we just began.
+        auto endDrawWarden = MakeScopeWarden([&] { sisNative->EndDraw(); });
+
+        drawingSession->Reopen(deviceContext.Get(), adapter);
+
+        endDrawWarden.Dismiss();
+    }
+
     //
     // CanvasImageSourceFactory implementation
     //
@@ -223,6 +249,25 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
+    void CanvasImageSource::ReopenDrawingSessionWithDpi(
+        float dpi,
+        ICanvasDrawingSessionInternal* drawingSession)
+    {
+        Rect updateRectangle = {};
+        updateRectangle.Width = static_cast<float>(m_widthInPixels);
+        updateRectangle.Height = static_cast<float>(m_heightInPixels);
+
+        ComPtr<ISurfaceImageSourceNativeWithD2D> sisNative;
+        ThrowIfFailed(GetComposableBase().As(&sisNative));
+
+        m_drawingSessionFactory->Reopen(
+            drawingSession,
+            sisNative.Get(),
+            updateRectangle,
+            dpi);
+    }
+
+
     IFACEMETHODIMP CanvasImageSource::CreateDrawingSessionWithUpdateRectangleAndDpi(
         Rect updateRectangle,
         float dpi,
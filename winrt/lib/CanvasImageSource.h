@@ -18,6 +18,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     using namespace ABI::Windows::UI::Xaml::Media::Imaging;
     using namespace ::Microsoft::WRL;
 
+    class ICanvasDrawingSessionInternal;
+
     class ICanvasImageSourceDrawingSessionFactory
     {
     public:
@@ -26,6 +28,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             ISurfaceImageSourceNativeWithD2D* sisNative,
             const Rect& updateRect,
             float dpi) const = 0;
+
+        //
+        // Begins drawing to sisNative again with a drawing session previously
+        // returned by Create and since closed with CloseForReuse.
+        //
+        virtual void Reopen(
+            ICanvasDrawingSessionInternal* drawingSession,
+            ISurfaceImageSourceNativeWithD2D* sisNative,
+            const Rect& updateRect,
+            float dpi) const = 0;
     };
 
 
@@ -84,6 +96,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             float dpi,
             _COM_Outptr_ ICanvasDrawingSession** drawingSession);
 
+        //
+        // Equivalent to CreateDrawingSessionWithDpi, but reuses a drawing
+        // session that this image source created earlier (and that has since
+        // been closed with CloseForReuse) rather than creating a new one.
+        //
+        void ReopenDrawingSessionWithDpi(
+            float dpi,
+            ICanvasDrawingSessionInternal* drawingSession);
+
         IFACEMETHOD(get_Device)(
             _COM_Outptr_ ICanvasDevice** value) override;
 
@@ -122,5 +143,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             ISurfaceImageSourceNativeWithD2D* sisNative,
             const Rect& updateRect,
             float dpi) const override;
+
+        virtual void Reopen(
+            ICanvasDrawingSessionInternal* drawingSession,
+            ISurfaceImageSourceNativeWithD2D* sisNative,
+            const Rect& updateRect,
+            float dpi) const override;
     };
 }}}}
@@ -326,8 +326,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     // ICanvasStrokeStyleInternal
     //
 
-    ComPtr<ID2D1StrokeStyle1> CanvasStrokeStyle::GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory)
+    ComPtr<ID2D1StrokeStyle1> CanvasStrokeStyle::GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory, bool* wasRealized)
     {
+        if (wasRealized)
+            *wasRealized = false;
+
         //
         // If there is already a realization, ensure its factory matches the target factory.
         // If not, invalidate and re-realize.
@@ -378,6 +381,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                 dashArray,
                 static_cast<UINT32>(m_customDashElements.size()),
                 &m_d2dStrokeStyle));
+
+            if (wasRealized)
+                *wasRealized = true;
         }
 
         return m_d2dStrokeStyle;
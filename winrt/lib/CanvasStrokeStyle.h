@@ -24,8 +24,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     class ICanvasStrokeStyleInternal : public IUnknown
     {
     public:
-        // This realizes the stroke style if necessary.
-        virtual ComPtr<ID2D1StrokeStyle1> GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory) = 0;
+        // This realizes the stroke style if necessary.  If wasRealized is
+        // not null it is set to whether a new D2D stroke style was created.
+        virtual ComPtr<ID2D1StrokeStyle1> GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory, bool* wasRealized) = 0;
+
+        ComPtr<ID2D1StrokeStyle1> GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory)
+        {
+            return GetRealizedD2DStrokeStyle(d2dFactory, nullptr);
+        }
     };
 
     class CanvasStrokeStyleFactory : public ActivationFactory<
@@ -125,7 +131,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHOD(Close)() override;
 
         // ICanvasStrokeStyleInternal
-        virtual ComPtr<ID2D1StrokeStyle1>  GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory) override;
+        virtual ComPtr<ID2D1StrokeStyle1>  GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory, bool* wasRealized) override;
+
+        ComPtr<ID2D1StrokeStyle1> GetRealizedD2DStrokeStyle(ID2D1Factory2* d2dFactory)
+        {
+            return GetRealizedD2DStrokeStyle(d2dFactory, nullptr);
+        }
 
     private:
         void ThrowIfClosed();
@@ -0,0 +1,626 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasTextFormat.h"
+#include "CanvasTextLayout.h"
+#include "CanvasTextDocument.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    IFACEMETHODIMP CanvasTextDocumentFactory::Create(
+        HSTRING text,
+        ICanvasTextFormat* textFormat,
+        float width,
+        ICanvasTextDocument** textDocument)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(textFormat);
+                CheckAndClearOutPointer(textDocument);
+
+                auto newTextDocument = Make<CanvasTextDocument>(
+                    SharedDWriteFactory::GetOrCreate(),
+                    text,
+                    textFormat,
+                    width);
+                CheckMakeResult(newTextDocument);
+
+                ThrowIfFailed(newTextDocument.CopyTo(textDocument));
+            });
+    }
+
+
+    //
+    // ParagraphHeightIndex
+    //
+    // Node i (1-based) of the tree holds the sum of the heights of the
+    // LowestBit(i) paragraphs ending at paragraph i - 1.  m_tree[i - 1] is
+    // node i.
+    //
+
+    static size_t LowestBit(size_t value)
+    {
+        return value & (0 - value);
+    }
+
+
+    void ParagraphHeightIndex::Clear()
+    {
+        m_heights.clear();
+        m_tree.clear();
+    }
+
+
+    void ParagraphHeightIndex::Append(double height)
+    {
+        auto node = m_heights.size() + 1;
+
+        // The new node covers this paragraph and the ones before it that
+        // the nodes it replaces as the first node to cover them did.
+        auto value = height + GetTop(node - 1) - GetTop(node - LowestBit(node));
+
+        m_heights.push_back(height);
+        m_tree.push_back(value);
+    }
+
+
+    void ParagraphHeightIndex::RemoveLast()
+    {
+        // No other node includes the last paragraph.
+        m_heights.pop_back();
+        m_tree.pop_back();
+    }
+
+
+    void ParagraphHeightIndex::Set(size_t index, double height)
+    {
+        auto delta = height - m_heights[index];
+        m_heights[index] = height;
+
+        for (auto node = index + 1; node <= m_tree.size(); node += LowestBit(node))
+        {
+            m_tree[node - 1] += delta;
+        }
+    }
+
+
+    double ParagraphHeightIndex::GetTop(size_t index) const
+    {
+        double top = 0;
+
+        for (auto node = index; node > 0; node -= LowestBit(node))
+        {
+            top += m_tree[node - 1];
+        }
+
+        return top;
+    }
+
+
+    double ParagraphHeightIndex::GetTotal() const
+    {
+        return GetTop(m_tree.size());
+    }
+
+
+    size_t ParagraphHeightIndex::Find(double offset) const
+    {
+        if (m_tree.empty())
+            return 0;
+
+        size_t step = 1;
+        while (step * 2 <= m_tree.size())
+            step *= 2;
+
+        //
+        // Finds the number of paragraphs that end at or before offset, which
+        // is the index of the paragraph containing it.
+        //
+        size_t node = 0;
+        double remaining = offset;
+
+        for (; step > 0; step /= 2)
+        {
+            if (node + step <= m_tree.size() && m_tree[node + step - 1] <= remaining)
+            {
+                node += step;
+                remaining -= m_tree[node - 1];
+            }
+        }
+
+        return std::min(node, m_tree.size() - 1);
+    }
+
+
+    TextDocumentParagraph::TextDocumentParagraph(uint32_t start, uint32_t length, uint32_t separatorLength)
+        : Start(start)
+        , Length(length)
+        , SeparatorLength(separatorLength)
+        , HasMeasuredHeight(false)
+    {
+    }
+
+
+    static void ThrowIfInvalidWidth(float width)
+    {
+        if (!(width >= 0))
+            ThrowHR(E_INVALIDARG);
+    }
+
+
+    //
+    // Laid out once per document to find the format's line height and the
+    // average width of a character.
+    //
+    static const wchar_t c_estimationSampleText[] = L"The quick brown fox jumps over the lazy dog. 0123456789";
+
+
+    CanvasTextDocument::CanvasTextDocument(
+        std::shared_ptr<SharedDWriteFactory> dwriteFactory,
+        HSTRING text,
+        ICanvasTextFormat* textFormat,
+        float width)
+        : m_closed(false)
+        , m_dwriteFactory(dwriteFactory)
+        , m_drawTextOptions(CanvasDrawTextOptions::Default)
+        , m_lineHeight(0)
+        , m_averageCharacterWidth(0)
+        , m_width(width)
+        , m_paragraphLayoutCount(0)
+    {
+        CheckInPointer(dwriteFactory.get());
+        CheckInPointer(textFormat);
+        ThrowIfInvalidWidth(width);
+
+        ComPtr<ICanvasTextFormatInternal> formatInternal;
+        ThrowIfFailed(textFormat->QueryInterface(formatInternal.GetAddressOf()));
+
+        auto formatSnapshot = formatInternal->GetSnapshot();
+        m_format = formatSnapshot->Format;
+        m_drawTextOptions = formatSnapshot->DrawTextOptions;
+
+        // Paragraphs are always stacked top to bottom.
+        if (m_format->GetFlowDirection() != DWRITE_FLOW_DIRECTION_TOP_TO_BOTTOM)
+            ThrowHR(E_INVALIDARG);
+
+        auto sampleLength = static_cast<uint32_t>(_countof(c_estimationSampleText) - 1);
+
+        ComPtr<IDWriteTextLayout> sampleLayout;
+        ThrowIfFailed(m_dwriteFactory->Get()->CreateTextLayout(
+            c_estimationSampleText,
+            sampleLength,
+            m_format.Get(),
+            0,
+            0,
+            &sampleLayout));
+
+        ThrowIfFailed(sampleLayout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+        DWRITE_TEXT_METRICS sampleMetrics;
+        ThrowIfFailed(sampleLayout->GetMetrics(&sampleMetrics));
+
+        m_lineHeight = sampleMetrics.height;
+        m_averageCharacterWidth = sampleMetrics.widthIncludingTrailingWhitespace / sampleLength;
+
+        uint32_t textLength;
+        auto textBuffer = WindowsGetStringRawBuffer(text, &textLength);
+        m_text.assign(textBuffer, textLength);
+
+        SplitParagraphs(0);
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::get_Text(HSTRING* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckAndClearOutPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                ThrowIfFailed(WindowsCreateString(m_text.c_str(), static_cast<uint32_t>(m_text.size()), value));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::AppendText(HSTRING text)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                uint32_t textLength;
+                auto textBuffer = WindowsGetStringRawBuffer(text, &textLength);
+
+                if (textLength == 0)
+                    return;
+
+                auto removeLastParagraph =
+                    [&]
+                    {
+                        DiscardLayout(m_paragraphs.back());
+                        m_paragraphs.pop_back();
+                        m_heights.RemoveLast();
+                    };
+
+                //
+                // The last paragraph never has a separator, so the new text
+                // is a continuation of it.
+                //
+                auto splitStart = m_paragraphs.back().Start;
+                removeLastParagraph();
+
+                //
+                // A CR at the end of the old text becomes part of a CR LF if
+                // the new text starts with a LF.
+                //
+                if (!m_paragraphs.empty() && textBuffer[0] == L'\n')
+                {
+                    auto& previous = m_paragraphs.back();
+
+                    if (previous.SeparatorLength == 1 && m_text[previous.Start + previous.Length] == L'\r')
+                    {
+                        splitStart = previous.Start;
+                        removeLastParagraph();
+                    }
+                }
+
+                m_text.append(textBuffer, textLength);
+
+                SplitParagraphs(splitStart);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::get_Width(float* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                *value = m_width;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::put_Width(float value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                ThrowIfInvalidWidth(value);
+
+                if (value == m_width)
+                    return;
+
+                auto wordWrapping = (value == 0) ? DWRITE_WORD_WRAPPING_NO_WRAP : m_format->GetWordWrapping();
+
+                //
+                // Changing the width of an existing layout only breaks its
+                // lines again; the text isn't re-analyzed or re-shaped.
+                //
+                for (auto index : m_layoutCache)
+                {
+                    auto& layout = m_paragraphs[index].Layout;
+
+                    ThrowIfFailed(layout->SetMaxWidth(value));
+                    ThrowIfFailed(layout->SetWordWrapping(wordWrapping));
+                }
+
+                m_width = value;
+
+                //
+                // Every height may change, so they all go back to being
+                // estimates, and are measured again as they are drawn.
+                //
+                m_heights.Clear();
+
+                for (auto& paragraph : m_paragraphs)
+                {
+                    paragraph.HasMeasuredHeight = false;
+                    m_heights.Append(EstimateHeight(paragraph));
+                }
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::get_ParagraphCount(int32_t* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                *value = static_cast<int32_t>(m_paragraphs.size());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::get_EstimatedHeight(float* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                *value = static_cast<float>(m_heights.GetTotal());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::GetParagraphTop(
+        int32_t paragraphIndex,
+        float* top)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(top);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                if (paragraphIndex < 0 || static_cast<size_t>(paragraphIndex) >= m_paragraphs.size())
+                    ThrowHR(E_INVALIDARG);
+
+                *top = static_cast<float>(m_heights.GetTop(paragraphIndex));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::GetParagraphAtOffset(
+        float offset,
+        int32_t* paragraphIndex)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(paragraphIndex);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                *paragraphIndex = static_cast<int32_t>(m_heights.Find(offset));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextDocument::Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_closed = true;
+        m_text.clear();
+        m_paragraphs.clear();
+        m_heights.Clear();
+        m_layoutCache.clear();
+        m_format.Reset();
+
+        return S_OK;
+    }
+
+
+    void CanvasTextDocument::Draw(
+        ID2D1DeviceContext1* deviceContext,
+        const D2D1_RECT_F& viewport,
+        float scrollOffset,
+        ID2D1Brush* brush)
+    {
+        CheckInPointer(deviceContext);
+        CheckInPointer(brush);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ThrowIfClosed();
+
+        auto viewportHeight = viewport.bottom - viewport.top;
+
+        if (!(viewportHeight > 0) || !(viewport.right > viewport.left))
+            return;
+
+        //
+        // The viewport is the clip, so clipping each paragraph to its own
+        // layout box as well would be redundant.
+        //
+        auto options = static_cast<D2D1_DRAW_TEXT_OPTIONS>(
+            static_cast<D2D1_DRAW_TEXT_OPTIONS>(m_drawTextOptions) & ~D2D1_DRAW_TEXT_OPTIONS_CLIP);
+
+        deviceContext->PushAxisAlignedClip(&viewport, D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+
+        auto popClipWarden = MakeScopeWarden([&] { deviceContext->PopAxisAlignedClip(); });
+
+        //
+        // Laying out the paragraph that the estimates put at scrollOffset
+        // doesn't move its top, but may make it shorter than estimated, in
+        // which case scrollOffset is in one of the paragraphs after it.
+        //
+        auto index = m_heights.Find(scrollOffset);
+        EnsureLayout(index);
+
+        while (index + 1 < m_paragraphs.size() && m_heights.GetTop(index + 1) <= scrollOffset)
+        {
+            ++index;
+            EnsureLayout(index);
+        }
+
+        auto top = m_heights.GetTop(index);
+        auto bottom = static_cast<double>(scrollOffset) + viewportHeight;
+
+        for (; index < m_paragraphs.size() && top < bottom; ++index)
+        {
+            EnsureLayout(index);
+
+            auto origin = D2D1::Point2F(
+                viewport.left,
+                static_cast<float>(viewport.top + (top - scrollOffset)));
+
+            deviceContext->DrawTextLayout(
+                origin,
+                m_paragraphs[index].Layout.Get(),
+                brush,
+                options);
+
+            top += m_heights.GetHeight(index);
+        }
+
+        TrimLayoutCache();
+    }
+
+
+    void CanvasTextDocument::ThrowIfClosed()
+    {
+        if (m_closed)
+            ThrowHR(RO_E_CLOSED);
+    }
+
+
+    void CanvasTextDocument::SplitParagraphs(uint32_t start)
+    {
+        auto end = static_cast<uint32_t>(m_text.size());
+        auto paragraphStart = start;
+        auto position = start;
+
+        auto addParagraph =
+            [&](uint32_t paragraphEnd, uint32_t separatorLength)
+            {
+                m_paragraphs.push_back(TextDocumentParagraph(paragraphStart, paragraphEnd - paragraphStart, separatorLength));
+                m_heights.Append(EstimateHeight(m_paragraphs.back()));
+            };
+
+        while (position < end)
+        {
+            auto separatorLength = GetParagraphSeparatorLength(m_text, position);
+
+            if (separatorLength)
+            {
+                addParagraph(position, separatorLength);
+                position += separatorLength;
+                paragraphStart = position;
+            }
+            else
+            {
+                ++position;
+            }
+        }
+
+        //
+        // The last paragraph is the one that appended text continues, so it
+        // exists even when it's empty.
+        //
+        addParagraph(end, 0);
+    }
+
+
+    float CanvasTextDocument::EstimateHeight(const TextDocumentParagraph& paragraph) const
+    {
+        float lineCount = 1;
+
+        if (m_width > 0)
+        {
+            auto estimatedLineCount = ceil(paragraph.Length * m_averageCharacterWidth / m_width);
+
+            if (estimatedLineCount > lineCount)
+                lineCount = estimatedLineCount;
+        }
+
+        return lineCount * m_lineHeight;
+    }
+
+
+    void CanvasTextDocument::EnsureLayout(size_t index)
+    {
+        auto& paragraph = m_paragraphs[index];
+
+        if (paragraph.Layout)
+        {
+            m_layoutCache.splice(m_layoutCache.begin(), m_layoutCache, paragraph.LayoutCachePosition);
+        }
+        else
+        {
+            ComPtr<IDWriteTextLayout> layout;
+            ThrowIfFailed(m_dwriteFactory->Get()->CreateTextLayout(
+                m_text.c_str() + paragraph.Start,
+                paragraph.Length,
+                m_format.Get(),
+                m_width,
+                0,
+                &layout));
+
+            ThrowIfFailed(layout->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR));
+
+            if (m_width == 0)
+                ThrowIfFailed(layout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+            m_layoutCache.push_front(index);
+            paragraph.Layout = layout;
+            paragraph.LayoutCachePosition = m_layoutCache.begin();
+
+            ++m_paragraphLayoutCount;
+        }
+
+        //
+        // Heights outlive the layouts they were measured from, so a
+        // paragraph that is laid out again after being evicted from the
+        // cache doesn't need measuring again.
+        //
+        if (!paragraph.HasMeasuredHeight)
+        {
+            DWRITE_TEXT_METRICS metrics;
+            ThrowIfFailed(paragraph.Layout->GetMetrics(&metrics));
+
+            m_heights.Set(index, metrics.top + metrics.height);
+            paragraph.HasMeasuredHeight = true;
+        }
+    }
+
+
+    void CanvasTextDocument::DiscardLayout(TextDocumentParagraph& paragraph)
+    {
+        if (!paragraph.Layout)
+            return;
+
+        m_layoutCache.erase(paragraph.LayoutCachePosition);
+        paragraph.Layout.Reset();
+    }
+
+
+    void CanvasTextDocument::TrimLayoutCache()
+    {
+        while (m_layoutCache.size() > MaxCachedLayoutCount)
+        {
+            m_paragraphs[m_layoutCache.back()].Layout.Reset();
+            m_layoutCache.pop_back();
+        }
+    }
+
+
+    ActivatableClassWithFactory(CanvasTextDocument, CanvasTextDocumentFactory);
+}}}}
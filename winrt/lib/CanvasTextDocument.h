@@ -0,0 +1,219 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <Canvas.abi.h>
+
+#include <list>
+
+#include "SharedDWriteFactory.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    class CanvasTextDocumentFactory : public ActivationFactory<ICanvasTextDocumentFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextDocument, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            HSTRING text,
+            ICanvasTextFormat* textFormat,
+            float width,
+            ICanvasTextDocument** textDocument) override;
+    };
+
+
+    [uuid(6F1C8D2E-4B7A-4E95-9C03-A2E5D8B17F64)]
+    class ICanvasTextDocumentInternal : public IUnknown
+    {
+    public:
+        //
+        // Draws the part of the document that is scrollOffset or more from
+        // its top into viewport, clipped to the viewport.  Only paragraphs
+        // that are at least partly visible are laid out.
+        //
+        virtual void Draw(
+            ID2D1DeviceContext1* deviceContext,
+            const D2D1_RECT_F& viewport,
+            float scrollOffset,
+            ID2D1Brush* brush) = 0;
+    };
+
+
+    //
+    // Running totals of paragraph heights, so that paragraph tops can be
+    // found, and paragraphs found from offsets, in O(log n) time however
+    // many heights have changed (a Fenwick tree).  Totals are accumulated in
+    // doubles so that repeatedly replacing estimates with real heights
+    // doesn't build up rounding errors.
+    //
+    class ParagraphHeightIndex
+    {
+        std::vector<double> m_heights;
+        std::vector<double> m_tree;
+
+    public:
+        size_t GetCount() const { return m_heights.size(); }
+        double GetHeight(size_t index) const { return m_heights[index]; }
+
+        void Clear();
+        void Append(double height);
+        void RemoveLast();
+        void Set(size_t index, double height);
+
+        // Sum of the heights of the paragraphs before index.
+        double GetTop(size_t index) const;
+        double GetTotal() const;
+
+        // The paragraph containing offset, clamped to the first or last one.
+        size_t Find(double offset) const;
+    };
+
+
+    //
+    // One paragraph of a CanvasTextDocument.  The paragraph's characters are
+    // [Start, Start + Length), followed by SeparatorLength characters of
+    // paragraph separator that aren't part of its layout.
+    //
+    struct TextDocumentParagraph
+    {
+        TextDocumentParagraph(uint32_t start, uint32_t length, uint32_t separatorLength);
+
+        uint32_t Start;
+        uint32_t Length;
+        uint32_t SeparatorLength;
+
+        // Only set for recently drawn paragraphs; see CanvasTextDocument.
+        ComPtr<IDWriteTextLayout> Layout;
+        std::list<size_t>::iterator LayoutCachePosition;
+
+        // Otherwise the height in the ParagraphHeightIndex is an estimate.
+        bool HasMeasuredHeight;
+    };
+
+
+    //
+    // A long string drawn one screenful at a time.
+    //
+    // Paragraphs are laid out only when drawn, and the layouts of the most
+    // recently drawn MaxCachedLayoutCount paragraphs are kept (their indices
+    // are in m_layoutCache, most recent first).  Until a paragraph has been
+    // laid out its height is estimated from its length, using the line
+    // height and average character width of the format measured when the
+    // document is created.
+    //
+    // All methods are thread-safe.
+    //
+    class CanvasTextDocument : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasTextDocument,
+        ABI::Windows::Foundation::IClosable,
+        CloakedIid<ICanvasTextDocumentInternal>>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextDocument, BaseTrust);
+
+        std::mutex m_mutex;
+        bool m_closed;
+
+        std::shared_ptr<SharedDWriteFactory> m_dwriteFactory;
+
+        // Captured from the CanvasTextFormat when the document was created.
+        ComPtr<IDWriteTextFormat> m_format;
+        CanvasDrawTextOptions m_drawTextOptions;
+
+        // Used to estimate the heights of paragraphs that aren't laid out.
+        float m_lineHeight;
+        float m_averageCharacterWidth;
+
+        std::wstring m_text;
+        float m_width;
+
+        std::vector<TextDocumentParagraph> m_paragraphs;
+        ParagraphHeightIndex m_heights;
+
+        std::list<size_t> m_layoutCache;
+
+        // Number of paragraph layouts created, for tests.
+        uint64_t m_paragraphLayoutCount;
+
+    public:
+        static const size_t MaxCachedLayoutCount = 512;
+
+        CanvasTextDocument(
+            std::shared_ptr<SharedDWriteFactory> dwriteFactory,
+            HSTRING text,
+            ICanvasTextFormat* textFormat,
+            float width);
+
+        //
+        // ICanvasTextDocument
+        //
+
+        IFACEMETHOD(get_Text)(HSTRING* value) override;
+        IFACEMETHOD(AppendText)(HSTRING text) override;
+
+        IFACEMETHOD(get_Width)(float* value) override;
+        IFACEMETHOD(put_Width)(float value) override;
+
+        IFACEMETHOD(get_ParagraphCount)(int32_t* value) override;
+        IFACEMETHOD(get_EstimatedHeight)(float* value) override;
+
+        IFACEMETHOD(GetParagraphTop)(
+            int32_t paragraphIndex,
+            float* top) override;
+
+        IFACEMETHOD(GetParagraphAtOffset)(
+            float offset,
+            int32_t* paragraphIndex) override;
+
+        //
+        // IClosable
+        //
+
+        IFACEMETHOD(Close)() override;
+
+        //
+        // ICanvasTextDocumentInternal
+        //
+
+        virtual void Draw(
+            ID2D1DeviceContext1* deviceContext,
+            const D2D1_RECT_F& viewport,
+            float scrollOffset,
+            ID2D1Brush* brush) override;
+
+        const std::vector<TextDocumentParagraph>& GetParagraphs() const { return m_paragraphs; }
+        size_t GetCachedLayoutCount() const { return m_layoutCache.size(); }
+        uint64_t GetParagraphLayoutCount() const { return m_paragraphLayoutCount; }
+
+    private:
+        void ThrowIfClosed();
+
+        // Splits m_text from start onwards, appending the paragraphs.
+        void SplitParagraphs(uint32_t start);
+
+        float EstimateHeight(const TextDocumentParagraph& paragraph) const;
+
+        //
+        // Lays out a paragraph if it doesn't already have a layout, replaces
+        // its estimated height with the real one, and marks it as the most
+        // recently used layout.
+        //
+        void EnsureLayout(size_t index);
+
+        void DiscardLayout(TextDocumentParagraph& paragraph);
+        void TrimLayoutCache();
+    };
+}}}}
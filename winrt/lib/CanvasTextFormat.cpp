@@ -13,7 +13,7 @@
 #include "pch.h"
 
 #include "CanvasTextFormat.h"
-#include "WinStringBuilder.h"
+#include "CanvasTextMeasurement.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
@@ -377,41 +377,40 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
-    static WinString ToCanvasTrimmingDelimiter(uint32_t value)
+    static InternedString ToCanvasTrimmingDelimiter(uint32_t value)
     {
         // TODO #1658: Do the unicode conversion properly.
         // http://www.unicode.org/faq/utf_bom.html#utf16-3.  This code needs its
         // own set of tests.
 
-        WinStringBuilder builder;
+        wchar_t buffer[2];
 
         if (value == 0)
         {
-            return WinString();
+            return InternedString();
         }
         else if (value <= 0x0000FFFF)
         {
-            auto buffer = builder.Allocate(1);
-            buffer[0] = value;
+            buffer[0] = static_cast<wchar_t>(value);
+            return InternedString(buffer, 1);
         }
         else
         {
-            auto buffer = builder.Allocate(2);
-            *(reinterpret_cast<uint32_t*>(buffer)) = value;
+            buffer[0] = static_cast<wchar_t>(value & 0xFFFF);
+            buffer[1] = static_cast<wchar_t>(value >> 16);
+            return InternedString(buffer, 2);
         }
-
-        return builder.Get();
     }
 
 
-    static uint32_t ToTrimmingDelimiter(const WinString& value)
+    static uint32_t ToTrimmingDelimiter(const InternedString& value)
     {
         // TODO #1658: Do the unicode conversion properly.
         // http://www.unicode.org/faq/utf_bom.html#utf16-3.  This code needs its
         // own set of tests.
 
-        uint32_t sourceStringLength = 0;
-        auto sourceString = WindowsGetStringRawBuffer(value, &sourceStringLength);
+        auto sourceStringLength = value.GetLength();
+        auto sourceString = value.GetBuffer();
 
         if (sourceStringLength == 0)
         {
@@ -447,23 +446,44 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
-    static WinString GetFontFamilyName(IDWriteTextFormat* format)
+    //
+    // Reads a string from DirectWrite straight into the intern pool.  Family
+    // and locale names are short enough to fit in the local buffer, so this
+    // only allocates when the string isn't already in use.
+    //
+    template<typename GET_LENGTH_FN, typename GET_FN>
+    static InternedString GetInternedString(GET_LENGTH_FN&& getLength, GET_FN&& get)
     {
-        WinStringBuilder stringBuilder;
-        auto length = format->GetFontFamilyNameLength() + 1;
-        auto buffer = stringBuilder.Allocate(length);
-        ThrowIfFailed(format->GetFontFamilyName(buffer, length));
-        return stringBuilder.Get();
+        uint32_t length = getLength() + 1;
+
+        wchar_t localBuffer[64];
+        std::vector<wchar_t> heapBuffer;
+        wchar_t* buffer = localBuffer;
+
+        if (length > _countof(localBuffer))
+        {
+            heapBuffer.resize(length);
+            buffer = &heapBuffer.front();
+        }
+
+        ThrowIfFailed(get(buffer, length));
+        return InternedString(buffer);
     }
 
 
-    static WinString GetLocaleName(IDWriteTextFormat* format)
+    static InternedString GetFontFamilyName(IDWriteTextFormat* format)
     {
-        WinStringBuilder stringBuilder;
-        auto length = format->GetLocaleNameLength() + 1;
-        auto buffer = stringBuilder.Allocate(length);
-        ThrowIfFailed(format->GetLocaleName(buffer, length));
-        return stringBuilder.Get();
+        return GetInternedString(
+            [=] { return format->GetFontFamilyNameLength(); },
+            [=] (wchar_t* buffer, uint32_t length) { return format->GetFontFamilyName(buffer, length); });
+    }
+
+
+    static InternedString GetLocaleName(IDWriteTextFormat* format)
+    {
+        return GetInternedString(
+            [=] { return format->GetLocaleNameLength(); },
+            [=] (wchar_t* buffer, uint32_t length) { return format->GetLocaleName(buffer, length); });
     }
 
     //
@@ -483,6 +503,63 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
+    IFACEMETHODIMP CanvasTextFormatFactory::PreloadFontsAsync(
+        uint32_t formatCount,
+        ICanvasTextFormat** formats,
+        ABI::Windows::Foundation::IAsyncAction** action)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                if (formatCount != 0)
+                    CheckInPointer(formats);
+                CheckAndClearOutPointer(action);
+
+                std::vector<ComPtr<ICanvasTextFormatInternal>> formatsToPreload;
+                formatsToPreload.reserve(formatCount);
+
+                for (uint32_t i = 0; i < formatCount; ++i)
+                {
+                    CheckInPointer(formats[i]);
+
+                    ComPtr<ICanvasTextFormatInternal> format;
+                    ThrowIfFailed(formats[i]->QueryInterface(format.GetAddressOf()));
+                    formatsToPreload.push_back(format);
+                }
+
+                auto dwriteFactory = GetFontFaceCache();
+
+                //
+                // Even realizing a format can be slow the first time, since
+                // it opens the system font collection, so that is done on the
+                // background thread too.
+                //
+                auto asyncAction = Make<AsyncAction>([=]
+                {
+                    for (auto const& format : formatsToPreload)
+                    {
+                        auto dwriteFormat = format->GetSnapshot()->Format;
+
+                        ComPtr<IDWriteFontCollection> fontCollection;
+                        ThrowIfFailed(dwriteFormat->GetFontCollection(&fontCollection));
+
+                        auto familyName = GetFontFamilyName(dwriteFormat.Get());
+
+                        dwriteFactory->GetOrCreateFontFace(
+                            fontCollection.Get(),
+                            familyName.GetBuffer(),
+                            dwriteFormat->GetFontWeight(),
+                            dwriteFormat->GetFontStyle(),
+                            dwriteFormat->GetFontStretch());
+                    }
+                });
+
+                CheckMakeResult(asyncAction);
+                ThrowIfFailed(asyncAction.CopyTo(action));
+            });
+    }
+
+
     IFACEMETHODIMP CanvasTextFormatFactory::GetOrCreate(
         IUnknown* resource,
         IInspectable** wrapper)
@@ -500,6 +577,17 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
+    std::shared_ptr<SharedDWriteFactory> CanvasTextFormatFactory::GetFontFaceCache()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_fontFaceCache)
+            m_fontFaceCache = SharedDWriteFactory::GetOrCreate();
+
+        return m_fontFaceCache;
+    }
+
+
     //
     // CanvasTextFormat implementation
     //
@@ -524,20 +612,26 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         , m_trimmingDelimiterCount(0)
         , m_wordWrapping(CanvasWordWrapping::Wrap)
         , m_drawTextOptions(CanvasDrawTextOptions::Default)
+        , m_realizationId(0)
     {
     }
 
 
     CanvasTextFormat::CanvasTextFormat(IDWriteTextFormat* format)
         : m_closed(false)
+        , m_drawTextOptions(CanvasDrawTextOptions::Default)
         , m_format(format)
+        , m_realizationId(0)
     {
         SetShadowPropertiesFromDWrite();
+        UpdateRealizationId();
     }
 
 
     IFACEMETHODIMP CanvasTextFormat::Close()
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
         m_closed = true;
         return S_OK;
     }
@@ -556,30 +650,215 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             [&]
             {
                 CheckAndClearOutPointer(value);
-                ThrowIfFailed(GetRealizedTextFormat().CopyTo(value));
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                //
+                // The app may modify the format we hand out, so it mustn't be
+                // one that other CanvasTextFormats are sharing.
+                //
+                if (!m_format || m_internedFormat)
+                {
+                    Unrealize();
+                    CreateTextFormatFromShadowProperties();
+                    UpdateRealizationId();
+                    PublishSnapshot();
+                }
+
+                ThrowIfFailed(m_format.CopyTo(value));
             });
     }
 
 
+    static ComPtr<CanvasTextMeasurement> MeasureWithSnapshot(
+        const TextFormatSnapshot& snapshot,
+        HSTRING text,
+        float requestedWidth)
+    {
+        uint32_t textLength;
+        auto textBuffer = WindowsGetStringRawBuffer(text, &textLength);
+
+        auto measurement = Make<CanvasTextMeasurement>(
+            CanvasTextMeasurementCache::GetShared().GetOrCreate(
+                snapshot.Format.Get(),
+                snapshot.RealizationId,
+                textBuffer,
+                textLength,
+                requestedWidth));
+        CheckMakeResult(measurement);
+
+        return measurement;
+    }
+
+
+    std::shared_ptr<const TextFormatSnapshot> CanvasTextFormat::GetSnapshotForMeasuring(float requestedWidth)
+    {
+        ThrowIfNegativeOrNan(requestedWidth);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ThrowIfClosed();
+        }
+
+        return GetSnapshot();
+    }
+
+
+    IFACEMETHODIMP CanvasTextFormat::MeasureText(
+        HSTRING text,
+        float requestedWidth,
+        ICanvasTextMeasurement** measurement)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckAndClearOutPointer(measurement);
+
+                auto snapshot = GetSnapshotForMeasuring(requestedWidth);
+
+                ThrowIfFailed(MeasureWithSnapshot(*snapshot, text, requestedWidth).CopyTo(measurement));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextFormat::MeasureTextAsync(
+        HSTRING rawText,
+        float requestedWidth,
+        ABI::Windows::Foundation::IAsyncOperation<CanvasTextMeasurement*>** measurement)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckAndClearOutPointer(measurement);
+
+                //
+                // The snapshot is taken now, so that changes made to the
+                // format after this returns don't affect the measurement.
+                //
+                auto snapshot = GetSnapshotForMeasuring(requestedWidth);
+
+                WinString text;
+                text = rawText;
+
+                auto asyncOperation = Make<AsyncOperation<CanvasTextMeasurement>>([=]
+                {
+                    return MeasureWithSnapshot(*snapshot, text, requestedWidth);
+                });
+
+                CheckMakeResult(asyncOperation);
+                ThrowIfFailed(asyncOperation.CopyTo(measurement));
+            });
+    }
+
+
+    static volatile LONG64 s_realizationCount = 0;
+
+
+    //
+    // Ids are unique across all formats in the process, so a cache keyed on
+    // the id never confuses two formats that happen to be allocated at the
+    // same address.
+    //
+    static volatile LONG64 s_nextRealizationId = 0;
+
+
+    static uint64_t AllocateRealizationId()
+    {
+        return static_cast<uint64_t>(InterlockedIncrement64(&s_nextRealizationId));
+    }
+
+
+    std::shared_ptr<const TextFormatSnapshot> CanvasTextFormat::GetSnapshot(bool* wasRealized)
+    {
+        if (wasRealized)
+            *wasRealized = false;
+
+        auto snapshot = std::atomic_load(&m_snapshot);
+        if (snapshot)
+            return snapshot;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        bool realized = EnsureRealized();
+        PublishSnapshot();
+
+        if (wasRealized)
+            *wasRealized = realized;
+
+        return std::atomic_load(&m_snapshot);
+    }
+
+
+    void CanvasTextFormat::DiscardSnapshot()
+    {
+        std::atomic_store(&m_snapshot, std::shared_ptr<const TextFormatSnapshot>());
+    }
+
+
+    void CanvasTextFormat::PublishSnapshot()
+    {
+        std::shared_ptr<const TextFormatSnapshot> snapshot;
+
+        if (m_format)
+            snapshot = std::make_shared<TextFormatSnapshot>(m_format.Get(), m_realizationId, m_drawTextOptions);
+
+        std::atomic_store(&m_snapshot, snapshot);
+    }
+
+
     ComPtr<IDWriteTextFormat> CanvasTextFormat::GetRealizedTextFormat()
+    {
+        return GetSnapshot()->Format;
+    }
+
+
+    bool CanvasTextFormat::EnsureRealized()
     {
         if (m_format)
-            return m_format;
+            return false;
+
+        auto key = GetInternKey();
+
+        auto internedFormat = CanvasTextFormatInternTable::Find(key);
+
+        bool realized = false;
+
+        if (!internedFormat)
+        {
+            CreateTextFormatFromShadowProperties();
+            realized = true;
+
+            internedFormat = CanvasTextFormatInternTable::Add(
+                key,
+                std::make_shared<InternedTextFormat>(m_format.Get(), AllocateRealizationId()));
+        }
+
+        m_internedFormat = internedFormat;
+        m_format = internedFormat->GetFormat();
+        m_realizationId = internedFormat->GetRealizationId();
+
+        return realized;
+    }
+
+
+    void CanvasTextFormat::CreateTextFormatFromShadowProperties()
+    {
+        assert(!m_format);
 
-        ComPtr<IDWriteFactory2> factory;
-        ThrowIfFailed(DWriteCreateFactory(
-            DWRITE_FACTORY_TYPE_SHARED,
-            __uuidof(&factory),
-            static_cast<IUnknown**>(&factory)));
+        // Don't leave a half realized format behind if any of this fails
+        auto warden = MakeScopeWarden([&] { m_format.Reset(); });
 
-        ThrowIfFailed(factory->CreateTextFormat(
-            static_cast<const wchar_t*>(m_fontFamilyName),
+        if (!m_dwriteFactory)
+            m_dwriteFactory = SharedDWriteFactory::GetOrCreate();
+
+        ThrowIfFailed(m_dwriteFactory->Get()->CreateTextFormat(
+            m_fontFamilyName.GetBuffer(),
             m_fontCollection.Get(),
             ToFontWeight(m_fontWeight),
             ToFontStyle(m_fontStyle),
             ToFontStretch(m_fontStretch),
             m_fontSize,
-            static_cast<const wchar_t*>(m_localeName),
+            m_localeName.GetBuffer(),
             &m_format));
 
         RealizeFlowDirection();
@@ -591,13 +870,61 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         RealizeTrimming();
         RealizeWordWrapping();
 
-        return m_format;
+        warden.Dismiss();
+
+        InterlockedIncrement64(&s_realizationCount);
+    }
+
+
+    TextFormatKey CanvasTextFormat::GetInternKey() const
+    {
+        TextFormatKey key;
+
+        key.FontCollection         = m_fontCollection.Get();
+        key.FontFamilyName         = m_fontFamilyName;
+        key.LocaleName             = m_localeName;
+        key.TrimmingDelimiter      = m_trimmingDelimiter;
+        key.FlowDirection          = m_flowDirection;
+        key.FontSize               = m_fontSize;
+        key.FontStretch            = m_fontStretch;
+        key.FontStyle              = m_fontStyle;
+        key.FontWeight             = m_fontWeight.Weight;
+        key.IncrementalTabStop     = m_incrementalTabStop;
+        key.LineSpacingMethod      = m_lineSpacingMethod;
+        key.LineSpacing            = m_lineSpacing;
+        key.LineSpacingBaseline    = m_lineSpacingBaseline;
+        key.VerticalAlignment      = m_verticalAlignment;
+        key.ReadingDirection       = m_readingDirection;
+        key.ParagraphAlignment     = m_paragraphAlignment;
+        key.TrimmingGranularity    = m_trimmingGranularity;
+        key.TrimmingDelimiterCount = m_trimmingDelimiterCount;
+        key.WordWrapping           = m_wordWrapping;
+
+        return key;
+    }
+
+
+    uint64_t CanvasTextFormat::GetRealizationCount()
+    {
+        return static_cast<uint64_t>(InterlockedCompareExchange64(&s_realizationCount, 0, 0));
     }
 
 
     CanvasDrawTextOptions CanvasTextFormat::GetDrawTextOptions()
     {
-        return m_drawTextOptions;
+        return GetSnapshot()->DrawTextOptions;
+    }
+
+
+    uint64_t CanvasTextFormat::GetRealizationId()
+    {
+        return GetSnapshot()->RealizationId;
+    }
+
+
+    void CanvasTextFormat::UpdateRealizationId()
+    {
+        m_realizationId = AllocateRealizationId();
     }
 
 
@@ -605,12 +932,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     {
         //
         // We're about to throw away m_format, so we need to extract all the
-        // values stored on it into our shadow copies.
+        // values stored on it into our shadow copies.  Shared formats are
+        // never modified, so the shadow copies are already up to date.
         //
-        if (m_format)
+        if (m_format && !m_internedFormat)
             SetShadowPropertiesFromDWrite();
 
         m_format.Reset();
+        m_internedFormat.reset();
+        DiscardSnapshot();
     }
 
 
@@ -632,7 +962,6 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         m_paragraphAlignment = ToWindowsParagraphAlignment(m_format->GetTextAlignment());
         m_readingDirection   = ToCanvasTextDirection(m_format->GetReadingDirection());
         m_wordWrapping       = ToCanvasWordWrapping(m_format->GetWordWrapping());
-        m_drawTextOptions    = CanvasDrawTextOptions::Default;
 
         DWRITE_LINE_SPACING_METHOD method{};
         ThrowIfFailed(m_format->GetLineSpacing(&method, &m_lineSpacing, &m_lineSpacingBaseline));
@@ -675,7 +1004,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
     template<typename HSTRING>
-    static bool IsSame(WinString* outputValue, const HSTRING& value)
+    static bool IsSame(InternedString* outputValue, const HSTRING& value)
     {
         return outputValue->Equals(value);
     }
@@ -700,9 +1029,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
     template<typename HSTRING>
-    static void SetFrom(WinString* outputValue, const HSTRING& value)
+    static void SetFrom(InternedString* outputValue, const HSTRING& value)
     {
-        *outputValue = value;
+        *outputValue = InternedString(value);
     }
 
 
@@ -713,6 +1042,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             [&]
             {
                 CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
                 ThrowIfClosed();
                 
                 if (m_format)
@@ -724,13 +1056,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     
     template<typename T, typename TT, typename FNV>
-    HRESULT __declspec(nothrow) CanvasTextFormat::PropertyPut(T value, TT* dest, FNV&& validator, void(CanvasTextFormat::*realizer)())
+    HRESULT __declspec(nothrow) CanvasTextFormat::PropertyPut(T value, TT* dest, FNV&& validator)
     {
         return ExceptionBoundary(
             [&]
             {
                 validator(value);
 
+                std::lock_guard<std::mutex> lock(m_mutex);
+
                 ThrowIfClosed();
 
                 if (IsSame(dest, value))
@@ -740,27 +1074,24 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                     return;
                 }
 
-                if (!realizer)
-                {
-                    // If there's no realizer set then we're going to have to
-                    // throw away m_format (ready to be recreated the next time
-                    // it is needed)
-                    Unrealize();
-                }
+                //
+                // m_format is never modified once it has been realized: it may
+                // be shared with other CanvasTextFormats, and drawing threads
+                // may be using it through a snapshot they've already taken.
+                // Instead it is thrown away, and a new one is realized from
+                // the shadow properties the next time it is needed.
+                //
+                Unrealize();
 
                 // Set the shadow value
                 SetFrom(dest, value);
-
-                // Realize the value on the dwrite object, if we can
-                if (m_format && realizer)
-                    (this->*realizer)();
             });
     }
 
     template<typename T, typename TT>
-    HRESULT __declspec(nothrow) CanvasTextFormat::PropertyPut(T value, TT* dest, void(CanvasTextFormat::*realizer)())
+    HRESULT __declspec(nothrow) CanvasTextFormat::PropertyPut(T value, TT* dest)
     {
-        return PropertyPut(value, dest, [](T){}, realizer);
+        return PropertyPut(value, dest, [](T){});
     }
 
     //
@@ -781,8 +1112,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_flowDirection, 
-            ThrowIfInvalid<CanvasTextDirection>,
-            &CanvasTextFormat::RealizeFlowDirection);
+            ThrowIfInvalid<CanvasTextDirection>);
     }
 
 
@@ -797,13 +1127,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     IFACEMETHODIMP CanvasTextFormat::get_FontFamily(HSTRING* value)
     {
+        // The family can't be changed on an IDWriteTextFormat, so the shadow
+        // value is always current.
         return PropertyGet(
             value,
             m_fontFamilyName,
-            [&]
-            {
-                return GetFontFamilyName(m_format.Get());
-            });
+            [&] { return m_fontFamilyName; });
     }
 
 
@@ -916,8 +1245,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_incrementalTabStop, 
-            ThrowIfNegativeOrNan,
-            &CanvasTextFormat::RealizeIncrementalTabStop);
+            ThrowIfNegativeOrNan);
     }
 
 
@@ -947,8 +1275,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_lineSpacingMethod, 
-            ThrowIfInvalid<CanvasLineSpacingMethod>,
-            &CanvasTextFormat::RealizeLineSpacing);
+            ThrowIfInvalid<CanvasLineSpacingMethod>);
     }
 
     //
@@ -969,8 +1296,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_lineSpacing, 
-            ThrowIfNegativeOrNan,
-            &CanvasTextFormat::RealizeLineSpacing);
+            ThrowIfNegativeOrNan);
     }
 
     //
@@ -991,8 +1317,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_lineSpacingBaseline, 
-            ThrowIfNan,
-            &CanvasTextFormat::RealizeLineSpacing);
+            ThrowIfNan);
     }
 
 
@@ -1011,13 +1336,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     IFACEMETHODIMP CanvasTextFormat::get_LocaleName(HSTRING* value)
     {
+        // As with the family, the shadow value is always current.
         return PropertyGet(
             value,
             m_localeName,
-            [&]
-            {
-                return GetLocaleName(m_format.Get());
-            });
+            [&] { return m_localeName; });
     }
 
 
@@ -1047,8 +1370,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_verticalAlignment,
-            ThrowIfInvalid<CanvasVerticalAlignment>,
-            &CanvasTextFormat::RealizeParagraphAlignment);
+            ThrowIfInvalid<CanvasVerticalAlignment>);
     }
 
 
@@ -1075,8 +1397,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_readingDirection,
-            ThrowIfInvalid<CanvasTextDirection>,
-            &CanvasTextFormat::RealizeReadingDirection);
+            ThrowIfInvalid<CanvasTextDirection>);
     }
 
 
@@ -1104,8 +1425,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_paragraphAlignment,
-            ThrowIfInvalid<ABI::Windows::UI::Text::ParagraphAlignment>,
-            &CanvasTextFormat::RealizeTextAlignment);
+            ThrowIfInvalid<ABI::Windows::UI::Text::ParagraphAlignment>);
     }
 
     void CanvasTextFormat::RealizeTextAlignment()
@@ -1131,8 +1451,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_trimmingGranularity,
-            ThrowIfInvalid<CanvasTextTrimmingGranularity>,
-            &CanvasTextFormat::RealizeTrimming);        
+            ThrowIfInvalid<CanvasTextTrimmingGranularity>);        
     }
 
     //
@@ -1153,8 +1472,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_trimmingDelimiter,
-            ThrowIfInvalidTrimmingDelimiter,
-            &CanvasTextFormat::RealizeTrimming);
+            ThrowIfInvalidTrimmingDelimiter);
     }
 
     //
@@ -1175,8 +1493,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_trimmingDelimiterCount,
-            ThrowIfNegative<int32_t>,
-            &CanvasTextFormat::RealizeTrimming);
+            ThrowIfNegative<int32_t>);
     }
 
 
@@ -1211,8 +1528,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return PropertyPut(
             value, 
             &m_wordWrapping,
-            ThrowIfInvalid<CanvasWordWrapping>,
-            &CanvasTextFormat::RealizeWordWrapping);
+            ThrowIfInvalid<CanvasWordWrapping>);
     }
 
 
@@ -1231,6 +1547,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             [&]
             {
                 CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
                 ThrowIfClosed();
                 *value = m_drawTextOptions;
             });
@@ -1242,6 +1561,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return ExceptionBoundary(
             [&]
             {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
                 ThrowIfClosed();
 
                 auto validOptions = 
@@ -1253,6 +1574,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                     ThrowHR(E_INVALIDARG);
 
                 m_drawTextOptions = value;
+
+                PublishSnapshot();
             });
     }
 
@@ -14,6 +14,8 @@
 
 #include <Canvas.abi.h>
 
+#include "CanvasTextFormatInternTable.h"
+#include "SharedDWriteFactory.h"
 #include "WinStringWrapper.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
@@ -21,10 +23,21 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     using namespace ::Microsoft::WRL;
 
     class CanvasTextFormatFactory : public ActivationFactory<
+        ICanvasTextFormatStatics,
         CloakedIid<ICanvasFactoryNative>>
     {
         InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextFormat, BaseTrust);
 
+        //
+        // The font faces loaded by PreloadFontsAsync are cached on the shared
+        // DWrite factory.  The activation factory holds on to it once fonts
+        // have been preloaded, so that the cache lives as long as the module
+        // rather than only as long as whichever text formats happen to
+        // reference the shared factory.
+        //
+        std::mutex m_mutex;
+        std::shared_ptr<SharedDWriteFactory> m_fontFaceCache;
+
     public:
         //
         // ActivationFactory
@@ -32,6 +45,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         IFACEMETHOD(ActivateInstance)(IInspectable** obj) override;
 
+        //
+        // ICanvasTextFormatStatics
+        //
+
+        IFACEMETHOD(PreloadFontsAsync)(
+            uint32_t formatCount,
+            ICanvasTextFormat** formats,
+            ABI::Windows::Foundation::IAsyncAction** action) override;
+
         //
         // ICanvasFactoryNative
         //
@@ -39,6 +61,29 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHOD(GetOrCreate)(
             IUnknown* resource,
             IInspectable** wrapper) override;
+
+    private:
+        std::shared_ptr<SharedDWriteFactory> GetFontFaceCache();
+    };
+
+
+    //
+    // Everything needed to draw with a CanvasTextFormat, as it was at one
+    // moment.  Snapshots are immutable and so can be used from any thread
+    // while the CanvasTextFormat they came from is being changed.
+    //
+    struct TextFormatSnapshot
+    {
+        TextFormatSnapshot(IDWriteTextFormat* format, uint64_t realizationId, CanvasDrawTextOptions drawTextOptions)
+            : Format(format)
+            , RealizationId(realizationId)
+            , DrawTextOptions(drawTextOptions)
+        {
+        }
+
+        const ComPtr<IDWriteTextFormat> Format;
+        const uint64_t RealizationId;
+        const CanvasDrawTextOptions DrawTextOptions;
     };
 
 
@@ -46,8 +91,36 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     class ICanvasTextFormatInternal : public IUnknown
     {
     public:
+        //
+        // Returns the current snapshot, realizing the format if necessary.
+        // Once a snapshot has been published this doesn't take the format's
+        // lock, so it is cheap to call from many drawing threads at once.
+        //
+        // If wasRealized is not null it is set to whether a new DWrite text
+        // format was created; formats found in the intern table don't count.
+        //
+        virtual std::shared_ptr<const TextFormatSnapshot> GetSnapshot(bool* wasRealized) = 0;
+
+        std::shared_ptr<const TextFormatSnapshot> GetSnapshot()
+        {
+            return GetSnapshot(nullptr);
+        }
+
+        //
+        // These each return one part of the current snapshot.  Callers that
+        // need more than one part should use GetSnapshot, so that they don't
+        // see a mix of two different snapshots.
+        //
         virtual ComPtr<IDWriteTextFormat> GetRealizedTextFormat() = 0;
         virtual CanvasDrawTextOptions GetDrawTextOptions() = 0;
+
+        //
+        // Identifies the current state of the realized IDWriteTextFormat.  This
+        // changes whenever the format is recreated or one of its properties is
+        // modified, so it can be used to key caches of objects derived from
+        // the format (eg text layouts).
+        //
+        virtual uint64_t GetRealizationId() = 0;
     };
 
 
@@ -57,6 +130,26 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     // keeps track of shadow copies of properties and recreates ("realizes") an
     // IDWriteTextFormat as necessary.
     //
+    // Setters never create an IDWriteTextFormat themselves: once m_format
+    // has been discarded they only update the shadow copies, and the format
+    // is realized again the next time it is needed.  So setting several
+    // properties in a row costs at most one realization, without needing
+    // an explicit BeginUpdate / EndUpdate.
+    //
+    // Realized formats are interned (see CanvasTextFormatInternTable), so
+    // CanvasTextFormats with the same properties share a single
+    // IDWriteTextFormat.  A shared format is never modified; setting a
+    // property on a CanvasTextFormat that uses one unrealizes it instead.
+    // Formats handed out through GetResource, or wrapped with GetOrCreate,
+    // belong to the app and so are never shared.
+    //
+    // All methods are thread-safe.  Drawing uses snapshots (see
+    // TextFormatSnapshot), which are published atomically whenever the
+    // format changes and read without locking.  Setting a property never
+    // modifies a realized IDWriteTextFormat, since a snapshot of it may be in
+    // use; the format is discarded and a new one realized instead.  So a
+    // format the app got from GetResource doesn't follow later changes.
+    //
     class CanvasTextFormat : public RuntimeClass<
         RuntimeClassFlags<WinRtClassicComMix>,
         ICanvasTextFormat,
@@ -65,7 +158,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         CloakedIid<ICanvasResourceWrapperNative>>
     {
         InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextFormat, BaseTrust);
-        
+
+        //
+        // Guards everything below, apart from m_snapshot which is only
+        // accessed with std::atomic_load / std::atomic_store.
+        //
+        std::mutex m_mutex;
+
         //
         // Has Close() been called?  It is tempting to use a null m_format to
         // indicated closed, but we need to be able to tell the difference
@@ -75,11 +174,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         //
         // Shadow properties.  These values are used to recreate m_format when
-        // it is required.
+        // it is required.  The strings are interned, so that formats with the
+        // same family or locale share one copy and can be interned themselves
+        // without comparing characters.
         //
         ComPtr<IDWriteFontCollection> m_fontCollection;
         CanvasTextDirection m_flowDirection;
-        WinString m_fontFamilyName;
+        InternedString m_fontFamilyName;
         float m_fontSize;
         ABI::Windows::UI::Text::FontStretch m_fontStretch;
         ABI::Windows::UI::Text::FontStyle m_fontStyle;
@@ -88,12 +189,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         CanvasLineSpacingMethod m_lineSpacingMethod;
         float m_lineSpacing;
         float m_lineSpacingBaseline;
-        WinString m_localeName;
+        InternedString m_localeName;
         CanvasVerticalAlignment m_verticalAlignment;
         CanvasTextDirection m_readingDirection;
         ABI::Windows::UI::Text::ParagraphAlignment m_paragraphAlignment;
         CanvasTextTrimmingGranularity m_trimmingGranularity;
-        WinString m_trimmingDelimiter;
+        InternedString m_trimmingDelimiter;
         int32_t m_trimmingDelimiterCount;
         CanvasWordWrapping m_wordWrapping;
 
@@ -109,6 +210,29 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         //
         ComPtr<IDWriteTextFormat> m_format;
 
+        //
+        // Held from the first realization on, so that re-realizing after a
+        // property change doesn't need to look the factory up again.
+        //
+        std::shared_ptr<SharedDWriteFactory> m_dwriteFactory;
+
+        //
+        // Non-null if m_format is shared with other CanvasTextFormats, in
+        // which case it must not be modified.
+        //
+        std::shared_ptr<InternedTextFormat> m_internedFormat;
+
+        //
+        // Process-unique identifier for the current state of m_format.
+        //
+        uint64_t m_realizationId;
+
+        //
+        // Snapshot of m_format, m_realizationId and m_drawTextOptions, or null
+        // if m_format hasn't been realized since the last change.
+        //
+        std::shared_ptr<const TextFormatSnapshot> m_snapshot;
+
     public:
         CanvasTextFormat();
         CanvasTextFormat(IDWriteTextFormat* format);
@@ -142,6 +266,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
 #undef PROPERTY
 
+        IFACEMETHOD(MeasureText)(
+            HSTRING text,
+            float requestedWidth,
+            ICanvasTextMeasurement** measurement) override;
+
+        IFACEMETHOD(MeasureTextAsync)(
+            HSTRING text,
+            float requestedWidth,
+            ABI::Windows::Foundation::IAsyncOperation<CanvasTextMeasurement*>** measurement) override;
+
         //
         // IClosable
         //
@@ -152,8 +286,20 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         // ICanvasTextFormatInternal
         //
 
+        virtual std::shared_ptr<const TextFormatSnapshot> GetSnapshot(bool* wasRealized) override;
         virtual ComPtr<IDWriteTextFormat> GetRealizedTextFormat() override;
         virtual CanvasDrawTextOptions GetDrawTextOptions() override;
+        virtual uint64_t GetRealizationId() override;
+
+        std::shared_ptr<const TextFormatSnapshot> GetSnapshot()
+        {
+            return GetSnapshot(nullptr);
+        }
+
+        // Number of DWrite text formats created by all CanvasTextFormats in
+        // the process.  This is only used to test interning; drawing
+        // sessions count their own realizations through GetSnapshot.
+        static uint64_t GetRealizationCount();
 
         //
         // ICanvasResourceWrapperNative
@@ -165,17 +311,26 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     private:
         void ThrowIfClosed();
 
+        std::shared_ptr<const TextFormatSnapshot> GetSnapshotForMeasuring(float requestedWidth);
+
         template<typename T, typename ST, typename FN>
         HRESULT __declspec(nothrow) PropertyGet(T* value, const ST& shadowValue, FN realizedGetter);
 
         template<typename T, typename TT, typename FNV>
-        HRESULT __declspec(nothrow) PropertyPut(T value, TT* dest, FNV&& validator, void(CanvasTextFormat::*realizer)() = nullptr);
+        HRESULT __declspec(nothrow) PropertyPut(T value, TT* dest, FNV&& validator);
         
         template<typename T, typename TT>
-        HRESULT __declspec(nothrow) PropertyPut(T value, TT* dest, void(CanvasTextFormat::*realizer)() = nullptr);
+        HRESULT __declspec(nothrow) PropertyPut(T value, TT* dest);
 
         void SetShadowPropertiesFromDWrite();
+        TextFormatKey GetInternKey() const;
+
+        bool EnsureRealized();      // returns true if a new format was created
+        void CreateTextFormatFromShadowProperties();
+        void DiscardSnapshot();
+        void PublishSnapshot();
 
+        void UpdateRealizationId();
         void Unrealize();
         void RealizeFlowDirection();
         void RealizeIncrementalTabStop();
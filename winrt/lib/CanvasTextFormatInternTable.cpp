@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasTextFormatInternTable.h"
+#include "HashHelpers.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // TextFormatKey
+    //
+
+    TextFormatKey::TextFormatKey()
+        : FontCollection(nullptr)
+        , FlowDirection(CanvasTextDirection::TopToBottom)
+        , FontSize(0)
+        , FontStretch(ABI::Windows::UI::Text::FontStretch_Normal)
+        , FontStyle(ABI::Windows::UI::Text::FontStyle_Normal)
+        , FontWeight(0)
+        , IncrementalTabStop(0)
+        , LineSpacingMethod(CanvasLineSpacingMethod::Default)
+        , LineSpacing(0)
+        , LineSpacingBaseline(0)
+        , VerticalAlignment(CanvasVerticalAlignment::Top)
+        , ReadingDirection(CanvasTextDirection::LeftToRight)
+        , ParagraphAlignment(ABI::Windows::UI::Text::ParagraphAlignment_Left)
+        , TrimmingGranularity(CanvasTextTrimmingGranularity::None)
+        , TrimmingDelimiterCount(0)
+        , WordWrapping(CanvasWordWrapping::Wrap)
+    {
+    }
+
+
+    bool TextFormatKey::operator==(const TextFormatKey& other) const
+    {
+        return FontCollection         == other.FontCollection &&
+               FontFamilyName         == other.FontFamilyName &&
+               LocaleName             == other.LocaleName &&
+               TrimmingDelimiter      == other.TrimmingDelimiter &&
+               FlowDirection          == other.FlowDirection &&
+               FontSize               == other.FontSize &&
+               FontStretch            == other.FontStretch &&
+               FontStyle              == other.FontStyle &&
+               FontWeight             == other.FontWeight &&
+               IncrementalTabStop     == other.IncrementalTabStop &&
+               LineSpacingMethod      == other.LineSpacingMethod &&
+               LineSpacing            == other.LineSpacing &&
+               LineSpacingBaseline    == other.LineSpacingBaseline &&
+               VerticalAlignment      == other.VerticalAlignment &&
+               ReadingDirection       == other.ReadingDirection &&
+               ParagraphAlignment     == other.ParagraphAlignment &&
+               TrimmingGranularity    == other.TrimmingGranularity &&
+               TrimmingDelimiterCount == other.TrimmingDelimiterCount &&
+               WordWrapping           == other.WordWrapping;
+    }
+
+
+    size_t TextFormatKeyHash::operator()(const TextFormatKey& key) const
+    {
+        size_t hash = key.FontFamilyName.GetHash();
+
+        HashCombine(&hash, std::hash<void*>()(key.FontCollection));
+        HashCombine(&hash, key.LocaleName.GetHash());
+        HashCombine(&hash, key.TrimmingDelimiter.GetHash());
+        HashCombine(&hash, static_cast<size_t>(key.FlowDirection));
+        HashCombine(&hash, std::hash<float>()(key.FontSize));
+        HashCombine(&hash, static_cast<size_t>(key.FontStretch));
+        HashCombine(&hash, static_cast<size_t>(key.FontStyle));
+        HashCombine(&hash, key.FontWeight);
+        HashCombine(&hash, std::hash<float>()(key.IncrementalTabStop));
+        HashCombine(&hash, static_cast<size_t>(key.LineSpacingMethod));
+        HashCombine(&hash, std::hash<float>()(key.LineSpacing));
+        HashCombine(&hash, std::hash<float>()(key.LineSpacingBaseline));
+        HashCombine(&hash, static_cast<size_t>(key.VerticalAlignment));
+        HashCombine(&hash, static_cast<size_t>(key.ReadingDirection));
+        HashCombine(&hash, static_cast<size_t>(key.ParagraphAlignment));
+        HashCombine(&hash, static_cast<size_t>(key.TrimmingGranularity));
+        HashCombine(&hash, static_cast<size_t>(key.TrimmingDelimiterCount));
+        HashCombine(&hash, static_cast<size_t>(key.WordWrapping));
+
+        return hash;
+    }
+
+
+    //
+    // InternedTextFormat
+    //
+
+    InternedTextFormat::InternedTextFormat(IDWriteTextFormat* format, uint64_t realizationId)
+        : m_format(format)
+        , m_realizationId(realizationId)
+    {
+    }
+
+
+    IDWriteTextFormat* InternedTextFormat::GetFormat() const
+    {
+        return m_format.Get();
+    }
+
+
+    uint64_t InternedTextFormat::GetRealizationId() const
+    {
+        return m_realizationId;
+    }
+
+
+    //
+    // CanvasTextFormatInternTable
+    //
+
+    typedef std::unordered_map<TextFormatKey, std::weak_ptr<InternedTextFormat>, TextFormatKeyHash> InternedTextFormatMap;
+
+    static std::mutex s_internTableMutex;
+    static InternedTextFormatMap s_internTable;
+    static size_t s_internTablePruneThreshold = CanvasTextFormatInternTable::MinimumPruneThreshold;
+
+
+    static void PruneExpiredEntries()
+    {
+        for (auto it = s_internTable.begin(); it != s_internTable.end();)
+        {
+            if (it->second.expired())
+                it = s_internTable.erase(it);
+            else
+                ++it;
+        }
+
+        s_internTablePruneThreshold = s_internTable.size() * 2;
+
+        if (s_internTablePruneThreshold < CanvasTextFormatInternTable::MinimumPruneThreshold)
+            s_internTablePruneThreshold = CanvasTextFormatInternTable::MinimumPruneThreshold;
+    }
+
+
+    std::shared_ptr<InternedTextFormat> CanvasTextFormatInternTable::Find(const TextFormatKey& key)
+    {
+        std::lock_guard<std::mutex> lock(s_internTableMutex);
+
+        auto it = s_internTable.find(key);
+
+        if (it == s_internTable.end())
+            return nullptr;
+
+        return it->second.lock();
+    }
+
+
+    std::shared_ptr<InternedTextFormat> CanvasTextFormatInternTable::Add(
+        const TextFormatKey& key,
+        const std::shared_ptr<InternedTextFormat>& format)
+    {
+        assert(format);
+
+        std::lock_guard<std::mutex> lock(s_internTableMutex);
+
+        auto& entry = s_internTable[key];
+
+        if (auto existingFormat = entry.lock())
+            return existingFormat;
+
+        entry = format;
+
+        if (s_internTable.size() > s_internTablePruneThreshold)
+            PruneExpiredEntries();
+
+        return format;
+    }
+
+
+    size_t CanvasTextFormatInternTable::GetEntryCount()
+    {
+        std::lock_guard<std::mutex> lock(s_internTableMutex);
+
+        return s_internTable.size();
+    }
+}}}}
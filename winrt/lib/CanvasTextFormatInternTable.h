@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <unordered_map>
+
+#include "InternedString.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    //
+    // The shadow properties of a CanvasTextFormat that end up on its realized
+    // IDWriteTextFormat.  Draw text options aren't part of the format, so
+    // they aren't part of the key either.
+    //
+    struct TextFormatKey
+    {
+        TextFormatKey();
+
+        //
+        // Compared by identity.  An interned format keeps its collection
+        // alive, so the address can't be reused while an entry for it is in
+        // use.
+        //
+        IDWriteFontCollection* FontCollection;
+
+        // Also compared, and hashed, by identity.
+        InternedString FontFamilyName;
+        InternedString LocaleName;
+        InternedString TrimmingDelimiter;
+
+        CanvasTextDirection FlowDirection;
+        float FontSize;
+        ABI::Windows::UI::Text::FontStretch FontStretch;
+        ABI::Windows::UI::Text::FontStyle FontStyle;
+        uint16_t FontWeight;
+        float IncrementalTabStop;
+        CanvasLineSpacingMethod LineSpacingMethod;
+        float LineSpacing;
+        float LineSpacingBaseline;
+        CanvasVerticalAlignment VerticalAlignment;
+        CanvasTextDirection ReadingDirection;
+        ABI::Windows::UI::Text::ParagraphAlignment ParagraphAlignment;
+        CanvasTextTrimmingGranularity TrimmingGranularity;
+        int32_t TrimmingDelimiterCount;
+        CanvasWordWrapping WordWrapping;
+
+        bool operator==(const TextFormatKey& other) const;
+    };
+
+
+    struct TextFormatKeyHash
+    {
+        size_t operator()(const TextFormatKey& key) const;
+    };
+
+
+    //
+    // A realized IDWriteTextFormat that is shared by every CanvasTextFormat
+    // with the same shadow properties, along with the realization id that
+    // they all report for it.
+    //
+    // The format must not be modified once it has been interned.  A
+    // CanvasTextFormat that changes one of its properties drops its reference
+    // and looks up its new state instead.
+    //
+    class InternedTextFormat
+    {
+        ComPtr<IDWriteTextFormat> m_format;
+        uint64_t m_realizationId;
+
+    public:
+        InternedTextFormat(IDWriteTextFormat* format, uint64_t realizationId);
+
+        IDWriteTextFormat* GetFormat() const;
+        uint64_t GetRealizationId() const;
+    };
+
+
+    //
+    // Process-wide table of interned text formats.  Like SharedDWriteFactory,
+    // the table only holds weak_ptrs, so a format is released as soon as the
+    // last CanvasTextFormat using it changes or goes away.  Entries for
+    // formats that are no longer used are pruned whenever the table has
+    // doubled in size since it was last pruned.
+    //
+    // All methods are thread-safe.
+    //
+    class CanvasTextFormatInternTable
+    {
+    public:
+        static const size_t MinimumPruneThreshold = 64;
+
+        // Returns null if no format with this key is currently in use.
+        static std::shared_ptr<InternedTextFormat> Find(const TextFormatKey& key);
+
+        //
+        // Interns format under key.  If another thread interned a format with
+        // the same key first then that one is returned instead, and format
+        // should be discarded.
+        //
+        static std::shared_ptr<InternedTextFormat> Add(
+            const TextFormatKey& key,
+            const std::shared_ptr<InternedTextFormat>& format);
+
+        // Number of entries, including ones that haven't been pruned yet.
+        static size_t GetEntryCount();
+    };
+}}}}
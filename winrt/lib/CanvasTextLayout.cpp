@@ -0,0 +1,1067 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasTextFormat.h"
+#include "CanvasTextLayout.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using ABI::Windows::Foundation::Rect;
+    using ABI::Windows::Foundation::Size;
+
+    IFACEMETHODIMP CanvasTextLayoutFactory::Create(
+        HSTRING text,
+        ICanvasTextFormat* textFormat,
+        float requestedWidth,
+        float requestedHeight,
+        ICanvasTextLayout** textLayout)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(textFormat);
+                CheckAndClearOutPointer(textLayout);
+
+                auto newTextLayout = Make<CanvasTextLayout>(
+                    SharedDWriteFactory::GetOrCreate(),
+                    text,
+                    textFormat,
+                    requestedWidth,
+                    requestedHeight);
+                CheckMakeResult(newTextLayout);
+
+                ThrowIfFailed(newTextLayout.CopyTo(textLayout));
+            });
+    }
+
+
+    TextLayoutParagraph::TextLayoutParagraph(uint32_t start, uint32_t length, uint32_t separatorLength)
+        : Start(start)
+        , Length(length)
+        , SeparatorLength(separatorLength)
+        , HasMetrics(false)
+        , Top(0)
+        , Height(0)
+        , LineCount(0)
+        , LineBounds()
+        , InkBounds()
+    {
+    }
+
+
+    TextLayoutFormattingValue::TextLayoutFormattingValue(uint64_t number)
+        : Number(number)
+    {
+    }
+
+
+    TextLayoutFormattingValue::TextLayoutFormattingValue(const InternedString& string)
+        : Number(0)
+        , String(string)
+    {
+    }
+
+
+    bool TextLayoutFormattingValue::operator==(const TextLayoutFormattingValue& other) const
+    {
+        return Number == other.Number && String == other.String;
+    }
+
+
+    TextLayoutFormattingRange::TextLayoutFormattingRange(
+        TextLayoutFormattingProperty property,
+        const TextLayoutFormattingValue& value,
+        uint32_t start,
+        uint32_t end,
+        Applier apply)
+        : Property(property)
+        , Value(value)
+        , Start(start)
+        , End(end)
+        , Apply(apply)
+    {
+    }
+
+
+    static void ThrowIfInvalidSize(float width, float height)
+    {
+        if (!(width >= 0) || !(height >= 0))
+            ThrowHR(E_INVALIDARG);
+    }
+
+
+    static void ThrowIfInvalidRange(int32_t characterIndex, int32_t characterCount, size_t textLength)
+    {
+        if (characterIndex < 0 || characterCount < 0)
+            ThrowHR(E_INVALIDARG);
+
+        if (static_cast<size_t>(characterIndex) > textLength ||
+            static_cast<size_t>(characterCount) > textLength - characterIndex)
+        {
+            ThrowHR(E_INVALIDARG);
+        }
+    }
+
+
+    uint32_t GetParagraphSeparatorLength(const std::wstring& text, size_t position)
+    {
+        switch (text[position])
+        {
+        case L'\r':
+            return (position + 1 < text.size() && text[position + 1] == L'\n') ? 2 : 1;
+
+        case L'\n':
+        case 0x0085:    // NEXT LINE
+        case 0x2029:    // PARAGRAPH SEPARATOR
+            return 1;
+
+        default:
+            return 0;
+        }
+    }
+
+
+    CanvasTextLayout::CanvasTextLayout(
+        std::shared_ptr<SharedDWriteFactory> dwriteFactory,
+        HSTRING text,
+        ICanvasTextFormat* textFormat,
+        float requestedWidth,
+        float requestedHeight)
+        : m_closed(false)
+        , m_dwriteFactory(dwriteFactory)
+        , m_drawTextOptions(CanvasDrawTextOptions::Default)
+        , m_splitsParagraphs(true)
+        , m_requestedWidth(requestedWidth)
+        , m_requestedHeight(requestedHeight)
+        , m_hasMetrics(false)
+        , m_paragraphLayoutCount(0)
+    {
+        CheckInPointer(dwriteFactory.get());
+        CheckInPointer(textFormat);
+        ThrowIfInvalidSize(requestedWidth, requestedHeight);
+
+        ComPtr<ICanvasTextFormatInternal> formatInternal;
+        ThrowIfFailed(textFormat->QueryInterface(formatInternal.GetAddressOf()));
+
+        auto formatSnapshot = formatInternal->GetSnapshot();
+        m_format = formatSnapshot->Format;
+        m_drawTextOptions = formatSnapshot->DrawTextOptions;
+        m_splitsParagraphs = (m_format->GetFlowDirection() == DWRITE_FLOW_DIRECTION_TOP_TO_BOTTOM);
+
+        uint32_t textLength;
+        auto textBuffer = WindowsGetStringRawBuffer(text, &textLength);
+        m_text.assign(textBuffer, textLength);
+
+        SplitParagraphs(0, textLength, &m_paragraphs);
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::get_Text(HSTRING* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckAndClearOutPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                ThrowIfFailed(WindowsCreateString(m_text.c_str(), static_cast<uint32_t>(m_text.size()), value));
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::ReplaceText(
+        int32_t characterIndex,
+        int32_t characterCount,
+        HSTRING newText)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                ThrowIfInvalidRange(characterIndex, characterCount, m_text.size());
+
+                uint32_t newTextLength;
+                auto newTextBuffer = WindowsGetStringRawBuffer(newText, &newTextLength);
+
+                auto editStart = static_cast<uint32_t>(characterIndex);
+                auto editEnd = editStart + static_cast<uint32_t>(characterCount);
+
+                //
+                // The paragraphs that the edit touches are split again.  This
+                // includes one paragraph either side, since the edit may join a
+                // CR at the end of one paragraph to an LF at the start of the
+                // next, or remove the separator between two paragraphs.
+                //
+                auto firstParagraph = FindParagraphForCharacter(editStart);
+                auto lastParagraph = FindParagraphForCharacter(editEnd);
+
+                if (firstParagraph > 0)
+                    --firstParagraph;
+
+                if (lastParagraph + 1 < m_paragraphs.size())
+                    ++lastParagraph;
+
+                auto& oldFirst = m_paragraphs[firstParagraph];
+                auto& oldLast = m_paragraphs[lastParagraph];
+
+                auto regionStart = oldFirst.Start;
+                auto regionEnd = oldLast.Start + oldLast.Length + oldLast.SeparatorLength;
+
+                m_text.replace(editStart, characterCount, newTextBuffer, newTextLength);
+
+                auto newRegionEnd = regionEnd - characterCount + newTextLength;
+
+                std::vector<TextLayoutParagraph> newParagraphs;
+                SplitParagraphs(regionStart, newRegionEnd, &newParagraphs);
+
+                //
+                // The extra paragraphs at either end of the region usually come
+                // out of the split unchanged, in which case they keep their
+                // layouts.
+                //
+                auto isUnchanged =
+                    [](const TextLayoutParagraph& oldParagraph, const TextLayoutParagraph& newParagraph)
+                    {
+                        return oldParagraph.Length == newParagraph.Length &&
+                               oldParagraph.SeparatorLength == newParagraph.SeparatorLength;
+                    };
+
+                bool keptFirst = false;
+
+                if (oldFirst.Start + oldFirst.Length + oldFirst.SeparatorLength <= editStart &&
+                    isUnchanged(oldFirst, newParagraphs.front()))
+                {
+                    newParagraphs.front() = oldFirst;
+                    keptFirst = true;
+                }
+
+                if (oldLast.Start >= editEnd &&
+                    isUnchanged(oldLast, newParagraphs.back()) &&
+                    !(keptFirst && newParagraphs.size() == 1))
+                {
+                    auto newStart = newParagraphs.back().Start;
+                    newParagraphs.back() = oldLast;
+                    newParagraphs.back().Start = newStart;
+                }
+
+                // Moves a position after the edit to where it is now.
+                auto shift = [&](uint32_t position) { return position - characterCount + newTextLength; };
+
+                for (auto i = lastParagraph + 1; i < m_paragraphs.size(); ++i)
+                {
+                    m_paragraphs[i].Start = shift(m_paragraphs[i].Start);
+                }
+
+                auto firstReplaced = m_paragraphs.begin() + firstParagraph;
+                auto lastReplaced = m_paragraphs.begin() + lastParagraph + 1;
+                auto insertAt = m_paragraphs.erase(firstReplaced, lastReplaced);
+                m_paragraphs.insert(insertAt, newParagraphs.begin(), newParagraphs.end());
+
+                //
+                // Formatting moves with the text around it.  Characters that
+                // are removed take their formatting with them, so a range that
+                // only covered removed characters goes away.
+                //
+                for (auto& range : m_formattingRanges)
+                {
+                    if (range.Start >= editEnd)
+                        range.Start = shift(range.Start);
+                    else if (range.Start >= editStart)
+                        range.Start = editStart + newTextLength;
+
+                    if (range.End <= editStart)
+                        continue;
+
+                    if (range.End >= editEnd)
+                        range.End = shift(range.End);
+                    else
+                        range.End = editStart;
+                }
+
+                m_formattingRanges.erase(
+                    std::remove_if(
+                        m_formattingRanges.begin(),
+                        m_formattingRanges.end(),
+                        [](const TextLayoutFormattingRange& range) { return range.Start >= range.End; }),
+                    m_formattingRanges.end());
+
+                m_hasMetrics = false;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::get_RequestedSize(Size* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                *value = Size{ m_requestedWidth, m_requestedHeight };
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::put_RequestedSize(Size value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                ThrowIfInvalidSize(value.Width, value.Height);
+
+                bool widthChanged = (value.Width != m_requestedWidth);
+                bool heightChanged = (value.Height != m_requestedHeight);
+
+                if (!widthChanged && !heightChanged)
+                    return;
+
+                //
+                // Changing the size of an existing layout only breaks its lines
+                // again; the text isn't re-analyzed or re-shaped.
+                //
+                for (auto& paragraph : m_paragraphs)
+                {
+                    if (!paragraph.Layout)
+                        continue;
+
+                    if (widthChanged)
+                        ThrowIfFailed(paragraph.Layout->SetMaxWidth(value.Width));
+
+                    if (heightChanged)
+                        ThrowIfFailed(paragraph.Layout->SetMaxHeight(value.Height));
+
+                    paragraph.HasMetrics = false;
+                }
+
+                m_requestedWidth = value.Width;
+                m_requestedHeight = value.Height;
+                m_hasMetrics = false;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::SetFontFamily(int32_t characterIndex, int32_t characterCount, HSTRING fontFamily)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                uint32_t fontFamilyLength;
+                auto fontFamilyBuffer = WindowsGetStringRawBuffer(fontFamily, &fontFamilyLength);
+
+                if (fontFamilyLength == 0)
+                    ThrowHR(E_INVALIDARG);
+
+                InternedString fontFamilyName(fontFamilyBuffer, fontFamilyLength);
+
+                SetFormatting(
+                    characterIndex,
+                    characterCount,
+                    TextLayoutFormattingProperty::FontFamily,
+                    TextLayoutFormattingValue(fontFamilyName),
+                    [fontFamilyName](IDWriteTextLayout* layout, DWRITE_TEXT_RANGE range)
+                    {
+                        ThrowIfFailed(layout->SetFontFamilyName(fontFamilyName.GetBuffer(), range));
+                    });
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::SetFontSize(int32_t characterIndex, int32_t characterCount, float fontSize)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                if (!(fontSize > 0))
+                    ThrowHR(E_INVALIDARG);
+
+                uint32_t fontSizeBits;
+                memcpy(&fontSizeBits, &fontSize, sizeof(fontSizeBits));
+
+                SetFormatting(
+                    characterIndex,
+                    characterCount,
+                    TextLayoutFormattingProperty::FontSize,
+                    fontSizeBits,
+                    [fontSize](IDWriteTextLayout* layout, DWRITE_TEXT_RANGE range)
+                    {
+                        ThrowIfFailed(layout->SetFontSize(fontSize, range));
+                    });
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::SetFontWeight(int32_t characterIndex, int32_t characterCount, ABI::Windows::UI::Text::FontWeight fontWeight)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                if (fontWeight.Weight < 1 || fontWeight.Weight > 999)
+                    ThrowHR(E_INVALIDARG);
+
+                auto weight = static_cast<DWRITE_FONT_WEIGHT>(fontWeight.Weight);
+
+                SetFormatting(
+                    characterIndex,
+                    characterCount,
+                    TextLayoutFormattingProperty::FontWeight,
+                    weight,
+                    [weight](IDWriteTextLayout* layout, DWRITE_TEXT_RANGE range)
+                    {
+                        ThrowIfFailed(layout->SetFontWeight(weight, range));
+                    });
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::SetFontStyle(int32_t characterIndex, int32_t characterCount, ABI::Windows::UI::Text::FontStyle fontStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                switch (fontStyle)
+                {
+                case ABI::Windows::UI::Text::FontStyle_Normal:
+                case ABI::Windows::UI::Text::FontStyle_Oblique:
+                case ABI::Windows::UI::Text::FontStyle_Italic:
+                    break;
+
+                default:
+                    ThrowHR(E_INVALIDARG);
+                }
+
+                auto style = static_cast<DWRITE_FONT_STYLE>(fontStyle);
+
+                SetFormatting(
+                    characterIndex,
+                    characterCount,
+                    TextLayoutFormattingProperty::FontStyle,
+                    style,
+                    [style](IDWriteTextLayout* layout, DWRITE_TEXT_RANGE range)
+                    {
+                        ThrowIfFailed(layout->SetFontStyle(style, range));
+                    });
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::SetUnderline(int32_t characterIndex, int32_t characterCount, boolean hasUnderline)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BOOL value = hasUnderline ? TRUE : FALSE;
+
+                SetFormatting(
+                    characterIndex,
+                    characterCount,
+                    TextLayoutFormattingProperty::Underline,
+                    value,
+                    [value](IDWriteTextLayout* layout, DWRITE_TEXT_RANGE range)
+                    {
+                        ThrowIfFailed(layout->SetUnderline(value, range));
+                    });
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::SetStrikethrough(int32_t characterIndex, int32_t characterCount, boolean hasStrikethrough)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BOOL value = hasStrikethrough ? TRUE : FALSE;
+
+                SetFormatting(
+                    characterIndex,
+                    characterCount,
+                    TextLayoutFormattingProperty::Strikethrough,
+                    value,
+                    [value](IDWriteTextLayout* layout, DWRITE_TEXT_RANGE range)
+                    {
+                        ThrowIfFailed(layout->SetStrikethrough(value, range));
+                    });
+            });
+    }
+
+
+    void CanvasTextLayout::SetFormatting(
+        int32_t characterIndex,
+        int32_t characterCount,
+        TextLayoutFormattingProperty property,
+        const TextLayoutFormattingValue& value,
+        TextLayoutFormattingRange::Applier apply)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ThrowIfClosed();
+
+        ThrowIfInvalidRange(characterIndex, characterCount, m_text.size());
+
+        if (characterCount == 0)
+            return;
+
+        auto start = static_cast<uint32_t>(characterIndex);
+        auto end = start + static_cast<uint32_t>(characterCount);
+
+        TextLayoutFormattingRange range(property, value, start, end, apply);
+
+        //
+        // The new range replaces whatever part of the existing ranges for
+        // this property it covers, and absorbs the ones that set the same
+        // value and touch it.  This keeps the ranges for a property
+        // disjoint, so however many times formatting is set there is at
+        // most one range per run of formatting.
+        //
+        TextLayoutFormattingRange mergedRange = range;
+        std::vector<TextLayoutFormattingRange> splitRanges;
+
+        for (auto& existing : m_formattingRanges)
+        {
+            if (existing.Property != property)
+                continue;
+
+            if (existing.Value == value && existing.Start <= end && existing.End >= start)
+            {
+                mergedRange.Start = std::min(mergedRange.Start, existing.Start);
+                mergedRange.End = std::max(mergedRange.End, existing.End);
+                existing.End = existing.Start;
+            }
+            else if (existing.End <= start || existing.Start >= end)
+            {
+                continue;
+            }
+            else if (existing.Start < start && existing.End > end)
+            {
+                splitRanges.push_back(TextLayoutFormattingRange(property, existing.Value, end, existing.End, existing.Apply));
+                existing.End = start;
+            }
+            else if (existing.Start < start)
+            {
+                existing.End = start;
+            }
+            else if (existing.End > end)
+            {
+                existing.Start = end;
+            }
+            else
+            {
+                // Entirely overridden
+                existing.End = existing.Start;
+            }
+        }
+
+        m_formattingRanges.erase(
+            std::remove_if(
+                m_formattingRanges.begin(),
+                m_formattingRanges.end(),
+                [](const TextLayoutFormattingRange& formattingRange) { return formattingRange.Start >= formattingRange.End; }),
+            m_formattingRanges.end());
+
+        m_formattingRanges.insert(m_formattingRanges.end(), splitRanges.begin(), splitRanges.end());
+        m_formattingRanges.push_back(mergedRange);
+
+        //
+        // Paragraphs that haven't been laid out yet pick up the range when
+        // they are.
+        //
+        for (auto i = FindParagraphForCharacter(start); i < m_paragraphs.size(); ++i)
+        {
+            auto& paragraph = m_paragraphs[i];
+
+            if (paragraph.Start >= end)
+                break;
+
+            if (!paragraph.Layout)
+                continue;
+
+            ApplyFormatting(paragraph, range);
+            paragraph.HasMetrics = false;
+            m_hasMetrics = false;
+        }
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::get_LayoutBounds(Rect* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                EnsureMetrics();
+
+                auto bounds = m_paragraphs.front().LineBounds;
+
+                for (auto& paragraph : m_paragraphs)
+                {
+                    bounds.left = std::min(bounds.left, paragraph.LineBounds.left);
+                    bounds.right = std::max(bounds.right, paragraph.LineBounds.right);
+                    bounds.bottom = paragraph.Top + paragraph.LineBounds.bottom;
+                }
+
+                auto verticalOffset = GetVerticalOffset();
+
+                *value = Rect{
+                    bounds.left,
+                    bounds.top + verticalOffset,
+                    bounds.right - bounds.left,
+                    bounds.bottom - bounds.top };
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::get_LineCount(int32_t* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                EnsureMetrics();
+
+                uint32_t lineCount = 0;
+
+                for (auto& paragraph : m_paragraphs)
+                {
+                    lineCount += paragraph.LineCount;
+                }
+
+                *value = static_cast<int32_t>(lineCount);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::get_LineMetrics(
+        uint32_t* valueCount,
+        CanvasLineMetrics** valueElements)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(valueCount);
+                CheckAndClearOutPointer(valueElements);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                EnsureMetrics();
+
+                std::vector<CanvasLineMetrics> lineMetrics;
+                std::vector<DWRITE_LINE_METRICS> paragraphLineMetrics;
+
+                for (auto& paragraph : m_paragraphs)
+                {
+                    paragraphLineMetrics.resize(paragraph.LineCount);
+
+                    UINT32 actualLineCount;
+                    ThrowIfFailed(paragraph.Layout->GetLineMetrics(
+                        paragraphLineMetrics.data(),
+                        paragraph.LineCount,
+                        &actualLineCount));
+
+                    assert(actualLineCount == paragraph.LineCount);
+
+                    for (auto& line : paragraphLineMetrics)
+                    {
+                        CanvasLineMetrics metrics;
+                        metrics.CharacterCount = line.length;
+                        metrics.TrailingWhitespaceCount = line.trailingWhitespaceLength;
+                        metrics.TerminalNewlineCount = line.newlineLength;
+                        metrics.Height = line.height;
+                        metrics.Baseline = line.baseline;
+
+                        lineMetrics.push_back(metrics);
+                    }
+
+                    // The separator isn't part of the paragraph's layout, but
+                    // belongs at the end of its last line.
+                    if (!paragraphLineMetrics.empty())
+                    {
+                        auto& lastLine = lineMetrics.back();
+                        lastLine.CharacterCount += paragraph.SeparatorLength;
+                        lastLine.TrailingWhitespaceCount += paragraph.SeparatorLength;
+                        lastLine.TerminalNewlineCount += paragraph.SeparatorLength;
+                    }
+                }
+
+                assert(lineMetrics.size() <= UINT_MAX);
+
+                (*valueCount) = static_cast<uint32_t>(lineMetrics.size());
+                (*valueElements) = static_cast<CanvasLineMetrics*>(CoTaskMemAlloc(lineMetrics.size() * sizeof(CanvasLineMetrics)));
+                ThrowIfNullPointer(*valueElements, E_OUTOFMEMORY);
+
+                if (!lineMetrics.empty())
+                {
+                    memcpy(*valueElements, &lineMetrics[0], lineMetrics.size() * sizeof(CanvasLineMetrics));
+                }
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::HitTest(
+        Numerics::Vector2 point,
+        int32_t* characterIndex,
+        boolean* isTrailingHit,
+        boolean* isInside)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(characterIndex);
+                CheckInPointer(isTrailingHit);
+                CheckInPointer(isInside);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                EnsureMetrics();
+
+                auto y = point.Y - GetVerticalOffset();
+                auto& paragraph = m_paragraphs[FindParagraphForY(y)];
+
+                BOOL trailingHit;
+                BOOL inside;
+                DWRITE_HIT_TEST_METRICS hitTestMetrics;
+
+                ThrowIfFailed(paragraph.Layout->HitTestPoint(
+                    point.X,
+                    y - paragraph.Top,
+                    &trailingHit,
+                    &inside,
+                    &hitTestMetrics));
+
+                *characterIndex = static_cast<int32_t>(paragraph.Start + hitTestMetrics.textPosition);
+                *isTrailingHit = !!trailingHit;
+                *isInside = !!inside;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::GetCaretPosition(
+        int32_t characterIndex,
+        boolean trailingSideOfCharacter,
+        Numerics::Vector2* position)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(position);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ThrowIfClosed();
+
+                ThrowIfInvalidRange(characterIndex, 0, m_text.size());
+
+                EnsureMetrics();
+
+                auto index = static_cast<uint32_t>(characterIndex);
+                auto& paragraph = m_paragraphs[FindParagraphForCharacter(index)];
+
+                // Positions inside the separator are at the end of the paragraph.
+                auto paragraphIndex = std::min(index - paragraph.Start, paragraph.Length);
+
+                float x;
+                float y;
+                DWRITE_HIT_TEST_METRICS hitTestMetrics;
+
+                ThrowIfFailed(paragraph.Layout->HitTestTextPosition(
+                    paragraphIndex,
+                    trailingSideOfCharacter ? TRUE : FALSE,
+                    &x,
+                    &y,
+                    &hitTestMetrics));
+
+                *position = Numerics::Vector2{ x, y + paragraph.Top + GetVerticalOffset() };
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextLayout::Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_closed = true;
+        m_paragraphs.clear();
+        m_formattingRanges.clear();
+        m_format.Reset();
+
+        return S_OK;
+    }
+
+
+    void CanvasTextLayout::Draw(
+        ID2D1DeviceContext1* deviceContext,
+        D2D1_POINT_2F origin,
+        ID2D1Brush* brush,
+        const std::function<bool(const D2D1_RECT_F&)>& isCulled)
+    {
+        CheckInPointer(deviceContext);
+        CheckInPointer(brush);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ThrowIfClosed();
+
+        EnsureMetrics();
+
+        auto options = static_cast<D2D1_DRAW_TEXT_OPTIONS>(m_drawTextOptions);
+
+        //
+        // The clip option would clip each paragraph to its own layout box, so
+        // the whole stack is clipped to the requested size instead.
+        //
+        bool clipToRequestedSize = m_splitsParagraphs && (options & D2D1_DRAW_TEXT_OPTIONS_CLIP) != 0;
+
+        if (clipToRequestedSize)
+        {
+            options = static_cast<D2D1_DRAW_TEXT_OPTIONS>(options & ~D2D1_DRAW_TEXT_OPTIONS_CLIP);
+
+            auto clipRect = D2D1::RectF(
+                origin.x,
+                origin.y,
+                origin.x + m_requestedWidth,
+                origin.y + m_requestedHeight);
+
+            deviceContext->PushAxisAlignedClip(&clipRect, D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+        }
+
+        auto popClipWarden = MakeScopeWarden(
+            [&]
+            {
+                if (clipToRequestedSize)
+                    deviceContext->PopAxisAlignedClip();
+            });
+
+        auto top = origin.y + GetVerticalOffset();
+
+        for (auto& paragraph : m_paragraphs)
+        {
+            auto paragraphOrigin = D2D1::Point2F(origin.x, top + paragraph.Top);
+
+            if (isCulled)
+            {
+                auto inkBounds = D2D1::RectF(
+                    paragraphOrigin.x + paragraph.InkBounds.left,
+                    paragraphOrigin.y + paragraph.InkBounds.top,
+                    paragraphOrigin.x + paragraph.InkBounds.right,
+                    paragraphOrigin.y + paragraph.InkBounds.bottom);
+
+                if (isCulled(inkBounds))
+                    continue;
+            }
+
+            deviceContext->DrawTextLayout(
+                paragraphOrigin,
+                paragraph.Layout.Get(),
+                brush,
+                options);
+        }
+    }
+
+
+    void CanvasTextLayout::ThrowIfClosed()
+    {
+        if (m_closed)
+            ThrowHR(RO_E_CLOSED);
+    }
+
+
+    void CanvasTextLayout::SplitParagraphs(uint32_t start, uint32_t end, std::vector<TextLayoutParagraph>* paragraphs) const
+    {
+        if (!m_splitsParagraphs)
+        {
+            paragraphs->push_back(TextLayoutParagraph(start, end - start, 0));
+            return;
+        }
+
+        auto paragraphStart = start;
+        auto position = start;
+
+        while (position < end)
+        {
+            auto separatorLength = GetParagraphSeparatorLength(m_text, position);
+
+            if (separatorLength)
+            {
+                paragraphs->push_back(TextLayoutParagraph(paragraphStart, position - paragraphStart, separatorLength));
+                position += separatorLength;
+                paragraphStart = position;
+            }
+            else
+            {
+                ++position;
+            }
+        }
+
+        //
+        // Text that ends with a separator still has an empty last paragraph,
+        // so that there is somewhere to put the caret.
+        //
+        if (paragraphStart < end || end == m_text.size())
+            paragraphs->push_back(TextLayoutParagraph(paragraphStart, end - paragraphStart, 0));
+    }
+
+
+    void CanvasTextLayout::CreateParagraphLayout(TextLayoutParagraph& paragraph)
+    {
+        ThrowIfFailed(m_dwriteFactory->Get()->CreateTextLayout(
+            m_text.c_str() + paragraph.Start,
+            paragraph.Length,
+            m_format.Get(),
+            m_requestedWidth,
+            m_requestedHeight,
+            &paragraph.Layout));
+
+        auto layoutWarden = MakeScopeWarden([&] { paragraph.Layout.Reset(); });
+
+        if (m_splitsParagraphs)
+            ThrowIfFailed(paragraph.Layout->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR));
+
+        for (auto& range : m_formattingRanges)
+        {
+            ApplyFormatting(paragraph, range);
+        }
+
+        layoutWarden.Dismiss();
+
+        paragraph.HasMetrics = false;
+        ++m_paragraphLayoutCount;
+    }
+
+
+    void CanvasTextLayout::ApplyFormatting(TextLayoutParagraph& paragraph, const TextLayoutFormattingRange& range)
+    {
+        auto start = std::max(range.Start, paragraph.Start);
+        auto end = std::min(range.End, paragraph.Start + paragraph.Length);
+
+        if (start >= end)
+            return;
+
+        range.Apply(paragraph.Layout.Get(), DWRITE_TEXT_RANGE{ start - paragraph.Start, end - start });
+    }
+
+
+    void CanvasTextLayout::EnsureMetrics()
+    {
+        if (m_hasMetrics)
+            return;
+
+        float top = 0;
+
+        for (auto& paragraph : m_paragraphs)
+        {
+            if (!paragraph.Layout)
+                CreateParagraphLayout(paragraph);
+
+            if (!paragraph.HasMetrics)
+            {
+                DWRITE_TEXT_METRICS metrics;
+                ThrowIfFailed(paragraph.Layout->GetMetrics(&metrics));
+
+                DWRITE_OVERHANG_METRICS overhang;
+                ThrowIfFailed(paragraph.Layout->GetOverhangMetrics(&overhang));
+
+                paragraph.Height = metrics.top + metrics.height;
+                paragraph.LineCount = metrics.lineCount;
+
+                paragraph.LineBounds = D2D1::RectF(
+                    metrics.left,
+                    metrics.top,
+                    metrics.left + metrics.width,
+                    metrics.top + metrics.height);
+
+                paragraph.InkBounds = D2D1::RectF(
+                    -overhang.left,
+                    -overhang.top,
+                    paragraph.Layout->GetMaxWidth() + overhang.right,
+                    paragraph.Layout->GetMaxHeight() + overhang.bottom);
+
+                paragraph.HasMetrics = true;
+            }
+
+            paragraph.Top = top;
+            top += paragraph.Height;
+        }
+
+        m_hasMetrics = true;
+    }
+
+
+    float CanvasTextLayout::GetVerticalOffset()
+    {
+        if (!m_splitsParagraphs)
+            return 0;
+
+        auto& lastParagraph = m_paragraphs.back();
+        auto totalHeight = lastParagraph.Top + lastParagraph.Height;
+
+        switch (m_format->GetParagraphAlignment())
+        {
+        case DWRITE_PARAGRAPH_ALIGNMENT_CENTER:
+            return (m_requestedHeight - totalHeight) / 2;
+
+        case DWRITE_PARAGRAPH_ALIGNMENT_FAR:
+            return m_requestedHeight - totalHeight;
+
+        default:
+            return 0;
+        }
+    }
+
+
+    size_t CanvasTextLayout::FindParagraphForCharacter(uint32_t characterIndex) const
+    {
+        auto it = std::upper_bound(
+            m_paragraphs.begin(),
+            m_paragraphs.end(),
+            characterIndex,
+            [](uint32_t index, const TextLayoutParagraph& paragraph) { return index < paragraph.Start; });
+
+        assert(it != m_paragraphs.begin());
+
+        return (it - m_paragraphs.begin()) - 1;
+    }
+
+
+    size_t CanvasTextLayout::FindParagraphForY(float y) const
+    {
+        auto it = std::upper_bound(
+            m_paragraphs.begin(),
+            m_paragraphs.end(),
+            y,
+            [](float value, const TextLayoutParagraph& paragraph) { return value < paragraph.Top; });
+
+        if (it == m_paragraphs.begin())
+            return 0;
+
+        return (it - m_paragraphs.begin()) - 1;
+    }
+
+
+    ActivatableClassWithFactory(CanvasTextLayout, CanvasTextLayoutFactory);
+}}}}
@@ -0,0 +1,295 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <Canvas.abi.h>
+
+#include "InternedString.h"
+#include "SharedDWriteFactory.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    class CanvasTextLayoutFactory : public ActivationFactory<ICanvasTextLayoutFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextLayout, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            HSTRING text,
+            ICanvasTextFormat* textFormat,
+            float requestedWidth,
+            float requestedHeight,
+            ICanvasTextLayout** textLayout) override;
+    };
+
+
+    [uuid(3A875EA8-73AB-4A8B-A1DC-9E73AF50B547)]
+    class ICanvasTextLayoutInternal : public IUnknown
+    {
+    public:
+        //
+        // Draws the layout with the top-left of its requested size at origin.
+        // If isCulled is set then paragraphs whose ink bounds (in the device
+        // context's current coordinate space) it returns true for are not
+        // drawn.
+        //
+        virtual void Draw(
+            ID2D1DeviceContext1* deviceContext,
+            D2D1_POINT_2F origin,
+            ID2D1Brush* brush,
+            const std::function<bool(const D2D1_RECT_F&)>& isCulled) = 0;
+    };
+
+
+    //
+    // Returns the length of the paragraph separator (CR, LF, CR LF, NEL or
+    // PS) starting at text[position], or 0 if there isn't one there.
+    //
+    uint32_t GetParagraphSeparatorLength(const std::wstring& text, size_t position);
+
+
+    //
+    // One paragraph of a CanvasTextLayout's text.  The paragraph's characters
+    // are [Start, Start + Length), followed by SeparatorLength characters of
+    // paragraph separator that aren't part of its layout.
+    //
+    struct TextLayoutParagraph
+    {
+        TextLayoutParagraph(uint32_t start, uint32_t length, uint32_t separatorLength);
+
+        uint32_t Start;
+        uint32_t Length;
+        uint32_t SeparatorLength;
+
+        // Created on demand, and kept across edits to other paragraphs.
+        ComPtr<IDWriteTextLayout> Layout;
+
+        //
+        // Cached from Layout, and only valid while HasMetrics is set.  Top is
+        // the paragraph's offset from the top of the first paragraph, and
+        // the bounds are relative to the paragraph's own top-left.
+        //
+        bool HasMetrics;
+        float Top;
+        float Height;
+        uint32_t LineCount;
+        D2D1_RECT_F LineBounds;
+        D2D1_RECT_F InkBounds;
+    };
+
+
+    enum class TextLayoutFormattingProperty
+    {
+        FontFamily,
+        FontSize,
+        FontWeight,
+        FontStyle,
+        Underline,
+        Strikethrough
+    };
+
+
+    //
+    // The value that a formatting range sets, so that ranges setting the same
+    // value can be merged.  Font family names are kept in String; every other
+    // property's value fits in Number.
+    //
+    struct TextLayoutFormattingValue
+    {
+        TextLayoutFormattingValue(uint64_t number);
+        explicit TextLayoutFormattingValue(const InternedString& string);
+
+        uint64_t Number;
+        InternedString String;
+
+        bool operator==(const TextLayoutFormattingValue& other) const;
+    };
+
+
+    //
+    // A range of characters in a CanvasTextLayout, and the formatting that is
+    // applied to them.  Ranges are kept up to date as the text is edited, so
+    // that they can be applied to paragraphs that are laid out later.
+    //
+    // The ranges for any one property never overlap (see SetFormatting), so
+    // the order they are applied in doesn't matter.
+    //
+    struct TextLayoutFormattingRange
+    {
+        typedef std::function<void(IDWriteTextLayout*, DWRITE_TEXT_RANGE)> Applier;
+
+        TextLayoutFormattingRange(
+            TextLayoutFormattingProperty property,
+            const TextLayoutFormattingValue& value,
+            uint32_t start,
+            uint32_t end,
+            Applier apply);
+
+        TextLayoutFormattingProperty Property;
+        TextLayoutFormattingValue Value;
+        uint32_t Start;
+        uint32_t End;
+        Applier Apply;
+    };
+
+
+    //
+    // DWrite lays out a whole IDWriteTextLayout again after any change to its
+    // text, so a CanvasTextLayout keeps a separate IDWriteTextLayout for each
+    // paragraph and stacks them vertically.  ReplaceText only creates layouts
+    // for the paragraphs that an edit touches, and a change of width re-breaks
+    // the lines of the existing layouts without shaping their text again.
+    //
+    // Paragraph layouts are created with their paragraph alignment set to
+    // near, and the format's vertical alignment is applied to the stack as a
+    // whole.  Text that doesn't flow top to bottom is laid out as a single
+    // paragraph, since the paragraphs would need to be stacked differently.
+    //
+    // All methods are thread-safe.
+    //
+    class CanvasTextLayout : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasTextLayout,
+        ABI::Windows::Foundation::IClosable,
+        CloakedIid<ICanvasTextLayoutInternal>>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextLayout, BaseTrust);
+
+        std::mutex m_mutex;
+        bool m_closed;
+
+        std::shared_ptr<SharedDWriteFactory> m_dwriteFactory;
+
+        // Captured from the CanvasTextFormat when the layout was created.
+        ComPtr<IDWriteTextFormat> m_format;
+        CanvasDrawTextOptions m_drawTextOptions;
+        bool m_splitsParagraphs;
+
+        std::wstring m_text;
+        float m_requestedWidth;
+        float m_requestedHeight;
+
+        std::vector<TextLayoutParagraph> m_paragraphs;
+        std::vector<TextLayoutFormattingRange> m_formattingRanges;
+
+        // Set when every paragraph has metrics and their tops are up to date.
+        bool m_hasMetrics;
+
+        // Number of paragraph layouts created, for tests.
+        uint64_t m_paragraphLayoutCount;
+
+    public:
+        CanvasTextLayout(
+            std::shared_ptr<SharedDWriteFactory> dwriteFactory,
+            HSTRING text,
+            ICanvasTextFormat* textFormat,
+            float requestedWidth,
+            float requestedHeight);
+
+        //
+        // ICanvasTextLayout
+        //
+
+        IFACEMETHOD(get_Text)(HSTRING* value) override;
+
+        IFACEMETHOD(ReplaceText)(
+            int32_t characterIndex,
+            int32_t characterCount,
+            HSTRING newText) override;
+
+        IFACEMETHOD(get_RequestedSize)(ABI::Windows::Foundation::Size* value) override;
+        IFACEMETHOD(put_RequestedSize)(ABI::Windows::Foundation::Size value) override;
+
+        IFACEMETHOD(SetFontFamily)(int32_t characterIndex, int32_t characterCount, HSTRING fontFamily) override;
+        IFACEMETHOD(SetFontSize)(int32_t characterIndex, int32_t characterCount, float fontSize) override;
+        IFACEMETHOD(SetFontWeight)(int32_t characterIndex, int32_t characterCount, ABI::Windows::UI::Text::FontWeight fontWeight) override;
+        IFACEMETHOD(SetFontStyle)(int32_t characterIndex, int32_t characterCount, ABI::Windows::UI::Text::FontStyle fontStyle) override;
+        IFACEMETHOD(SetUnderline)(int32_t characterIndex, int32_t characterCount, boolean hasUnderline) override;
+        IFACEMETHOD(SetStrikethrough)(int32_t characterIndex, int32_t characterCount, boolean hasStrikethrough) override;
+
+        IFACEMETHOD(get_LayoutBounds)(ABI::Windows::Foundation::Rect* value) override;
+        IFACEMETHOD(get_LineCount)(int32_t* value) override;
+
+        IFACEMETHOD(get_LineMetrics)(
+            uint32_t* valueCount,
+            CanvasLineMetrics** valueElements) override;
+
+        IFACEMETHOD(HitTest)(
+            Numerics::Vector2 point,
+            int32_t* characterIndex,
+            boolean* isTrailingHit,
+            boolean* isInside) override;
+
+        IFACEMETHOD(GetCaretPosition)(
+            int32_t characterIndex,
+            boolean trailingSideOfCharacter,
+            Numerics::Vector2* position) override;
+
+        //
+        // IClosable
+        //
+
+        IFACEMETHOD(Close)() override;
+
+        //
+        // ICanvasTextLayoutInternal
+        //
+
+        virtual void Draw(
+            ID2D1DeviceContext1* deviceContext,
+            D2D1_POINT_2F origin,
+            ID2D1Brush* brush,
+            const std::function<bool(const D2D1_RECT_F&)>& isCulled) override;
+
+        const std::vector<TextLayoutParagraph>& GetParagraphs() const { return m_paragraphs; }
+        uint64_t GetParagraphLayoutCount() const { return m_paragraphLayoutCount; }
+        size_t GetFormattingRangeCount() const { return m_formattingRanges.size(); }
+
+    private:
+        void ThrowIfClosed();
+
+        //
+        // Appends the paragraphs of m_text[start, end) to paragraphs.  start
+        // must be the start of a paragraph, and end either the end of the
+        // text or just after a paragraph separator.
+        //
+        void SplitParagraphs(uint32_t start, uint32_t end, std::vector<TextLayoutParagraph>* paragraphs) const;
+
+        //
+        // Replaces the formatting of one property over a range of characters.
+        // Value identifies what the applier sets, so that ranges setting the
+        // same value can be merged.
+        //
+        void SetFormatting(
+            int32_t characterIndex,
+            int32_t characterCount,
+            TextLayoutFormattingProperty property,
+            const TextLayoutFormattingValue& value,
+            TextLayoutFormattingRange::Applier apply);
+
+        void CreateParagraphLayout(TextLayoutParagraph& paragraph);
+        void ApplyFormatting(TextLayoutParagraph& paragraph, const TextLayoutFormattingRange& range);
+
+        // Lays out any paragraphs that need it and updates their tops.
+        void EnsureMetrics();
+
+        // Offset of the first paragraph from the top of the requested size.
+        float GetVerticalOffset();
+
+        // The paragraph containing the given character or vertical position.
+        size_t FindParagraphForCharacter(uint32_t characterIndex) const;
+        size_t FindParagraphForY(float y) const;
+    };
+}}}}
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasTextLayoutCache.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // Rough per-entry cost used for memory accounting.  A layout holds on to
+    // the text, its analysis and the shaped glyphs, which grows with the
+    // length of the string.
+    //
+    static const size_t c_entryOverheadInBytes = 1024;
+    static const size_t c_bytesPerCharacter = 64;
+
+
+    static size_t EstimateSizeInBytes(uint32_t textLength)
+    {
+        return c_entryOverheadInBytes + (c_bytesPerCharacter + sizeof(wchar_t)) * textLength;
+    }
+
+
+    bool CanvasTextLayoutCache::LayoutParameters::operator==(const LayoutParameters& other) const
+    {
+        return FormatRealizationId == other.FormatRealizationId &&
+               MaxWidth            == other.MaxWidth &&
+               MaxHeight           == other.MaxHeight &&
+               NoWrap              == other.NoWrap;
+    }
+
+
+    size_t CanvasTextLayoutCache::LayoutParameters::GetHash() const
+    {
+        size_t hash = std::hash<uint64_t>()(FormatRealizationId);
+
+        HashCombine(&hash, std::hash<float>()(MaxWidth));
+        HashCombine(&hash, std::hash<float>()(MaxHeight));
+        HashCombine(&hash, NoWrap ? 1 : 0);
+
+        return hash;
+    }
+
+
+    CanvasTextLayoutCache::CanvasTextLayoutCache(size_t maxSizeInBytes)
+        : m_cache(maxSizeInBytes)
+    {
+    }
+
+
+    ComPtr<IDWriteTextLayout> CanvasTextLayoutCache::GetOrCreate(
+        IDWriteTextFormat* format,
+        uint64_t formatRealizationId,
+        const wchar_t* text,
+        uint32_t textLength,
+        float maxWidth,
+        float maxHeight,
+        bool noWrap)
+    {
+        CheckInPointer(format);
+
+        KeyPolicy::LookupKey key;
+        key.Text = text;
+        key.TextLength = textLength;
+        key.Parameters.FormatRealizationId = formatRealizationId;
+        key.Parameters.MaxWidth = maxWidth;
+        key.Parameters.MaxHeight = maxHeight;
+        key.Parameters.NoWrap = noWrap;
+
+        ComPtr<IDWriteTextLayout> layout;
+
+        if (m_cache.TryGet(key, &layout))
+            return layout;
+
+        //
+        // Creating the layout is the expensive bit, so we do this without
+        // holding the lock.
+        //
+        ThrowIfFailed(GetFactory()->CreateTextLayout(
+            text,
+            textLength,
+            format,
+            maxWidth,
+            maxHeight,
+            &layout));
+
+        if (noWrap)
+            ThrowIfFailed(layout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+        //
+        // DWrite formats lines lazily.  Forcing this now means that the cached
+        // layout isn't modified when it is later drawn from multiple threads.
+        //
+        DWRITE_TEXT_METRICS metrics;
+        ThrowIfFailed(layout->GetMetrics(&metrics));
+
+        m_cache.Add(key, layout, EstimateSizeInBytes(textLength));
+
+        return layout;
+    }
+
+
+    void CanvasTextLayoutCache::Clear()
+    {
+        m_cache.Clear();
+    }
+
+
+    void CanvasTextLayoutCache::SetMaxSizeInBytes(size_t value)
+    {
+        m_cache.SetMaxSizeInBytes(value);
+    }
+
+
+    size_t CanvasTextLayoutCache::GetMaxSizeInBytes()
+    {
+        return m_cache.GetMaxSizeInBytes();
+    }
+
+
+    size_t CanvasTextLayoutCache::GetSizeInBytes()
+    {
+        return m_cache.GetSizeInBytes();
+    }
+
+
+    size_t CanvasTextLayoutCache::GetEntryCount()
+    {
+        return m_cache.GetEntryCount();
+    }
+
+
+    uint64_t CanvasTextLayoutCache::GetHitCount()
+    {
+        return m_cache.GetHitCount();
+    }
+
+
+    uint64_t CanvasTextLayoutCache::GetMissCount()
+    {
+        return m_cache.GetMissCount();
+    }
+
+
+    ComPtr<IDWriteFactory> CanvasTextLayoutCache::GetFactory()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_dwriteFactory)
+            m_dwriteFactory = SharedDWriteFactory::GetOrCreate();
+
+        return m_dwriteFactory->Get();
+    }
+}}}}
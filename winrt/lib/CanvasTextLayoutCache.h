@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include "LruCache.h"
+#include "SharedDWriteFactory.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    //
+    // Bounded least-recently-used cache of IDWriteTextLayout objects.
+    //
+    // ID2D1DeviceContext::DrawText shapes and lays out its string on every
+    // call.  Apps that draw the same labels every frame can instead draw a
+    // cached layout via DrawTextLayout.
+    //
+    // Layouts are device independent, so a single cache is shared by all
+    // drawing sessions created through the same CanvasDrawingSessionManager.
+    // All methods are thread-safe.
+    //
+    // Entries are keyed on the string content, the realization id of the
+    // format (see ICanvasTextFormatInternal), the layout box and the word
+    // wrapping override.  DWrite doesn't report how much memory a layout
+    // uses, so the size of each entry is estimated from the string length.
+    //
+    class CanvasTextLayoutCache
+    {
+    public:
+        static const size_t DefaultMaxSizeInBytes = 4 * 1024 * 1024;
+
+        CanvasTextLayoutCache(size_t maxSizeInBytes = DefaultMaxSizeInBytes);
+
+        //
+        // Returns a layout for the given text.  If noWrap is true then word
+        // wrapping is disabled on the layout, leaving the format untouched.
+        //
+        ComPtr<IDWriteTextLayout> GetOrCreate(
+            IDWriteTextFormat* format,
+            uint64_t formatRealizationId,
+            const wchar_t* text,
+            uint32_t textLength,
+            float maxWidth,
+            float maxHeight,
+            bool noWrap);
+
+        void Clear();
+
+        void SetMaxSizeInBytes(size_t value);
+        size_t GetMaxSizeInBytes();
+        size_t GetSizeInBytes();
+        size_t GetEntryCount();
+
+        uint64_t GetHitCount();
+        uint64_t GetMissCount();
+
+    private:
+        struct LayoutParameters
+        {
+            uint64_t FormatRealizationId;
+            float MaxWidth;
+            float MaxHeight;
+            bool NoWrap;
+
+            bool operator==(const LayoutParameters& other) const;
+            size_t GetHash() const;
+        };
+
+        typedef TextKeyPolicy<LayoutParameters> KeyPolicy;
+
+        LruCache<KeyPolicy, ComPtr<IDWriteTextLayout>> m_cache;
+
+        std::mutex m_mutex;
+        std::shared_ptr<SharedDWriteFactory> m_dwriteFactory;
+
+        ComPtr<IDWriteFactory> GetFactory();
+    };
+}}}}
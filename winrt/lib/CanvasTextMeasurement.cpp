@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "CanvasTextMeasurement.h"
+#include "SharedDWriteFactory.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    CanvasTextMeasurement::CanvasTextMeasurement(std::shared_ptr<const TextMeasurement> measurement)
+        : m_measurement(measurement)
+    {
+        ThrowIfNullPointer(m_measurement.get(), E_INVALIDARG);
+    }
+
+
+    IFACEMETHODIMP CanvasTextMeasurement::get_LayoutBounds(ABI::Windows::Foundation::Rect* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+                *value = m_measurement->LayoutBounds;
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextMeasurement::get_LineCount(int32_t* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+                *value = static_cast<int32_t>(m_measurement->LineMetrics.size());
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextMeasurement::get_LineMetrics(
+        uint32_t* valueCount,
+        CanvasLineMetrics** valueElements)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(valueCount);
+                CheckAndClearOutPointer(valueElements);
+
+                auto& lineMetrics = m_measurement->LineMetrics;
+
+                assert(lineMetrics.size() <= UINT_MAX);
+
+                (*valueCount) = static_cast<uint32_t>(lineMetrics.size());
+                (*valueElements) = static_cast<CanvasLineMetrics*>(CoTaskMemAlloc(lineMetrics.size() * sizeof(CanvasLineMetrics)));
+                ThrowIfNullPointer(*valueElements, E_OUTOFMEMORY);
+
+                if (!lineMetrics.empty())
+                {
+                    memcpy(*valueElements, &lineMetrics[0], lineMetrics.size() * sizeof(CanvasLineMetrics));
+                }
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasTextMeasurement::get_Overhang(CanvasTextOverhang* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(value);
+                *value = m_measurement->Overhang;
+            });
+    }
+
+
+    //
+    // Rough per-entry cost used for memory accounting: the entry itself and
+    // its index node, plus a copy of the text and the line metrics.
+    //
+    static const size_t c_entryOverheadInBytes = 256;
+
+
+    static size_t EstimateSizeInBytes(uint32_t textLength, size_t lineCount)
+    {
+        return c_entryOverheadInBytes + sizeof(wchar_t) * textLength + sizeof(CanvasLineMetrics) * lineCount;
+    }
+
+
+    static std::shared_ptr<const TextMeasurement> Measure(
+        IDWriteFactory* factory,
+        IDWriteTextFormat* format,
+        const wchar_t* text,
+        uint32_t textLength,
+        float requestedWidth)
+    {
+        //
+        // The layout box is given no height, and its paragraph alignment is
+        // forced to near, so the format's vertical alignment doesn't move
+        // the text away from the top of the box.
+        //
+        ComPtr<IDWriteTextLayout> layout;
+        ThrowIfFailed(factory->CreateTextLayout(
+            text,
+            textLength,
+            format,
+            requestedWidth,
+            0,
+            &layout));
+
+        ThrowIfFailed(layout->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR));
+
+        if (requestedWidth == 0)
+            ThrowIfFailed(layout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+        DWRITE_TEXT_METRICS metrics;
+        ThrowIfFailed(layout->GetMetrics(&metrics));
+
+        DWRITE_OVERHANG_METRICS overhang;
+        ThrowIfFailed(layout->GetOverhangMetrics(&overhang));
+
+        std::vector<DWRITE_LINE_METRICS> lineMetrics(metrics.lineCount);
+
+        if (!lineMetrics.empty())
+        {
+            UINT32 actualLineCount;
+            ThrowIfFailed(layout->GetLineMetrics(
+                &lineMetrics[0],
+                metrics.lineCount,
+                &actualLineCount));
+
+            assert(actualLineCount == metrics.lineCount);
+        }
+
+        auto measurement = std::make_shared<TextMeasurement>();
+
+        measurement->LayoutBounds.X = metrics.left;
+        measurement->LayoutBounds.Y = metrics.top;
+        measurement->LayoutBounds.Width = metrics.width;
+        measurement->LayoutBounds.Height = metrics.height;
+
+        //
+        // DWrite's overhangs are relative to the layout box, which is
+        // requestedWidth by 0; ours are relative to the layout bounds.
+        //
+        measurement->Overhang.Left = metrics.left + overhang.left;
+        measurement->Overhang.Top = metrics.top + overhang.top;
+        measurement->Overhang.Right = requestedWidth + overhang.right - (metrics.left + metrics.width);
+        measurement->Overhang.Bottom = overhang.bottom - (metrics.top + metrics.height);
+
+        measurement->LineMetrics.reserve(lineMetrics.size());
+
+        for (auto& line : lineMetrics)
+        {
+            CanvasLineMetrics canvasLine;
+            canvasLine.CharacterCount = line.length;
+            canvasLine.TrailingWhitespaceCount = line.trailingWhitespaceLength;
+            canvasLine.TerminalNewlineCount = line.newlineLength;
+            canvasLine.Height = line.height;
+            canvasLine.Baseline = line.baseline;
+
+            measurement->LineMetrics.push_back(canvasLine);
+        }
+
+        return measurement;
+    }
+
+
+    static CanvasTextMeasurementCache s_sharedCache;
+
+
+    CanvasTextMeasurementCache& CanvasTextMeasurementCache::GetShared()
+    {
+        return s_sharedCache;
+    }
+
+
+    bool CanvasTextMeasurementCache::MeasurementParameters::operator==(const MeasurementParameters& other) const
+    {
+        return FormatRealizationId == other.FormatRealizationId &&
+               RequestedWidth      == other.RequestedWidth;
+    }
+
+
+    size_t CanvasTextMeasurementCache::MeasurementParameters::GetHash() const
+    {
+        size_t hash = std::hash<uint64_t>()(FormatRealizationId);
+        HashCombine(&hash, std::hash<float>()(RequestedWidth));
+        return hash;
+    }
+
+
+    CanvasTextMeasurementCache::CanvasTextMeasurementCache(size_t maxSizeInBytes)
+        : m_cache(maxSizeInBytes)
+    {
+    }
+
+
+    std::shared_ptr<const TextMeasurement> CanvasTextMeasurementCache::GetOrCreate(
+        IDWriteTextFormat* format,
+        uint64_t formatRealizationId,
+        const wchar_t* text,
+        uint32_t textLength,
+        float requestedWidth)
+    {
+        CheckInPointer(format);
+
+        KeyPolicy::LookupKey key;
+        key.Text = text;
+        key.TextLength = textLength;
+        key.Parameters.FormatRealizationId = formatRealizationId;
+        key.Parameters.RequestedWidth = requestedWidth;
+
+        std::shared_ptr<const TextMeasurement> measurement;
+
+        if (m_cache.TryGet(key, &measurement))
+            return measurement;
+
+        //
+        // Measuring is the expensive bit, so we do this without holding the
+        // lock.  The factory isn't kept, since this cache may outlive
+        // everything else that uses it (see SharedDWriteFactory).
+        //
+        measurement = Measure(
+            SharedDWriteFactory::GetOrCreate()->Get(),
+            format,
+            text,
+            textLength,
+            requestedWidth);
+
+        m_cache.Add(key, measurement, EstimateSizeInBytes(textLength, measurement->LineMetrics.size()));
+
+        return measurement;
+    }
+
+
+    void CanvasTextMeasurementCache::Clear()
+    {
+        m_cache.Clear();
+    }
+
+
+    size_t CanvasTextMeasurementCache::GetSizeInBytes()
+    {
+        return m_cache.GetSizeInBytes();
+    }
+
+
+    size_t CanvasTextMeasurementCache::GetEntryCount()
+    {
+        return m_cache.GetEntryCount();
+    }
+
+
+    uint64_t CanvasTextMeasurementCache::GetHitCount()
+    {
+        return m_cache.GetHitCount();
+    }
+
+
+    uint64_t CanvasTextMeasurementCache::GetMissCount()
+    {
+        return m_cache.GetMissCount();
+    }
+}}}}
@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <Canvas.abi.h>
+
+#include "LruCache.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    //
+    // The metrics of one string laid out with one format.  These are shared
+    // between CanvasTextMeasurementCache and any number of
+    // CanvasTextMeasurements on different threads, so are never modified
+    // once created.
+    //
+    struct TextMeasurement
+    {
+        ABI::Windows::Foundation::Rect LayoutBounds;
+        CanvasTextOverhang Overhang;
+        std::vector<CanvasLineMetrics> LineMetrics;
+    };
+
+
+    class CanvasTextMeasurement : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasTextMeasurement>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextMeasurement, BaseTrust);
+
+        std::shared_ptr<const TextMeasurement> m_measurement;
+
+    public:
+        CanvasTextMeasurement(std::shared_ptr<const TextMeasurement> measurement);
+
+        IFACEMETHOD(get_LayoutBounds)(ABI::Windows::Foundation::Rect* value) override;
+        IFACEMETHOD(get_LineCount)(int32_t* value) override;
+
+        IFACEMETHOD(get_LineMetrics)(
+            uint32_t* valueCount,
+            CanvasLineMetrics** valueElements) override;
+
+        IFACEMETHOD(get_Overhang)(CanvasTextOverhang* value) override;
+
+        const std::shared_ptr<const TextMeasurement>& GetMeasurement() const { return m_measurement; }
+    };
+
+
+    //
+    // Bounded least-recently-used cache of text measurements.
+    //
+    // Virtualized lists measure every item that scrolls into view, and
+    // usually measure the same items again when they scroll back.  Laying
+    // out a string is much more expensive than looking it up, so
+    // CanvasTextFormat::MeasureText goes through the process-wide cache
+    // returned by GetShared.  All methods are thread-safe.
+    //
+    // Entries are keyed on the string content, the realization id of the
+    // format (see ICanvasTextFormatInternal) and the requested width.
+    // Formats with the same properties share a realization id, so they also
+    // share measurements.  Entries hold no COM objects, which is what makes
+    // it safe for the shared cache to be a global.
+    //
+    class CanvasTextMeasurementCache
+    {
+    public:
+        static const size_t DefaultMaxSizeInBytes = 1024 * 1024;
+
+        static CanvasTextMeasurementCache& GetShared();
+
+        CanvasTextMeasurementCache(size_t maxSizeInBytes = DefaultMaxSizeInBytes);
+
+        std::shared_ptr<const TextMeasurement> GetOrCreate(
+            IDWriteTextFormat* format,
+            uint64_t formatRealizationId,
+            const wchar_t* text,
+            uint32_t textLength,
+            float requestedWidth);
+
+        void Clear();
+
+        size_t GetSizeInBytes();
+        size_t GetEntryCount();
+
+        uint64_t GetHitCount();
+        uint64_t GetMissCount();
+
+    private:
+        struct MeasurementParameters
+        {
+            uint64_t FormatRealizationId;
+            float RequestedWidth;
+
+            bool operator==(const MeasurementParameters& other) const;
+            size_t GetHash() const;
+        };
+
+        typedef TextKeyPolicy<MeasurementParameters> KeyPolicy;
+
+        LruCache<KeyPolicy, std::shared_ptr<const TextMeasurement>> m_cache;
+    };
+}}}}
@@ -169,4 +169,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         static_assert(offsetof(D2D1_MATRIX_3X2_F, _31) == offsetof(Numerics::Matrix3x2, M31), "Matrix3x2 layout must match D2D1_MATRIX_3X2_F");
         static_assert(offsetof(D2D1_MATRIX_3X2_F, _32) == offsetof(Numerics::Matrix3x2, M32), "Matrix3x2 layout must match D2D1_MATRIX_3X2_F");
     }
+
+    template<> inline void ValidateReinterpretAs<const D2D1_POINT_2F*, const Numerics::Vector2*>()
+    {
+        static_assert(offsetof(D2D1_POINT_2F, x) == offsetof(Numerics::Vector2, X), "Vector2 layout must match D2D1_POINT_2F");
+        static_assert(offsetof(D2D1_POINT_2F, y) == offsetof(Numerics::Vector2, Y), "Vector2 layout must match D2D1_POINT_2F");
+        static_assert(sizeof(D2D1_POINT_2F) == sizeof(Numerics::Vector2), "Vector2 layout must match D2D1_POINT_2F");
+    }
+
+    inline D2D1::Matrix3x2F ToD2DMatrix(Numerics::Matrix3x2 value)
+    {
+        return *D2D1::Matrix3x2F::ReinterpretBaseType(ReinterpretAs<D2D1_MATRIX_3X2_F*>(&value));
+    }
 }}}}
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // FNV-1a over the characters of a string.  This is used wherever we key
+    // a table on string content, so that equal strings hash the same way in
+    // every cache.
+    //
+    inline size_t HashString(const wchar_t* text, uint32_t textLength)
+    {
+        size_t hash = 2166136261U;
+
+        for (uint32_t i = 0; i < textLength; ++i)
+        {
+            hash ^= static_cast<size_t>(text[i]);
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+
+
+    //
+    // Mixes another value into a hash, as boost::hash_combine does.
+    //
+    inline void HashCombine(size_t* hash, size_t value)
+    {
+        *hash ^= value + 0x9e3779b9 + (*hash << 6) + (*hash >> 2);
+    }
+}}}}
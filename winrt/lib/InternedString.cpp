@@ -0,0 +1,260 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include <atomic>
+#include <unordered_map>
+
+#include "HashHelpers.h"
+#include "InternedString.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    class InternedStringEntry
+    {
+    public:
+        InternedStringEntry(const wchar_t* buffer, uint32_t length)
+        {
+            ThrowIfFailed(WindowsCreateString(buffer, length, Value.GetAddressOf()));
+            Buffer = WindowsGetStringRawBuffer(Value, &Length);
+        }
+
+        WinString Value;
+        const wchar_t* Buffer;
+        uint32_t Length;
+    };
+
+
+    //
+    // The pool is keyed by the characters of each entry, pointing into the
+    // entry itself so that lookups don't need to copy the string.  This
+    // means that an entry must be removed from the pool before it is freed;
+    // see DeleteEntry.
+    //
+
+    struct StringPoolKey
+    {
+        const wchar_t* Buffer;
+        uint32_t Length;
+
+        bool operator==(const StringPoolKey& other) const
+        {
+            return Length == other.Length && wmemcmp(Buffer, other.Buffer, Length) == 0;
+        }
+    };
+
+
+    struct StringPoolKeyHash
+    {
+        size_t operator()(const StringPoolKey& key) const
+        {
+            return HashString(key.Buffer, key.Length);
+        }
+    };
+
+
+    typedef std::unordered_map<StringPoolKey, std::weak_ptr<const InternedStringEntry>, StringPoolKeyHash> StringPoolMap;
+
+    struct StringPool
+    {
+        std::mutex Mutex;
+        StringPoolMap Entries;
+    };
+
+
+    //
+    // Interned strings are held by other globals, such as the text format
+    // intern table, that may be destroyed after this file's globals when the
+    // DLL is unloaded.  Releasing those strings needs the pool, so it is
+    // created on first use and deliberately never destroyed.
+    //
+    // This is a zero-initialized atomic, rather than a function-local
+    // static, since those aren't initialized thread-safely by VS2013.
+    //
+    static std::atomic<StringPool*> s_stringPool;
+
+    static StringPool& GetStringPool()
+    {
+        auto pool = s_stringPool.load(std::memory_order_acquire);
+        if (pool)
+            return *pool;
+
+        std::unique_ptr<StringPool> newPool(new StringPool());
+
+        if (s_stringPool.compare_exchange_strong(pool, newPool.get(), std::memory_order_acq_rel))
+            return *newPool.release();
+
+        // Another thread got there first; pool now points at its one
+        return *pool;
+    }
+
+
+    static void DeleteEntry(const InternedStringEntry* entry)
+    {
+        {
+            auto& pool = GetStringPool();
+            std::lock_guard<std::mutex> lock(pool.Mutex);
+
+            StringPoolKey key = { entry->Buffer, entry->Length };
+            auto it = pool.Entries.find(key);
+
+            //
+            // If the string was interned again after this entry expired then
+            // the pool already points at a new entry, which must be left
+            // alone.
+            //
+            if (it != pool.Entries.end() && it->second.expired())
+                pool.Entries.erase(it);
+        }
+
+        delete entry;
+    }
+
+
+    static std::shared_ptr<const InternedStringEntry> Intern(const wchar_t* buffer, uint32_t length)
+    {
+        if (length == 0)
+            return nullptr;
+
+        StringPoolKey key = { buffer, length };
+
+        auto& pool = GetStringPool();
+
+        {
+            std::lock_guard<std::mutex> lock(pool.Mutex);
+
+            auto it = pool.Entries.find(key);
+            if (it != pool.Entries.end())
+            {
+                if (auto entry = it->second.lock())
+                    return entry;
+            }
+        }
+
+        //
+        // The new entry is created, and if another thread got there first,
+        // released, without holding the lock, since DeleteEntry takes it.
+        //
+        std::shared_ptr<const InternedStringEntry> newEntry(new InternedStringEntry(buffer, length), DeleteEntry);
+        std::shared_ptr<const InternedStringEntry> existingEntry;
+
+        {
+            std::lock_guard<std::mutex> lock(pool.Mutex);
+
+            auto it = pool.Entries.find(key);
+            if (it != pool.Entries.end())
+            {
+                existingEntry = it->second.lock();
+
+                if (!existingEntry)
+                    pool.Entries.erase(it);
+            }
+
+            if (!existingEntry)
+            {
+                StringPoolKey newKey = { newEntry->Buffer, newEntry->Length };
+                pool.Entries.insert(std::make_pair(newKey, newEntry));
+            }
+        }
+
+        return existingEntry ? existingEntry : newEntry;
+    }
+
+
+    InternedString::InternedString()
+    {
+    }
+
+
+    InternedString::InternedString(HSTRING value)
+    {
+        uint32_t length;
+        auto buffer = WindowsGetStringRawBuffer(value, &length);
+        m_entry = Intern(buffer, length);
+    }
+
+
+    InternedString::InternedString(const wchar_t* value)
+        : m_entry(Intern(value, static_cast<uint32_t>(wcslen(value))))
+    {
+    }
+
+
+    InternedString::InternedString(const wchar_t* buffer, uint32_t length)
+        : m_entry(Intern(buffer, length))
+    {
+    }
+
+
+    const wchar_t* InternedString::GetBuffer() const
+    {
+        return m_entry ? m_entry->Buffer : L"";
+    }
+
+
+    uint32_t InternedString::GetLength() const
+    {
+        return m_entry ? m_entry->Length : 0;
+    }
+
+
+    void InternedString::CopyTo(HSTRING* value) const
+    {
+        if (m_entry)
+            m_entry->Value.CopyTo(value);
+        else
+            *value = nullptr;
+    }
+
+
+    bool InternedString::Equals(HSTRING value) const
+    {
+        uint32_t length;
+        auto buffer = WindowsGetStringRawBuffer(value, &length);
+
+        return length == GetLength() && wmemcmp(buffer, GetBuffer(), length) == 0;
+    }
+
+
+    bool InternedString::operator==(const InternedString& other) const
+    {
+        return m_entry == other.m_entry;
+    }
+
+
+    bool InternedString::operator!=(const InternedString& other) const
+    {
+        return m_entry != other.m_entry;
+    }
+
+
+    size_t InternedString::GetHash() const
+    {
+        return std::hash<const void*>()(m_entry.get());
+    }
+
+
+    size_t InternedString::GetPoolSize()
+    {
+        auto& pool = GetStringPool();
+        std::lock_guard<std::mutex> lock(pool.Mutex);
+
+        return pool.Entries.size();
+    }
+
+
+    size_t InternedStringHash::operator()(const InternedString& value) const
+    {
+        return value.GetHash();
+    }
+}}}}
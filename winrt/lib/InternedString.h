@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    class InternedStringEntry;
+
+    //
+    // An immutable string from a process-wide pool.  Equal strings share one
+    // pool entry, so InternedStrings are compared and hashed by the address
+    // of their entry rather than by their contents, and copying one only
+    // adds a reference.  The entry holds the string as an HSTRING, so
+    // handing it back out through the ABI doesn't copy the characters
+    // either.
+    //
+    // Like CanvasTextFormatInternTable, the pool doesn't keep strings alive:
+    // an entry is removed as soon as the last InternedString using it goes
+    // away.  The empty string doesn't need an entry at all.
+    //
+    // Creating an InternedString from characters takes the pool's lock;
+    // nothing else does.
+    //
+    class InternedString
+    {
+        std::shared_ptr<const InternedStringEntry> m_entry;
+
+    public:
+        InternedString();
+        explicit InternedString(HSTRING value);
+
+        // Stops at the first null, so embedded nulls are dropped.
+        explicit InternedString(const wchar_t* value);
+
+        InternedString(const wchar_t* buffer, uint32_t length);
+
+        // Never null, and always null-terminated.
+        const wchar_t* GetBuffer() const;
+        uint32_t GetLength() const;
+
+        void CopyTo(HSTRING* value) const;
+
+        // Compares contents, without adding value to the pool.
+        bool Equals(HSTRING value) const;
+
+        bool operator==(const InternedString& other) const;
+        bool operator!=(const InternedString& other) const;
+
+        size_t GetHash() const;
+
+        // Number of distinct non-empty strings currently in use.
+        static size_t GetPoolSize();
+    };
+
+
+    struct InternedStringHash
+    {
+        size_t operator()(const InternedString& value) const;
+    };
+}}}}
@@ -0,0 +1,263 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include "HashHelpers.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // Bounded least-recently-used cache.  This is what CanvasTextLayoutCache
+    // and CanvasTextMeasurementCache are built on.
+    //
+    // KEY_POLICY describes how entries are keyed:
+    //
+    //     typedef ... Key;           stored in each entry
+    //     typedef ... LookupKey;     what callers look entries up with
+    //
+    //     static size_t Hash(const LookupKey&);
+    //     static bool Equals(const Key&, const LookupKey&);
+    //     static void Store(const LookupKey&, Key*);
+    //
+    // Having a separate lookup key means that a hit doesn't have to copy
+    // anything (such as the string being looked up); the key is only copied
+    // by Store once an entry is actually added.
+    //
+    // The caller estimates the size of each entry, and the least recently
+    // used entries are evicted to keep the total under the maximum size.
+    //
+    // All methods are thread-safe.  Values are expected to be created
+    // without holding any lock, between a TryGet that missed and the Add, so
+    // two threads may race to add the same entry; the second one is ignored.
+    //
+    template<typename KEY_POLICY, typename VALUE>
+    class LruCache
+    {
+    public:
+        typedef typename KEY_POLICY::Key Key;
+        typedef typename KEY_POLICY::LookupKey LookupKey;
+
+    private:
+        struct Entry
+        {
+            size_t Hash;
+            Key StoredKey;
+            VALUE Value;
+            size_t SizeInBytes;
+        };
+
+        typedef std::list<Entry> EntryList;
+
+        std::mutex m_mutex;
+
+        // Most recently used entries are at the front of the list.
+        EntryList m_entries;
+        std::unordered_multimap<size_t, typename EntryList::iterator> m_index;
+
+        size_t m_maxSizeInBytes;
+        size_t m_sizeInBytes;
+        uint64_t m_hitCount;
+        uint64_t m_missCount;
+
+    public:
+        LruCache(size_t maxSizeInBytes)
+            : m_maxSizeInBytes(maxSizeInBytes)
+            , m_sizeInBytes(0)
+            , m_hitCount(0)
+            , m_missCount(0)
+        {
+        }
+
+        //
+        // On a hit this marks the entry as most recently used and copies its
+        // value out.  Hits and misses are both counted.
+        //
+        bool TryGet(const LookupKey& key, VALUE* value)
+        {
+            auto hash = KEY_POLICY::Hash(key);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = Find(hash, key);
+            if (it == m_entries.end())
+            {
+                ++m_missCount;
+                return false;
+            }
+
+            ++m_hitCount;
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            *value = it->Value;
+            return true;
+        }
+
+        void Add(const LookupKey& key, const VALUE& value, size_t sizeInBytes)
+        {
+            auto hash = KEY_POLICY::Hash(key);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // This would evict everything else, so don't bother caching it.
+            if (sizeInBytes > m_maxSizeInBytes)
+                return;
+
+            // Another thread may have added the same entry while the caller
+            // wasn't holding the lock.
+            if (Find(hash, key) != m_entries.end())
+                return;
+
+            TrimToSize(m_maxSizeInBytes - sizeInBytes);
+
+            m_entries.emplace_front();
+
+            auto& entry = m_entries.front();
+            entry.Hash = hash;
+            KEY_POLICY::Store(key, &entry.StoredKey);
+            entry.Value = value;
+            entry.SizeInBytes = sizeInBytes;
+
+            m_sizeInBytes += sizeInBytes;
+            m_index.insert(std::make_pair(hash, m_entries.begin()));
+        }
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            TrimToSize(0);
+        }
+
+        void SetMaxSizeInBytes(size_t value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_maxSizeInBytes = value;
+            TrimToSize(m_maxSizeInBytes);
+        }
+
+        size_t GetMaxSizeInBytes()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_maxSizeInBytes;
+        }
+
+        size_t GetSizeInBytes()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_sizeInBytes;
+        }
+
+        size_t GetEntryCount()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_entries.size();
+        }
+
+        uint64_t GetHitCount()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_hitCount;
+        }
+
+        uint64_t GetMissCount()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_missCount;
+        }
+
+    private:
+        typename EntryList::iterator Find(size_t hash, const LookupKey& key)
+        {
+            auto range = m_index.equal_range(hash);
+
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (KEY_POLICY::Equals(it->second->StoredKey, key))
+                    return it->second;
+            }
+
+            return m_entries.end();
+        }
+
+        void TrimToSize(size_t maxSizeInBytes)
+        {
+            while (!m_entries.empty() && m_sizeInBytes > maxSizeInBytes)
+            {
+                auto leastRecentlyUsed = std::prev(m_entries.end());
+
+                auto range = m_index.equal_range(leastRecentlyUsed->Hash);
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    if (it->second == leastRecentlyUsed)
+                    {
+                        m_index.erase(it);
+                        break;
+                    }
+                }
+
+                m_sizeInBytes -= leastRecentlyUsed->SizeInBytes;
+                m_entries.erase(leastRecentlyUsed);
+            }
+        }
+    };
+
+
+    //
+    // Key policy for caches keyed on a string plus some other parameters,
+    // such as the format and layout box a string is laid out with.  The
+    // lookup key points at the caller's characters; the stored key owns a
+    // copy of them.
+    //
+    // PARAMETERS must be copyable, comparable with == and provide
+    // size_t GetHash() const.
+    //
+    template<typename PARAMETERS>
+    struct TextKeyPolicy
+    {
+        struct LookupKey
+        {
+            const wchar_t* Text;
+            uint32_t TextLength;
+            PARAMETERS Parameters;
+        };
+
+        struct Key
+        {
+            std::wstring Text;
+            PARAMETERS Parameters;
+        };
+
+        static size_t Hash(const LookupKey& key)
+        {
+            auto hash = HashString(key.Text, key.TextLength);
+            HashCombine(&hash, key.Parameters.GetHash());
+            return hash;
+        }
+
+        static bool Equals(const Key& entryKey, const LookupKey& key)
+        {
+            return entryKey.Parameters == key.Parameters &&
+                entryKey.Text.size() == key.TextLength &&
+                std::equal(key.Text, key.Text + key.TextLength, entryKey.Text.begin());
+        }
+
+        static void Store(const LookupKey& key, Key* entryKey)
+        {
+            entryKey->Text.assign(key.Text, key.TextLength);
+            entryKey->Parameters = key.Parameters;
+        }
+    };
+}}}}
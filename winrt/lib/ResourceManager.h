@@ -98,14 +98,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         //
         // Indicates that 'resource' is no longer being wrapped by anything.
-        // The is called by ResourceWrapper::Close().
+        // The is called by ResourceWrapper::Close() and Detach().
         //
         void Remove(resource_t* resource)
         {
             m_tracker.Remove(resource);
         }
 
-        // ResourceWrapper needs to be able to call remove
+        //
+        // Indicates that 'wrapper' now wraps 'resource' again, having been
+        // closed or detached.  This is called by ResourceWrapper::Attach().
+        //
+        void Add(resource_t* resource, wrapper_t* wrapper)
+        {
+            m_tracker.Add(resource, wrapper);
+        }
+
+        // ResourceWrapper needs to be able to call Remove and Add
         friend class ResourceWrapper<TRAITS>;
     };
 
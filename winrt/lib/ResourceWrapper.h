@@ -40,6 +40,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         std::shared_ptr<typename TRAITS::manager_t> m_manager;
         ClosablePtr<typename TRAITS::resource_t> m_resource;
 
+        // The resource the wrapper was last attached to, kept while it is
+        // detached (see Detach) only so that Attach can tell whether it is
+        // getting the same one back.
+        ComPtr<typename TRAITS::resource_t> m_detachedResource;
+
     public:
         typedef typename TRAITS::resource_t resource_t;
         typedef typename TRAITS::wrapper_t wrapper_t;
@@ -64,6 +69,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             return m_resource.EnsureNotClosed();
         }
 
+        // As GetResource, but returns null rather than throwing if closed.
+        resource_t* TryGetResource() throw()
+        {
+            return m_resource.GetIfNotClosed();
+        }
+
         std::shared_ptr<typename TRAITS::manager_t> Manager()
         {
             return m_manager;
@@ -78,6 +89,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             return ExceptionBoundary(
                 [&]
                 {
+                    m_detachedResource.Reset();
+
                     if (m_resource)
                     {
                         auto& resource = m_resource.Close();
@@ -101,5 +114,45 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                     ThrowIfFailed(resource.CopyTo(outResource));
                 });
         }
+
+    protected:
+        //
+        // Detach and Attach allow a wrapper to be recycled.  A detached wrapper
+        // behaves as if it had been closed, and is unregistered from its
+        // manager like a closed one, so that the resource is free to be
+        // wrapped by something else in the meantime.  Attach registers the
+        // wrapper again.
+        //
+        // Attach returns false if the wrapper was attached to the same
+        // resource as before it was detached, so that anything derived from
+        // that resource can be kept.  If it throws the wrapper stays
+        // detached.
+        //
+
+        void Detach()
+        {
+            if (!m_resource)
+                return;
+
+            m_detachedResource = m_resource.Close();
+            m_manager->Remove(m_detachedResource.Get());
+        }
+
+        bool Attach(resource_t* resource)
+        {
+            CheckInPointer(resource);
+
+            if (m_resource)
+                ThrowHR(E_ILLEGAL_METHOD_CALL);
+
+            m_manager->Add(resource, static_cast<wrapper_t*>(this));
+
+            bool isNewResource = (m_detachedResource.Get() != resource);
+
+            m_detachedResource.Reset();
+            m_resource = resource;
+
+            return isNewResource;
+        }
     };
 }}}}
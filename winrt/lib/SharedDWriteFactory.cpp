@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include <tuple>
+
+#include "SharedDWriteFactory.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    static std::mutex s_sharedFactoryMutex;
+    static std::weak_ptr<SharedDWriteFactory> s_sharedFactory;
+
+
+    std::shared_ptr<SharedDWriteFactory> SharedDWriteFactory::GetOrCreate()
+    {
+        std::lock_guard<std::mutex> lock(s_sharedFactoryMutex);
+
+        auto factory = s_sharedFactory.lock();
+
+        if (!factory)
+        {
+            factory = std::make_shared<SharedDWriteFactory>();
+            s_sharedFactory = factory;
+        }
+
+        return factory;
+    }
+
+
+    SharedDWriteFactory::SharedDWriteFactory()
+    {
+        ThrowIfFailed(DWriteCreateFactory(
+            DWRITE_FACTORY_TYPE_SHARED,
+            __uuidof(IDWriteFactory2),
+            static_cast<IUnknown**>(&m_factory)));
+    }
+
+
+    IDWriteFactory2* SharedDWriteFactory::Get() const
+    {
+        return m_factory.Get();
+    }
+
+
+    bool SharedDWriteFactory::FontFaceKey::operator<(const FontFaceKey& other) const
+    {
+        auto collection = Collection.Get();
+        auto otherCollection = other.Collection.Get();
+
+        return std::tie(collection, FamilyName, Weight, Style, Stretch) <
+            std::tie(otherCollection, other.FamilyName, other.Weight, other.Style, other.Stretch);
+    }
+
+
+    ComPtr<IDWriteFontFace> SharedDWriteFactory::GetOrCreateFontFace(
+        IDWriteFontCollection* collection,
+        const wchar_t* familyName,
+        DWRITE_FONT_WEIGHT weight,
+        DWRITE_FONT_STYLE style,
+        DWRITE_FONT_STRETCH stretch)
+    {
+        FontFaceKey key;
+        key.Collection = collection ? collection : GetSystemFontCollection();
+        key.FamilyName = familyName;
+        key.Weight = weight;
+        key.Style = style;
+        key.Stretch = stretch;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_fontFaces.find(key);
+            if (it != m_fontFaces.end())
+                return it->second;
+        }
+
+        //
+        // Loading the font can take a while, so it is done without holding
+        // the lock.  If two threads race to load the same face then the
+        // first one to finish wins; the other's face is discarded.
+        //
+        auto fontFace = CreateFontFace(key);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_fontFaces.insert(std::make_pair(key, fontFace)).first->second;
+    }
+
+
+    size_t SharedDWriteFactory::GetFontFaceCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_fontFaces.size();
+    }
+
+
+    ComPtr<IDWriteFontCollection> SharedDWriteFactory::GetSystemFontCollection()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_systemFontCollection)
+                return m_systemFontCollection;
+        }
+
+        ComPtr<IDWriteFontCollection> collection;
+        ThrowIfFailed(m_factory->GetSystemFontCollection(&collection, FALSE));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_systemFontCollection)
+            m_systemFontCollection = collection;
+
+        return m_systemFontCollection;
+    }
+
+
+    ComPtr<IDWriteFontFace> SharedDWriteFactory::CreateFontFace(const FontFaceKey& key)
+    {
+        uint32_t familyIndex;
+        BOOL exists;
+        ThrowIfFailed(key.Collection->FindFamilyName(key.FamilyName.c_str(), &familyIndex, &exists));
+
+        if (!exists)
+            return nullptr;
+
+        ComPtr<IDWriteFontFamily> family;
+        ThrowIfFailed(key.Collection->GetFontFamily(familyIndex, &family));
+
+        ComPtr<IDWriteFont> font;
+        ThrowIfFailed(family->GetFirstMatchingFont(key.Weight, key.Stretch, key.Style, &font));
+
+        ComPtr<IDWriteFontFace> fontFace;
+        ThrowIfFailed(font->CreateFontFace(&fontFace));
+
+        return fontFace;
+    }
+}}}}
@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using namespace ::Microsoft::WRL;
+
+    //
+    // The DirectWrite factory shared by all text formats and text layout
+    // caches in the process.
+    //
+    // Objects that use the factory hold a shared_ptr to it, so it is created
+    // on first use and released once nothing needs it any more.  Only a
+    // weak_ptr is kept globally, since global references to COM objects
+    // would be released in an unpredictable order at shutdown.
+    //
+    // The factory also caches the font faces that text formats resolve to
+    // (see GetOrCreateFontFace).  Holding a face keeps its font file open and
+    // its family's metadata loaded, so that matching the same font again
+    // when a layout is created doesn't have to go back to the disk.  Once
+    // fonts have been preloaded the CanvasTextFormat activation factory
+    // keeps the shared factory, and so this cache, alive.
+    //
+    // All methods are thread-safe.
+    //
+    class SharedDWriteFactory
+    {
+        ComPtr<IDWriteFactory2> m_factory;
+
+        struct FontFaceKey
+        {
+            // The collection is held so that its address can't be reused
+            // by another collection while it is in the cache.
+            ComPtr<IDWriteFontCollection> Collection;
+            std::wstring FamilyName;
+            DWRITE_FONT_WEIGHT Weight;
+            DWRITE_FONT_STYLE Style;
+            DWRITE_FONT_STRETCH Stretch;
+
+            bool operator<(const FontFaceKey& other) const;
+        };
+
+        std::mutex m_mutex;
+        ComPtr<IDWriteFontCollection> m_systemFontCollection;
+
+        // Families that aren't in their collection are cached as null.
+        std::map<FontFaceKey, ComPtr<IDWriteFontFace>> m_fontFaces;
+
+    public:
+        static std::shared_ptr<SharedDWriteFactory> GetOrCreate();
+
+        SharedDWriteFactory();
+
+        IDWriteFactory2* Get() const;
+
+        //
+        // Returns the face that a text format with these properties would
+        // draw with, or null if the family isn't in the collection.  A null
+        // collection means the system font collection.  The first lookup of
+        // each combination loads the font; later ones are served from the
+        // cache.
+        //
+        ComPtr<IDWriteFontFace> GetOrCreateFontFace(
+            IDWriteFontCollection* collection,
+            const wchar_t* familyName,
+            DWRITE_FONT_WEIGHT weight,
+            DWRITE_FONT_STYLE style,
+            DWRITE_FONT_STRETCH stretch);
+
+        size_t GetFontFaceCount();
+
+    private:
+        ComPtr<IDWriteFontCollection> GetSystemFontCollection();
+
+        ComPtr<IDWriteFontFace> CreateFontFace(const FontFaceKey& key);
+    };
+}}}}
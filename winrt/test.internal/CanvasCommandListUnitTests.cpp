@@ -0,0 +1,477 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include <future>
+#include <thread>
+
+#include "StubD2DResources.h"
+
+class CommandListFixture
+{
+public:
+    ComPtr<StubCanvasDevice> Device;
+    std::shared_ptr<CanvasDrawingSessionManager> DrawingSessionManager;
+    std::vector<std::wstring> Calls;
+
+    CommandListFixture()
+        : Device(Make<StubCanvasDevice>())
+        , DrawingSessionManager(std::make_shared<CanvasDrawingSessionManager>())
+    {
+    }
+
+    struct CommandList
+    {
+        ComPtr<CanvasCommandList> List;
+        ComPtr<MockD2DCommandList> D2DCommandList;
+        ComPtr<StubD2DDeviceContextWithGetFactory> RecordingContext;
+    };
+
+    CommandList Create()
+    {
+        CommandList result;
+        result.D2DCommandList = Make<MockD2DCommandList>();
+        result.RecordingContext = Make<StubD2DDeviceContextWithGetFactory>();
+
+        auto d2dCommandList = result.D2DCommandList;
+        auto recordingContext = result.RecordingContext;
+
+        recordingContext->MockCreateCommandList =
+            [=](ID2D1CommandList** value)
+            {
+                return d2dCommandList.CopyTo(value);
+            };
+
+        recordingContext->MockSetTarget =
+            [=](ID2D1Image* target)
+            {
+                Assert::AreEqual<ID2D1Image*>(d2dCommandList.Get(), target);
+                Calls.push_back(L"SetTarget");
+            };
+
+        recordingContext->MockBeginDraw = [=] { Calls.push_back(L"BeginDraw"); };
+        recordingContext->MockEndDraw = [=] { Calls.push_back(L"EndDraw"); return S_OK; };
+        d2dCommandList->MockClose = [=] { Calls.push_back(L"Close"); return S_OK; };
+
+        Device->MockCreateDeviceContext =
+            [=]
+            {
+                return recordingContext;
+            };
+
+        result.List = Make<CanvasCommandList>(Device.Get(), DrawingSessionManager);
+
+        Device->MockCreateDeviceContext = nullptr;
+
+        return result;
+    }
+
+    void ExpectCalls(std::vector<std::wstring> const& expected)
+    {
+        Assert::AreEqual(expected.size(), Calls.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+            Assert::AreEqual(expected[i], Calls[i]);
+
+        Calls.clear();
+    }
+};
+
+TEST_CLASS(CanvasCommandListUnitTests)
+{
+    TEST_METHOD(CanvasCommandList_Implements_Expected_Interfaces)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create().List;
+
+        ASSERT_IMPLEMENTS_INTERFACE(commandList, ICanvasCommandList);
+        ASSERT_IMPLEMENTS_INTERFACE(commandList, ICanvasImage);
+        ASSERT_IMPLEMENTS_INTERFACE(commandList, IEffectInput);
+        ASSERT_IMPLEMENTS_INTERFACE(commandList, ABI::Windows::Foundation::IClosable);
+        ASSERT_IMPLEMENTS_INTERFACE(commandList, ICanvasImageInternal);
+        ASSERT_IMPLEMENTS_INTERFACE(commandList, ICanvasCommandListInternal);
+    }
+
+    TEST_METHOD(CanvasCommandList_DrawingSession_RecordsIntoTheCommandList)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+        f.ExpectCalls({ L"SetTarget", L"BeginDraw" });
+
+        ComPtr<IClosable> closable;
+        ThrowIfFailed(drawingSession.As(&closable));
+        ThrowIfFailed(closable->Close());
+        f.ExpectCalls({ L"EndDraw", L"Close" });
+
+        auto d2dImage = commandList.List->GetD2DImage(commandList.RecordingContext.Get());
+        Assert::AreEqual<ID2D1Image*>(commandList.D2DCommandList.Get(), d2dImage.Get());
+        f.ExpectCalls({});
+    }
+
+    TEST_METHOD(CanvasCommandList_CanOnlyBeRecordedOnce)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+
+        ComPtr<ICanvasDrawingSession> secondDrawingSession;
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, commandList.List->CreateDrawingSession(&secondDrawingSession));
+
+        drawingSession.Reset();     // closes the drawing session
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, commandList.List->CreateDrawingSession(&secondDrawingSession));
+    }
+
+    TEST_METHOD(CanvasCommandList_CannotBeDrawnWhileRecording)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+
+        Assert::ExpectException<HResultException>(
+            [&] { commandList.List->GetD2DImage(commandList.RecordingContext.Get()); });
+    }
+
+    TEST_METHOD(CanvasCommandList_DrawnWithoutRecording_IsClosedEmpty)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        auto d2dImage = commandList.List->GetD2DImage(commandList.RecordingContext.Get());
+        Assert::AreEqual<ID2D1Image*>(commandList.D2DCommandList.Get(), d2dImage.Get());
+        f.ExpectCalls({ L"Close" });
+
+        // Drawing it again doesn't close it again
+        commandList.List->GetD2DImage(commandList.RecordingContext.Get());
+        f.ExpectCalls({});
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, commandList.List->CreateDrawingSession(&drawingSession));
+    }
+
+    TEST_METHOD(CanvasCommandList_Closed)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        ThrowIfFailed(commandList.List->Close());
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        Assert::AreEqual(RO_E_CLOSED, commandList.List->CreateDrawingSession(&drawingSession));
+
+        Assert::ExpectException<ObjectDisposedException>(
+            [&] { commandList.List->GetD2DImage(commandList.RecordingContext.Get()); });
+    }
+
+    TEST_METHOD(CanvasCommandList_WaitForRecordingToFinish_BlocksUntilTheDrawingSessionIsClosed)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        // Nothing to wait for before recording starts
+        commandList.List->WaitForRecordingToFinish(std::chrono::seconds(10));
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+
+        auto waiter = std::async(std::launch::async, [&] { commandList.List->WaitForRecordingToFinish(std::chrono::seconds(10)); });
+
+        Assert::IsTrue(std::future_status::timeout == waiter.wait_for(std::chrono::milliseconds(50)));
+
+        drawingSession.Reset();
+
+        waiter.get();
+    }
+
+    TEST_METHOD(CanvasCommandList_WhenEndDrawFails_RecordingStillFinishes)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        commandList.RecordingContext->MockEndDraw = [] { return D2DERR_RECREATE_TARGET; };
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+
+        ComPtr<IClosable> closable;
+        ThrowIfFailed(drawingSession.As(&closable));
+        Assert::AreEqual(D2DERR_RECREATE_TARGET, closable->Close());
+
+        // Doesn't block
+        commandList.List->WaitForRecordingToFinish(std::chrono::seconds(10));
+    }
+
+    TEST_METHOD(CanvasCommandList_WhenPending_WaitForRecordingToFinish_WaitsForRecordingToStart)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        commandList.List->MarkAsPendingDraw();
+
+        auto waiter = std::async(std::launch::async, [&] { return commandList.List->WaitForRecordingToFinish(std::chrono::seconds(10)); });
+
+        Assert::IsTrue(std::future_status::timeout == waiter.wait_for(std::chrono::milliseconds(50)));
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+
+        Assert::IsTrue(std::future_status::timeout == waiter.wait_for(std::chrono::milliseconds(50)));
+
+        drawingSession.Reset();
+
+        Assert::IsTrue(waiter.get());
+    }
+
+    TEST_METHOD(CanvasCommandList_WhenPending_ClosingReleasesWaiters)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        commandList.List->MarkAsPendingDraw();
+
+        auto waiter = std::async(std::launch::async, [&] { return commandList.List->WaitForRecordingToFinish(std::chrono::seconds(10)); });
+
+        Assert::IsTrue(std::future_status::timeout == waiter.wait_for(std::chrono::milliseconds(50)));
+
+        ThrowIfFailed(commandList.List->Close());
+
+        Assert::IsFalse(waiter.get());
+    }
+
+    TEST_METHOD(CanvasCommandList_WhenPending_WaitForRecordingToFinish_GivesUpAfterTheTimeout)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        commandList.List->MarkAsPendingDraw();
+
+        Assert::IsFalse(commandList.List->WaitForRecordingToFinish(std::chrono::milliseconds(10)));
+
+        // It is no longer pending, so it can be drawn (as nothing)
+        commandList.List->GetD2DImage(commandList.RecordingContext.Get());
+    }
+
+    TEST_METHOD(CanvasCommandList_WhileRecording_WaitForRecordingToFinish_GivesUpAfterTheTimeout)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        commandList.List->MarkAsPendingDraw();
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+
+        Assert::IsFalse(commandList.List->WaitForRecordingToFinish(std::chrono::milliseconds(10)));
+
+        // Recording can still finish afterwards
+        drawingSession.Reset();
+        Assert::IsTrue(commandList.List->WaitForRecordingToFinish(std::chrono::milliseconds(10)));
+    }
+
+    TEST_METHOD(CanvasCommandList_WhenPending_CannotBeDrawnBeforeItIsRecorded)
+    {
+        CommandListFixture f;
+        auto commandList = f.Create();
+
+        commandList.List->MarkAsPendingDraw();
+
+        Assert::ExpectException<HResultException>(
+            [&] { commandList.List->GetD2DImage(commandList.RecordingContext.Get()); });
+
+        // It can still be recorded
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+    }
+};
+
+TEST_CLASS(CanvasDrawEventArgs_CommandListTests)
+{
+    class Fixture : public CommandListFixture
+    {
+    public:
+        ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+        ComPtr<CanvasDrawingSession> DrawingSession;
+        ComPtr<CanvasDrawEventArgs> DrawEventArgs;
+        std::vector<ID2D1Image*> DrawnImages;
+
+        Fixture()
+            : DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+        {
+            DrawingSession = DrawingSessionManager->Create(
+                DeviceContext.Get(),
+                std::make_shared<StubCanvasDrawingSessionAdapter>());
+
+            DrawEventArgs = Make<CanvasDrawEventArgs>(DrawingSession.Get());
+
+            DeviceContext->MockGetTransform =
+                [](D2D1_MATRIX_3X2_F* transform)
+                {
+                    *transform = D2D1::IdentityMatrix();
+                };
+
+            DeviceContext->MockSetTransform =
+                [](const D2D1_MATRIX_3X2_F* transform)
+                {
+                    Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::IdentityMatrix(), *transform);
+                };
+
+            DeviceContext->MockDrawImage =
+                [this](ID2D1Image* image)
+                {
+                    DrawnImages.push_back(image);
+                };
+        }
+    };
+
+    TEST_METHOD(CanvasDrawEventArgs_AddCommandList_NullArgument)
+    {
+        Fixture f;
+
+        Assert::AreEqual(E_INVALIDARG, f.DrawEventArgs->AddCommandList(nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawEventArgs_DrawCommandLists_WithNoCommandLists_DoesNothing)
+    {
+        Fixture f;
+
+        f.DeviceContext->MockSetTransform = nullptr;
+
+        f.DrawEventArgs->DrawCommandLists();
+
+        Assert::AreEqual<size_t>(0, f.DrawnImages.size());
+    }
+
+    TEST_METHOD(CanvasDrawEventArgs_DrawCommandLists_DrawsInTheOrderTheyWereAdded)
+    {
+        Fixture f;
+
+        std::vector<CommandListFixture::CommandList> commandLists;
+        std::vector<ComPtr<ICanvasDrawingSession>> drawingSessions;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            commandLists.push_back(f.Create());
+
+            ComPtr<ICanvasDrawingSession> drawingSession;
+            ThrowIfFailed(commandLists.back().List->CreateDrawingSession(&drawingSession));
+            drawingSessions.push_back(drawingSession);
+
+            ThrowIfFailed(f.DrawEventArgs->AddCommandList(commandLists.back().List.Get()));
+        }
+
+        // Finish recording on another thread, in the reverse order
+        auto recorder = std::async(std::launch::async,
+            [&]
+            {
+                for (auto it = drawingSessions.rbegin(); it != drawingSessions.rend(); ++it)
+                    it->Reset();
+            });
+
+        f.DrawEventArgs->DrawCommandLists();
+        recorder.get();
+
+        Assert::AreEqual<size_t>(3, f.DrawnImages.size());
+        for (size_t i = 0; i < 3; ++i)
+            Assert::AreEqual<ID2D1Image*>(commandLists[i].D2DCommandList.Get(), f.DrawnImages[i]);
+
+        // The command lists are only drawn once
+        f.DrawnImages.clear();
+        f.DrawEventArgs->DrawCommandLists();
+        Assert::AreEqual<size_t>(0, f.DrawnImages.size());
+    }
+
+    TEST_METHOD(CanvasDrawEventArgs_DrawCommandLists_WaitsForCommandListsThatHaveNotStartedRecording)
+    {
+        Fixture f;
+
+        auto commandList = f.Create();
+        ThrowIfFailed(f.DrawEventArgs->AddCommandList(commandList.List.Get()));
+
+        auto recorder = std::async(std::launch::async,
+            [&]
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+                ComPtr<ICanvasDrawingSession> drawingSession;
+                ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+            });
+
+        f.DrawEventArgs->DrawCommandLists();
+        recorder.get();
+
+        Assert::AreEqual<size_t>(1, f.DrawnImages.size());
+        Assert::AreEqual<ID2D1Image*>(commandList.D2DCommandList.Get(), f.DrawnImages[0]);
+    }
+
+    TEST_METHOD(CanvasDrawEventArgs_DrawCommandLists_SkipsCommandListsThatWereClosed)
+    {
+        Fixture f;
+
+        auto commandList = f.Create();
+        ThrowIfFailed(f.DrawEventArgs->AddCommandList(commandList.List.Get()));
+        ThrowIfFailed(commandList.List->Close());
+
+        f.DrawEventArgs->DrawCommandLists();
+
+        Assert::AreEqual<size_t>(0, f.DrawnImages.size());
+    }
+
+    TEST_METHOD(CanvasDrawEventArgs_DrawCommandLists_SkipsCommandListsThatAreNotRecordedInTime)
+    {
+        Fixture f;
+
+        auto neverRecorded = f.Create();
+        ThrowIfFailed(f.DrawEventArgs->AddCommandList(neverRecorded.List.Get()));
+
+        auto recorded = f.Create();
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(recorded.List->CreateDrawingSession(&drawingSession));
+        drawingSession.Reset();
+        ThrowIfFailed(f.DrawEventArgs->AddCommandList(recorded.List.Get()));
+
+        f.DrawEventArgs->DrawCommandLists(std::chrono::milliseconds(10));
+
+        Assert::AreEqual<size_t>(1, f.DrawnImages.size());
+        Assert::AreEqual<ID2D1Image*>(recorded.D2DCommandList.Get(), f.DrawnImages[0]);
+    }
+
+    TEST_METHOD(CanvasDrawEventArgs_DrawCommandLists_RestoresTheTransform)
+    {
+        Fixture f;
+
+        auto appTransform = D2D1::Matrix3x2F::Translation(10, 20);
+        std::vector<D2D1_MATRIX_3X2_F> setTransforms;
+
+        f.DeviceContext->MockGetTransform = [&](D2D1_MATRIX_3X2_F* transform) { *transform = appTransform; };
+        f.DeviceContext->MockSetTransform = [&](const D2D1_MATRIX_3X2_F* transform) { setTransforms.push_back(*transform); };
+
+        auto commandList = f.Create();
+
+        ComPtr<ICanvasDrawingSession> drawingSession;
+        ThrowIfFailed(commandList.List->CreateDrawingSession(&drawingSession));
+        drawingSession.Reset();
+
+        ThrowIfFailed(f.DrawEventArgs->AddCommandList(commandList.List.Get()));
+
+        f.DrawEventArgs->DrawCommandLists();
+
+        Assert::AreEqual<size_t>(2, setTransforms.size());
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::IdentityMatrix(), setTransforms[0]);
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(appTransform, setTransforms[1]);
+    }
+};
@@ -55,6 +55,18 @@ TEST_CLASS(CanvasControlTests_CommonAdapter)
         Assert::AreEqual(drawingSession.Get(), drawingSessionRetrieved.Get());
     }
 
+    TEST_METHOD(CanvasControl_LastFrameStatistics)
+    {
+        ComPtr<CanvasControl> canvasControl = Make<CanvasControl>(m_adapter);
+
+        Assert::AreEqual(E_INVALIDARG, canvasControl->get_LastFrameStatistics(nullptr));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(canvasControl->get_LastFrameStatistics(&statistics));
+        Assert::AreEqual(0, statistics.ClearCount);
+        Assert::AreEqual<int64_t>(0, statistics.EndDrawDuration.Duration);
+    }
+
     HRESULT OnCreateResources(ICanvasControl* sender, IInspectable* args)
     {
         Assert::IsNotNull(sender);
@@ -442,4 +454,118 @@ TEST_CLASS(CanvasControlTests_AdapterWithResizing)
 
 
     }
-};
\ No newline at end of file
+};
+TEST_CLASS(CanvasControlTests_DrawingSessionReuse)
+{
+    //
+    // Uses real CanvasDrawingSessions, which can be reused, rather than
+    // MockCanvasDrawingSessions, which can't.
+    //
+    class CanvasControlTestAdapter_ReusableDrawingSessions : public CanvasControlTestAdapter
+    {
+    public:
+        std::shared_ptr<CanvasDrawingSessionManager> m_drawingSessionManager;
+        ComPtr<StubD2DDeviceContextWithGetFactory> m_deviceContext;
+        int m_createCount;
+        int m_reopenCount;
+
+        CanvasControlTestAdapter_ReusableDrawingSessions()
+            : m_drawingSessionManager(std::make_shared<CanvasDrawingSessionManager>())
+            , m_deviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+            , m_createCount(0)
+            , m_reopenCount(0)
+        {}
+
+        virtual ComPtr<ICanvasImageSource> CreateCanvasImageSource(ICanvasDevice* device, int width, int height) override
+        {
+            auto sisFactory = Make<MockSurfaceImageSourceFactory>();
+            sisFactory->MockCreateInstanceWithDimensionsAndOpacity =
+                [&](int32_t actualWidth, int32_t actualHeight, bool isOpaque, IInspectable* outer)
+            {
+                return Make<StubSurfaceImageSource>();
+            };
+
+            auto dsFactory = std::make_shared<MockCanvasImageSourceDrawingSessionFactory>();
+            dsFactory->MockCreate =
+                [=](ICanvasDevice* owner, ISurfaceImageSourceNativeWithD2D* sisNative, const Rect& updateRect, float dpi)
+            {
+                ++m_createCount;
+                return m_drawingSessionManager->Create(
+                    owner,
+                    m_deviceContext.Get(),
+                    std::make_shared<StubCanvasDrawingSessionAdapter>());
+            };
+            dsFactory->MockReopen =
+                [=](ICanvasDrawingSessionInternal* drawingSession, ISurfaceImageSourceNativeWithD2D* sisNative, const Rect& updateRect, float dpi)
+            {
+                ++m_reopenCount;
+                drawingSession->Reopen(
+                    m_deviceContext.Get(),
+                    std::make_shared<StubCanvasDrawingSessionAdapter>());
+            };
+
+            ComPtr<ICanvasResourceCreator> resourceCreator;
+            ThrowIfFailed(device->QueryInterface(resourceCreator.GetAddressOf()));
+
+            return Make<CanvasImageSource>(
+                resourceCreator.Get(),
+                width,
+                height,
+                CanvasBackground::Transparent,
+                sisFactory.Get(),
+                dsFactory);
+        }
+    };
+
+    TEST_METHOD(CanvasControl_ReusesTheDrawingSessionAndDrawEventArgs_FromFrameToFrame)
+    {
+        auto adapter = std::make_shared<CanvasControlTestAdapter_ReusableDrawingSessions>();
+
+        ComPtr<CanvasControl> canvasControl = Make<CanvasControl>(adapter);
+        canvasControl->OnLoaded(nullptr, nullptr);
+
+        std::vector<ComPtr<ICanvasDrawEventArgs>> drawEventArgs;
+        std::vector<ComPtr<ICanvasDrawingSession>> drawingSessions;
+
+        auto onDrawFn = Callback<DrawEventHandlerType>(
+            [&](ICanvasControl*, ICanvasDrawEventArgs* args)
+            {
+                ComPtr<ICanvasDrawingSession> drawingSession;
+                ThrowIfFailed(args->get_DrawingSession(&drawingSession));
+                ThrowIfFailed(drawingSession->Clear(Color{}));
+
+                drawEventArgs.push_back(args);
+                drawingSessions.push_back(drawingSession);
+                return S_OK;
+            });
+
+        EventRegistrationToken drawEventToken;
+        ThrowIfFailed(canvasControl->add_Draw(onDrawFn.Get(), &drawEventToken));
+
+        adapter->m_deviceContext->MockClear = [](const D2D1_COLOR_F*) {};
+
+        for (int i = 0; i < 3; ++i)
+        {
+            canvasControl->Invalidate();
+            adapter->FireCompositionRenderingEvent(static_cast<ICanvasControl*>(canvasControl.Get()));
+        }
+
+        Assert::AreEqual(1, adapter->m_createCount);
+        Assert::AreEqual(2, adapter->m_reopenCount);
+
+        Assert::AreEqual<size_t>(3, drawingSessions.size());
+        for (size_t i = 1; i < drawingSessions.size(); ++i)
+        {
+            Assert::AreEqual(drawingSessions[0].Get(), drawingSessions[i].Get());
+            Assert::AreEqual(drawEventArgs[0].Get(), drawEventArgs[i].Get());
+        }
+
+        // Statistics are per frame
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(canvasControl->get_LastFrameStatistics(&statistics));
+        Assert::AreEqual(1, statistics.ClearCount);
+
+        // Between frames the drawing session can't be used
+        Assert::AreEqual(RO_E_CLOSED, drawingSessions[0]->Clear(Color{}));
+    }
+};
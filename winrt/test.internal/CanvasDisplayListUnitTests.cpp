@@ -0,0 +1,454 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "StubD2DResources.h"
+
+//
+// Records the calls a display list makes to the drawing session it is
+// drawn into.
+//
+class DisplayListTargetSession : public MockCanvasDrawingSession
+{
+public:
+    std::vector<std::wstring> Calls;
+    std::vector<ICanvasImage*> Images;
+    std::vector<Color> Colors;
+
+    CanvasBlend Blend;
+    HRESULT FillRectangleResult;
+
+    DisplayListTargetSession()
+        : Blend(CanvasBlend::SourceOver)
+        , FillRectangleResult(S_OK)
+    {
+    }
+
+    IFACEMETHODIMP get_Blend(CanvasBlend* value) override
+    {
+        *value = Blend;
+        return S_OK;
+    }
+
+    IFACEMETHODIMP get_Antialiasing(CanvasAntialiasing* value) override
+    {
+        *value = CanvasAntialiasing::Antialiased;
+        return S_OK;
+    }
+
+    IFACEMETHODIMP get_TextAntialiasing(CanvasTextAntialiasing* value) override
+    {
+        *value = CanvasTextAntialiasing::Default;
+        return S_OK;
+    }
+
+    IFACEMETHODIMP get_Units(CanvasUnits* value) override
+    {
+        *value = CanvasUnits::Dips;
+        return S_OK;
+    }
+
+    IFACEMETHODIMP FillRectangleWithColor(Rect, Color color) override
+    {
+        Calls.push_back(L"FillRectangle");
+        Colors.push_back(color);
+        return FillRectangleResult;
+    }
+
+    IFACEMETHODIMP FillEllipseWithColor(Vector2, float, float, Color color) override
+    {
+        Calls.push_back(L"FillEllipse");
+        Colors.push_back(color);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP DrawTextAtPointWithColorAndFormat(HSTRING, Vector2, Color color, ICanvasTextFormat*) override
+    {
+        Calls.push_back(L"DrawText");
+        Colors.push_back(color);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP DrawImage(ICanvasImage* image, Vector2) override
+    {
+        Calls.push_back(L"DrawImage");
+        Images.push_back(image);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP DrawImageAtOrigin(ICanvasImage* image) override
+    {
+        Calls.push_back(L"DrawRecording");
+        Images.push_back(image);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP PushTransform(Numerics::Matrix3x2) override
+    {
+        Calls.push_back(L"PushTransform");
+        return S_OK;
+    }
+
+    IFACEMETHODIMP PopTransform() override
+    {
+        Calls.push_back(L"PopTransform");
+        return S_OK;
+    }
+};
+
+class StubCanvasImage : public RuntimeClass<ICanvasImage>
+{
+};
+
+class DisplayListFixture
+{
+public:
+    ComPtr<StubCanvasDevice> Device;
+    ComPtr<CanvasDisplayList> List;
+    ComPtr<DisplayListTargetSession> Target;
+
+    // Calls made to the device contexts that groups are recorded through.
+    std::vector<std::wstring> RecordedCalls;
+    int RecordingCount;
+
+    DisplayListFixture()
+        : Device(Make<StubCanvasDevice>())
+        , Target(Make<DisplayListTargetSession>())
+        , RecordingCount(0)
+    {
+        List = Make<CanvasDisplayList>(Device.Get(), std::make_shared<CanvasDrawingSessionManager>());
+
+        Device->MockCreateDeviceContext =
+            [=]
+            {
+                ++RecordingCount;
+
+                auto commandList = Make<MockD2DCommandList>();
+                commandList->MockClose = [] { return S_OK; };
+
+                auto deviceContext = Make<StubD2DDeviceContextWithGetFactory>();
+                deviceContext->MockCreateCommandList = [=](ID2D1CommandList** value) { return commandList.CopyTo(value); };
+                deviceContext->MockSetTarget = [](ID2D1Image*) {};
+                deviceContext->MockBeginDraw = [] {};
+                deviceContext->MockEndDraw = [] { return S_OK; };
+
+                deviceContext->MockCreateSolidColorBrush =
+                    [](const D2D1_COLOR_F*, const D2D1_BRUSH_PROPERTIES*, ID2D1SolidColorBrush** value)
+                    {
+                        auto brush = Make<MockD2DSolidColorBrush>();
+                        brush->MockSetColor = [](const D2D1_COLOR_F*) {};
+                        return brush.CopyTo(value);
+                    };
+
+                deviceContext->MockFillRectangle = [=](const D2D1_RECT_F*, ID2D1Brush*) { RecordedCalls.push_back(L"FillRectangle"); };
+                deviceContext->MockDrawImage = [=](ID2D1Image*) { RecordedCalls.push_back(L"DrawRecording"); };
+
+                return deviceContext;
+            };
+    }
+
+    uint32_t AddRectangle(uint32_t parent)
+    {
+        uint32_t node;
+        ThrowIfFailed(List->AddFilledRectangle(parent, Rect{ 0, 0, 1, 1 }, Color{ 255, 0, 0, 0 }, &node));
+        return node;
+    }
+
+    uint32_t AddGroupWithTwoRectangles(uint32_t parent)
+    {
+        uint32_t group;
+        ThrowIfFailed(List->AddGroup(parent, &group));
+        AddRectangle(group);
+        AddRectangle(group);
+        return group;
+    }
+
+    void Draw()
+    {
+        Target->Calls.clear();
+        Target->Images.clear();
+        RecordedCalls.clear();
+
+        ThrowIfFailed(List->Draw(Target.Get()));
+    }
+
+    static void ExpectCalls(std::vector<std::wstring> const& expected, std::vector<std::wstring> const& actual)
+    {
+        Assert::AreEqual(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+            Assert::AreEqual(expected[i], actual[i]);
+    }
+};
+
+TEST_CLASS(CanvasDisplayListUnitTests)
+{
+    TEST_METHOD(CanvasDisplayList_Implements_Expected_Interfaces)
+    {
+        DisplayListFixture f;
+
+        ASSERT_IMPLEMENTS_INTERFACE(f.List, ICanvasDisplayList);
+        ASSERT_IMPLEMENTS_INTERFACE(f.List, ABI::Windows::Foundation::IClosable);
+    }
+
+    TEST_METHOD(CanvasDisplayList_DrawsNodesWithTheirTransforms)
+    {
+        DisplayListFixture f;
+
+        uint32_t root;
+        ThrowIfFailed(f.List->get_RootNode(&root));
+
+        f.AddRectangle(root);
+
+        uint32_t group, ellipse, text;
+        ThrowIfFailed(f.List->AddGroup(root, &group));
+        ThrowIfFailed(f.List->AddFilledEllipse(group, Vector2{ 1, 2 }, 3, 4, Color{}, &ellipse));
+        ThrowIfFailed(f.List->AddText(root, WinString(L"text"), Vector2{}, Color{}, nullptr, &text));
+
+        Numerics::Matrix3x2 translation{ 1, 0, 0, 1, 10, 20 };
+        ThrowIfFailed(f.List->SetTransform(group, translation));
+
+        Numerics::Matrix3x2 transform;
+        ThrowIfFailed(f.List->GetTransform(group, &transform));
+        Assert::AreEqual(translation, transform);
+
+        f.Draw();
+        f.ExpectCalls({ L"FillRectangle", L"PushTransform", L"FillEllipse", L"PopTransform", L"DrawText" }, f.Target->Calls);
+        Assert::AreEqual(0, f.RecordingCount);
+    }
+
+    TEST_METHOD(CanvasDisplayList_UnchangedGroupsAreRecordedOnTheSecondDraw)
+    {
+        DisplayListFixture f;
+
+        f.AddRectangle(CanvasDisplayList::Root);
+        f.AddRectangle(CanvasDisplayList::Root);
+
+        f.Draw();
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle" }, f.Target->Calls);
+        Assert::AreEqual(0, f.RecordingCount);
+
+        f.Draw();
+        f.ExpectCalls({ L"DrawRecording" }, f.Target->Calls);
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle" }, f.RecordedCalls);
+        Assert::AreEqual(1, f.RecordingCount);
+
+        auto recording = f.Target->Images[0];
+
+        f.Draw();
+        f.ExpectCalls({ L"DrawRecording" }, f.Target->Calls);
+        f.ExpectCalls({}, f.RecordedCalls);
+        Assert::AreEqual(1, f.RecordingCount);
+        Assert::AreEqual<ICanvasImage*>(recording, f.Target->Images[0]);
+    }
+
+    TEST_METHOD(CanvasDisplayList_ChangesOnlyDiscardTheRecordingsThatIncludeThem)
+    {
+        DisplayListFixture f;
+
+        auto groupA = f.AddGroupWithTwoRectangles(CanvasDisplayList::Root);
+        auto groupB = f.AddGroupWithTwoRectangles(CanvasDisplayList::Root);
+
+        uint32_t rectangleInA;
+        ThrowIfFailed(f.List->AddFilledRectangle(groupA, Rect{}, Color{}, &rectangleInA));
+
+        f.Draw();
+        f.Draw();
+
+        // The root, A and B were all recorded
+        Assert::AreEqual(3, f.RecordingCount);
+        f.ExpectCalls({ L"DrawRecording" }, f.Target->Calls);
+
+        Color newColor{ 255, 1, 2, 3 };
+        ThrowIfFailed(f.List->SetColor(rectangleInA, newColor));
+
+        // A and the root are drawn directly, B from its recording
+        f.Draw();
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle", L"FillRectangle", L"DrawRecording" }, f.Target->Calls);
+        Assert::AreEqual(newColor, f.Target->Colors.back());
+        Assert::AreEqual(3, f.RecordingCount);
+
+        // ...and then recorded again, reusing B's recording
+        f.Draw();
+        f.ExpectCalls({ L"DrawRecording" }, f.Target->Calls);
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle", L"FillRectangle", L"DrawRecording", L"DrawRecording" }, f.RecordedCalls);
+        Assert::AreEqual(5, f.RecordingCount);
+
+        UNREFERENCED_PARAMETER(groupB);
+    }
+
+    TEST_METHOD(CanvasDisplayList_MovingAGroupReusesItsRecording)
+    {
+        DisplayListFixture f;
+
+        auto group = f.AddGroupWithTwoRectangles(CanvasDisplayList::Root);
+        f.AddRectangle(CanvasDisplayList::Root);
+
+        f.Draw();
+        f.Draw();
+        Assert::AreEqual(2, f.RecordingCount);
+
+        ThrowIfFailed(f.List->SetTransform(group, Numerics::Matrix3x2{ 1, 0, 0, 1, 5, 5 }));
+
+        f.Draw();
+        f.ExpectCalls({ L"PushTransform", L"DrawRecording", L"PopTransform", L"FillRectangle" }, f.Target->Calls);
+        Assert::AreEqual(2, f.RecordingCount);
+    }
+
+    TEST_METHOD(CanvasDisplayList_GroupsThatChangeEveryFrameAreNotRecorded)
+    {
+        DisplayListFixture f;
+
+        auto rectangle = f.AddRectangle(CanvasDisplayList::Root);
+        f.AddRectangle(CanvasDisplayList::Root);
+
+        for (int i = 0; i < 5; ++i)
+        {
+            ThrowIfFailed(f.List->SetColor(rectangle, Color{ 255, 0, 0, static_cast<uint8_t>(i) }));
+            f.Draw();
+            f.ExpectCalls({ L"FillRectangle", L"FillRectangle" }, f.Target->Calls);
+        }
+
+        Assert::AreEqual(0, f.RecordingCount);
+    }
+
+    TEST_METHOD(CanvasDisplayList_WhenTheTargetIsNotInItsDefaultState_GroupsAreDrawnDirectly)
+    {
+        DisplayListFixture f;
+
+        f.AddRectangle(CanvasDisplayList::Root);
+        f.AddRectangle(CanvasDisplayList::Root);
+
+        f.Target->Blend = CanvasBlend::Copy;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            f.Draw();
+            f.ExpectCalls({ L"FillRectangle", L"FillRectangle" }, f.Target->Calls);
+            Assert::AreEqual(0, f.RecordingCount);
+        }
+
+        // Back in the default state, the group is recorded straight away,
+        // since it hasn't changed
+        f.Target->Blend = CanvasBlend::SourceOver;
+
+        f.Draw();
+        f.ExpectCalls({ L"DrawRecording" }, f.Target->Calls);
+        Assert::AreEqual(1, f.RecordingCount);
+
+        // ...and the recording is kept, but not used, while the state is
+        // changed again
+        f.Target->Blend = CanvasBlend::Copy;
+
+        f.Draw();
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle" }, f.Target->Calls);
+
+        f.Target->Blend = CanvasBlend::SourceOver;
+
+        f.Draw();
+        f.ExpectCalls({ L"DrawRecording" }, f.Target->Calls);
+        Assert::AreEqual(1, f.RecordingCount);
+    }
+
+    TEST_METHOD(CanvasDisplayList_WhenDrawingAChildFails_TransformsAreStillPopped)
+    {
+        DisplayListFixture f;
+
+        uint32_t group;
+        ThrowIfFailed(f.List->AddGroup(CanvasDisplayList::Root, &group));
+        ThrowIfFailed(f.List->SetTransform(group, Numerics::Matrix3x2{ 1, 0, 0, 1, 10, 20 }));
+        f.AddRectangle(group);
+
+        f.Target->FillRectangleResult = E_FAIL;
+
+        Assert::AreEqual(E_FAIL, f.List->Draw(f.Target.Get()));
+        f.ExpectCalls({ L"PushTransform", L"FillRectangle", L"PopTransform" }, f.Target->Calls);
+    }
+
+    TEST_METHOD(CanvasDisplayList_HiddenNodesAreNotDrawn)
+    {
+        DisplayListFixture f;
+
+        auto group = f.AddGroupWithTwoRectangles(CanvasDisplayList::Root);
+        auto image = Make<StubCanvasImage>();
+
+        uint32_t imageNode;
+        ThrowIfFailed(f.List->AddImage(CanvasDisplayList::Root, image.Get(), Vector2{}, &imageNode));
+
+        ThrowIfFailed(f.List->SetIsVisible(group, false));
+
+        f.Draw();
+        f.ExpectCalls({ L"DrawImage" }, f.Target->Calls);
+        Assert::AreEqual<ICanvasImage*>(image.Get(), f.Target->Images[0]);
+
+        ThrowIfFailed(f.List->SetIsVisible(group, true));
+
+        f.Draw();
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle", L"DrawImage" }, f.Target->Calls);
+    }
+
+    TEST_METHOD(CanvasDisplayList_RemoveNode)
+    {
+        DisplayListFixture f;
+
+        auto group = f.AddGroupWithTwoRectangles(CanvasDisplayList::Root);
+        f.AddRectangle(CanvasDisplayList::Root);
+
+        ThrowIfFailed(f.List->RemoveNode(group));
+
+        f.Draw();
+        f.ExpectCalls({ L"FillRectangle" }, f.Target->Calls);
+
+        Assert::AreEqual(E_INVALIDARG, f.List->RemoveNode(group));
+        Assert::AreEqual(E_INVALIDARG, f.List->SetIsVisible(group, false));
+        Assert::AreEqual(E_INVALIDARG, f.List->RemoveNode(CanvasDisplayList::Root));
+
+        // Removed ids are reused
+        uint32_t newGroup;
+        ThrowIfFailed(f.List->AddGroup(CanvasDisplayList::Root, &newGroup));
+        Assert::IsTrue(newGroup <= 3);
+    }
+
+    TEST_METHOD(CanvasDisplayList_InvalidArguments)
+    {
+        DisplayListFixture f;
+
+        auto group = f.AddGroupWithTwoRectangles(CanvasDisplayList::Root);
+        auto rectangle = f.AddRectangle(CanvasDisplayList::Root);
+        uint32_t node;
+
+        Assert::AreEqual(E_INVALIDARG, f.List->AddGroup(rectangle, &node));
+        Assert::AreEqual(E_INVALIDARG, f.List->AddGroup(12345, &node));
+        Assert::AreEqual(E_INVALIDARG, f.List->AddGroup(group, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.List->AddImage(group, nullptr, Vector2{}, &node));
+        Assert::AreEqual(E_INVALIDARG, f.List->SetColor(group, Color{}));
+        Assert::AreEqual(E_INVALIDARG, f.List->SetText(rectangle, WinString(L"text")));
+        Assert::AreEqual(E_INVALIDARG, f.List->GetTransform(rectangle, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.List->Draw(nullptr));
+    }
+
+    TEST_METHOD(CanvasDisplayList_Closed)
+    {
+        DisplayListFixture f;
+
+        auto rectangle = f.AddRectangle(CanvasDisplayList::Root);
+
+        ThrowIfFailed(f.List->Close());
+
+        uint32_t node;
+        Assert::AreEqual(RO_E_CLOSED, f.List->get_RootNode(&node));
+        Assert::AreEqual(RO_E_CLOSED, f.List->AddGroup(CanvasDisplayList::Root, &node));
+        Assert::AreEqual(RO_E_CLOSED, f.List->SetColor(rectangle, Color{}));
+        Assert::AreEqual(RO_E_CLOSED, f.List->Invalidate(rectangle));
+        Assert::AreEqual(RO_E_CLOSED, f.List->Draw(f.Target.Get()));
+    }
+};
@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "StubD2DResources.h"
+
+//
+// Microbenchmarks for the per-call overhead of CanvasDrawingSession.  The
+// device context is a MockD2DDeviceContext whose draw methods do nothing, so
+// what is measured is the cost of getting from the ABI method to the device
+// context.
+//
+// Results depend on the machine and build, so they are written to the test
+// log rather than asserted on.
+//
+TEST_CLASS(CanvasDrawingSessionBenchmarks)
+{
+    static const int CallCount = 200000;
+
+    class Fixture
+    {
+    public:
+        ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+        ComPtr<CanvasDrawingSession> DS;
+
+        Fixture()
+            : DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+        {
+            DS = std::make_shared<CanvasDrawingSessionManager>()->Create(
+                DeviceContext.Get(),
+                std::make_shared<StubCanvasDrawingSessionAdapter>());
+
+            DeviceContext->MockCreateSolidColorBrush =
+                [](const D2D1_COLOR_F*, const D2D1_BRUSH_PROPERTIES*, ID2D1SolidColorBrush** value)
+                {
+                    auto brush = Make<MockD2DSolidColorBrush>();
+                    brush->MockSetColor = [](const D2D1_COLOR_F*) {};
+                    return brush.CopyTo(value);
+                };
+
+            DeviceContext->MockDrawLine = [](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float, ID2D1StrokeStyle*) {};
+            DeviceContext->MockFillEllipse = [](const D2D1_ELLIPSE*, ID2D1Brush*) {};
+        }
+    };
+
+    template<typename FN>
+    static double MeasureCallsPerSecond(FN&& fn)
+    {
+        // Warm up, which also creates the session's solid color brush.
+        for (int i = 0; i < 100; ++i)
+            ThrowIfFailed(fn(i));
+
+        LARGE_INTEGER frequency, start, end;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&start);
+
+        for (int i = 0; i < CallCount; ++i)
+            ThrowIfFailed(fn(i));
+
+        QueryPerformanceCounter(&end);
+
+        return CallCount * static_cast<double>(frequency.QuadPart) / (end.QuadPart - start.QuadPart);
+    }
+
+    static void Report(const wchar_t* name, double directCallsPerSecond, double generalCallsPerSecond)
+    {
+        wchar_t message[256];
+        StringCchPrintf(message, _countof(message),
+            L"%s: %.0f calls/s on the direct path, %.0f calls/s on the general path (%.2fx)\n",
+            name,
+            directCallsPerSecond,
+            generalCallsPerSecond,
+            directCallsPerSecond / generalCallsPerSecond);
+
+        Logger::WriteMessage(message);
+    }
+
+    //
+    // Enabling pixel aligned aliasing takes the general path for every call,
+    // but does no extra work for lines or ellipses, so it gives a like-for-like
+    // comparison with the direct path.
+    //
+
+    TEST_METHOD(CanvasDrawingSession_Benchmark_DrawLineWithColor)
+    {
+        Fixture f;
+
+        auto drawLine = [&](int i) { return f.DS->DrawLineWithColor(Vector2{ 0, 0 }, Vector2{ 10, 10 }, Color{ 255, 0, 0, static_cast<uint8_t>(i) }); };
+
+        auto direct = MeasureCallsPerSecond(drawLine);
+
+        ThrowIfFailed(f.DS->put_IsPixelAlignedAliasingEnabled(true));
+        auto general = MeasureCallsPerSecond(drawLine);
+
+        Report(L"DrawLineWithColor", direct, general);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Benchmark_FillEllipseWithColor)
+    {
+        Fixture f;
+
+        auto fillEllipse = [&](int i) { return f.DS->FillEllipseWithColor(Vector2{ 10, 10 }, 5, 5, Color{ 255, 0, 0, static_cast<uint8_t>(i) }); };
+
+        auto direct = MeasureCallsPerSecond(fillEllipse);
+
+        ThrowIfFailed(f.DS->put_IsPixelAlignedAliasingEnabled(true));
+        auto general = MeasureCallsPerSecond(fillEllipse);
+
+        Report(L"FillEllipseWithColor", direct, general);
+    }
+};
@@ -0,0 +1,340 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include "StubD2DResources.h"
+
+//
+// Records the calls replayed into it, in place of a real drawing session.
+//
+class RecordingCanvasDrawingSession : public MockCanvasDrawingSession
+{
+public:
+    std::vector<std::wstring> Calls;
+    std::vector<Color> Colors;
+    std::vector<ICanvasBrush*> Brushes;
+    std::vector<Rect> Rects;
+    std::vector<std::wstring> Labels;
+
+    IFACEMETHODIMP Clear(Color color) override
+    {
+        Calls.push_back(L"Clear");
+        Colors.push_back(color);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP FillRectangleWithColor(Rect rect, Color color) override
+    {
+        Calls.push_back(L"FillRectangleWithColor");
+        Rects.push_back(rect);
+        Colors.push_back(color);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP FillRectangleWithBrush(Rect rect, ICanvasBrush* brush) override
+    {
+        Calls.push_back(L"FillRectangleWithBrush");
+        Rects.push_back(rect);
+        Brushes.push_back(brush);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP DrawLineWithColorAndStrokeWidthAndStrokeStyle(Vector2, Vector2, Color color, float strokeWidth, ICanvasStrokeStyle* strokeStyle) override
+    {
+        Calls.push_back(L"DrawLineWithColorAndStrokeWidthAndStrokeStyle");
+        Colors.push_back(color);
+        Assert::AreEqual(3.0f, strokeWidth);
+        Assert::IsNull(strokeStyle);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP DrawTextBatch(uint32_t textCount, HSTRING* text, uint32_t pointCount, Vector2*, uint32_t colorCount, Color* colors, ICanvasTextFormat* format) override
+    {
+        Calls.push_back(L"DrawTextBatch");
+        Assert::AreEqual(textCount, pointCount);
+        Assert::IsNull(format);
+
+        for (uint32_t i = 0; i < textCount; ++i)
+        {
+            uint32_t length;
+            auto buffer = WindowsGetStringRawBuffer(text[i], &length);
+            Labels.push_back(std::wstring(buffer, length));
+        }
+
+        Colors.insert(Colors.end(), colors, colors + colorCount);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP put_Antialiasing(CanvasAntialiasing value) override
+    {
+        Calls.push_back(L"put_Antialiasing");
+        Assert::AreEqual(CanvasAntialiasing::Aliased, value);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP PopLayer() override
+    {
+        Calls.push_back(L"PopLayer");
+        return E_FAIL;
+    }
+};
+
+class TraceFixture
+{
+public:
+    ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+    ComPtr<CanvasDrawingSession> DS;
+    ComPtr<StubCanvasBrush> Brush;
+
+    TraceFixture()
+        : DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+        , Brush(Make<StubCanvasBrush>())
+    {
+        auto manager = std::make_shared<CanvasDrawingSessionManager>();
+        DS = manager->Create(
+            DeviceContext.Get(),
+            std::make_shared<StubCanvasDrawingSessionAdapter>());
+
+        DeviceContext->MockClear = [](const D2D1_COLOR_F*) {};
+        DeviceContext->MockFillRectangle = [](const D2D1_RECT_F*, ID2D1Brush*) {};
+        DeviceContext->MockDrawLine = [](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float, ID2D1StrokeStyle*) {};
+        DeviceContext->MockSetAntialiasMode = [](D2D1_ANTIALIAS_MODE) {};
+    }
+
+    std::vector<uint8_t> GetTrace()
+    {
+        uint32_t traceSize;
+        uint8_t* traceData;
+        ThrowIfFailed(DS->GetTrace(&traceSize, &traceData));
+
+        std::vector<uint8_t> trace(traceData, traceData + traceSize);
+        CoTaskMemFree(traceData);
+
+        return trace;
+    }
+};
+
+TEST_CLASS(CanvasDrawingSessionTraceTests)
+{
+    TEST_METHOD(CanvasDrawingSession_Tracing_IsDisabledByDefault)
+    {
+        TraceFixture f;
+
+        boolean isTracingEnabled = true;
+        ThrowIfFailed(f.DS->get_IsTracingEnabled(&isTracingEnabled));
+        Assert::IsFalse(!!isTracingEnabled);
+
+        ThrowIfFailed(f.DS->Clear(Color{}));
+
+        Assert::AreEqual<size_t>(0, f.GetTrace().size());
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->get_IsTracingEnabled(nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_ReplaysTheRecordedCalls)
+    {
+        TraceFixture f;
+
+        Color color1{ 255, 1, 2, 3 };
+        Color color2{ 255, 4, 5, 6 };
+        Rect rect{ 1, 2, 3, 4 };
+
+        ThrowIfFailed(f.DS->put_IsTracingEnabled(true));
+        ThrowIfFailed(f.DS->Clear(color1));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(rect, color2));
+        ThrowIfFailed(f.DS->DrawLineAtCoordsWithColorAndStrokeWidth(0, 0, 10, 10, color1, 3.0f));
+        ThrowIfFailed(f.DS->put_Antialiasing(CanvasAntialiasing::Aliased));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(rect, f.Brush.Get()));
+
+        // Calls after tracing is disabled aren't recorded
+        ThrowIfFailed(f.DS->put_IsTracingEnabled(false));
+        ThrowIfFailed(f.DS->Clear(color2));
+
+        auto replayBrush = Make<StubCanvasBrush>();
+
+        CanvasDrawingSessionTraceReplayer replayer(
+            f.GetTrace(),
+            [&](CanvasTraceResourceKind kind, uint32_t id) -> ComPtr<IUnknown>
+            {
+                Assert::IsTrue(kind == CanvasTraceResourceKind::Brush);
+                Assert::AreEqual(1u, id);
+                ComPtr<IUnknown> resource;
+                ThrowIfFailed(replayBrush.As(&resource));
+                return resource;
+            });
+
+        auto target = Make<RecordingCanvasDrawingSession>();
+        replayer.Replay(target.Get());
+
+        std::vector<std::wstring> expectedCalls
+        {
+            L"Clear",
+            L"FillRectangleWithColor",
+            L"DrawLineWithColorAndStrokeWidthAndStrokeStyle",
+            L"put_Antialiasing",
+            L"FillRectangleWithBrush"
+        };
+
+        Assert::AreEqual(expectedCalls.size(), target->Calls.size());
+        for (size_t i = 0; i < expectedCalls.size(); ++i)
+            Assert::AreEqual(expectedCalls[i], target->Calls[i]);
+
+        Assert::AreEqual(3u, static_cast<uint32_t>(target->Colors.size()));
+        Assert::AreEqual(color1, target->Colors[0]);
+        Assert::AreEqual(color2, target->Colors[1]);
+        Assert::AreEqual(color1, target->Colors[2]);
+
+        Assert::AreEqual(rect, target->Rects[0]);
+        Assert::AreEqual(rect, target->Rects[1]);
+
+        Assert::AreEqual(1u, static_cast<uint32_t>(target->Brushes.size()));
+        Assert::AreEqual<ICanvasBrush*>(replayBrush.Get(), target->Brushes[0]);
+
+        Assert::AreEqual(2u, replayer.GetCost(CanvasTraceOp::FillRectangle).CallCount);
+        Assert::AreEqual(1u, replayer.GetCost(CanvasTraceOp::Clear).CallCount);
+        Assert::AreEqual(1u, replayer.GetCost(CanvasTraceOp::DrawLine).CallCount);
+        Assert::AreEqual(1u, replayer.GetCost(CanvasTraceOp::SetAntialiasing).CallCount);
+        Assert::AreEqual(0u, replayer.GetCost(CanvasTraceOp::DrawText).CallCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_TextBatchesFromBuffersAreReplayedAsSeparateStrings)
+    {
+        TraceFixture f;
+        f.DeviceContext->MockDrawTextLayout = [](D2D1_POINT_2F, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS) {};
+
+        int32_t offsets[] = { 0, 2, 2, 5 };
+        Vector2 points[] = { Vector2{}, Vector2{}, Vector2{} };
+        Color color{ 255, 1, 2, 3 };
+
+        ThrowIfFailed(f.DS->put_IsTracingEnabled(true));
+        ThrowIfFailed(f.DS->DrawTextBatchFromBuffer(WinString(L"abcde"), 4, offsets, 3, points, 1, &color, nullptr));
+
+        CanvasDrawingSessionTraceReplayer replayer(f.GetTrace());
+
+        auto target = Make<RecordingCanvasDrawingSession>();
+        replayer.Replay(target.Get());
+
+        Assert::AreEqual(1u, static_cast<uint32_t>(target->Calls.size()));
+        Assert::AreEqual<std::wstring>(L"DrawTextBatch", target->Calls[0]);
+
+        Assert::AreEqual(3u, static_cast<uint32_t>(target->Labels.size()));
+        Assert::AreEqual<std::wstring>(L"ab", target->Labels[0]);
+        Assert::AreEqual<std::wstring>(L"", target->Labels[1]);
+        Assert::AreEqual<std::wstring>(L"cde", target->Labels[2]);
+
+        Assert::AreEqual(1u, static_cast<uint32_t>(target->Colors.size()));
+        Assert::AreEqual(color, target->Colors[0]);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_UnresolvedBrushesAreReplayedAsBlack)
+    {
+        TraceFixture f;
+
+        ThrowIfFailed(f.DS->put_IsTracingEnabled(true));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{}, f.Brush.Get()));
+
+        CanvasDrawingSessionTraceReplayer replayer(f.GetTrace());
+
+        auto target = Make<RecordingCanvasDrawingSession>();
+        replayer.Replay(target.Get());
+
+        Assert::AreEqual(1u, static_cast<uint32_t>(target->Calls.size()));
+        Assert::AreEqual<std::wstring>(L"FillRectangleWithColor", target->Calls[0]);
+        Assert::AreEqual(Color{ 255, 0, 0, 0 }, target->Colors[0]);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_UnresolvedImagesAreSkipped)
+    {
+        CanvasDrawingSessionTraceWriter writer;
+
+        auto image = Make<StubCanvasBrush>();
+
+        writer.BeginRecord(CanvasTraceOp::DrawImage);
+        writer.WriteResource(static_cast<ICanvasBrush*>(image.Get()));
+        writer.Write(Vector2{ 1, 2 });
+
+        CanvasDrawingSessionTraceReplayer replayer(writer.GetData());
+
+        auto target = Make<RecordingCanvasDrawingSession>();
+        replayer.Replay(target.Get());
+
+        Assert::AreEqual(0u, static_cast<uint32_t>(target->Calls.size()));
+        Assert::AreEqual(0u, replayer.GetCost(CanvasTraceOp::DrawImage).CallCount);
+        Assert::AreEqual(1u, replayer.GetCost(CanvasTraceOp::DrawImage).SkippedCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_FailedCallsAreCounted)
+    {
+        CanvasDrawingSessionTraceWriter writer;
+        writer.BeginRecord(CanvasTraceOp::PopLayer);
+        writer.BeginRecord(CanvasTraceOp::PopLayer);
+
+        CanvasDrawingSessionTraceReplayer replayer(writer.GetData());
+
+        auto target = Make<RecordingCanvasDrawingSession>();
+        replayer.Replay(target.Get());
+
+        Assert::AreEqual(2u, replayer.GetCost(CanvasTraceOp::PopLayer).CallCount);
+        Assert::AreEqual(2u, replayer.GetCost(CanvasTraceOp::PopLayer).FailedCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_InvalidTracesAreRejected)
+    {
+        CanvasDrawingSessionTraceWriter writer;
+        writer.BeginRecord(CanvasTraceOp::Clear);
+        writer.Write(Color{});
+
+        auto trace = writer.GetData();
+        auto target = Make<RecordingCanvasDrawingSession>();
+
+        // Truncated
+        auto truncated = trace;
+        truncated.pop_back();
+
+        Assert::ExpectException<HResultException>(
+            [&] { CanvasDrawingSessionTraceReplayer(truncated).Replay(target.Get()); });
+
+        // Wrong magic number
+        auto badHeader = trace;
+        badHeader[0] ^= 0xFF;
+
+        Assert::ExpectException<HResultException>(
+            [&] { CanvasDrawingSessionTraceReplayer(badHeader).Replay(target.Get()); });
+
+        // Unknown op
+        auto badOp = trace;
+        badOp[sizeof(CanvasTraceHeader)] = static_cast<uint8_t>(CanvasTraceOp::Count);
+
+        Assert::ExpectException<HResultException>(
+            [&] { CanvasDrawingSessionTraceReplayer(badOp).Replay(target.Get()); });
+
+        Assert::AreEqual(0u, static_cast<uint32_t>(target->Calls.size()));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Tracing_IsResetWhenTheSessionIsReopened)
+    {
+        TraceFixture f;
+
+        ThrowIfFailed(f.DS->put_IsTracingEnabled(true));
+        ThrowIfFailed(f.DS->Clear(Color{}));
+        Assert::AreNotEqual<size_t>(0, f.GetTrace().size());
+
+        f.DS->CloseForReuse();
+        f.DS->Reopen(f.DeviceContext.Get(), std::make_shared<StubCanvasDrawingSessionAdapter>());
+
+        boolean isTracingEnabled = true;
+        ThrowIfFailed(f.DS->get_IsTracingEnabled(&isTracingEnabled));
+        Assert::IsFalse(!!isTracingEnabled);
+        Assert::AreEqual<size_t>(0, f.GetTrace().size());
+    }
+};
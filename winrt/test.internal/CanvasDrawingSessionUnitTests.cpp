@@ -1708,6 +1708,1954 @@ public:
         Assert::AreEqual(expectedTransform, wrappedResourceTransform);
     }
 
+    //
+    // Transform stack
+    //
+
+    class TransformStackFixture
+    {
+    public:
+        ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+        std::shared_ptr<CanvasDrawingSessionAdapter_ChangeableOffset> Adapter;
+        ComPtr<CanvasDrawingSession> DS;
+        ComPtr<StubCanvasBrush> Brush;
+
+        D2D1_MATRIX_3X2_F NativeTransform;
+        int SetTransformCount;
+
+        TransformStackFixture(D2D1_POINT_2F offset = D2D1::Point2F(0, 0))
+            : DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+            , Adapter(std::make_shared<CanvasDrawingSessionAdapter_ChangeableOffset>())
+            , Brush(Make<StubCanvasBrush>())
+            , NativeTransform(D2D1::Matrix3x2F::Translation(offset.x, offset.y))
+            , SetTransformCount(0)
+        {
+            Adapter->m_offset = offset;
+
+            auto manager = std::make_shared<CanvasDrawingSessionManager>();
+            DS = manager->Create(DeviceContext.Get(), Adapter);
+
+            DeviceContext->MockGetTransform =
+                [this](D2D1_MATRIX_3X2_F* m)
+                {
+                    *m = NativeTransform;
+                };
+
+            DeviceContext->MockSetTransform =
+                [this](const D2D1_MATRIX_3X2_F* m)
+                {
+                    NativeTransform = *m;
+                    ++SetTransformCount;
+                };
+
+            DeviceContext->MockFillRectangle =
+                [](const D2D1_RECT_F*, ID2D1Brush*) {};
+        }
+
+        void Draw()
+        {
+            ThrowIfFailed(DS->FillRectangleWithBrush(Rect{ 0, 0, 1, 1 }, Brush.Get()));
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_TransformStack_IsOnlyAppliedWhenDrawing)
+    {
+        TransformStackFixture f;
+
+        ThrowIfFailed(f.DS->PushTransform(Numerics::Matrix3x2{ 1, 0, 0, 1, 5, 6 }));
+        ThrowIfFailed(f.DS->Translate(1, 2));
+        ThrowIfFailed(f.DS->Scale(2, 3));
+        Assert::AreEqual(0, f.SetTransformCount);
+
+        f.Draw();
+        Assert::AreEqual(1, f.SetTransformCount);
+
+        D2D1_MATRIX_3X2_F expected = D2D1::Matrix3x2F(2, 0, 0, 3, 6, 8);
+        Assert::AreEqual(expected, f.NativeTransform);
+
+        // Drawing again with the same transform doesn't set it again
+        f.Draw();
+        Assert::AreEqual(1, f.SetTransformCount);
+
+        ThrowIfFailed(f.DS->PopTransform());
+        Assert::AreEqual(1, f.SetTransformCount);
+
+        f.Draw();
+        Assert::AreEqual(2, f.SetTransformCount);
+
+        D2D1_MATRIX_3X2_F identity = D2D1::IdentityMatrix();
+        Assert::AreEqual(identity, f.NativeTransform);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_TransformStack_PushPopWithoutDrawing_DoesNotSetTransform)
+    {
+        TransformStackFixture f;
+
+        ThrowIfFailed(f.DS->PushTransform(Numerics::Matrix3x2{ 1, 0, 0, 1, 5, 6 }));
+        ThrowIfFailed(f.DS->Rotate(1));
+        ThrowIfFailed(f.DS->PopTransform());
+
+        f.Draw();
+        Assert::AreEqual(0, f.SetTransformCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_TransformStack_Rotate)
+    {
+        TransformStackFixture f;
+
+        ThrowIfFailed(f.DS->Translate(10, 0));
+        ThrowIfFailed(f.DS->Rotate(1.5707963f));
+
+        Numerics::Matrix3x2 transform;
+        ThrowIfFailed(f.DS->get_Transform(&transform));
+
+        // Rotating the point (1, 0) by 90 degrees and then translating it
+        Assert::AreEqual(0.0f, transform.M11, 0.0001f);
+        Assert::AreEqual(1.0f, transform.M12, 0.0001f);
+        Assert::AreEqual(-1.0f, transform.M21, 0.0001f);
+        Assert::AreEqual(0.0f, transform.M22, 0.0001f);
+        Assert::AreEqual(10.0f, transform.M31, 0.0001f);
+        Assert::AreEqual(0.0f, transform.M32, 0.0001f);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_TransformStack_ComposesWithTransformProperty)
+    {
+        TransformStackFixture f(D2D1::Point2F(100, 200));
+
+        ThrowIfFailed(f.DS->put_Transform(Numerics::Matrix3x2{ 2, 0, 0, 2, 1, 1 }));
+        ThrowIfFailed(f.DS->Translate(3, 4));
+
+        Numerics::Matrix3x2 transform;
+        ThrowIfFailed(f.DS->get_Transform(&transform));
+        Assert::AreEqual(Numerics::Matrix3x2{ 2, 0, 0, 2, 7, 9 }, transform);
+
+        // The rendering surface offset is applied to the native transform only
+        D2D1_MATRIX_3X2_F expected = D2D1::Matrix3x2F(2, 0, 0, 2, 107, 209);
+        Assert::AreEqual(expected, f.NativeTransform);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_TransformStack_UnbalancedPopFails)
+    {
+        TransformStackFixture f;
+
+        Assert::AreEqual(E_FAIL, f.DS->PopTransform());
+
+        ThrowIfFailed(f.DS->PushTransform(Numerics::Matrix3x2{ 1, 0, 0, 1, 0, 0 }));
+        ThrowIfFailed(f.DS->PopTransform());
+        Assert::AreEqual(E_FAIL, f.DS->PopTransform());
+    }
+
+    //
+    // Clips and layers
+    //
+
+    class ClipFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        std::vector<std::wstring> Calls;
+        std::vector<D2D1_RECT_F> PushedClips;
+        std::vector<D2D1_LAYER_PARAMETERS1> PushedLayers;
+
+        ClipFixture()
+        {
+            DeviceContext->MockGetTransform =
+                [](D2D1_MATRIX_3X2_F* m)
+                {
+                    *m = D2D1::IdentityMatrix();
+                };
+
+            DeviceContext->MockSetTransform =
+                [this](const D2D1_MATRIX_3X2_F*)
+                {
+                    Calls.push_back(L"SetTransform");
+                };
+
+            DeviceContext->MockGetAntialiasMode =
+                []
+                {
+                    return D2D1_ANTIALIAS_MODE_ALIASED;
+                };
+
+            DeviceContext->MockPushAxisAlignedClip =
+                [this](const D2D1_RECT_F* rect, D2D1_ANTIALIAS_MODE antialiasMode)
+                {
+                    Assert::AreEqual(D2D1_ANTIALIAS_MODE_ALIASED, antialiasMode);
+                    Calls.push_back(L"PushAxisAlignedClip");
+                    PushedClips.push_back(*rect);
+                };
+
+            DeviceContext->MockPopAxisAlignedClip =
+                [this]
+                {
+                    Calls.push_back(L"PopAxisAlignedClip");
+                };
+
+            DeviceContext->MockPushLayer =
+                [this](const D2D1_LAYER_PARAMETERS1* parameters, ID2D1Layer* layer)
+                {
+                    Assert::IsNull(layer);
+                    Calls.push_back(L"PushLayer");
+                    PushedLayers.push_back(*parameters);
+                };
+
+            DeviceContext->MockPopLayer =
+                [this]
+                {
+                    Calls.push_back(L"PopLayer");
+                };
+        }
+
+        void ExpectCalls(std::vector<std::wstring> const& expected)
+        {
+            Assert::AreEqual(expected.size(), Calls.size());
+
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                Assert::AreEqual(expected[i], Calls[i]);
+            }
+
+            Calls.clear();
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_PushClipRectangle_UsesAxisAlignedClip)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 1, 2, 3, 4 }));
+        f.ExpectCalls({ L"PushAxisAlignedClip" });
+        Assert::AreEqual(D2D1::RectF(1, 2, 4, 6), f.PushedClips[0]);
+
+        ThrowIfFailed(f.DS->PopClip());
+        f.ExpectCalls({ L"PopAxisAlignedClip" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushClipRectangle_AppliesPendingTransformFirst)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->Translate(10, 10));
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 0, 0, 1, 1 }));
+        f.ExpectCalls({ L"SetTransform", L"PushAxisAlignedClip" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushClipRectangle_RedundantNestedClipsAreElided)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 0, 0, 100, 100 }));
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ -10, -10, 200, 200 }));  // contains the first clip
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 10, 10, 10, 10 }));      // doesn't
+        f.ExpectCalls({ L"PushAxisAlignedClip", L"PushAxisAlignedClip" });
+
+        ThrowIfFailed(f.DS->PopClip());
+        ThrowIfFailed(f.DS->PopClip());
+        ThrowIfFailed(f.DS->PopClip());
+        f.ExpectCalls({ L"PopAxisAlignedClip", L"PopAxisAlignedClip" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushLayer_WithOpacity)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->PushLayerWithOpacity(0.5f));
+        f.ExpectCalls({ L"PushLayer" });
+        Assert::AreEqual(0.5f, f.PushedLayers[0].opacity);
+        Assert::IsNull(f.PushedLayers[0].opacityBrush);
+        Assert::IsNull(f.PushedLayers[0].geometricMask);
+
+        ThrowIfFailed(f.DS->PopLayer());
+        f.ExpectCalls({ L"PopLayer" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushLayer_WithOpacityBrushAndClipRectangle)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->PushLayerWithOpacityBrushAndClipRectangle(f.Brush.Get(), Rect{ 0, 0, 5, 5 }));
+        f.ExpectCalls({ L"PushAxisAlignedClip", L"PushLayer" });
+        Assert::AreEqual(f.Brush->GetD2DBrush().Get(), f.PushedLayers[0].opacityBrush);
+
+        ThrowIfFailed(f.DS->PopLayer());
+        f.ExpectCalls({ L"PopLayer", L"PopAxisAlignedClip" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushLayer_WithFullOpacity_OnlyClips)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->PushLayerWithOpacity(1.0f));
+        ThrowIfFailed(f.DS->PushLayerWithOpacityAndClipRectangle(1.0f, Rect{ 0, 0, 5, 5 }));
+        f.ExpectCalls({ L"PushAxisAlignedClip" });
+
+        ThrowIfFailed(f.DS->PopLayer());
+        ThrowIfFailed(f.DS->PopLayer());
+        f.ExpectCalls({ L"PopAxisAlignedClip" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushLayer_NullOpacityBrush)
+    {
+        ClipFixture f;
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->PushLayerWithOpacityBrush(nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->PushLayerWithOpacityBrushAndClipRectangle(nullptr, Rect{}));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PopClipAndPopLayer_MustMatchPushes)
+    {
+        ClipFixture f;
+
+        Assert::AreEqual(E_FAIL, f.DS->PopClip());
+        Assert::AreEqual(E_FAIL, f.DS->PopLayer());
+
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 0, 0, 1, 1 }));
+        Assert::AreEqual(E_FAIL, f.DS->PopLayer());
+
+        ThrowIfFailed(f.DS->PushLayerWithOpacity(0.5f));
+        Assert::AreEqual(E_FAIL, f.DS->PopClip());
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Close_PopsOutstandingClipsAndLayers)
+    {
+        ClipFixture f;
+
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 0, 0, 1, 1 }));
+        ThrowIfFailed(f.DS->PushLayerWithOpacity(0.5f));
+        f.Calls.clear();
+
+        ThrowIfFailed(f.DS->Close());
+        f.ExpectCalls({ L"PopLayer", L"PopAxisAlignedClip" });
+    }
+
+    //
+    // Culling
+    //
+
+    class CullingFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        ComPtr<MockD2DBitmap> Target;
+        int DrawCount;
+
+        CullingFixture()
+            : Target(Make<MockD2DBitmap>())
+            , DrawCount(0)
+        {
+            DeviceContext->MockGetTransform =
+                [](D2D1_MATRIX_3X2_F* m)
+                {
+                    *m = D2D1::IdentityMatrix();
+                };
+
+            DeviceContext->MockSetTransform =
+                [](const D2D1_MATRIX_3X2_F*) {};
+
+            DeviceContext->MockGetTarget =
+                [this](ID2D1Image** target)
+                {
+                    ThrowIfFailed(Target.CopyTo(target));
+                };
+
+            DeviceContext->MockGetImageLocalBounds =
+                [this](ID2D1Image* image, D2D1_RECT_F* bounds)
+                {
+                    Assert::AreEqual<ID2D1Image*>(Target.Get(), image);
+                    *bounds = D2D1::RectF(0, 0, 100, 100);
+                    return S_OK;
+                };
+
+            DeviceContext->MockFillRectangle =
+                [this](const D2D1_RECT_F*, ID2D1Brush*) { ++DrawCount; };
+
+            DeviceContext->MockDrawLine =
+                [this](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float, ID2D1StrokeStyle*) { ++DrawCount; };
+
+            DeviceContext->MockFillEllipse =
+                [this](const D2D1_ELLIPSE*, ID2D1Brush*) { ++DrawCount; };
+
+            DeviceContext->MockDrawTextLayout =
+                [this](D2D1_POINT_2F, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS) { ++DrawCount; };
+
+            ThrowIfFailed(DS->put_IsCullingEnabled(true));
+        }
+
+        bool FillRectangleIsDrawn(Rect rect)
+        {
+            DrawCount = 0;
+            ThrowIfFailed(DS->FillRectangleWithBrush(rect, Brush.Get()));
+            return DrawCount == 1;
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_Culling_IsDisabledByDefault)
+    {
+        CanvasDrawingSessionFixture f;
+
+        boolean isCullingEnabled;
+        ThrowIfFailed(f.DS->get_IsCullingEnabled(&isCullingEnabled));
+        Assert::IsFalse(!!isCullingEnabled);
+
+        // With culling disabled, nothing asks for the target bounds
+        bool called = false;
+        f.DeviceContext->MockFillRectangle =
+            [&](const D2D1_RECT_F*, ID2D1Brush*) { called = true; };
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 1000, 1000, 1, 1 }, f.Brush.Get()));
+        Assert::IsTrue(called);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_SkipsDrawsOutsideTheTarget)
+    {
+        CullingFixture f;
+
+        Assert::IsTrue(f.FillRectangleIsDrawn(Rect{ 10, 10, 10, 10 }));
+        Assert::IsTrue(f.FillRectangleIsDrawn(Rect{ -10, -10, 20, 20 }));  // partially visible
+        Assert::IsTrue(f.FillRectangleIsDrawn(Rect{ 100.5f, 0, 10, 10 })); // within the antialiasing margin
+
+        Assert::IsFalse(f.FillRectangleIsDrawn(Rect{ 200, 10, 10, 10 }));
+        Assert::IsFalse(f.FillRectangleIsDrawn(Rect{ 10, -20, 10, 10 }));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_UsesTheCurrentTransform)
+    {
+        CullingFixture f;
+
+        ThrowIfFailed(f.DS->Translate(-500, 0));
+        Assert::IsFalse(f.FillRectangleIsDrawn(Rect{ 10, 10, 10, 10 }));
+        Assert::IsTrue(f.FillRectangleIsDrawn(Rect{ 510, 10, 10, 10 }));
+
+        ThrowIfFailed(f.DS->Scale(0.1f, 0.1f));
+        Assert::IsTrue(f.FillRectangleIsDrawn(Rect{ 5100, 10, 10, 10 }));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_UsesTheCurrentClip)
+    {
+        CullingFixture f;
+
+        f.DeviceContext->MockGetAntialiasMode = [] { return D2D1_ANTIALIAS_MODE_PER_PRIMITIVE; };
+        f.DeviceContext->MockPushAxisAlignedClip = [](const D2D1_RECT_F*, D2D1_ANTIALIAS_MODE) {};
+
+        ThrowIfFailed(f.DS->PushClipRectangle(Rect{ 0, 0, 10, 10 }));
+
+        Assert::IsTrue(f.FillRectangleIsDrawn(Rect{ 5, 5, 10, 10 }));
+        Assert::IsFalse(f.FillRectangleIsDrawn(Rect{ 50, 50, 10, 10 }));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_AccountsForStrokeWidth)
+    {
+        CullingFixture f;
+
+        f.DrawCount = 0;
+        ThrowIfFailed(f.DS->DrawLineWithBrushAndStrokeWidth(Vector2{ 110, 0 }, Vector2{ 110, 50 }, f.Brush.Get(), 5));
+        Assert::AreEqual(0, f.DrawCount);
+
+        ThrowIfFailed(f.DS->DrawLineWithBrushAndStrokeWidth(Vector2{ 110, 0 }, Vector2{ 110, 50 }, f.Brush.Get(), 20));
+        Assert::AreEqual(1, f.DrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_Ellipses)
+    {
+        CullingFixture f;
+
+        f.DrawCount = 0;
+        ThrowIfFailed(f.DS->FillEllipseWithBrush(Vector2{ 150, 50 }, 30, 10, f.Brush.Get()));
+        Assert::AreEqual(0, f.DrawCount);
+
+        ThrowIfFailed(f.DS->FillEllipseWithBrush(Vector2{ 150, 50 }, 60, 10, f.Brush.Get()));
+        Assert::AreEqual(1, f.DrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_TextUsesInkBounds)
+    {
+        CullingFixture f;
+
+        f.DrawCount = 0;
+        ThrowIfFailed(f.DS->DrawTextAtPointWithBrushAndFormat(WinString(L"Hello"), Vector2{ 500, 50 }, f.Brush.Get(), nullptr));
+        Assert::AreEqual(0, f.DrawCount);
+
+        // Point text has an empty layout box, but its ink extends to the right
+        ThrowIfFailed(f.DS->DrawTextAtPointWithBrushAndFormat(WinString(L"A long piece of text"), Vector2{ -20, 50 }, f.Brush.Get(), nullptr));
+        Assert::AreEqual(1, f.DrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Culling_TextLayoutSkipsParagraphsOutsideTheTarget)
+    {
+        CullingFixture f;
+
+        auto format = Make<CanvasTextFormat>();
+        auto textLayout = Make<CanvasTextLayout>(
+            SharedDWriteFactory::GetOrCreate(),
+            WinString(L"one\ntwo\nthree\nfour\nfive\nsix\nseven\neight"),
+            format.Get(),
+            100.0f,
+            0.0f);
+
+        ThrowIfFailed(f.DS->DrawTextLayoutWithBrush(textLayout.Get(), Vector2{ 0, 0 }, f.Brush.Get()));
+        auto drawnFromTop = f.DrawCount;
+
+        Assert::IsTrue(drawnFromTop > 0);
+        Assert::IsTrue(drawnFromTop < 8);
+
+        // Scrolled so that the last paragraph is at the top of the target
+        f.DrawCount = 0;
+        ThrowIfFailed(f.DS->DrawTextLayoutWithBrush(textLayout.Get(), Vector2{ 0, -textLayout->GetParagraphs().back().Top }, f.Brush.Get()));
+        Assert::AreEqual(1, f.DrawCount);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(2, statistics.DrawTextCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawTextDocument_DrawsVisibleParagraphsClippedToTheViewport)
+    {
+        CanvasDrawingSessionFixture f;
+
+        auto format = Make<CanvasTextFormat>();
+        auto textDocument = Make<CanvasTextDocument>(
+            SharedDWriteFactory::GetOrCreate(),
+            WinString(L"one\ntwo\nthree\nfour\nfive\nsix\nseven\neight"),
+            format.Get(),
+            100.0f);
+
+        int pushCount = 0;
+        int popCount = 0;
+        int drawCount = 0;
+
+        f.DeviceContext->MockPushAxisAlignedClip =
+            [&](const D2D1_RECT_F* clipRect, D2D1_ANTIALIAS_MODE)
+            {
+                Assert::AreEqual(D2D1::RectF(10, 20, 110, 50), *clipRect);
+                ++pushCount;
+            };
+
+        f.DeviceContext->MockPopAxisAlignedClip = [&] { ++popCount; };
+
+        f.DeviceContext->MockDrawTextLayout =
+            [&](D2D1_POINT_2F origin, IDWriteTextLayout*, ID2D1Brush* brush, D2D1_DRAW_TEXT_OPTIONS)
+            {
+                Assert::AreEqual<ID2D1Brush*>(f.Brush->GetD2DBrush().Get(), brush);
+                Assert::AreEqual(10.0f, origin.x);
+                Assert::IsTrue(origin.y < 50);
+                ++drawCount;
+            };
+
+        ThrowIfFailed(f.DS->DrawTextDocumentWithBrush(textDocument.Get(), Rect{ 10, 20, 100, 30 }, 0, f.Brush.Get()));
+
+        Assert::AreEqual(1, pushCount);
+        Assert::AreEqual(1, popCount);
+        Assert::IsTrue(drawCount > 0);
+        Assert::IsTrue(drawCount < 8);
+        Assert::AreEqual<uint64_t>(drawCount, textDocument->GetParagraphLayoutCount());
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(1, statistics.DrawTextCount);
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextDocumentWithBrush(nullptr, Rect{ 10, 20, 100, 30 }, 0, f.Brush.Get()));
+    }
+
+    class TextBatchFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        struct DrawnLabel
+        {
+            D2D1_POINT_2F Origin;
+            IDWriteTextLayout* Layout;
+            D2D1_COLOR_F Color;
+        };
+
+        std::vector<DrawnLabel> Drawn;
+        D2D1_COLOR_F CurrentColor;
+
+        TextBatchFixture()
+        {
+            DeviceContext->MockCreateSolidColorBrush =
+                [this](const D2D1_COLOR_F* color, const D2D1_BRUSH_PROPERTIES*, ID2D1SolidColorBrush** value)
+                {
+                    CurrentColor = *color;
+
+                    auto brush = Make<MockD2DSolidColorBrush>();
+                    brush->MockSetColor = [this](const D2D1_COLOR_F* color) { CurrentColor = *color; };
+                    return brush.CopyTo(value);
+                };
+
+            DeviceContext->MockDrawTextLayout =
+                [this](D2D1_POINT_2F origin, IDWriteTextLayout* layout, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS)
+                {
+                    DrawnLabel label{ origin, layout, CurrentColor };
+                    Drawn.push_back(label);
+                };
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_DrawTextBatch_DrawsEachLabelAndLaysOutRepeatedStringsOnce)
+    {
+        TextBatchFixture f;
+
+        WinString text[] = { WinString(L"10"), WinString(L"20"), WinString(L"10"), WinString(L"") };
+        HSTRING textHandles[] = { text[0], text[1], text[2], text[3] };
+        Vector2 points[] = { Vector2{ 0, 1 }, Vector2{ 10, 1 }, Vector2{ 20, 1 }, Vector2{ 30, 1 } };
+        Color colors[] = { Color{ 255, 255, 0, 0 }, Color{ 255, 255, 0, 0 }, Color{ 255, 0, 0, 255 }, Color{ 255, 0, 0, 255 } };
+
+        ThrowIfFailed(f.DS->DrawTextBatch(4, textHandles, 4, points, 4, colors, nullptr));
+
+        // The empty label isn't drawn
+        Assert::AreEqual<size_t>(3, f.Drawn.size());
+
+        for (size_t i = 0; i < f.Drawn.size(); ++i)
+        {
+            Assert::AreEqual(D2D1::Point2F(points[i].X, points[i].Y), f.Drawn[i].Origin);
+            Assert::AreEqual(ToD2DColor(colors[i]), f.Drawn[i].Color);
+        }
+
+        Assert::AreEqual(f.Drawn[0].Layout, f.Drawn[2].Layout);
+        Assert::AreNotEqual(f.Drawn[0].Layout, f.Drawn[1].Layout);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(3, statistics.DrawTextCount);
+        Assert::AreEqual(1, statistics.SetColorCount);     // the first color creates the brush, and red is reused
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawTextBatchFromBuffer_MatchesDrawTextBatch)
+    {
+        TextBatchFixture f;
+
+        int32_t offsets[] = { 0, 2, 4, 6 };
+        Vector2 points[] = { Vector2{ 0, 0 }, Vector2{ 0, 10 }, Vector2{ 0, 20 } };
+        Color color{ 255, 0, 128, 0 };
+
+        ThrowIfFailed(f.DS->DrawTextBatchFromBuffer(WinString(L"102030"), 4, offsets, 3, points, 1, &color, nullptr));
+
+        Assert::AreEqual<size_t>(3, f.Drawn.size());
+
+        for (auto& label : f.Drawn)
+        {
+            Assert::AreEqual(ToD2DColor(color), label.Color);
+        }
+
+        // Labels share the session's layout cache, so the same string gets
+        // the same layout however it was passed in
+        WinString text(L"20");
+        HSTRING textHandle = text;
+
+        ThrowIfFailed(f.DS->DrawTextBatch(1, &textHandle, 1, points, 1, &color, nullptr));
+
+        Assert::AreEqual<size_t>(4, f.Drawn.size());
+        Assert::AreEqual(f.Drawn[1].Layout, f.Drawn[3].Layout);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawTextBatch_WithManyDistinctLabels_DrawsThemAll)
+    {
+        TextBatchFixture f;
+
+        // More distinct labels than the batch remembers, each drawn twice
+        const int distinctCount = 100;
+
+        std::wstring buffer;
+        std::vector<int32_t> offsets(1, 0);
+        std::vector<Vector2> points;
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (int i = 0; i < distinctCount; ++i)
+            {
+                buffer += std::to_wstring(i);
+                offsets.push_back(static_cast<int32_t>(buffer.size()));
+                points.push_back(Vector2{ static_cast<float>(i), static_cast<float>(pass) });
+            }
+        }
+
+        Color color{ 255, 0, 0, 0 };
+        auto labelCount = static_cast<uint32_t>(points.size());
+
+        ThrowIfFailed(f.DS->DrawTextBatchFromBuffer(WinString(buffer), labelCount + 1, offsets.data(), labelCount, points.data(), 1, &color, nullptr));
+
+        Assert::AreEqual<size_t>(labelCount, f.Drawn.size());
+
+        for (int i = 0; i < distinctCount; ++i)
+        {
+            Assert::AreEqual(f.Drawn[i].Layout, f.Drawn[i + distinctCount].Layout);
+
+            if (i > 0)
+                Assert::AreNotEqual(f.Drawn[i - 1].Layout, f.Drawn[i].Layout);
+        }
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawTextBatch_InvalidArguments)
+    {
+        TextBatchFixture f;
+
+        WinString text(L"text");
+        HSTRING textHandles[] = { text, text };
+        Vector2 points[] = { Vector2{}, Vector2{} };
+        Color colors[] = { Color{}, Color{}, Color{} };
+        int32_t offsets[] = { 0, 2, 4 };
+        int32_t decreasingOffsets[] = { 0, 3, 2 };
+        int32_t negativeOffsets[] = { -1, 2, 4 };
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatch(2, nullptr, 2, points, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatch(2, textHandles, 2, nullptr, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatch(2, textHandles, 2, points, 1, nullptr, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatch(2, textHandles, 1, points, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatch(2, textHandles, 2, points, 0, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatch(2, textHandles, 2, points, 3, colors, nullptr));
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatchFromBuffer(WinString(L"text"), 3, nullptr, 2, points, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatchFromBuffer(WinString(L"tex"), 3, offsets, 2, points, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatchFromBuffer(WinString(L"text"), 3, decreasingOffsets, 2, points, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatchFromBuffer(WinString(L"text"), 3, negativeOffsets, 2, points, 1, colors, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawTextBatchFromBuffer(WinString(L"text"), 2, offsets, 2, points, 1, colors, nullptr));
+
+        Assert::AreEqual<size_t>(0, f.Drawn.size());
+
+        // An empty batch is fine
+        ThrowIfFailed(f.DS->DrawTextBatch(0, nullptr, 0, nullptr, 0, nullptr, nullptr));
+        ThrowIfFailed(f.DS->DrawTextBatchFromBuffer(nullptr, 0, nullptr, 0, nullptr, 0, nullptr, nullptr));
+        ThrowIfFailed(f.DS->DrawTextBatchFromBuffer(nullptr, 1, offsets, 0, nullptr, 0, nullptr, nullptr));
+    }
+
+    //
+    // Statistics
+    //
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_CountsDrawCallsAndStateChanges)
+    {
+        CanvasDrawingSessionFixture f;
+
+        f.DeviceContext->MockFillRectangle = [](const D2D1_RECT_F*, ID2D1Brush*) {};
+        f.DeviceContext->MockFillEllipse = [](const D2D1_ELLIPSE*, ID2D1Brush*) {};
+        f.DeviceContext->MockSetAntialiasMode = [](D2D1_ANTIALIAS_MODE) {};
+        f.DeviceContext->MockGetTransform = [](D2D1_MATRIX_3X2_F* m) { *m = D2D1::IdentityMatrix(); };
+        f.DeviceContext->MockSetTransform = [](const D2D1_MATRIX_3X2_F*) {};
+        f.DeviceContext->MockCreateSolidColorBrush =
+            [](const D2D1_COLOR_F*, const D2D1_BRUSH_PROPERTIES*, ID2D1SolidColorBrush** value)
+            {
+                auto brush = Make<MockD2DSolidColorBrush>();
+                brush->MockSetColor = [](const D2D1_COLOR_F*) {};
+                return brush.CopyTo(value);
+            };
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{}, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{}, Color{}));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{}, Color{}));
+        ThrowIfFailed(f.DS->FillEllipseWithBrush(Vector2{}, 1, 1, f.Brush.Get()));
+
+        ThrowIfFailed(f.DS->put_Antialiasing(CanvasAntialiasing::Aliased));
+        ThrowIfFailed(f.DS->Translate(1, 1));
+        ThrowIfFailed(f.DS->Translate(1, 1));
+        ThrowIfFailed(f.DS->FillEllipseWithBrush(Vector2{}, 1, 1, f.Brush.Get()));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+
+        Assert::AreEqual(3, statistics.FillRectangleCount);
+        Assert::AreEqual(2, statistics.FillEllipseCount);
+        Assert::AreEqual(0, statistics.DrawLineCount);
+        Assert::AreEqual(0, statistics.CulledDrawCount);
+        Assert::AreEqual(1, statistics.SetColorCount);         // the first color creates the brush
+        Assert::AreEqual(2, statistics.StateChangeCount);      // the two translations are applied together
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_CountsCulledDraws)
+    {
+        CanvasDrawingSessionFixture f;
+
+        auto target = Make<MockD2DBitmap>();
+        f.DeviceContext->MockGetTarget = [&](ID2D1Image** value) { ThrowIfFailed(target.CopyTo(value)); };
+        f.DeviceContext->MockGetImageLocalBounds = [](ID2D1Image*, D2D1_RECT_F* bounds) { *bounds = D2D1::RectF(0, 0, 10, 10); return S_OK; };
+        f.DeviceContext->MockGetTransform = [](D2D1_MATRIX_3X2_F* m) { *m = D2D1::IdentityMatrix(); };
+
+        ThrowIfFailed(f.DS->put_IsCullingEnabled(true));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 100, 100, 1, 1 }, f.Brush.Get()));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+
+        Assert::AreEqual(0, statistics.FillRectangleCount);
+        Assert::AreEqual(1, statistics.CulledDrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_CountsTextFormatRealizations)
+    {
+        CanvasDrawingSessionFixture f;
+
+        f.DeviceContext->MockDrawTextLayout = [](D2D1_POINT_2F, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS) {};
+
+        auto format = Make<CanvasTextFormat>();
+        ThrowIfFailed(f.DS->DrawTextAtPointWithBrushAndFormat(WinString(L"text"), Vector2{}, f.Brush.Get(), format.Get()));
+        ThrowIfFailed(f.DS->DrawTextAtPointWithBrushAndFormat(WinString(L"text"), Vector2{}, f.Brush.Get(), format.Get()));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+
+        Assert::AreEqual(2, statistics.DrawTextCount);
+        Assert::AreEqual(1, statistics.TextFormatRealizationCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_OnlyCountTheSessionsOwnRealizations)
+    {
+        CanvasDrawingSessionFixture f1;
+        CanvasDrawingSessionFixture f2;
+
+        // Both sessions draw with the same D2D factory, so a stroke style
+        // realized by one can be used by the other
+        f2.DeviceContext->m_factory = f1.DeviceContext->m_factory;
+
+        f1.DeviceContext->MockDrawLine = [](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float, ID2D1StrokeStyle*) {};
+        f2.DeviceContext->MockDrawLine = [](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float, ID2D1StrokeStyle*) {};
+        f1.DeviceContext->MockDrawTextLayout = [](D2D1_POINT_2F, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS) {};
+        f2.DeviceContext->MockDrawTextLayout = [](D2D1_POINT_2F, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS) {};
+
+        auto strokeStyle = Make<CanvasStrokeStyle>();
+        auto format = Make<CanvasTextFormat>();
+
+        ThrowIfFailed(f1.DS->DrawLineWithBrushAndStrokeWidthAndStrokeStyle(Vector2{}, Vector2{ 1, 1 }, f1.Brush.Get(), 1.0f, strokeStyle.Get()));
+        ThrowIfFailed(f1.DS->DrawTextAtPointWithBrushAndFormat(WinString(L"text"), Vector2{}, f1.Brush.Get(), format.Get()));
+
+        ThrowIfFailed(f2.DS->DrawLineWithBrushAndStrokeWidthAndStrokeStyle(Vector2{}, Vector2{ 1, 1 }, f2.Brush.Get(), 1.0f, strokeStyle.Get()));
+        ThrowIfFailed(f2.DS->DrawTextAtPointWithBrushAndFormat(WinString(L"text"), Vector2{}, f2.Brush.Get(), format.Get()));
+
+        CanvasDrawingSessionStatistics statistics;
+
+        ThrowIfFailed(f1.DS->get_Statistics(&statistics));
+        Assert::AreEqual(1, statistics.StrokeStyleRealizationCount);
+        Assert::AreEqual(1, statistics.TextFormatRealizationCount);
+
+        ThrowIfFailed(f2.DS->get_Statistics(&statistics));
+        Assert::AreEqual(0, statistics.StrokeStyleRealizationCount);
+        Assert::AreEqual(0, statistics.TextFormatRealizationCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_AreAvailableAfterClose)
+    {
+        CanvasDrawingSessionFixture f;
+
+        f.DeviceContext->MockClear = [](const D2D1_COLOR_F*) {};
+        ThrowIfFailed(f.DS->Clear(Color{}));
+        ThrowIfFailed(f.DS->Close());
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(1, statistics.ClearCount);
+        Assert::IsTrue(statistics.EndDrawDuration.Duration >= 0);
+
+        ThrowIfFailed(f.DS->ResetStatistics());
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(0, statistics.ClearCount);
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->get_Statistics(nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_AddStatistics)
+    {
+        CanvasDrawingSessionStatistics total{};
+        CanvasDrawingSessionStatistics value{};
+        value.DrawLineCount = 2;
+        value.StateChangeCount = 3;
+        value.EndDrawDuration.Duration = 4;
+
+        AddStatistics(&total, value);
+        AddStatistics(&total, value);
+
+        Assert::AreEqual(4, total.DrawLineCount);
+        Assert::AreEqual(6, total.StateChangeCount);
+        Assert::AreEqual<int64_t>(8, total.EndDrawDuration.Duration);
+        Assert::AreEqual(0, total.ClearCount);
+    }
+
+    //
+    // Batching
+    //
+
+    class BatchingFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        ComPtr<MockD2DPathGeometry> PathGeometry;
+        ComPtr<MockD2DGeometrySink> Sink;
+        std::vector<std::wstring> Calls;
+        int FigureCount;
+
+        BatchingFixture()
+            : PathGeometry(Make<MockD2DPathGeometry>())
+            , Sink(Make<MockD2DGeometrySink>())
+            , FigureCount(0)
+        {
+            DeviceContext->MockCreateSolidColorBrush =
+                [](const D2D1_COLOR_F*, const D2D1_BRUSH_PROPERTIES*, ID2D1SolidColorBrush** value)
+                {
+                    auto brush = Make<MockD2DSolidColorBrush>();
+                    brush->MockSetColor = [](const D2D1_COLOR_F*) {};
+                    return brush.CopyTo(value);
+                };
+
+            DeviceContext->MockGetPrimitiveBlend = [] { return D2D1_PRIMITIVE_BLEND_SOURCE_OVER; };
+
+            DeviceContext->m_factory->MockCreatePathGeometry =
+                [this](ID2D1PathGeometry** value)
+                {
+                    return PathGeometry.CopyTo(value);
+                };
+
+            PathGeometry->MockOpen = [this](ID2D1GeometrySink** value) { ThrowIfFailed(Sink.CopyTo(value)); };
+            Sink->MockSetFillMode = [](D2D1_FILL_MODE mode) { Assert::IsTrue(mode == D2D1_FILL_MODE_WINDING); };
+            Sink->MockBeginFigure = [this](D2D1_POINT_2F, D2D1_FIGURE_BEGIN) { ++FigureCount; };
+            Sink->MockAddLine = [](D2D1_POINT_2F) {};
+            Sink->MockAddArc = [](const D2D1_ARC_SEGMENT*) {};
+            Sink->MockEndFigure = [](D2D1_FIGURE_END) {};
+            Sink->MockClose = [] { return S_OK; };
+
+            DeviceContext->MockFillRectangle = [this](const D2D1_RECT_F*, ID2D1Brush*) { Calls.push_back(L"FillRectangle"); };
+            DeviceContext->MockFillEllipse = [this](const D2D1_ELLIPSE*, ID2D1Brush*) { Calls.push_back(L"FillEllipse"); };
+            DeviceContext->MockDrawLine = [this](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float, ID2D1StrokeStyle*) { Calls.push_back(L"DrawLine"); };
+            DeviceContext->MockClear = [this](const D2D1_COLOR_F*) { Calls.push_back(L"Clear"); };
+
+            DeviceContext->MockFillGeometry =
+                [this](ID2D1Geometry* geometry, ID2D1Brush*, ID2D1Brush*)
+                {
+                    Assert::AreEqual<ID2D1Geometry*>(PathGeometry.Get(), geometry);
+                    Calls.push_back(L"FillGeometry");
+                };
+
+            DeviceContext->MockDrawGeometry =
+                [this](ID2D1Geometry* geometry, ID2D1Brush*, float, ID2D1StrokeStyle*)
+                {
+                    Assert::AreEqual<ID2D1Geometry*>(PathGeometry.Get(), geometry);
+                    Calls.push_back(L"DrawGeometry");
+                };
+
+            ThrowIfFailed(DS->put_IsBatchingEnabled(true));
+        }
+
+        void ExpectCalls(std::vector<std::wstring> const& expected)
+        {
+            Assert::AreEqual(expected.size(), Calls.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+                Assert::AreEqual(expected[i], Calls[i]);
+
+            Calls.clear();
+        }
+    };
+
+    static Color Opaque(uint8_t r) { return Color{ 255, r, 0, 0 }; }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_IsDisabledByDefault)
+    {
+        CanvasDrawingSessionFixture f;
+
+        boolean isBatchingEnabled;
+        ThrowIfFailed(f.DS->get_IsBatchingEnabled(&isBatchingEnabled));
+        Assert::IsFalse(!!isBatchingEnabled);
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->get_IsBatchingEnabled(nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_CombinesFillsOfTheSameColor)
+    {
+        BatchingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 2, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillEllipseWithColor(Vector2{ 4, 0 }, 1, 1, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 6, 0, -1, -1 }, Opaque(1)));
+        f.ExpectCalls({});
+
+        // Anything else flushes the batch first
+        ThrowIfFailed(f.DS->Clear(Color{}));
+        f.ExpectCalls({ L"FillGeometry", L"Clear" });
+        Assert::AreEqual(4, f.FigureCount);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(3, statistics.FillRectangleCount);
+        Assert::AreEqual(1, statistics.FillEllipseCount);
+        Assert::AreEqual(1, statistics.BatchCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_ChangingColorStartsANewBatch)
+    {
+        BatchingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 2, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillEllipseWithColor(Vector2{ 4, 0 }, 1, 1, Opaque(2)));
+        f.ExpectCalls({ L"FillGeometry" });
+
+        // A batch of one is drawn directly, when the session is closed
+        ThrowIfFailed(f.DS->Close());
+        f.ExpectCalls({ L"FillEllipse" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_LinesAreBatchedByStrokeWidth)
+    {
+        BatchingFixture f;
+
+        ThrowIfFailed(f.DS->DrawLineWithColorAndStrokeWidth(Vector2{ 0, 0 }, Vector2{ 1, 1 }, Opaque(1), 1));
+        ThrowIfFailed(f.DS->DrawLineWithColorAndStrokeWidth(Vector2{ 1, 1 }, Vector2{ 2, 2 }, Opaque(1), 1));
+        ThrowIfFailed(f.DS->DrawLineWithColorAndStrokeWidth(Vector2{ 2, 2 }, Vector2{ 3, 3 }, Opaque(1), 2));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        f.ExpectCalls({ L"DrawGeometry", L"DrawLine" });
+
+        // Turning batching off flushes the batch
+        ThrowIfFailed(f.DS->put_IsBatchingEnabled(false));
+        f.ExpectCalls({ L"FillRectangle" });
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        f.ExpectCalls({ L"FillRectangle" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_TranslucentColorsAndOtherBrushesAreDrawnDirectly)
+    {
+        BatchingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Color{ 128, 1, 0, 0 }));
+        f.ExpectCalls({ L"FillGeometry", L"FillRectangle" });
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 1, 1 }, f.Brush.Get()));
+        f.ExpectCalls({ L"FillRectangle", L"FillRectangle" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_OnlyCombinesPrimitivesWithTheSameTransform)
+    {
+        BatchingFixture f;
+
+        f.DeviceContext->MockGetTransform = [](D2D1_MATRIX_3X2_F* m) { *m = D2D1::IdentityMatrix(); };
+        f.DeviceContext->MockSetTransform = [&](const D2D1_MATRIX_3X2_F*) { f.Calls.push_back(L"SetTransform"); };
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 2, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->Translate(10, 10));
+        f.ExpectCalls({});
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        f.ExpectCalls({ L"FillGeometry", L"SetTransform" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Batching_IsFlushedBeforeInterop)
+    {
+        BatchingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 0, 0, 1, 1 }, Opaque(1)));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 2, 0, 1, 1 }, Opaque(1)));
+
+        ComPtr<ICanvasResourceWrapperNative> wrapper;
+        ThrowIfFailed(f.DS.As(&wrapper));
+
+        ComPtr<IUnknown> resource;
+        ThrowIfFailed(wrapper->GetResource(&resource));
+        ComPtr<ID2D1DeviceContext1> deviceContext;
+        ThrowIfFailed(resource.As(&deviceContext));
+        Assert::AreEqual<ID2D1DeviceContext1*>(f.DeviceContext.Get(), deviceContext.Get());
+
+        f.ExpectCalls({ L"FillGeometry" });
+    }
+
+    //
+    // Pixel aligned aliasing
+    //
+
+    class AliasingFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        std::vector<std::wstring> Calls;
+        D2D1_ANTIALIAS_MODE AntialiasMode;
+        float Dpi;
+
+        AliasingFixture()
+            : AntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE)
+            , Dpi(DEFAULT_DPI)
+        {
+            DeviceContext->MockGetAntialiasMode = [this] { return AntialiasMode; };
+
+            DeviceContext->MockSetAntialiasMode =
+                [this](D2D1_ANTIALIAS_MODE mode)
+                {
+                    AntialiasMode = mode;
+                    Calls.push_back(mode == D2D1_ANTIALIAS_MODE_ALIASED ? L"Aliased" : L"Antialiased");
+                };
+
+            DeviceContext->MockGetUnitMode = [] { return D2D1_UNIT_MODE_DIPS; };
+            DeviceContext->MockGetDpi = [this](float* dpiX, float* dpiY) { *dpiX = *dpiY = Dpi; };
+            DeviceContext->MockSetTransform = [](const D2D1_MATRIX_3X2_F*) {};
+
+            DeviceContext->MockFillRectangle = [this](const D2D1_RECT_F*, ID2D1Brush*) { Calls.push_back(L"FillRectangle"); };
+            DeviceContext->MockDrawRectangle = [this](const D2D1_RECT_F*, ID2D1Brush*, float, ID2D1StrokeStyle*) { Calls.push_back(L"DrawRectangle"); };
+            DeviceContext->MockFillEllipse = [this](const D2D1_ELLIPSE*, ID2D1Brush*) { Calls.push_back(L"FillEllipse"); };
+
+            ThrowIfFailed(DS->put_IsPixelAlignedAliasingEnabled(true));
+        }
+
+        void ExpectCalls(std::vector<std::wstring> const& expected)
+        {
+            Assert::AreEqual(expected.size(), Calls.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+                Assert::AreEqual(expected[i], Calls[i]);
+
+            Calls.clear();
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_IsDisabledByDefault)
+    {
+        CanvasDrawingSessionFixture f;
+
+        boolean isEnabled = true;
+        ThrowIfFailed(f.DS->get_IsPixelAlignedAliasingEnabled(&isEnabled));
+        Assert::IsFalse(!!isEnabled);
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->get_IsPixelAlignedAliasingEnabled(nullptr));
+
+        // The mock fails any call to SetAntialiasMode
+        f.DeviceContext->MockFillRectangle = [](const D2D1_RECT_F*, ID2D1Brush*) {};
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_RunsOfAlignedRectanglesOnlySwitchModeOnce)
+    {
+        AliasingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 10, 0, 10, 10 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 20, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"Aliased", L"FillRectangle", L"FillRectangle", L"FillRectangle" });
+
+        ThrowIfFailed(f.DS->FillCircleWithBrush(Vector2{ 5, 5 }, 5, f.Brush.Get()));
+        f.ExpectCalls({ L"Antialiased", L"FillEllipse" });
+
+        // Unaligned rectangles don't switch the mode
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0.5f, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"FillRectangle" });
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10.5f }, f.Brush.Get()));
+        f.ExpectCalls({ L"Aliased", L"FillRectangle", L"Antialiased", L"FillRectangle" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_OnlyAppliesToWholePixelTranslations)
+    {
+        AliasingFixture f;
+
+        ThrowIfFailed(f.DS->Translate(0.5f, 0));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0.5f, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"FillRectangle", L"Aliased", L"FillRectangle" });
+
+        ThrowIfFailed(f.DS->put_Transform(Numerics::Matrix3x2{ 2, 0, 0, 2, 0, 0 }));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"Antialiased", L"FillRectangle" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_TakesDpiIntoAccount)
+    {
+        AliasingFixture f;
+        f.Dpi = 144;
+
+        // 1.5 pixels per DIP
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 1, 1 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 2, 2, 2, 2 }, f.Brush.Get()));
+        f.ExpectCalls({ L"FillRectangle", L"Aliased", L"FillRectangle" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_StrokesMustBeAlignedOnBothSides)
+    {
+        AliasingFixture f;
+
+        // A one pixel stroke centered on whole pixels straddles two pixels
+        ThrowIfFailed(f.DS->DrawRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"DrawRectangle" });
+
+        ThrowIfFailed(f.DS->DrawRectangleWithBrush(Rect{ 0.5f, 0.5f, 10, 10 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->DrawRectangleWithBrushAndStrokeWidth(Rect{ 0, 0, 10, 10 }, f.Brush.Get(), 2));
+        f.ExpectCalls({ L"Aliased", L"DrawRectangle", L"DrawRectangle" });
+
+        // Stroke styles can change the corners
+        auto strokeStyle = Make<CanvasStrokeStyle>();
+        ThrowIfFailed(f.DS->DrawRectangleWithBrushAndStrokeWidthAndStrokeStyle(Rect{ 0, 0, 10, 10 }, f.Brush.Get(), 2, strokeStyle.Get()));
+        f.ExpectCalls({ L"Antialiased", L"DrawRectangle" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_LeavesAppChosenModeAlone)
+    {
+        AliasingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"Aliased", L"FillRectangle" });
+
+        // The app sees the mode it set
+        CanvasAntialiasing antialiasing;
+        ThrowIfFailed(f.DS->get_Antialiasing(&antialiasing));
+        Assert::AreEqual(CanvasAntialiasing::Antialiased, antialiasing);
+
+        // Once the app chooses aliased drawing there is nothing to switch
+        ThrowIfFailed(f.DS->put_Antialiasing(CanvasAntialiasing::Aliased));
+        f.ExpectCalls({ L"Aliased" });
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillCircleWithBrush(Vector2{ 5, 5 }, 5, f.Brush.Get()));
+        f.ExpectCalls({ L"FillRectangle", L"FillEllipse" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PixelAlignedAliasing_ModeIsRestoredOnClose)
+    {
+        AliasingFixture f;
+
+        ThrowIfFailed(f.DS->FillRectangleWithBrush(Rect{ 0, 0, 10, 10 }, f.Brush.Get()));
+        f.ExpectCalls({ L"Aliased", L"FillRectangle" });
+
+        ThrowIfFailed(f.DS->Close());
+        f.ExpectCalls({ L"Antialiased" });
+    }
+
+    //
+    // Direct drawing
+    //
+
+    class DirectDrawingFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        std::vector<std::wstring> Calls;
+        std::vector<D2D1_COLOR_F> Colors;
+
+        DirectDrawingFixture()
+        {
+            DeviceContext->MockCreateSolidColorBrush =
+                [=](const D2D1_COLOR_F* color, const D2D1_BRUSH_PROPERTIES*, ID2D1SolidColorBrush** value)
+                {
+                    Calls.push_back(L"CreateSolidColorBrush");
+                    Colors.push_back(*color);
+
+                    auto brush = Make<MockD2DSolidColorBrush>();
+                    brush->MockSetColor = [=](const D2D1_COLOR_F* color) { Colors.push_back(*color); };
+                    return brush.CopyTo(value);
+                };
+
+            DeviceContext->MockDrawLine =
+                [=](D2D1_POINT_2F p0, D2D1_POINT_2F p1, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+                {
+                    Assert::AreEqual(D2D1::Point2F(1, 2), p0);
+                    Assert::AreEqual(D2D1::Point2F(3, 4), p1);
+                    Assert::AreEqual(5.0f, strokeWidth);
+                    Assert::IsNull(strokeStyle);
+                    Calls.push_back(L"DrawLine");
+                };
+
+            DeviceContext->MockDrawRectangle =
+                [=](const D2D1_RECT_F* rect, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+                {
+                    Assert::AreEqual(D2D1::RectF(1, 2, 4, 6), *rect);
+                    Assert::AreEqual(5.0f, strokeWidth);
+                    Assert::IsNull(strokeStyle);
+                    Calls.push_back(L"DrawRectangle");
+                };
+
+            DeviceContext->MockFillRectangle =
+                [=](const D2D1_RECT_F* rect, ID2D1Brush*)
+                {
+                    Assert::AreEqual(D2D1::RectF(1, 2, 4, 6), *rect);
+                    Calls.push_back(L"FillRectangle");
+                };
+
+            DeviceContext->MockFillEllipse =
+                [=](const D2D1_ELLIPSE* ellipse, ID2D1Brush*)
+                {
+                    Assert::AreEqual(D2D1::Ellipse(D2D1::Point2F(1, 2), 3, 4), *ellipse);
+                    Calls.push_back(L"FillEllipse");
+                };
+        }
+
+        void DrawEachPrimitive(Color color)
+        {
+            ThrowIfFailed(DS->DrawLineWithColorAndStrokeWidth(Vector2{ 1, 2 }, Vector2{ 3, 4 }, color, 5));
+            ThrowIfFailed(DS->DrawRectangleWithColorAndStrokeWidth(Rect{ 1, 2, 3, 4 }, color, 5));
+            ThrowIfFailed(DS->FillRectangleWithColor(Rect{ 1, 2, 3, 4 }, color));
+            ThrowIfFailed(DS->FillEllipseWithColor(Vector2{ 1, 2 }, 3, 4, color));
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_DirectDrawing_MatchesTheGeneralPath)
+    {
+        DirectDrawingFixture f;
+
+        Color color1{ 255, 1, 2, 3 };
+        Color color2{ 255, 4, 5, 6 };
+
+        // The first call creates the brush via the general path, the rest
+        // reuse it via the direct path.
+        f.DrawEachPrimitive(color1);
+        f.DrawEachPrimitive(color2);
+
+        std::vector<std::wstring> expectedCalls
+        {
+            L"CreateSolidColorBrush", L"DrawLine", L"DrawRectangle", L"FillRectangle", L"FillEllipse",
+            L"DrawLine", L"DrawRectangle", L"FillRectangle", L"FillEllipse"
+        };
+
+        Assert::AreEqual(expectedCalls.size(), f.Calls.size());
+        for (size_t i = 0; i < expectedCalls.size(); ++i)
+            Assert::AreEqual(expectedCalls[i], f.Calls[i]);
+
+        Assert::AreEqual<size_t>(8, f.Colors.size());
+        for (size_t i = 0; i < 4; ++i)
+        {
+            Assert::AreEqual(ToD2DColor(color1), f.Colors[i]);
+            Assert::AreEqual(ToD2DColor(color2), f.Colors[i + 4]);
+        }
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+
+        Assert::AreEqual(2, statistics.DrawLineCount);
+        Assert::AreEqual(2, statistics.DrawRectangleCount);
+        Assert::AreEqual(2, statistics.FillRectangleCount);
+        Assert::AreEqual(2, statistics.FillEllipseCount);
+        Assert::AreEqual(7, statistics.SetColorCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DirectDrawing_AppliesDeferredTransforms)
+    {
+        DirectDrawingFixture f;
+
+        f.DrawEachPrimitive(Color{});
+        f.Calls.clear();
+
+        f.DeviceContext->MockGetTransform = [](D2D1_MATRIX_3X2_F* m) { *m = D2D1::IdentityMatrix(); };
+        f.DeviceContext->MockSetTransform = [&](const D2D1_MATRIX_3X2_F*) { f.Calls.push_back(L"SetTransform"); };
+
+        ThrowIfFailed(f.DS->Translate(1, 1));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 1, 2, 3, 4 }, Color{}));
+        ThrowIfFailed(f.DS->FillRectangleWithColor(Rect{ 1, 2, 3, 4 }, Color{}));
+
+        std::vector<std::wstring> expectedCalls { L"SetTransform", L"FillRectangle", L"FillRectangle" };
+
+        Assert::AreEqual(expectedCalls.size(), f.Calls.size());
+        for (size_t i = 0; i < expectedCalls.size(); ++i)
+            Assert::AreEqual(expectedCalls[i], f.Calls[i]);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DirectDrawing_ReportsClosedSessions)
+    {
+        DirectDrawingFixture f;
+
+        f.DrawEachPrimitive(Color{});
+        f.Calls.clear();
+
+        ThrowIfFailed(f.DS->Close());
+
+        Assert::AreEqual(RO_E_CLOSED, f.DS->DrawLineWithColor(Vector2{}, Vector2{}, Color{}));
+        Assert::AreEqual(RO_E_CLOSED, f.DS->DrawRectangleWithColor(Rect{}, Color{}));
+        Assert::AreEqual(RO_E_CLOSED, f.DS->FillRectangleWithColor(Rect{}, Color{}));
+        Assert::AreEqual(RO_E_CLOSED, f.DS->FillEllipseWithColor(Vector2{}, 0, 0, Color{}));
+
+        Assert::AreEqual<size_t>(0, f.Calls.size());
+    }
+
+    //
+    // Geometry
+    //
+
+    class GeometryFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        ComPtr<MockD2DPathGeometry> PathGeometry;
+        ComPtr<CanvasGeometry> Geometry;
+        std::vector<std::wstring> Calls;
+
+        GeometryFixture()
+            : PathGeometry(Make<MockD2DPathGeometry>())
+        {
+            Geometry = std::make_shared<CanvasGeometryManager>()->GetOrCreate(PathGeometry.Get());
+
+            PathGeometry->MockGetBounds =
+                [](const D2D1_MATRIX_3X2_F*, D2D1_RECT_F* bounds)
+                {
+                    *bounds = D2D1::RectF(10, 10, 20, 20);
+                };
+
+            auto d2dDevice = Make<MockD2DDevice>();
+
+            DeviceContext->MockGetTransform = [](D2D1_MATRIX_3X2_F* m) { *m = D2D1::IdentityMatrix(); };
+            DeviceContext->MockGetDpi = [](float* dpiX, float* dpiY) { *dpiX = *dpiY = DEFAULT_DPI; };
+            DeviceContext->MockGetDevice = [=](ID2D1Device** device) { ThrowIfFailed(d2dDevice.CopyTo(device)); };
+
+            DeviceContext->MockCreateFilledGeometryRealization =
+                [](ID2D1Geometry*, float, ID2D1GeometryRealization** realization)
+                {
+                    return Make<MockD2DGeometryRealization>().CopyTo(realization);
+                };
+
+            DeviceContext->MockCreateStrokedGeometryRealization =
+                [](ID2D1Geometry*, float, float, ID2D1StrokeStyle*, ID2D1GeometryRealization** realization)
+                {
+                    return Make<MockD2DGeometryRealization>().CopyTo(realization);
+                };
+
+            DeviceContext->MockDrawGeometry =
+                [this](ID2D1Geometry* geometry, ID2D1Brush* brush, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+                {
+                    Assert::AreEqual<ID2D1Geometry*>(PathGeometry.Get(), geometry);
+                    Assert::AreEqual(Brush->GetD2DBrush().Get(), brush);
+                    Assert::AreEqual(5.0f, strokeWidth);
+                    Assert::IsNull(strokeStyle);
+                    Calls.push_back(L"DrawGeometry");
+                };
+
+            DeviceContext->MockFillGeometry =
+                [this](ID2D1Geometry* geometry, ID2D1Brush* brush, ID2D1Brush* opacityBrush)
+                {
+                    Assert::AreEqual<ID2D1Geometry*>(PathGeometry.Get(), geometry);
+                    Assert::AreEqual(Brush->GetD2DBrush().Get(), brush);
+                    Assert::IsNull(opacityBrush);
+                    Calls.push_back(L"FillGeometry");
+                };
+
+            DeviceContext->MockDrawGeometryRealization =
+                [this](ID2D1GeometryRealization* realization, ID2D1Brush* brush)
+                {
+                    Assert::IsNotNull(realization);
+                    Assert::AreEqual(Brush->GetD2DBrush().Get(), brush);
+                    Calls.push_back(L"DrawGeometryRealization");
+                };
+        }
+
+        void ExpectCalls(std::vector<std::wstring> const& expected)
+        {
+            Assert::AreEqual(expected.size(), Calls.size());
+
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                Assert::AreEqual(expected[i], Calls[i]);
+            }
+
+            Calls.clear();
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_DrawGeometry_UsesARealizationOnceTheGeometryIsReused)
+    {
+        GeometryFixture f;
+
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(f.Geometry.Get(), f.Brush.Get(), 5));
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(f.Geometry.Get(), f.Brush.Get(), 5));
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(f.Geometry.Get(), f.Brush.Get(), 5));
+
+        f.ExpectCalls({ L"DrawGeometry", L"DrawGeometryRealization", L"DrawGeometryRealization" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_FillGeometry_UsesARealizationOnceTheGeometryIsReused)
+    {
+        GeometryFixture f;
+
+        ThrowIfFailed(f.DS->FillGeometryWithBrush(f.Geometry.Get(), f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillGeometryWithBrush(f.Geometry.Get(), f.Brush.Get()));
+
+        f.ExpectCalls({ L"FillGeometry", L"DrawGeometryRealization" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Geometry_NullArguments)
+    {
+        GeometryFixture f;
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawGeometryWithBrush(nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawGeometryWithBrush(f.Geometry.Get(), nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawGeometryWithColor(nullptr, Color{}));
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillGeometryWithBrush(nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillGeometryWithBrush(f.Geometry.Get(), nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillGeometryWithColor(nullptr, Color{}));
+        Assert::AreEqual(E_INVALIDARG, f.DS->PushLayerWithOpacityAndClipGeometry(1, nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Geometry_IsCulledUsingItsBounds)
+    {
+        CullingFixture f;
+
+        auto pathGeometry = Make<MockD2DPathGeometry>();
+        pathGeometry->MockGetBounds =
+            [](const D2D1_MATRIX_3X2_F*, D2D1_RECT_F* bounds)
+            {
+                *bounds = D2D1::RectF(110, 10, 120, 20);
+            };
+
+        auto geometry = std::make_shared<CanvasGeometryManager>()->GetOrCreate(pathGeometry.Get());
+
+        ThrowIfFailed(f.DS->FillGeometryWithBrush(geometry.Get(), f.Brush.Get()));
+
+        // A wide enough stroke reaches back into the target
+        bool drawn = false;
+        f.DeviceContext->MockGetDpi = [](float* dpiX, float* dpiY) { *dpiX = *dpiY = DEFAULT_DPI; };
+        f.DeviceContext->MockGetDevice = [](ID2D1Device** device) { ThrowIfFailed(Make<MockD2DDevice>().CopyTo(device)); };
+        f.DeviceContext->MockDrawGeometry = [&](ID2D1Geometry*, ID2D1Brush*, float, ID2D1StrokeStyle*) { drawn = true; };
+
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(geometry.Get(), f.Brush.Get(), 1));
+        Assert::IsFalse(drawn);
+
+        // The default miter limit of 10 reaches 8.5 to the left, which is
+        // still outside the target once the antialiasing margin is added
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(geometry.Get(), f.Brush.Get(), 1.7f));
+        Assert::IsFalse(drawn);
+
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(geometry.Get(), f.Brush.Get(), 4));
+        Assert::IsTrue(drawn);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(3, statistics.CulledDrawCount);
+    }
+
+    //
+    // Polylines and polygons
+    //
+
+    class PolygonFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        ComPtr<MockD2DPathGeometry> PathGeometry;
+        ComPtr<MockD2DGeometrySink> Sink;
+        std::vector<Vector2> Points;
+        D2D1_FIGURE_BEGIN FigureBegin;
+        D2D1_FIGURE_END FigureEnd;
+        std::vector<D2D1_POINT_2F> ReceivedPoints;
+
+        PolygonFixture()
+            : PathGeometry(Make<MockD2DPathGeometry>())
+            , Sink(Make<MockD2DGeometrySink>())
+            , FigureBegin(static_cast<D2D1_FIGURE_BEGIN>(-1))
+            , FigureEnd(static_cast<D2D1_FIGURE_END>(-1))
+        {
+            Points.push_back(Vector2{ 1, 2 });
+            Points.push_back(Vector2{ 3, 4 });
+            Points.push_back(Vector2{ 5, 2 });
+
+            DeviceContext->m_factory->MockCreatePathGeometry =
+                [this](ID2D1PathGeometry** value)
+                {
+                    return PathGeometry.CopyTo(value);
+                };
+
+            PathGeometry->MockOpen = [this](ID2D1GeometrySink** value) { ThrowIfFailed(Sink.CopyTo(value)); };
+
+            Sink->MockBeginFigure =
+                [this](D2D1_POINT_2F point, D2D1_FIGURE_BEGIN figureBegin)
+                {
+                    Assert::AreEqual(0, static_cast<int>(ReceivedPoints.size()));
+                    ReceivedPoints.push_back(point);
+                    FigureBegin = figureBegin;
+                };
+
+            Sink->MockAddLines =
+                [this](const D2D1_POINT_2F* points, UINT32 pointsCount)
+                {
+                    ReceivedPoints.insert(ReceivedPoints.end(), points, points + pointsCount);
+                };
+
+            Sink->MockEndFigure = [this](D2D1_FIGURE_END figureEnd) { FigureEnd = figureEnd; };
+            Sink->MockClose = [] { return S_OK; };
+        }
+
+        void ExpectFigure(D2D1_FIGURE_BEGIN expectedBegin, D2D1_FIGURE_END expectedEnd)
+        {
+            Assert::AreEqual(expectedBegin, FigureBegin);
+            Assert::AreEqual(expectedEnd, FigureEnd);
+
+            Assert::AreEqual(Points.size(), ReceivedPoints.size());
+            for (size_t i = 0; i < Points.size(); ++i)
+            {
+                Assert::AreEqual(Points[i].X, ReceivedPoints[i].x);
+                Assert::AreEqual(Points[i].Y, ReceivedPoints[i].y);
+            }
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_DrawPolyline_StrokesOneOpenFigure)
+    {
+        PolygonFixture f;
+
+        int drawCount = 0;
+        f.DeviceContext->MockDrawGeometry =
+            [&](ID2D1Geometry* geometry, ID2D1Brush* brush, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+            {
+                Assert::AreEqual<ID2D1Geometry*>(f.PathGeometry.Get(), geometry);
+                Assert::AreEqual<ID2D1Brush*>(f.Brush->GetD2DBrush().Get(), brush);
+                Assert::AreEqual(3.0f, strokeWidth);
+                Assert::IsNull(strokeStyle);
+                ++drawCount;
+            };
+
+        ThrowIfFailed(f.DS->DrawPolylineWithBrushAndStrokeWidth(static_cast<uint32_t>(f.Points.size()), f.Points.data(), f.Brush.Get(), 3));
+
+        Assert::AreEqual(1, drawCount);
+        f.ExpectFigure(D2D1_FIGURE_BEGIN_HOLLOW, D2D1_FIGURE_END_OPEN);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawPolygon_StrokesOneClosedFigure)
+    {
+        PolygonFixture f;
+
+        int drawCount = 0;
+        f.DeviceContext->MockDrawGeometry =
+            [&](ID2D1Geometry* geometry, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle*)
+            {
+                Assert::AreEqual<ID2D1Geometry*>(f.PathGeometry.Get(), geometry);
+                Assert::AreEqual(1.0f, strokeWidth);
+                ++drawCount;
+            };
+
+        ThrowIfFailed(f.DS->DrawPolygonWithBrush(static_cast<uint32_t>(f.Points.size()), f.Points.data(), f.Brush.Get()));
+
+        Assert::AreEqual(1, drawCount);
+        f.ExpectFigure(D2D1_FIGURE_BEGIN_HOLLOW, D2D1_FIGURE_END_CLOSED);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(1, statistics.DrawGeometryCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_FillPolygon_FillsOneClosedFigure)
+    {
+        PolygonFixture f;
+
+        int fillCount = 0;
+        f.DeviceContext->MockFillGeometry =
+            [&](ID2D1Geometry* geometry, ID2D1Brush* brush, ID2D1Brush* opacityBrush)
+            {
+                Assert::AreEqual<ID2D1Geometry*>(f.PathGeometry.Get(), geometry);
+                Assert::AreEqual<ID2D1Brush*>(f.Brush->GetD2DBrush().Get(), brush);
+                Assert::IsNull(opacityBrush);
+                ++fillCount;
+            };
+
+        ThrowIfFailed(f.DS->FillPolygonWithBrush(static_cast<uint32_t>(f.Points.size()), f.Points.data(), f.Brush.Get()));
+
+        Assert::AreEqual(1, fillCount);
+        f.ExpectFigure(D2D1_FIGURE_BEGIN_FILLED, D2D1_FIGURE_END_CLOSED);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(1, statistics.FillGeometryCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Polygons_WithNoPoints_DrawNothing)
+    {
+        CanvasDrawingSessionFixture f;
+
+        ThrowIfFailed(f.DS->DrawPolylineWithBrush(0, nullptr, f.Brush.Get()));
+        ThrowIfFailed(f.DS->DrawPolygonWithBrush(0, nullptr, f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillPolygonWithBrush(0, nullptr, f.Brush.Get()));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Polygons_NullArgs)
+    {
+        CanvasDrawingSessionFixture f;
+        Vector2 points[] = { Vector2{ 0, 0 }, Vector2{ 1, 1 } };
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawPolylineWithBrush(2, nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawPolylineWithBrush(2, points, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawPolygonWithBrush(2, nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawPolygonWithBrush(2, points, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillPolygonWithBrush(2, nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillPolygonWithBrush(2, points, nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Polygons_AreCulledUsingTheBoundsOfTheirPoints)
+    {
+        CullingFixture f;
+        Vector2 points[] = { Vector2{ 110, 10 }, Vector2{ 120, 20 }, Vector2{ 115, 30 } };
+
+        // Nothing is drawn, so no path is created
+        ThrowIfFailed(f.DS->FillPolygonWithBrush(3, points, f.Brush.Get()));
+        ThrowIfFailed(f.DS->DrawPolylineWithBrushAndStrokeWidth(3, points, f.Brush.Get(), 1));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(2, statistics.CulledDrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_PushLayer_WithOpacityAndClipGeometry)
+    {
+        ClipFixture f;
+
+        auto pathGeometry = Make<MockD2DPathGeometry>();
+        pathGeometry->MockGetBounds =
+            [](const D2D1_MATRIX_3X2_F*, D2D1_RECT_F* bounds)
+            {
+                *bounds = D2D1::RectF(0, 0, 10, 10);
+            };
+
+        auto geometry = std::make_shared<CanvasGeometryManager>()->GetOrCreate(pathGeometry.Get());
+
+        // Even at full opacity a geometry clip needs a layer
+        ThrowIfFailed(f.DS->PushLayerWithOpacityAndClipGeometry(1.0f, geometry.Get()));
+        f.ExpectCalls({ L"PushLayer" });
+        Assert::AreEqual<ID2D1Geometry*>(pathGeometry.Get(), f.PushedLayers[0].geometricMask);
+        Assert::AreEqual(1.0f, f.PushedLayers[0].opacity);
+
+        ThrowIfFailed(f.DS->PopLayer());
+        f.ExpectCalls({ L"PopLayer" });
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_CountsGeometry)
+    {
+        GeometryFixture f;
+
+        ThrowIfFailed(f.DS->DrawGeometryWithBrushAndStrokeWidth(f.Geometry.Get(), f.Brush.Get(), 5));
+        ThrowIfFailed(f.DS->FillGeometryWithBrush(f.Geometry.Get(), f.Brush.Get()));
+        ThrowIfFailed(f.DS->FillGeometryWithBrush(f.Geometry.Get(), f.Brush.Get()));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+
+        Assert::AreEqual(1, statistics.DrawGeometryCount);
+        Assert::AreEqual(2, statistics.FillGeometryCount);
+    }
+
+    //
+    // Sprites
+    //
+
+    class SpriteFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        struct DrawnSprite
+        {
+            D2D1_RECT_F DestinationRect;
+            bool HasSourceRect;
+            D2D1_RECT_F SourceRect;
+            float Opacity;
+            D2D1_MATRIX_3X2_F Transform;
+        };
+
+        ComPtr<StubCanvasBitmap> Bitmap;
+        std::vector<DrawnSprite> Drawn;
+        std::vector<D2D1_MATRIX_3X2_F> TransformsSet;
+        D2D1_MATRIX_3X2_F CurrentTransform;
+
+        SpriteFixture()
+            : Bitmap(Make<StubCanvasBitmap>(64.0f, 32.0f))
+            , CurrentTransform(D2D1::IdentityMatrix())
+        {
+            DeviceContext->MockGetTransform =
+                [this](D2D1_MATRIX_3X2_F* m)
+                {
+                    *m = CurrentTransform;
+                };
+
+            DeviceContext->MockSetTransform =
+                [this](const D2D1_MATRIX_3X2_F* m)
+                {
+                    CurrentTransform = *m;
+                    TransformsSet.push_back(*m);
+                };
+
+            DeviceContext->MockDrawBitmap =
+                [this](ID2D1Bitmap* bitmap, const D2D1_RECT_F* destinationRect, float opacity, D2D1_INTERPOLATION_MODE interpolationMode, const D2D1_RECT_F* sourceRect, const D2D1_MATRIX_4X4_F* perspectiveTransform)
+                {
+                    Assert::AreEqual<ID2D1Bitmap*>(Bitmap->GetD2DBitmap().Get(), bitmap);
+                    Assert::AreEqual(D2D1_INTERPOLATION_MODE_LINEAR, interpolationMode);
+                    Assert::IsNull(perspectiveTransform);
+
+                    DrawnSprite sprite;
+                    sprite.DestinationRect = *destinationRect;
+                    sprite.HasSourceRect = sourceRect != nullptr;
+                    sprite.SourceRect = sourceRect ? *sourceRect : D2D1_RECT_F{};
+                    sprite.Opacity = opacity;
+                    sprite.Transform = CurrentTransform;
+                    Drawn.push_back(sprite);
+                };
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_DrawSprites_ForwardsEachSprite)
+    {
+        SpriteFixture f;
+
+        Rect destinationRects[] = { Rect{ 1, 2, 3, 4 }, Rect{ 10, 20, 30, 40 } };
+        Rect sourceRects[] = { Rect{ 0, 0, 8, 8 }, Rect{ 8, 0, 8, 8 } };
+        float opacities[] = { 0.5f, 1.0f };
+
+        ThrowIfFailed(f.DS->DrawSprites(f.Bitmap.Get(), 2, destinationRects, 2, sourceRects, 2, opacities));
+
+        Assert::AreEqual<size_t>(2, f.Drawn.size());
+
+        Assert::AreEqual(D2D1::RectF(1, 2, 4, 6), f.Drawn[0].DestinationRect);
+        Assert::IsTrue(f.Drawn[0].HasSourceRect);
+        Assert::AreEqual(D2D1::RectF(0, 0, 8, 8), f.Drawn[0].SourceRect);
+        Assert::AreEqual(0.5f, f.Drawn[0].Opacity);
+
+        Assert::AreEqual(D2D1::RectF(10, 20, 40, 60), f.Drawn[1].DestinationRect);
+        Assert::AreEqual(D2D1::RectF(8, 0, 16, 8), f.Drawn[1].SourceRect);
+        Assert::AreEqual(1.0f, f.Drawn[1].Opacity);
+
+        // Untransformed sprites never touch the device transform
+        Assert::AreEqual<size_t>(0, f.TransformsSet.size());
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSprites_OptionalArraysDefaultToWholeBitmapAndFullOpacity)
+    {
+        SpriteFixture f;
+
+        Rect destinationRect{ 0, 0, 5, 5 };
+
+        ThrowIfFailed(f.DS->DrawSprites(f.Bitmap.Get(), 1, &destinationRect, 0, nullptr, 0, nullptr));
+
+        Assert::AreEqual<size_t>(1, f.Drawn.size());
+        Assert::IsFalse(f.Drawn[0].HasSourceRect);
+        Assert::AreEqual(1.0f, f.Drawn[0].Opacity);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSprites_SkipsTransparentSprites)
+    {
+        SpriteFixture f;
+
+        Rect destinationRects[] = { Rect{ 0, 0, 1, 1 }, Rect{ 1, 1, 1, 1 }, Rect{ 2, 2, 1, 1 } };
+        float opacities[] = { 0.0f, 0.25f, -1.0f };
+
+        ThrowIfFailed(f.DS->DrawSprites(f.Bitmap.Get(), 3, destinationRects, 0, nullptr, 3, opacities));
+
+        Assert::AreEqual<size_t>(1, f.Drawn.size());
+        Assert::AreEqual(D2D1::RectF(1, 1, 2, 2), f.Drawn[0].DestinationRect);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSprites_InvalidArguments)
+    {
+        SpriteFixture f;
+
+        Rect rects[] = { Rect{}, Rect{} };
+        float opacities[] = { 1, 1 };
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawSprites(nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawSprites(f.Bitmap.Get(), 1, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawSprites(f.Bitmap.Get(), 2, rects, 1, rects, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawSprites(f.Bitmap.Get(), 1, rects, 0, nullptr, 2, opacities));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawSprites(f.Bitmap.Get(), 1, rects, 1, nullptr, 0, nullptr));
+
+        Assert::AreEqual<size_t>(0, f.Drawn.size());
+
+        // An empty batch is fine
+        ThrowIfFailed(f.DS->DrawSprites(f.Bitmap.Get(), 0, nullptr, 0, nullptr, 0, nullptr));
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSpritesWithTransforms_SetsEachTransformAndRestoresOnce)
+    {
+        SpriteFixture f;
+
+        ThrowIfFailed(f.DS->Translate(100, 0));
+
+        Matrix3x2 transforms[] =
+        {
+            Matrix3x2{ 1, 0, 0, 1, 10, 20 },
+            Matrix3x2{ 2, 0, 0, 2, 0, 0 },
+        };
+        Rect sourceRects[] = { Rect{ 0, 0, 8, 4 }, Rect{ 8, 0, 8, 4 } };
+
+        ThrowIfFailed(f.DS->DrawSpritesWithTransforms(f.Bitmap.Get(), 2, transforms, 2, sourceRects, 0, nullptr));
+
+        Assert::AreEqual<size_t>(2, f.Drawn.size());
+
+        // Each sprite is drawn at the origin, sized to its source rectangle
+        Assert::AreEqual(D2D1::RectF(0, 0, 8, 4), f.Drawn[0].DestinationRect);
+        Assert::AreEqual(D2D1::RectF(0, 0, 8, 4), f.Drawn[1].DestinationRect);
+
+        // The sprite transform is applied before the session transform
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::Matrix3x2F::Translation(110, 20), f.Drawn[0].Transform);
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::Matrix3x2F(2, 0, 0, 2, 100, 0), f.Drawn[1].Transform);
+
+        // Pending translate + one per sprite + a single restore
+        Assert::AreEqual<size_t>(4, f.TransformsSet.size());
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::Matrix3x2F::Translation(100, 0), f.CurrentTransform);
+
+        // Every transform set counts as a state change
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(4, statistics.StateChangeCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSpritesWithTransforms_WhenDrawingFails_RestoresTheTransform)
+    {
+        SpriteFixture f;
+
+        ThrowIfFailed(f.DS->Translate(100, 0));
+
+        int drawCount = 0;
+        f.DeviceContext->MockDrawBitmap =
+            [&](ID2D1Bitmap*, const D2D1_RECT_F*, float, D2D1_INTERPOLATION_MODE, const D2D1_RECT_F*, const D2D1_MATRIX_4X4_F*)
+            {
+                if (++drawCount == 2)
+                    ThrowHR(E_FAIL);
+            };
+
+        Matrix3x2 transforms[] =
+        {
+            Matrix3x2{ 1, 0, 0, 1, 10, 20 },
+            Matrix3x2{ 2, 0, 0, 2, 0, 0 },
+            Matrix3x2{ 3, 0, 0, 3, 0, 0 },
+        };
+
+        Assert::AreEqual(E_FAIL, f.DS->DrawSpritesWithTransforms(f.Bitmap.Get(), 3, transforms, 0, nullptr, 0, nullptr));
+
+        Assert::AreEqual(2, drawCount);
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::Matrix3x2F::Translation(100, 0), f.CurrentTransform);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(4, statistics.StateChangeCount);
+        Assert::AreEqual(1, statistics.DrawSpriteCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSpritesWithTransforms_WithoutSourceRects_DrawsWholeBitmap)
+    {
+        SpriteFixture f;
+
+        Matrix3x2 transform{ 1, 0, 0, 1, 0, 0 };
+
+        ThrowIfFailed(f.DS->DrawSpritesWithTransforms(f.Bitmap.Get(), 1, &transform, 0, nullptr, 0, nullptr));
+
+        Assert::AreEqual<size_t>(1, f.Drawn.size());
+        Assert::AreEqual(D2D1::RectF(0, 0, 64, 32), f.Drawn[0].DestinationRect);
+        Assert::IsFalse(f.Drawn[0].HasSourceRect);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_DrawSprites_CullsSpritesOutsideTheTarget)
+    {
+        CullingFixture f;
+
+        auto bitmap = Make<StubCanvasBitmap>(10.0f, 10.0f);
+        f.DeviceContext->MockDrawBitmap =
+            [&](ID2D1Bitmap*, const D2D1_RECT_F*, float, D2D1_INTERPOLATION_MODE, const D2D1_RECT_F*, const D2D1_MATRIX_4X4_F*)
+            {
+                ++f.DrawCount;
+            };
+
+        Rect destinationRects[] = { Rect{ 10, 10, 10, 10 }, Rect{ 500, 10, 10, 10 } };
+        ThrowIfFailed(f.DS->DrawSprites(bitmap.Get(), 2, destinationRects, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(1, f.DrawCount);
+
+        f.DrawCount = 0;
+        Matrix3x2 transforms[] = { Matrix3x2{ 1, 0, 0, 1, 500, 0 }, Matrix3x2{ 1, 0, 0, 1, 50, 50 } };
+        ThrowIfFailed(f.DS->DrawSpritesWithTransforms(bitmap.Get(), 2, transforms, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(1, f.DrawCount);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(2, statistics.CulledDrawCount);
+        Assert::AreEqual(2, statistics.DrawSpriteCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Statistics_CountsSprites)
+    {
+        SpriteFixture f;
+
+        Rect destinationRects[] = { Rect{}, Rect{}, Rect{} };
+        ThrowIfFailed(f.DS->DrawSprites(f.Bitmap.Get(), 3, destinationRects, 0, nullptr, 0, nullptr));
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+
+        Assert::AreEqual(3, statistics.DrawSpriteCount);
+        Assert::AreEqual(0, statistics.DrawImageCount);
+    }
+
     TEST_METHOD(CanvasDrawingSession_get_Device)
     {
         //
@@ -1802,24 +3750,33 @@ TEST_CLASS(CanvasDrawingSession_DrawTextTests)
         template<typename FORMAT_VALIDATOR>
         void ExpectOnce(std::wstring expectedText, D2D1_RECT_F expectedRect, D2D1_DRAW_TEXT_OPTIONS expectedOptions, FORMAT_VALIDATOR&& formatValidator)
         {            
-            DeviceContext->MockDrawText =
-                [=](const wchar_t* actualText,
-                    uint32_t actualTextLength,
-                    IDWriteTextFormat* format,
-                    D2D1_RECT_F actualRect,
+            DeviceContext->MockDrawTextLayout =
+                [=](D2D1_POINT_2F actualOrigin,
+                    IDWriteTextLayout* layout,
                     ID2D1Brush* actualBrush,
-                    D2D1_DRAW_TEXT_OPTIONS actualOptions,
-                    DWRITE_MEASURING_MODE)
+                    D2D1_DRAW_TEXT_OPTIONS actualOptions)
                 {
                     m_drawTextCount++;
 
-                    Assert::AreEqual(expectedText.c_str(), actualText);
-                    Assert::AreEqual<uint32_t>(expectedText.size(), actualTextLength);
-                    Assert::IsNotNull(format);
-                    Assert::AreEqual(expectedRect, actualRect);
+                    Assert::IsNotNull(layout);
+                    Assert::AreEqual(D2D1_POINT_2F{ expectedRect.left, expectedRect.top }, actualOrigin);
+                    Assert::AreEqual(expectedRect.right - expectedRect.left, layout->GetMaxWidth());
+                    Assert::AreEqual(expectedRect.bottom - expectedRect.top, layout->GetMaxHeight());
                     Assert::AreEqual(expectedOptions, actualOptions);
 
-                    formatValidator(format, actualBrush);
+                    // The text itself isn't retrievable from the layout, but
+                    // the line metrics tell us how much text was laid out.
+                    uint32_t lineCount = 0;
+                    Assert::AreEqual(E_NOT_SUFFICIENT_BUFFER, layout->GetLineMetrics(nullptr, 0, &lineCount));
+                    std::vector<DWRITE_LINE_METRICS> lineMetrics(lineCount);
+                    ThrowIfFailed(layout->GetLineMetrics(&lineMetrics.front(), lineCount, &lineCount));
+
+                    uint32_t actualTextLength = 0;
+                    for (auto& line : lineMetrics)
+                        actualTextLength += line.length;
+                    Assert::AreEqual<uint32_t>(expectedText.size(), actualTextLength);
+
+                    formatValidator(layout, actualBrush);
                 };
         }
 
@@ -2057,6 +4014,51 @@ TEST_CLASS(CanvasDrawingSession_DrawTextTests)
             ThrowIfFailed(f.DS->DrawTextAtRectCoordsWithColorAndFormat(text, 1, 2, 3, 4, ArbitraryMarkerColor2, nullptr));
         });
     }
+
+    TEST_METHOD(CanvasDrawingSession_DrawText_ReusesCachedTextLayouts)
+    {
+        Fixture f;
+
+        std::vector<IDWriteTextLayout*> layouts;
+        f.DeviceContext->MockDrawTextLayout =
+            [&](D2D1_POINT_2F, IDWriteTextLayout* layout, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS)
+            {
+                layouts.push_back(layout);
+            };
+
+        WinString text(L"label");
+        WinString otherText(L"other label");
+
+        ThrowIfFailed(f.DS->DrawTextAtRectWithBrushAndFormat(text, Rect{ 1, 2, 3, 4 }, f.Brush.Get(), f.Format.Get()));
+        ThrowIfFailed(f.DS->DrawTextAtRectWithBrushAndFormat(text, Rect{ 1, 2, 3, 4 }, f.Brush.Get(), f.Format.Get()));
+
+        // Moving the rectangle doesn't require a new layout
+        ThrowIfFailed(f.DS->DrawTextAtRectWithBrushAndFormat(text, Rect{ 5, 6, 3, 4 }, f.Brush.Get(), f.Format.Get()));
+
+        // Different text, layout box, word wrapping or format all do
+        ThrowIfFailed(f.DS->DrawTextAtRectWithBrushAndFormat(otherText, Rect{ 1, 2, 3, 4 }, f.Brush.Get(), f.Format.Get()));
+        ThrowIfFailed(f.DS->DrawTextAtRectWithBrushAndFormat(text, Rect{ 1, 2, 7, 8 }, f.Brush.Get(), f.Format.Get()));
+        ThrowIfFailed(f.DS->DrawTextAtPointWithBrushAndFormat(text, Vector2{ 1, 2 }, f.Brush.Get(), f.Format.Get()));
+        ThrowIfFailed(f.Format->put_ParagraphAlignment(ABI::Windows::UI::Text::ParagraphAlignment_Right));
+        ThrowIfFailed(f.DS->DrawTextAtRectWithBrushAndFormat(text, Rect{ 1, 2, 3, 4 }, f.Brush.Get(), f.Format.Get()));
+
+        Assert::AreEqual<size_t>(7, layouts.size());
+        Assert::AreEqual(layouts[0], layouts[1]);
+        Assert::AreEqual(layouts[0], layouts[2]);
+
+        for (size_t i = 3; i < layouts.size(); ++i)
+        {
+            for (size_t j = 0; j < i; ++j)
+            {
+                if (j != 1 && j != 2)
+                    Assert::AreNotEqual(layouts[j], layouts[i]);
+            }
+        }
+
+        auto& cache = f.DS->Manager()->GetTextLayoutCache();
+        Assert::AreEqual<uint64_t>(2, cache->GetHitCount());
+        Assert::AreEqual<uint64_t>(5, cache->GetMissCount());
+    }
 };
 
 
@@ -2125,6 +4127,9 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawImageAtCoords(nullptr, 0, 0));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawImageAtOrigin(nullptr));
 
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawSprites(nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawSpritesWithTransforms(nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLineWithBrush(Vector2{}, Vector2{}, nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLineAtCoordsWithBrush(0, 0, 0, 0, nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLineWithColor(Vector2{}, Vector2{}, Color{}));
@@ -2210,6 +4215,33 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillCircleWithColor(Vector2{}, 0, Color{}));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillCircleAtCoordsWithColor(0, 0, 0, Color{}));
 
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGeometryWithBrush(nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGeometryWithColor(nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGeometryWithBrushAndStrokeWidth(nullptr, nullptr, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGeometryWithColorAndStrokeWidth(nullptr, Color{}, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle(nullptr, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGeometryWithColorAndStrokeWidthAndStrokeStyle(nullptr, Color{}, 0, nullptr));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillGeometryWithBrush(nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillGeometryWithColor(nullptr, Color{}));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithBrush(0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithColor(0, nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithBrushAndStrokeWidth(0, nullptr, nullptr, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithColorAndStrokeWidth(0, nullptr, Color{}, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(0, nullptr, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(0, nullptr, Color{}, 0, nullptr));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolygonWithBrush(0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolygonWithColor(0, nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolygonWithBrushAndStrokeWidth(0, nullptr, nullptr, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolygonWithColorAndStrokeWidth(0, nullptr, Color{}, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle(0, nullptr, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolygonWithColorAndStrokeWidthAndStrokeStyle(0, nullptr, Color{}, 0, nullptr));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillPolygonWithBrush(0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillPolygonWithColor(0, nullptr, Color{}));
+
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextAtPointWithColor(nullptr, Vector2{}, Color{}));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextAtPointCoordsWithColor(nullptr, 0, 0, Color{}));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextAtPointWithBrushAndFormat(nullptr, Vector2{}, nullptr, nullptr));
@@ -2220,6 +4252,12 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextAtRectWithColorAndFormat(nullptr, Rect{}, Color{}, nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextAtPointCoordsWithColorAndFormat(nullptr, 0, 0, Color{}, nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextAtRectCoordsWithColorAndFormat(nullptr, 0, 0, 0, 0, Color{}, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextLayoutWithBrush(nullptr, Vector2{}, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextLayoutWithColor(nullptr, Vector2{}, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextBatch(0, nullptr, 0, nullptr, 0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextBatchFromBuffer(nullptr, 0, nullptr, 0, nullptr, 0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextDocumentWithBrush(nullptr, Rect{}, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawTextDocumentWithColor(nullptr, Rect{}, 0, Color{}));
 
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_Antialiasing(nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_Antialiasing(CanvasAntialiasing::Aliased));
@@ -2233,6 +4271,31 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_Units(CanvasUnits::Dips));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_Device(&deviceVerify));
 
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushTransform(Numerics::Matrix3x2()));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PopTransform());
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->Translate(0, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->Scale(0, 0));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->Rotate(0));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushClipRectangle(Rect{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PopClip());
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushLayerWithOpacity(1));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushLayerWithOpacityAndClipRectangle(1, Rect{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushLayerWithOpacityBrush(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushLayerWithOpacityBrushAndClipRectangle(nullptr, Rect{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PushLayerWithOpacityAndClipGeometry(1, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->PopLayer());
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_IsCullingEnabled(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_IsCullingEnabled(true));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_IsBatchingEnabled(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_IsBatchingEnabled(true));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_IsPixelAlignedAliasingEnabled(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_IsPixelAlignedAliasingEnabled(true));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_IsTracingEnabled(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_IsTracingEnabled(true));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->GetTrace(nullptr, nullptr));
+
 
 #undef EXPECT_OBJECT_CLOSED
     }
@@ -2242,6 +4305,7 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         CanvasDrawingSessionFixture f;
 
         ASSERT_IMPLEMENTS_INTERFACE(f.DS, ICanvasResourceCreator);
+        ASSERT_IMPLEMENTS_INTERFACE(f.DS, ICanvasDrawingSessionStatistics);
     }
 
     TEST_METHOD(CanvasDrawingSession_get_Device_NullArg)
@@ -2284,3 +4348,149 @@ TEST_CLASS(CanvasDrawingSession_Interop)
     }
 
 };
+
+TEST_CLASS(CanvasDrawingSession_ReuseTests)
+{
+    class CountingAdapter : public StubCanvasDrawingSessionAdapter
+    {
+    public:
+        int EndDrawCount;
+
+        CountingAdapter()
+            : EndDrawCount(0)
+        {}
+
+        virtual void EndDraw() override
+        {
+            ++EndDrawCount;
+        }
+    };
+
+    class Fixture
+    {
+    public:
+        std::shared_ptr<CanvasDrawingSessionManager> Manager;
+        ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+        std::shared_ptr<CountingAdapter> Adapter;
+        ComPtr<CanvasDrawingSession> DS;
+
+        Fixture()
+            : Manager(std::make_shared<CanvasDrawingSessionManager>())
+            , DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+            , Adapter(std::make_shared<CountingAdapter>())
+        {
+            DS = Manager->Create(DeviceContext.Get(), Adapter);
+            DeviceContext->MockClear = [](const D2D1_COLOR_F*) {};
+        }
+    };
+
+    TEST_METHOD(CanvasDrawingSession_CloseForReuse_EndsDrawing_AndBehavesAsClosed)
+    {
+        Fixture f;
+
+        f.DS->CloseForReuse();
+        Assert::AreEqual(1, f.Adapter->EndDrawCount);
+
+        Assert::AreEqual(RO_E_CLOSED, f.DS->Clear(Color{}));
+
+        // Closing it again doesn't end drawing again
+        ThrowIfFailed(f.DS->Close());
+        Assert::AreEqual(1, f.Adapter->EndDrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Reopen_WithSameDeviceContext_KeepsTheSameWrapper)
+    {
+        Fixture f;
+
+        f.DS->CloseForReuse();
+
+        auto newAdapter = std::make_shared<CountingAdapter>();
+        f.DS->Reopen(f.DeviceContext.Get(), newAdapter);
+
+        Assert::AreEqual<void*>(f.DS.Get(), f.Manager->GetOrCreate(f.DeviceContext.Get()).Get());
+        ThrowIfFailed(f.DS->Clear(Color{}));
+
+        ThrowIfFailed(f.DS->Close());
+        Assert::AreEqual(1, f.Adapter->EndDrawCount);
+        Assert::AreEqual(1, newAdapter->EndDrawCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_CloseForReuse_UnregistersTheWrapper_UntilItIsReopened)
+    {
+        Fixture f;
+
+        f.DS->CloseForReuse();
+
+        // Until it is reopened, another session can use the device context
+        auto otherAdapter = std::make_shared<CountingAdapter>();
+        auto otherDS = f.Manager->Create(f.DeviceContext.Get(), otherAdapter);
+        Assert::AreEqual<void*>(otherDS.Get(), f.Manager->GetOrCreate(f.DeviceContext.Get()).Get());
+        ThrowIfFailed(otherDS->Close());
+
+        f.DS->Reopen(f.DeviceContext.Get(), std::make_shared<CountingAdapter>());
+        Assert::AreEqual<void*>(f.DS.Get(), f.Manager->GetOrCreate(f.DeviceContext.Get()).Get());
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Reopen_WithDifferentDeviceContext_MovesTheWrapper)
+    {
+        Fixture f;
+
+        f.DS->CloseForReuse();
+
+        auto newDeviceContext = Make<StubD2DDeviceContextWithGetFactory>();
+        f.DS->Reopen(newDeviceContext.Get(), std::make_shared<CountingAdapter>());
+
+        Assert::AreEqual<void*>(f.DS.Get(), f.Manager->GetOrCreate(newDeviceContext.Get()).Get());
+        Assert::AreNotEqual<void*>(f.DS.Get(), f.Manager->GetOrCreate(f.DeviceContext.Get()).Get());
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Reopen_AfterClose_RegistersTheWrapperAgain)
+    {
+        Fixture f;
+
+        ThrowIfFailed(f.DS->Close());
+        f.DS->Reopen(f.DeviceContext.Get(), std::make_shared<CountingAdapter>());
+
+        Assert::AreEqual<void*>(f.DS.Get(), f.Manager->GetOrCreate(f.DeviceContext.Get()).Get());
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Close_AfterCloseForReuse_UnregistersTheWrapper)
+    {
+        Fixture f;
+
+        f.DS->CloseForReuse();
+        ThrowIfFailed(f.DS->Close());
+
+        Assert::AreNotEqual<void*>(f.DS.Get(), f.Manager->GetOrCreate(f.DeviceContext.Get()).Get());
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Reopen_StartsPerSessionStateOver)
+    {
+        Fixture f;
+
+        ThrowIfFailed(f.DS->put_IsCullingEnabled(true));
+        ThrowIfFailed(f.DS->Clear(Color{}));
+
+        f.DS->CloseForReuse();
+        f.DS->Reopen(f.DeviceContext.Get(), std::make_shared<CountingAdapter>());
+
+        boolean isCullingEnabled;
+        ThrowIfFailed(f.DS->get_IsCullingEnabled(&isCullingEnabled));
+        Assert::IsFalse(!!isCullingEnabled);
+
+        CanvasDrawingSessionStatistics statistics;
+        ThrowIfFailed(f.DS->get_Statistics(&statistics));
+        Assert::AreEqual(0, statistics.ClearCount);
+    }
+
+    TEST_METHOD(CanvasDrawingSession_Reopen_WhileOpen_Fails)
+    {
+        Fixture f;
+
+        Assert::ExpectException<HResultException>(
+            [&] { f.DS->Reopen(f.DeviceContext.Get(), std::make_shared<CountingAdapter>()); });
+
+        Assert::ExpectException<InvalidArgException>(
+            [&] { f.DS->Reopen(nullptr, std::make_shared<CountingAdapter>()); });
+    }
+};
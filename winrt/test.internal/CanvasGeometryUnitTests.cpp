@@ -0,0 +1,470 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+TEST_CLASS(CanvasPathBuilderUnitTests)
+{
+    class Fixture
+    {
+    public:
+        ComPtr<MockD2DPathGeometry> PathGeometry;
+        ComPtr<MockD2DGeometrySink> GeometrySink;
+        ComPtr<StubCanvasDevice> Device;
+        ComPtr<CanvasPathBuilder> PathBuilder;
+
+        Fixture()
+            : PathGeometry(Make<MockD2DPathGeometry>())
+            , GeometrySink(Make<MockD2DGeometrySink>())
+            , Device(Make<StubCanvasDevice>())
+        {
+            PathGeometry->MockOpen =
+                [=](ID2D1GeometrySink** sink)
+                {
+                    ThrowIfFailed(GeometrySink.CopyTo(sink));
+                };
+
+            Device->MockCreatePathGeometry =
+                [=]
+                {
+                    return PathGeometry;
+                };
+
+            GeometrySink->MockBeginFigure = [](D2D1_POINT_2F, D2D1_FIGURE_BEGIN) {};
+            GeometrySink->MockEndFigure = [](D2D1_FIGURE_END) {};
+            GeometrySink->MockClose = [] { return S_OK; };
+
+            PathBuilder = Make<CanvasPathBuilder>(Device.Get());
+        }
+    };
+
+    TEST_METHOD(CanvasPathBuilder_Implements_Expected_Interfaces)
+    {
+        Fixture f;
+
+        ASSERT_IMPLEMENTS_INTERFACE(f.PathBuilder, ICanvasPathBuilder);
+        ASSERT_IMPLEMENTS_INTERFACE(f.PathBuilder, ABI::Windows::Foundation::IClosable);
+        ASSERT_IMPLEMENTS_INTERFACE(f.PathBuilder, ICanvasPathBuilderInternal);
+    }
+
+    TEST_METHOD(CanvasPathBuilder_ForwardsFiguresToTheGeometrySink)
+    {
+        Fixture f;
+
+        std::vector<std::wstring> calls;
+
+        f.GeometrySink->MockSetFillMode =
+            [&](D2D1_FILL_MODE fillMode)
+            {
+                Assert::AreEqual(D2D1_FILL_MODE_WINDING, fillMode);
+                calls.push_back(L"SetFillMode");
+            };
+
+        f.GeometrySink->MockBeginFigure =
+            [&](D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN figureBegin)
+            {
+                Assert::AreEqual(D2D1::Point2F(1, 2), startPoint);
+                Assert::AreEqual(D2D1_FIGURE_BEGIN_FILLED, figureBegin);
+                calls.push_back(L"BeginFigure");
+            };
+
+        f.GeometrySink->MockAddLine =
+            [&](D2D1_POINT_2F point)
+            {
+                Assert::AreEqual(D2D1::Point2F(3, 4), point);
+                calls.push_back(L"AddLine");
+            };
+
+        f.GeometrySink->MockAddQuadraticBezier =
+            [&](const D2D1_QUADRATIC_BEZIER_SEGMENT* bezier)
+            {
+                Assert::AreEqual(D2D1::Point2F(5, 6), bezier->point1);
+                Assert::AreEqual(D2D1::Point2F(7, 8), bezier->point2);
+                calls.push_back(L"AddQuadraticBezier");
+            };
+
+        f.GeometrySink->MockAddBezier =
+            [&](const D2D1_BEZIER_SEGMENT* bezier)
+            {
+                Assert::AreEqual(D2D1::Point2F(9, 10), bezier->point1);
+                Assert::AreEqual(D2D1::Point2F(11, 12), bezier->point2);
+                Assert::AreEqual(D2D1::Point2F(13, 14), bezier->point3);
+                calls.push_back(L"AddBezier");
+            };
+
+        f.GeometrySink->MockAddArc =
+            [&](const D2D1_ARC_SEGMENT* arc)
+            {
+                Assert::AreEqual(D2D1::Point2F(15, 16), arc->point);
+                Assert::AreEqual(D2D1::SizeF(17, 18), arc->size);
+                Assert::AreEqual(90.0f, arc->rotationAngle, 0.001f);
+                Assert::AreEqual(D2D1_SWEEP_DIRECTION_CLOCKWISE, arc->sweepDirection);
+                Assert::AreEqual(D2D1_ARC_SIZE_LARGE, arc->arcSize);
+                calls.push_back(L"AddArc");
+            };
+
+        f.GeometrySink->MockEndFigure =
+            [&](D2D1_FIGURE_END figureEnd)
+            {
+                Assert::AreEqual(D2D1_FIGURE_END_CLOSED, figureEnd);
+                calls.push_back(L"EndFigure");
+            };
+
+        ThrowIfFailed(f.PathBuilder->SetFilledRegionDetermination(CanvasFilledRegionDetermination::Winding));
+        ThrowIfFailed(f.PathBuilder->BeginFigure(Vector2{ 1, 2 }));
+        ThrowIfFailed(f.PathBuilder->AddLine(Vector2{ 3, 4 }));
+        ThrowIfFailed(f.PathBuilder->AddQuadraticBezier(Vector2{ 5, 6 }, Vector2{ 7, 8 }));
+        ThrowIfFailed(f.PathBuilder->AddCubicBezier(Vector2{ 9, 10 }, Vector2{ 11, 12 }, Vector2{ 13, 14 }));
+        ThrowIfFailed(f.PathBuilder->AddArc(Vector2{ 15, 16 }, 17, 18, 3.14159265f / 2, CanvasSweepDirection::Clockwise, CanvasArcSize::Large));
+        ThrowIfFailed(f.PathBuilder->EndFigure(CanvasFigureLoop::Closed));
+
+        std::vector<std::wstring> expected{ L"SetFillMode", L"BeginFigure", L"AddLine", L"AddQuadraticBezier", L"AddBezier", L"AddArc", L"EndFigure" };
+        Assert::AreEqual(expected.size(), calls.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            Assert::AreEqual(expected[i], calls[i]);
+        }
+    }
+
+    TEST_METHOD(CanvasPathBuilder_FiguresMustBeBalanced)
+    {
+        Fixture f;
+
+        f.GeometrySink->MockAddLine = [](D2D1_POINT_2F) {};
+
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, f.PathBuilder->AddLine(Vector2{}));
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, f.PathBuilder->EndFigure(CanvasFigureLoop::Open));
+
+        ThrowIfFailed(f.PathBuilder->BeginFigure(Vector2{}));
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, f.PathBuilder->BeginFigure(Vector2{}));
+        ThrowIfFailed(f.PathBuilder->AddLine(Vector2{}));
+        ThrowIfFailed(f.PathBuilder->EndFigure(CanvasFigureLoop::Open));
+
+        // The path can't be used while a figure is still open
+        ThrowIfFailed(f.PathBuilder->BeginFigure(Vector2{}));
+        Assert::ExpectException<HResultException>([&] { f.PathBuilder->CloseAndReturnPath(); });
+    }
+
+    TEST_METHOD(CanvasPathBuilder_FilledRegionDetermination_MustPrecedeFigures)
+    {
+        Fixture f;
+
+        f.GeometrySink->MockSetFillMode = [](D2D1_FILL_MODE) {};
+
+        ThrowIfFailed(f.PathBuilder->BeginFigure(Vector2{}));
+        ThrowIfFailed(f.PathBuilder->EndFigure(CanvasFigureLoop::Open));
+
+        Assert::AreEqual(E_ILLEGAL_METHOD_CALL, f.PathBuilder->SetFilledRegionDetermination(CanvasFilledRegionDetermination::Winding));
+    }
+
+    TEST_METHOD(CanvasPathBuilder_Closed)
+    {
+        Fixture f;
+
+        ThrowIfFailed(f.PathBuilder->Close());
+
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->BeginFigure(Vector2{}));
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->AddLine(Vector2{}));
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->AddQuadraticBezier(Vector2{}, Vector2{}));
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->AddCubicBezier(Vector2{}, Vector2{}, Vector2{}));
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->AddArc(Vector2{}, 0, 0, 0, CanvasSweepDirection::Clockwise, CanvasArcSize::Small));
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->EndFigure(CanvasFigureLoop::Open));
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->SetFilledRegionDetermination(CanvasFilledRegionDetermination::Alternate));
+
+        // Closing twice is fine
+        ThrowIfFailed(f.PathBuilder->Close());
+    }
+
+    TEST_METHOD(CanvasGeometry_CreatePath_ClosesThePathBuilder)
+    {
+        Fixture f;
+
+        bool sinkClosed = false;
+        f.GeometrySink->MockClose = [&] { sinkClosed = true; return S_OK; };
+
+        auto manager = std::make_shared<CanvasGeometryManager>();
+        auto geometry = manager->Create(f.PathBuilder.Get());
+
+        Assert::IsTrue(sinkClosed);
+        Assert::AreEqual<ID2D1Geometry*>(f.PathGeometry.Get(), geometry->GetD2DGeometry().Get());
+
+        Assert::AreEqual(RO_E_CLOSED, f.PathBuilder->BeginFigure(Vector2{}));
+        Assert::ExpectException<ObjectDisposedException>([&] { manager->Create(f.PathBuilder.Get()); });
+    }
+};
+
+
+TEST_CLASS(CanvasGeometryUnitTests)
+{
+    class Fixture
+    {
+    public:
+        ComPtr<MockD2DPathGeometry> PathGeometry;
+        ComPtr<CanvasGeometry> Geometry;
+        ComPtr<MockD2DDeviceContext> DeviceContext;
+        ComPtr<ID2D1Device> D2DDevice;
+        D2D1_MATRIX_3X2_F Transform;
+        float Dpi;
+        int FilledRealizationCount;
+        int StrokedRealizationCount;
+
+        Fixture()
+            : PathGeometry(Make<MockD2DPathGeometry>())
+            , DeviceContext(Make<MockD2DDeviceContext>())
+            , D2DDevice(Make<MockD2DDevice>())
+            , Transform(D2D1::IdentityMatrix())
+            , Dpi(DEFAULT_DPI)
+            , FilledRealizationCount(0)
+            , StrokedRealizationCount(0)
+        {
+            Geometry = std::make_shared<CanvasGeometryManager>()->GetOrCreate(PathGeometry.Get());
+
+            DeviceContext->MockGetTransform = [=](D2D1_MATRIX_3X2_F* m) { *m = Transform; };
+            DeviceContext->MockGetDpi = [=](float* dpiX, float* dpiY) { *dpiX = *dpiY = Dpi; };
+            DeviceContext->MockGetDevice = [=](ID2D1Device** device) { D2DDevice.CopyTo(device); };
+
+            DeviceContext->MockCreateFilledGeometryRealization =
+                [=](ID2D1Geometry* geometry, float, ID2D1GeometryRealization** realization)
+                {
+                    Assert::AreEqual<ID2D1Geometry*>(PathGeometry.Get(), geometry);
+                    ++FilledRealizationCount;
+                    return Make<MockD2DGeometryRealization>().CopyTo(realization);
+                };
+
+            DeviceContext->MockCreateStrokedGeometryRealization =
+                [=](ID2D1Geometry* geometry, float, float, ID2D1StrokeStyle*, ID2D1GeometryRealization** realization)
+                {
+                    Assert::AreEqual<ID2D1Geometry*>(PathGeometry.Get(), geometry);
+                    ++StrokedRealizationCount;
+                    return Make<MockD2DGeometryRealization>().CopyTo(realization);
+                };
+        }
+
+        ComPtr<ID2D1GeometryRealization> Fill()
+        {
+            return Geometry->GetRealization(DeviceContext.Get(), false, 0, nullptr);
+        }
+
+        ComPtr<ID2D1GeometryRealization> Stroke(float strokeWidth, ID2D1StrokeStyle1* strokeStyle = nullptr)
+        {
+            return Geometry->GetRealization(DeviceContext.Get(), true, strokeWidth, strokeStyle);
+        }
+    };
+
+    TEST_METHOD(CanvasGeometry_Implements_Expected_Interfaces)
+    {
+        Fixture f;
+
+        ASSERT_IMPLEMENTS_INTERFACE(f.Geometry, ICanvasGeometry);
+        ASSERT_IMPLEMENTS_INTERFACE(f.Geometry, ABI::Windows::Foundation::IClosable);
+        ASSERT_IMPLEMENTS_INTERFACE(f.Geometry, ICanvasResourceWrapperNative);
+        ASSERT_IMPLEMENTS_INTERFACE(f.Geometry, ICanvasGeometryInternal);
+    }
+
+    TEST_METHOD(CanvasGeometry_ComputeBounds_IsOnlyCalculatedOnce)
+    {
+        Fixture f;
+
+        int getBoundsCount = 0;
+        f.PathGeometry->MockGetBounds =
+            [&](const D2D1_MATRIX_3X2_F* worldTransform, D2D1_RECT_F* bounds)
+            {
+                Assert::IsNull(worldTransform);
+                *bounds = D2D1::RectF(1, 2, 4, 6);
+                ++getBoundsCount;
+            };
+
+        Rect bounds;
+        ThrowIfFailed(f.Geometry->ComputeBounds(&bounds));
+        ThrowIfFailed(f.Geometry->ComputeBounds(&bounds));
+
+        Assert::AreEqual(Rect{ 1, 2, 3, 4 }, bounds);
+        Assert::AreEqual(1, getBoundsCount);
+
+        Assert::AreEqual(E_INVALIDARG, f.Geometry->ComputeBounds(nullptr));
+    }
+
+    TEST_METHOD(CanvasGeometry_Closed)
+    {
+        Fixture f;
+
+        ThrowIfFailed(f.Geometry->Close());
+
+        Rect bounds;
+        Assert::AreEqual(RO_E_CLOSED, f.Geometry->ComputeBounds(&bounds));
+    }
+
+    TEST_METHOD(CanvasGeometry_GetScaleBucket)
+    {
+        auto bucket = [](D2D1_MATRIX_3X2_F const& m, float dpi)
+        {
+            return CanvasGeometryRealizationCache::GetScaleBucket(m, dpi, dpi);
+        };
+
+        Assert::AreEqual(1.0f, bucket(D2D1::IdentityMatrix(), DEFAULT_DPI));
+        Assert::AreEqual(1.0f, bucket(D2D1::Matrix3x2F::Translation(100, 100), DEFAULT_DPI));
+        Assert::AreEqual(2.0f, bucket(D2D1::IdentityMatrix(), DEFAULT_DPI * 1.5f));
+        Assert::AreEqual(2.0f, bucket(D2D1::Matrix3x2F::Scale(1.1f, 1.1f), DEFAULT_DPI));
+        Assert::AreEqual(2.0f, bucket(D2D1::Matrix3x2F::Scale(2.0f, 2.0f), DEFAULT_DPI));
+        Assert::AreEqual(4.0f, bucket(D2D1::Matrix3x2F::Scale(1, 3), DEFAULT_DPI));
+        Assert::AreEqual(0.5f, bucket(D2D1::Matrix3x2F::Scale(0.4f, 0.4f), DEFAULT_DPI));
+
+        // Rotation doesn't change the scale
+        Assert::AreEqual(1.0f, bucket(D2D1::Matrix3x2F::Rotation(45), DEFAULT_DPI));
+
+        // Degenerate transforms use the smallest bucket
+        Assert::AreEqual(1.0f / 64, bucket(D2D1::Matrix3x2F::Scale(0, 0), DEFAULT_DPI));
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_IsCreatedOnSecondUseAndThenReused)
+    {
+        Fixture f;
+
+        Assert::IsNull(f.Fill().Get());
+        Assert::AreEqual(0, f.FilledRealizationCount);
+
+        auto realization = f.Fill();
+        Assert::IsNotNull(realization.Get());
+        Assert::AreEqual(1, f.FilledRealizationCount);
+
+        Assert::AreEqual(realization.Get(), f.Fill().Get());
+        Assert::AreEqual(1, f.FilledRealizationCount);
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_SmallScaleChangesShareARealization)
+    {
+        Fixture f;
+
+        f.Transform = D2D1::Matrix3x2F::Scale(1.2f, 1.2f);
+        f.Fill();
+        auto realization = f.Fill();
+
+        f.Transform = D2D1::Matrix3x2F::Scale(1.9f, 1.9f) * D2D1::Matrix3x2F::Translation(10, 10);
+        Assert::AreEqual(realization.Get(), f.Fill().Get());
+
+        f.Transform = D2D1::Matrix3x2F::Scale(2.1f, 2.1f);
+        Assert::IsNull(f.Fill().Get());
+
+        f.Transform = D2D1::IdentityMatrix();
+        f.Dpi = DEFAULT_DPI * 2;
+        Assert::AreEqual(realization.Get(), f.Fill().Get());
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_FlatteningToleranceFollowsTheScale)
+    {
+        Fixture f;
+
+        float tolerance = 0;
+        f.DeviceContext->MockCreateFilledGeometryRealization =
+            [&](ID2D1Geometry*, float flatteningTolerance, ID2D1GeometryRealization** realization)
+            {
+                tolerance = flatteningTolerance;
+                return Make<MockD2DGeometryRealization>().CopyTo(realization);
+            };
+
+        f.Transform = D2D1::Matrix3x2F::Scale(3, 3);
+        f.Fill();
+        f.Fill();
+
+        Assert::AreEqual(D2D1_DEFAULT_FLATTENING_TOLERANCE / 4, tolerance);
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_StrokesAreKeyedByWidthAndStyle)
+    {
+        Fixture f;
+
+        auto strokeStyle = Make<MockD2DStrokeStyle>();
+        strokeStyle->MockGetStrokeTransformType = [] { return D2D1_STROKE_TRANSFORM_TYPE_NORMAL; };
+
+        f.Stroke(1);
+        auto realization = f.Stroke(1);
+        Assert::IsNotNull(realization.Get());
+
+        Assert::IsNull(f.Stroke(2).Get());
+        Assert::IsNull(f.Stroke(1, strokeStyle.Get()).Get());
+        Assert::IsNull(f.Fill().Get());
+
+        Assert::AreEqual(realization.Get(), f.Stroke(1).Get());
+        Assert::AreEqual(1, f.StrokedRealizationCount);
+        Assert::AreEqual(0, f.FilledRealizationCount);
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_IsKeyedByDevice)
+    {
+        Fixture f;
+
+        f.Fill();
+        auto realization = f.Fill();
+
+        f.D2DDevice = Make<MockD2DDevice>();
+        Assert::IsNull(f.Fill().Get());
+        Assert::AreNotEqual(realization.Get(), f.Fill().Get());
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_NotUsedForFixedWidthStrokes)
+    {
+        Fixture f;
+
+        auto strokeStyle = Make<MockD2DStrokeStyle>();
+        strokeStyle->MockGetStrokeTransformType = [] { return D2D1_STROKE_TRANSFORM_TYPE_FIXED; };
+
+        f.Stroke(1, strokeStyle.Get());
+        Assert::IsNull(f.Stroke(1, strokeStyle.Get()).Get());
+        Assert::AreEqual<size_t>(0, f.Geometry->GetRealizationCacheEntryCount());
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_NotUsedForHugeScales)
+    {
+        Fixture f;
+
+        f.Transform = D2D1::Matrix3x2F::Scale(1000, 1000);
+        f.Fill();
+        Assert::IsNull(f.Fill().Get());
+        Assert::AreEqual<size_t>(0, f.Geometry->GetRealizationCacheEntryCount());
+    }
+
+    TEST_METHOD(CanvasGeometry_Realization_EvictsLeastRecentlyUsed)
+    {
+        Fixture f;
+
+        f.Stroke(0);
+        auto first = f.Stroke(0);
+
+        for (size_t i = 1; i < CanvasGeometryRealizationCache::MaxEntries; ++i)
+        {
+            f.Stroke(static_cast<float>(i));
+        }
+
+        Assert::AreEqual(CanvasGeometryRealizationCache::MaxEntries, f.Geometry->GetRealizationCacheEntryCount());
+        Assert::AreEqual(first.Get(), f.Stroke(0).Get());   // now the most recently used
+
+        f.Stroke(100);                                      // evicts the stroke with width 1
+        Assert::AreEqual(CanvasGeometryRealizationCache::MaxEntries, f.Geometry->GetRealizationCacheEntryCount());
+
+        Assert::AreEqual(first.Get(), f.Stroke(0).Get());
+        Assert::IsNull(f.Stroke(1).Get());
+    }
+
+    TEST_METHOD(CanvasGeometry_Close_ClearsTheRealizationCache)
+    {
+        Fixture f;
+
+        f.Fill();
+        f.Fill();
+        Assert::AreEqual<size_t>(1, f.Geometry->GetRealizationCacheEntryCount());
+
+        ThrowIfFailed(f.Geometry->Close());
+        Assert::AreEqual<size_t>(0, f.Geometry->GetRealizationCacheEntryCount());
+
+        Assert::ExpectException<ObjectDisposedException>([&] { f.Fill(); });
+    }
+};
@@ -307,6 +307,33 @@ public:
         Assert::IsTrue(createCalled);
         Assert::IsTrue(drawingSession);
     }
+
+    TEST_METHOD(CanvasImageSource_ReopenDrawingSessionWithDpi_PassesEntireImage)
+    {
+        auto drawingSession = std::make_shared<CanvasDrawingSessionManager>()->Create(
+            Make<StubD2DDeviceContextWithGetFactory>().Get(),
+            std::make_shared<StubCanvasDrawingSessionAdapter>());
+
+        const float expectedDpi = 144;
+
+        bool reopenCalled = false;
+        m_canvasImageSourceDrawingSessionFactory->MockReopen =
+            [&](ICanvasDrawingSessionInternal* actualDrawingSession, ISurfaceImageSourceNativeWithD2D* sisNative, const Rect& updateRect, float dpi)
+            {
+                Assert::IsFalse(reopenCalled);
+                Assert::IsTrue(actualDrawingSession == static_cast<ICanvasDrawingSessionInternal*>(drawingSession.Get()));
+                Assert::IsNotNull(sisNative);
+                Assert::AreEqual<float>(0, updateRect.X);
+                Assert::AreEqual<float>(0, updateRect.Y);
+                Assert::AreEqual<float>(static_cast<float>(m_imageWidth), updateRect.Width);
+                Assert::AreEqual<float>(static_cast<float>(m_imageHeight), updateRect.Height);
+                Assert::AreEqual(expectedDpi, dpi);
+                reopenCalled = true;
+            };
+
+        m_canvasImageSource->ReopenDrawingSessionWithDpi(expectedDpi, drawingSession.Get());
+        Assert::IsTrue(reopenCalled);
+    }
 };
 
 TEST_CLASS(CanvasImageSourceDrawingSessionAdapterTests)
@@ -0,0 +1,388 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+TEST_CLASS(CanvasTextDocumentUnitTests)
+{
+    class Fixture
+    {
+    public:
+        ComPtr<CanvasTextFormat> Format;
+        ComPtr<MockD2DDeviceContext> DeviceContext;
+        ComPtr<MockD2DSolidColorBrush> Brush;
+
+        std::vector<D2D1_POINT_2F> Origins;
+
+        Fixture()
+            : Format(Make<CanvasTextFormat>())
+            , DeviceContext(Make<MockD2DDeviceContext>())
+            , Brush(Make<MockD2DSolidColorBrush>())
+        {
+            DeviceContext->MockPushAxisAlignedClip = [](const D2D1_RECT_F*, D2D1_ANTIALIAS_MODE) {};
+            DeviceContext->MockPopAxisAlignedClip = [] {};
+
+            DeviceContext->MockDrawTextLayout =
+                [this](D2D1_POINT_2F origin, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS)
+                {
+                    Origins.push_back(origin);
+                };
+        }
+
+        ComPtr<CanvasTextDocument> Create(std::wstring const& text, float width = 200)
+        {
+            return Make<CanvasTextDocument>(
+                SharedDWriteFactory::GetOrCreate(),
+                WinString(text),
+                Format.Get(),
+                width);
+        }
+
+        void Draw(CanvasTextDocument* textDocument, float scrollOffset, float viewportHeight = 100)
+        {
+            Origins.clear();
+            textDocument->Draw(DeviceContext.Get(), D2D1::RectF(0, 0, 200, viewportHeight), scrollOffset, Brush.Get());
+        }
+    };
+
+    static std::wstring MakeLines(int lineCount)
+    {
+        std::wstring text;
+
+        for (int i = 0; i < lineCount; ++i)
+        {
+            text += L"line " + std::to_wstring(i) + L"\n";
+        }
+
+        return text;
+    }
+
+    static float GetParagraphTop(CanvasTextDocument* textDocument, int32_t index)
+    {
+        float top;
+        ThrowIfFailed(textDocument->GetParagraphTop(index, &top));
+        return top;
+    }
+
+    static float GetEstimatedHeight(CanvasTextDocument* textDocument)
+    {
+        float height;
+        ThrowIfFailed(textDocument->get_EstimatedHeight(&height));
+        return height;
+    }
+
+    static void AssertParagraph(uint32_t start, uint32_t length, uint32_t separatorLength, TextDocumentParagraph const& paragraph)
+    {
+        Assert::AreEqual(start, paragraph.Start);
+        Assert::AreEqual(length, paragraph.Length);
+        Assert::AreEqual(separatorLength, paragraph.SeparatorLength);
+    }
+
+    TEST_METHOD(ParagraphHeightIndex_TopsAndFindsMatchRunningTotals)
+    {
+        ParagraphHeightIndex index;
+
+        Assert::AreEqual<size_t>(0, index.Find(10));
+        Assert::AreEqual(0.0, index.GetTotal());
+
+        std::vector<double> heights;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            heights.push_back(1 + (i * 7) % 13);
+            index.Append(heights.back());
+        }
+
+        auto check = [&]
+        {
+            Assert::AreEqual(heights.size(), index.GetCount());
+
+            double top = 0;
+
+            for (size_t i = 0; i < heights.size(); ++i)
+            {
+                Assert::AreEqual(top, index.GetTop(i));
+                Assert::AreEqual(i, index.Find(top));
+                Assert::AreEqual(i, index.Find(top + heights[i] / 2));
+                top += heights[i];
+            }
+
+            Assert::AreEqual(top, index.GetTotal());
+        };
+
+        check();
+
+        index.Set(37, 100);
+        heights[37] = 100;
+        check();
+
+        index.RemoveLast();
+        heights.pop_back();
+        check();
+
+        index.Append(5);
+        heights.push_back(5);
+        check();
+
+        // Offsets outside the document find the first or last paragraph
+        Assert::AreEqual<size_t>(0, index.Find(-10));
+        Assert::AreEqual(heights.size() - 1, index.Find(index.GetTotal() + 10));
+    }
+
+    TEST_METHOD(CanvasTextDocument_SplitsTheTextIntoParagraphs)
+    {
+        Fixture f;
+        auto textDocument = f.Create(L"one\r\ntwo\rthree\n");
+
+        auto& paragraphs = textDocument->GetParagraphs();
+        Assert::AreEqual<size_t>(4, paragraphs.size());
+
+        AssertParagraph(0, 3, 2, paragraphs[0]);
+        AssertParagraph(5, 3, 1, paragraphs[1]);
+        AssertParagraph(9, 5, 1, paragraphs[2]);
+        AssertParagraph(15, 0, 0, paragraphs[3]);
+
+        int32_t paragraphCount;
+        ThrowIfFailed(textDocument->get_ParagraphCount(&paragraphCount));
+        Assert::AreEqual(4, paragraphCount);
+    }
+
+    TEST_METHOD(CanvasTextDocument_EstimatesHeightsWithoutLayingOutParagraphs)
+    {
+        Fixture f;
+        auto textDocument = f.Create(MakeLines(10000));
+
+        auto height = GetEstimatedHeight(textDocument.Get());
+        Assert::IsTrue(height > 10000);
+
+        // Short paragraphs are estimated to be one line each
+        auto lineHeight = GetParagraphTop(textDocument.Get(), 1);
+        Assert::IsTrue(lineHeight > 0);
+        Assert::AreEqual(lineHeight * 10000, GetParagraphTop(textDocument.Get(), 10000), 1.0f);
+
+        int32_t paragraphIndex;
+        ThrowIfFailed(textDocument->GetParagraphAtOffset(lineHeight * 5000.5f, &paragraphIndex));
+        Assert::AreEqual(5000, paragraphIndex);
+
+        Assert::AreEqual<uint64_t>(0, textDocument->GetParagraphLayoutCount());
+    }
+
+    TEST_METHOD(CanvasTextDocument_Draw_OnlyLaysOutVisibleParagraphs)
+    {
+        Fixture f;
+        auto textDocument = f.Create(MakeLines(10000));
+
+        f.Draw(textDocument.Get(), 0);
+
+        Assert::IsTrue(f.Origins.size() > 1);
+        Assert::IsTrue(f.Origins.size() < 20);
+        Assert::AreEqual<uint64_t>(f.Origins.size(), textDocument->GetParagraphLayoutCount());
+
+        Assert::AreEqual(0.0f, f.Origins.front().y);
+        Assert::IsTrue(f.Origins.back().y < 100);
+
+        // Scrolling to the middle lays out just the paragraphs there
+        auto layoutCount = textDocument->GetParagraphLayoutCount();
+        f.Draw(textDocument.Get(), GetParagraphTop(textDocument.Get(), 5000) + 1);
+
+        Assert::IsTrue(f.Origins.size() < 20);
+        Assert::IsTrue(textDocument->GetParagraphLayoutCount() - layoutCount < 20);
+
+        Assert::IsTrue(f.Origins.front().y <= 0);
+        Assert::IsTrue(f.Origins.back().y < 100);
+
+        for (size_t i = 1; i < f.Origins.size(); ++i)
+        {
+            Assert::IsTrue(f.Origins[i].y > f.Origins[i - 1].y);
+        }
+    }
+
+    TEST_METHOD(CanvasTextDocument_Draw_ReplacesEstimatedHeightsWithMeasuredOnes)
+    {
+        Fixture f;
+
+        // A long paragraph wraps onto more lines than a short one
+        auto textDocument = f.Create(L"short\n" + std::wstring(500, L'x') + L" " + std::wstring(500, L'y') + L"\nshort", 100);
+
+        f.Draw(textDocument.Get(), 0, 10000);
+
+        auto& paragraphs = textDocument->GetParagraphs();
+        Assert::AreEqual<size_t>(3, f.Origins.size());
+
+        for (size_t i = 0; i < paragraphs.size(); ++i)
+        {
+            Assert::IsTrue(paragraphs[i].HasMeasuredHeight);
+
+            DWRITE_TEXT_METRICS metrics;
+            ThrowIfFailed(paragraphs[i].Layout->GetMetrics(&metrics));
+
+            auto top = GetParagraphTop(textDocument.Get(), static_cast<int32_t>(i));
+            Assert::AreEqual(top, f.Origins[i].y, 0.01f);
+
+            if (i + 1 < paragraphs.size())
+                Assert::AreEqual(top + metrics.top + metrics.height, GetParagraphTop(textDocument.Get(), static_cast<int32_t>(i + 1)), 0.01f);
+            else
+                Assert::AreEqual(top + metrics.top + metrics.height, GetEstimatedHeight(textDocument.Get()), 0.01f);
+        }
+    }
+
+    TEST_METHOD(CanvasTextDocument_Draw_ReusesTheLayoutsOfRecentlyDrawnParagraphs)
+    {
+        Fixture f;
+        auto textDocument = f.Create(MakeLines(10000));
+
+        f.Draw(textDocument.Get(), 0);
+        f.Draw(textDocument.Get(), GetParagraphTop(textDocument.Get(), 5000));
+
+        auto layoutCount = textDocument->GetParagraphLayoutCount();
+
+        f.Draw(textDocument.Get(), 0);
+        Assert::AreEqual(layoutCount, textDocument->GetParagraphLayoutCount());
+    }
+
+    TEST_METHOD(CanvasTextDocument_Draw_KeepsALimitedNumberOfLayouts)
+    {
+        Fixture f;
+        auto textDocument = f.Create(MakeLines(2000));
+
+        size_t maxCachedLayoutCount = CanvasTextDocument::MaxCachedLayoutCount;
+
+        f.Draw(textDocument.Get(), 0, 1000000);
+
+        Assert::AreEqual<size_t>(2001, f.Origins.size());
+        Assert::AreEqual(maxCachedLayoutCount, textDocument->GetCachedLayoutCount());
+
+        // The most recently drawn layouts are the ones that are kept
+        auto& paragraphs = textDocument->GetParagraphs();
+        Assert::IsNull(paragraphs[0].Layout.Get());
+        Assert::IsNotNull(paragraphs[2000].Layout.Get());
+
+        // Evicted paragraphs keep their measured heights
+        Assert::IsTrue(paragraphs[0].HasMeasuredHeight);
+    }
+
+    TEST_METHOD(CanvasTextDocument_AppendText_ContinuesTheLastParagraph)
+    {
+        Fixture f;
+        auto textDocument = f.Create(L"one\ntw");
+
+        f.Draw(textDocument.Get(), 0);
+        Assert::AreEqual<size_t>(2, textDocument->GetCachedLayoutCount());
+
+        ThrowIfFailed(textDocument->AppendText(WinString(L"o\nthree")));
+
+        WinString text;
+        ThrowIfFailed(textDocument->get_Text(text.GetAddressOf()));
+        uint32_t length;
+        auto buffer = WindowsGetStringRawBuffer(text, &length);
+        Assert::AreEqual(std::wstring(L"one\ntwo\nthree"), std::wstring(buffer, length));
+
+        auto& paragraphs = textDocument->GetParagraphs();
+        Assert::AreEqual<size_t>(3, paragraphs.size());
+
+        AssertParagraph(0, 3, 1, paragraphs[0]);
+        AssertParagraph(4, 3, 1, paragraphs[1]);
+        AssertParagraph(8, 5, 0, paragraphs[2]);
+
+        // Only the paragraph that changed loses its layout
+        Assert::AreEqual<size_t>(1, textDocument->GetCachedLayoutCount());
+        Assert::IsNotNull(paragraphs[0].Layout.Get());
+        Assert::IsTrue(paragraphs[0].HasMeasuredHeight);
+        Assert::IsFalse(paragraphs[1].HasMeasuredHeight);
+    }
+
+    TEST_METHOD(CanvasTextDocument_AppendText_JoinsCarriageReturnAndLineFeed)
+    {
+        Fixture f;
+        auto textDocument = f.Create(L"one\r");
+
+        ThrowIfFailed(textDocument->AppendText(WinString(L"\ntwo")));
+
+        auto& paragraphs = textDocument->GetParagraphs();
+        Assert::AreEqual<size_t>(2, paragraphs.size());
+
+        AssertParagraph(0, 3, 2, paragraphs[0]);
+        AssertParagraph(5, 3, 0, paragraphs[1]);
+    }
+
+    TEST_METHOD(CanvasTextDocument_ChangingTheWidth_ReestimatesHeights)
+    {
+        Fixture f;
+        auto textDocument = f.Create(std::wstring(200, L'x') + L" " + std::wstring(200, L'y'), 0);
+
+        f.Draw(textDocument.Get(), 0);
+        auto unwrappedHeight = GetEstimatedHeight(textDocument.Get());
+
+        ThrowIfFailed(textDocument->put_Width(50));
+
+        float width;
+        ThrowIfFailed(textDocument->get_Width(&width));
+        Assert::AreEqual(50.0f, width);
+
+        Assert::IsFalse(textDocument->GetParagraphs()[0].HasMeasuredHeight);
+        Assert::IsTrue(GetEstimatedHeight(textDocument.Get()) > unwrappedHeight);
+
+        // The existing layout is rewrapped rather than recreated
+        auto layoutCount = textDocument->GetParagraphLayoutCount();
+        f.Draw(textDocument.Get(), 0);
+
+        Assert::AreEqual(layoutCount, textDocument->GetParagraphLayoutCount());
+        Assert::IsTrue(GetEstimatedHeight(textDocument.Get()) > unwrappedHeight);
+    }
+
+    TEST_METHOD(CanvasTextDocument_InvalidArguments)
+    {
+        Fixture f;
+        auto factory = Make<CanvasTextDocumentFactory>();
+
+        ComPtr<ICanvasTextDocument> created;
+        Assert::AreEqual(E_INVALIDARG, factory->Create(WinString(L"text"), nullptr, 0, &created));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(WinString(L"text"), f.Format.Get(), -1, &created));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(WinString(L"text"), f.Format.Get(), nanf(""), &created));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(WinString(L"text"), f.Format.Get(), 0, nullptr));
+
+        ThrowIfFailed(f.Format->put_FlowDirection(CanvasTextDirection::LeftToRight));
+        ThrowIfFailed(f.Format->put_ReadingDirection(CanvasTextDirection::TopToBottom));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(WinString(L"text"), f.Format.Get(), 0, &created));
+
+        auto textDocument = f.Create(L"one\ntwo");
+
+        float top;
+        Assert::AreEqual(E_INVALIDARG, textDocument->put_Width(-1));
+        Assert::AreEqual(E_INVALIDARG, textDocument->GetParagraphTop(-1, &top));
+        Assert::AreEqual(E_INVALIDARG, textDocument->GetParagraphTop(2, &top));
+        Assert::AreEqual(E_INVALIDARG, textDocument->GetParagraphTop(0, nullptr));
+    }
+
+    TEST_METHOD(CanvasTextDocument_Closed)
+    {
+        Fixture f;
+        auto textDocument = f.Create(L"text");
+
+        ThrowIfFailed(textDocument->Close());
+
+        WinString text;
+        float value;
+        int32_t i;
+
+        Assert::AreEqual(RO_E_CLOSED, textDocument->get_Text(text.GetAddressOf()));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->AppendText(WinString(L"more")));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->get_Width(&value));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->put_Width(10));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->get_ParagraphCount(&i));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->get_EstimatedHeight(&value));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->GetParagraphTop(0, &value));
+        Assert::AreEqual(RO_E_CLOSED, textDocument->GetParagraphAtOffset(0, &i));
+
+        Assert::ExpectException<ObjectDisposedException>([&] { f.Draw(textDocument.Get(), 0); });
+    }
+};
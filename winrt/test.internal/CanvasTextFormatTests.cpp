@@ -14,13 +14,24 @@
 
 namespace canvas
 {
+    static ComPtr<IDWriteTextFormat> GetWrappedResource(CanvasTextFormat* ctf)
+    {
+        ComPtr<IUnknown> resource;
+        ThrowIfFailed(ctf->GetResource(&resource));
+
+        ComPtr<IDWriteTextFormat> dwf;
+        ThrowIfFailed(resource.As(&dwf));
+        return dwf;
+    }
+
     //
     // Function that tests a simple property on CanvasTextFormat.
     //
     // It first checks that simple roundtripping works.
     //
-    // Then it forces the dwrite object to get realized and it verifies
-    // that the dwrite object has the correct value on it.
+    // Then it gets the dwrite object through GetResource, so that it is one
+    // that the test may modify, and it verifies that the dwrite object has
+    // the correct value on it.
     //
     // Then it sets the property on the dwrite object and verifies that this
     // is reflected on the CanvasTextFormat object.
@@ -50,7 +61,7 @@ namespace canvas
         //
         // Check the realized object
         //        
-        ComPtr<IDWriteTextFormat> dwf = ctf->GetRealizedTextFormat();
+        ComPtr<IDWriteTextFormat> dwf = GetWrappedResource(ctf.Get());
 
         auto actualDWriteValue = dwriteGetter(dwf.Get());
         Assert::AreEqual(realizedValue, actualDWriteValue);
@@ -76,34 +87,36 @@ namespace canvas
         // Check round-tripping on a realized format
         //
         ctf = Make<CanvasTextFormat>();
-        dwf = ctf->GetRealizedTextFormat();
+        dwf = GetWrappedResource(ctf.Get());
 
         canvasSetter(ctf.Get(), expectedValue);
         actualValue = canvasGetter(ctf.Get());
         Assert::AreEqual(expectedValue, actualValue);
 
         //
-        // Setting a property that has a dwriteSetter should not cause the
-        // property to be re-realized.
+        // Setting a property realizes a new format rather than modifying the
+        // one that drawing may already be using, even for properties that
+        // could be set on the dwrite object.
         //
         if (dwriteSetter)
         {
+            dwf = ctf->GetRealizedTextFormat();
             canvasSetter(ctf.Get(), expectedRealizedValue);
-            Assert::AreEqual(dwf.Get(), ctf->GetRealizedTextFormat().Get());
+
+            auto newDwf = ctf->GetRealizedTextFormat();
+            Assert::AreNotEqual(dwf.Get(), newDwf.Get());
+            Assert::AreEqual(realizedValue, dwriteGetter(dwf.Get()));
+            Assert::AreEqual(setRealizedValue, dwriteGetter(newDwf.Get()));
         }
 
         //
-        // Setting a property that doesn't have a dwriteSetter would normally
-        // cause the property to be re-realized -- unless we set it to exactly
-        // the same value that it had previously in which case we want to leave
-        // it alone.
+        // Setting a property would normally cause the format to be
+        // re-realized -- unless we set it to exactly the same value that it
+        // had previously in which case we want to leave it alone.
         //
-        if (!dwriteSetter)
-        {
-            dwf = ctf->GetRealizedTextFormat();
-            canvasSetter(ctf.Get(), canvasGetter(ctf.Get()));
-            Assert::AreEqual(dwf.Get(), ctf->GetRealizedTextFormat().Get());
-        }
+        dwf = ctf->GetRealizedTextFormat();
+        canvasSetter(ctf.Get(), canvasGetter(ctf.Get()));
+        Assert::AreEqual(dwf.Get(), ctf->GetRealizedTextFormat().Get());
 
         //
         // Closing should cause any attempt to get/set to fail
@@ -653,6 +666,362 @@ namespace canvas
                 Options,
                 static_cast<CanvasDrawTextOptions>(999));
         }
+
+        TEST_METHOD(CanvasTextFormat_SharesOneDWriteFactoryForItsLifetime)
+        {
+            auto ctf1 = Make<CanvasTextFormat>();
+            auto ctf2 = Make<CanvasTextFormat>();
+
+            ctf1->GetRealizedTextFormat();
+
+            // The realized format keeps the shared factory alive...
+            std::weak_ptr<SharedDWriteFactory> factory = SharedDWriteFactory::GetOrCreate();
+            Assert::IsFalse(factory.expired());
+
+            // ...and everything else uses the same one, including
+            // re-realizations after a property change.
+            ctf2->GetRealizedTextFormat();
+            ThrowIfFailed(ctf1->put_FontFamily(WinString(L"Arial")));
+            ctf1->GetRealizedTextFormat();
+
+            Assert::AreEqual<void*>(factory.lock().get(), SharedDWriteFactory::GetOrCreate().get());
+
+            ctf1.Reset();
+            ctf2.Reset();
+            Assert::IsTrue(factory.expired());
+        }
+
+        TEST_METHOD(CanvasTextFormat_FormatsWithTheSameProperties_ShareARealization)
+        {
+            auto ctf1 = Make<CanvasTextFormat>();
+            auto ctf2 = Make<CanvasTextFormat>();
+            auto ctf3 = Make<CanvasTextFormat>();
+
+            ThrowIfFailed(ctf1->put_FontSize(123));
+            ThrowIfFailed(ctf2->put_FontSize(123));
+            ThrowIfFailed(ctf3->put_FontSize(124));
+
+            auto realizationCount = CanvasTextFormat::GetRealizationCount();
+
+            auto dwf1 = ctf1->GetRealizedTextFormat();
+            auto dwf2 = ctf2->GetRealizedTextFormat();
+            auto dwf3 = ctf3->GetRealizedTextFormat();
+
+            Assert::AreEqual(dwf1.Get(), dwf2.Get());
+            Assert::AreEqual(ctf1->GetRealizationId(), ctf2->GetRealizationId());
+
+            Assert::AreNotEqual(dwf1.Get(), dwf3.Get());
+            Assert::AreNotEqual(ctf1->GetRealizationId(), ctf3->GetRealizationId());
+
+            Assert::AreEqual<uint64_t>(2, CanvasTextFormat::GetRealizationCount() - realizationCount);
+        }
+
+        TEST_METHOD(CanvasTextFormat_ChangingASharedFormat_DoesNotAffectTheOthers)
+        {
+            auto ctf1 = Make<CanvasTextFormat>();
+            auto ctf2 = Make<CanvasTextFormat>();
+
+            auto dwf = ctf1->GetRealizedTextFormat();
+            Assert::AreEqual(dwf.Get(), ctf2->GetRealizedTextFormat().Get());
+
+            // WordWrapping can normally be changed on the realized format
+            ThrowIfFailed(ctf1->put_WordWrapping(CanvasWordWrapping::Character));
+
+            Assert::AreNotEqual(dwf.Get(), ctf1->GetRealizedTextFormat().Get());
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_CHARACTER, ctf1->GetRealizedTextFormat()->GetWordWrapping());
+
+            Assert::AreEqual(dwf.Get(), ctf2->GetRealizedTextFormat().Get());
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_WRAP, dwf->GetWordWrapping());
+
+            // Changing it back shares the original format again
+            ThrowIfFailed(ctf1->put_WordWrapping(CanvasWordWrapping::Wrap));
+            Assert::AreEqual(dwf.Get(), ctf1->GetRealizedTextFormat().Get());
+        }
+
+        TEST_METHOD(CanvasTextFormat_GetResource_ReturnsAFormatThatIsNotShared)
+        {
+            auto ctf1 = Make<CanvasTextFormat>();
+            auto ctf2 = Make<CanvasTextFormat>();
+
+            auto sharedFormat = ctf2->GetRealizedTextFormat();
+            Assert::AreEqual(sharedFormat.Get(), ctf1->GetRealizedTextFormat().Get());
+
+            auto wrappedFormat = GetWrappedResource(ctf1.Get());
+            Assert::AreNotEqual(sharedFormat.Get(), wrappedFormat.Get());
+            Assert::AreEqual(wrappedFormat.Get(), ctf1->GetRealizedTextFormat().Get());
+            Assert::AreNotEqual(ctf1->GetRealizationId(), ctf2->GetRealizationId());
+
+            // Changes the app makes to its format don't leak into other formats
+            ThrowIfFailed(wrappedFormat->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+            CanvasWordWrapping wordWrapping;
+            ThrowIfFailed(ctf1->get_WordWrapping(&wordWrapping));
+            Assert::AreEqual(CanvasWordWrapping::NoWrap, wordWrapping);
+
+            ThrowIfFailed(ctf2->get_WordWrapping(&wordWrapping));
+            Assert::AreEqual(CanvasWordWrapping::Wrap, wordWrapping);
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_WRAP, sharedFormat->GetWordWrapping());
+        }
+
+        TEST_METHOD(CanvasTextFormat_SettingAProperty_DoesNotModifyAFormatThatHasBeenHandedOut)
+        {
+            auto ctf = Make<CanvasTextFormat>();
+
+            auto wrappedFormat = GetWrappedResource(ctf.Get());
+            auto snapshot = ctf->GetSnapshot();
+            Assert::AreEqual(wrappedFormat.Get(), snapshot->Format.Get());
+
+            ThrowIfFailed(ctf->put_WordWrapping(CanvasWordWrapping::NoWrap));
+
+            // Drawing threads may still be using the old snapshot
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_WRAP, wrappedFormat->GetWordWrapping());
+
+            auto newSnapshot = ctf->GetSnapshot();
+            Assert::AreNotEqual(wrappedFormat.Get(), newSnapshot->Format.Get());
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_NO_WRAP, newSnapshot->Format->GetWordWrapping());
+            Assert::AreNotEqual(snapshot->RealizationId, newSnapshot->RealizationId);
+        }
+
+        TEST_METHOD(CanvasTextFormat_SettingSeveralPropertiesOnARealizedFormat_RealizesOnce)
+        {
+            auto ctf = Make<CanvasTextFormat>();
+            ThrowIfFailed(ctf->put_Options(CanvasDrawTextOptions::Clip));
+
+            // A format that belongs to the app, so its properties have to be
+            // read back from it when it is discarded
+            auto dwf = GetWrappedResource(ctf.Get());
+            ThrowIfFailed(dwf->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+            auto realizationCount = CanvasTextFormat::GetRealizationCount();
+
+            ThrowIfFailed(ctf->put_FontFamily(WinString(L"Arial")));
+            ThrowIfFailed(ctf->put_FontSize(71));
+            ThrowIfFailed(ctf->put_FontWeight(ABI::Windows::UI::Text::FontWeight{ 700 }));
+            ThrowIfFailed(ctf->put_FontStyle(ABI::Windows::UI::Text::FontStyle_Italic));
+            ThrowIfFailed(ctf->put_FontStretch(ABI::Windows::UI::Text::FontStretch_Condensed));
+            ThrowIfFailed(ctf->put_LocaleName(WinString(L"en-GB")));
+            ThrowIfFailed(ctf->put_ParagraphAlignment(ABI::Windows::UI::Text::ParagraphAlignment_Center));
+
+            Assert::AreEqual<uint64_t>(0, CanvasTextFormat::GetRealizationCount() - realizationCount);
+
+            auto realized = ctf->GetRealizedTextFormat();
+
+            Assert::AreEqual<uint64_t>(1, CanvasTextFormat::GetRealizationCount() - realizationCount);
+
+            Assert::AreEqual(71.0f, realized->GetFontSize());
+            Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, realized->GetFontWeight());
+            Assert::AreEqual(DWRITE_FONT_STYLE_ITALIC, realized->GetFontStyle());
+            Assert::AreEqual(DWRITE_FONT_STRETCH_CONDENSED, realized->GetFontStretch());
+            Assert::AreEqual(DWRITE_TEXT_ALIGNMENT_CENTER, realized->GetTextAlignment());
+
+            // Values set directly on the discarded format are kept...
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_NO_WRAP, realized->GetWordWrapping());
+
+            // ...as are the options, which aren't part of the format
+            CanvasDrawTextOptions options;
+            ThrowIfFailed(ctf->get_Options(&options));
+            Assert::AreEqual(CanvasDrawTextOptions::Clip, options);
+        }
+
+        TEST_METHOD(CanvasTextFormat_Snapshot_IsNotAffectedByLaterChanges)
+        {
+            auto ctf = Make<CanvasTextFormat>();
+
+            auto snapshot = ctf->GetSnapshot();
+            Assert::IsTrue(snapshot == ctf->GetSnapshot());
+
+            ThrowIfFailed(ctf->put_WordWrapping(CanvasWordWrapping::Character));
+            ThrowIfFailed(ctf->put_Options(CanvasDrawTextOptions::Clip));
+
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_WRAP, snapshot->Format->GetWordWrapping());
+            Assert::AreEqual(CanvasDrawTextOptions::Default, snapshot->DrawTextOptions);
+
+            auto newSnapshot = ctf->GetSnapshot();
+            Assert::AreEqual(DWRITE_WORD_WRAPPING_CHARACTER, newSnapshot->Format->GetWordWrapping());
+            Assert::AreEqual(CanvasDrawTextOptions::Clip, newSnapshot->DrawTextOptions);
+            Assert::AreNotEqual(snapshot->RealizationId, newSnapshot->RealizationId);
+
+            // Changing only the options keeps the realized format
+            ThrowIfFailed(ctf->put_Options(CanvasDrawTextOptions::NoSnap));
+
+            Assert::AreEqual(newSnapshot->Format.Get(), ctf->GetSnapshot()->Format.Get());
+            Assert::AreEqual(newSnapshot->RealizationId, ctf->GetSnapshot()->RealizationId);
+            Assert::AreEqual(CanvasDrawTextOptions::NoSnap, ctf->GetSnapshot()->DrawTextOptions);
+        }
+
+        TEST_METHOD(CanvasTextFormat_Snapshots_AreConsistentWhileAnotherThreadChangesTheFormat)
+        {
+            auto ctf = Make<CanvasTextFormat>();
+
+            auto setter = std::async(std::launch::async,
+                [&]
+                {
+                    for (int i = 0; i < 1000; ++i)
+                        ThrowIfFailed(ctf->put_FontSize((i % 2) ? 10.0f : 20.0f));
+                });
+
+            //
+            // Layouts are cached by realization id, so a snapshot must never
+            // pair an id with a different format than it was first seen with.
+            // Holding on to the formats keeps them interned, so their ids get
+            // reused.
+            //
+            std::map<uint64_t, ComPtr<IDWriteTextFormat>> formatsById;
+
+            while (setter.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+            {
+                auto snapshot = ctf->GetSnapshot();
+
+                auto& format = formatsById[snapshot->RealizationId];
+                if (!format)
+                    format = snapshot->Format;
+
+                Assert::AreEqual(format.Get(), snapshot->Format.Get());
+
+                auto fontSize = snapshot->Format->GetFontSize();
+                Assert::IsTrue(fontSize == 10.0f || fontSize == 20.0f || fontSize == 32.0f);
+            }
+
+            setter.get();
+        }
+
+        TEST_METHOD(SharedDWriteFactory_GetOrCreateFontFace_CachesFaces)
+        {
+            auto factory = SharedDWriteFactory::GetOrCreate();
+            auto initialCount = factory->GetFontFaceCount();
+
+            auto face1 = factory->GetOrCreateFontFace(nullptr, L"Arial", DWRITE_FONT_WEIGHT_BOLD, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL);
+            auto face2 = factory->GetOrCreateFontFace(nullptr, L"Arial", DWRITE_FONT_WEIGHT_BOLD, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL);
+            auto face3 = factory->GetOrCreateFontFace(nullptr, L"Arial", DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL);
+
+            Assert::IsNotNull(face1.Get());
+            Assert::AreEqual(face1.Get(), face2.Get());
+            Assert::IsFalse(face1.Get() == face3.Get());
+
+            // The system collection can also be passed explicitly
+            ComPtr<IDWriteFontCollection> systemFontCollection;
+            ThrowIfFailed(factory->Get()->GetSystemFontCollection(&systemFontCollection));
+            auto face4 = factory->GetOrCreateFontFace(systemFontCollection.Get(), L"Arial", DWRITE_FONT_WEIGHT_BOLD, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL);
+            Assert::AreEqual(face1.Get(), face4.Get());
+
+            Assert::AreEqual(initialCount + 2, factory->GetFontFaceCount());
+        }
+
+        TEST_METHOD(SharedDWriteFactory_GetOrCreateFontFace_ReturnsNullForUnknownFamilies)
+        {
+            auto factory = SharedDWriteFactory::GetOrCreate();
+
+            auto face = factory->GetOrCreateFontFace(nullptr, L"No Such Font Family", DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL);
+            Assert::IsNull(face.Get());
+        }
+
+        TEST_METHOD(CanvasTextFormat_PreloadFontsAsync_LoadsTheFontsTheFormatsUse)
+        {
+            auto ctf1 = Make<CanvasTextFormat>();
+            auto ctf2 = Make<CanvasTextFormat>();
+            auto ctf3 = Make<CanvasTextFormat>();
+
+            ThrowIfFailed(ctf1->put_FontFamily(WinString(L"Courier New")));
+            ThrowIfFailed(ctf2->put_FontFamily(WinString(L"Courier New")));
+            ThrowIfFailed(ctf2->put_FontStyle(ABI::Windows::UI::Text::FontStyle_Italic));
+            ThrowIfFailed(ctf3->put_FontFamily(WinString(L"No Such Font Family")));
+
+            // Keeps the shared factory, and so its cache, alive for the test
+            ctf1->GetRealizedTextFormat();
+            auto factory = SharedDWriteFactory::GetOrCreate();
+            auto initialCount = factory->GetFontFaceCount();
+
+            ICanvasTextFormat* formats[] = { ctf1.Get(), ctf2.Get(), ctf3.Get() };
+
+            auto textFormatFactory = Make<CanvasTextFormatFactory>();
+
+            ComPtr<ABI::Windows::Foundation::IAsyncAction> action;
+            ThrowIfFailed(textFormatFactory->PreloadFontsAsync(_countof(formats), formats, &action));
+
+            ComPtr<ABI::Windows::Foundation::IAsyncInfo> asyncInfo;
+            ThrowIfFailed(action.As(&asyncInfo));
+
+            auto startTime = GetTickCount64();
+            auto status = ABI::Windows::Foundation::AsyncStatus::Started;
+
+            while (status == ABI::Windows::Foundation::AsyncStatus::Started)
+            {
+                Assert::IsTrue(GetTickCount64() < startTime + 5000);
+                ThrowIfFailed(asyncInfo->get_Status(&status));
+            }
+
+            Assert::AreEqual(ABI::Windows::Foundation::AsyncStatus::Completed, status);
+            ThrowIfFailed(action->GetResults());
+
+            //
+            // All three lookups are now cached, so asking for them again
+            // doesn't add any entries.
+            //
+            Assert::AreEqual(initialCount + 3, factory->GetFontFaceCount());
+
+            Assert::IsNotNull(factory->GetOrCreateFontFace(nullptr, L"Courier New", DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_ITALIC, DWRITE_FONT_STRETCH_NORMAL).Get());
+            Assert::IsNull(factory->GetOrCreateFontFace(nullptr, L"No Such Font Family", DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL).Get());
+
+            Assert::AreEqual(initialCount + 3, factory->GetFontFaceCount());
+        }
+
+        TEST_METHOD(CanvasTextFormat_PreloadFontsAsync_KeepsTheFontsLoadedAfterTheFormatsAreReleased)
+        {
+            std::weak_ptr<SharedDWriteFactory> factory;
+            size_t expectedCount;
+
+            auto textFormatFactory = Make<CanvasTextFormatFactory>();
+
+            {
+                // The format is found in the intern table if another test
+                // realized one just like it, in which case it doesn't hold a
+                // reference to the shared factory itself.
+                auto ctf = Make<CanvasTextFormat>();
+                ThrowIfFailed(ctf->put_FontFamily(WinString(L"Courier New")));
+
+                ICanvasTextFormat* formats[] = { ctf.Get() };
+
+                ComPtr<ABI::Windows::Foundation::IAsyncAction> action;
+                ThrowIfFailed(textFormatFactory->PreloadFontsAsync(_countof(formats), formats, &action));
+
+                ComPtr<ABI::Windows::Foundation::IAsyncInfo> asyncInfo;
+                ThrowIfFailed(action.As(&asyncInfo));
+
+                auto startTime = GetTickCount64();
+                auto status = ABI::Windows::Foundation::AsyncStatus::Started;
+
+                while (status == ABI::Windows::Foundation::AsyncStatus::Started)
+                {
+                    Assert::IsTrue(GetTickCount64() < startTime + 5000);
+                    ThrowIfFailed(asyncInfo->get_Status(&status));
+                }
+
+                Assert::AreEqual(ABI::Windows::Foundation::AsyncStatus::Completed, status);
+
+                factory = SharedDWriteFactory::GetOrCreate();
+                expectedCount = factory.lock()->GetFontFaceCount();
+            }
+
+            // The activation factory keeps the cache alive
+            Assert::IsFalse(factory.expired());
+            Assert::AreEqual(expectedCount, factory.lock()->GetFontFaceCount());
+            Assert::IsNotNull(factory.lock()->GetOrCreateFontFace(nullptr, L"Courier New", DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL).Get());
+            Assert::AreEqual(expectedCount, factory.lock()->GetFontFaceCount());
+        }
+
+        TEST_METHOD(CanvasTextFormat_PreloadFontsAsync_InvalidArguments)
+        {
+            auto textFormatFactory = Make<CanvasTextFormatFactory>();
+            auto ctf = Make<CanvasTextFormat>();
+
+            ICanvasTextFormat* formats[] = { ctf.Get(), nullptr };
+
+            ComPtr<ABI::Windows::Foundation::IAsyncAction> action;
+
+            Assert::AreEqual(E_INVALIDARG, textFormatFactory->PreloadFontsAsync(1, nullptr, &action));
+            Assert::AreEqual(E_INVALIDARG, textFormatFactory->PreloadFontsAsync(_countof(formats), formats, &action));
+            Assert::AreEqual(E_INVALIDARG, textFormatFactory->PreloadFontsAsync(1, formats, nullptr));
+        }
     };
 
 #undef TEST_SIMPLE_PROPERTY
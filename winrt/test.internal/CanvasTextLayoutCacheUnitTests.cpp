@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+TEST_CLASS(CanvasTextLayoutCacheUnitTests)
+{
+    class Fixture
+    {
+    public:
+        ComPtr<CanvasTextFormat> Format;
+        ComPtr<IDWriteTextFormat> DWriteFormat;
+        uint64_t RealizationId;
+
+        Fixture()
+        {
+            Format = Make<CanvasTextFormat>();
+            DWriteFormat = Format->GetRealizedTextFormat();
+            RealizationId = Format->GetRealizationId();
+        }
+
+        ComPtr<IDWriteTextLayout> Get(CanvasTextLayoutCache& cache, std::wstring const& text, float width = 100, bool noWrap = false)
+        {
+            return cache.GetOrCreate(
+                DWriteFormat.Get(),
+                RealizationId,
+                text.c_str(),
+                static_cast<uint32_t>(text.size()),
+                width,
+                100,
+                noWrap);
+        }
+    };
+
+    TEST_METHOD(CanvasTextLayoutCache_SameKey_ReturnsSameLayout)
+    {
+        Fixture f;
+        CanvasTextLayoutCache cache;
+
+        auto layout1 = f.Get(cache, L"hello");
+        auto layout2 = f.Get(cache, L"hello");
+
+        Assert::AreEqual(layout1.Get(), layout2.Get());
+        Assert::AreEqual<uint64_t>(1, cache.GetHitCount());
+        Assert::AreEqual<uint64_t>(1, cache.GetMissCount());
+        Assert::AreEqual<size_t>(1, cache.GetEntryCount());
+    }
+
+    TEST_METHOD(CanvasTextLayoutCache_DifferentKeys_ReturnDifferentLayouts)
+    {
+        Fixture f;
+        CanvasTextLayoutCache cache;
+
+        auto layout = f.Get(cache, L"hello");
+
+        Assert::AreNotEqual(layout.Get(), f.Get(cache, L"hellO").Get());
+        Assert::AreNotEqual(layout.Get(), f.Get(cache, L"hello", 50).Get());
+        Assert::AreNotEqual(layout.Get(), f.Get(cache, L"hello", 100, true).Get());
+
+        ThrowIfFailed(f.Format->put_WordWrapping(CanvasWordWrapping::Character));
+        f.RealizationId = f.Format->GetRealizationId();
+
+        Assert::AreNotEqual(layout.Get(), f.Get(cache, L"hello").Get());
+
+        Assert::AreEqual<uint64_t>(0, cache.GetHitCount());
+        Assert::AreEqual<uint64_t>(5, cache.GetMissCount());
+    }
+
+    TEST_METHOD(CanvasTextLayoutCache_NoWrap_DoesNotModifyFormat)
+    {
+        Fixture f;
+        CanvasTextLayoutCache cache;
+
+        auto layout = f.Get(cache, L"hello", 0, true);
+
+        Assert::AreEqual(DWRITE_WORD_WRAPPING_NO_WRAP, layout->GetWordWrapping());
+        Assert::AreEqual(DWRITE_WORD_WRAPPING_WRAP, f.DWriteFormat->GetWordWrapping());
+    }
+
+    TEST_METHOD(CanvasTextLayoutCache_EvictsLeastRecentlyUsed)
+    {
+        Fixture f;
+        CanvasTextLayoutCache cache;
+
+        auto a = f.Get(cache, L"a");
+        auto entrySize = cache.GetSizeInBytes();
+
+        // Room for exactly two single character entries
+        cache.SetMaxSizeInBytes(entrySize * 2);
+
+        auto b = f.Get(cache, L"b");
+        Assert::AreEqual(a.Get(), f.Get(cache, L"a").Get()); // 'a' is now the most recently used
+
+        f.Get(cache, L"c");                                   // evicts 'b'
+
+        Assert::AreEqual<size_t>(2, cache.GetEntryCount());
+        Assert::AreEqual(entrySize * 2, cache.GetSizeInBytes());
+
+        Assert::AreEqual(a.Get(), f.Get(cache, L"a").Get());
+        Assert::AreNotEqual(b.Get(), f.Get(cache, L"b").Get());
+    }
+
+    TEST_METHOD(CanvasTextLayoutCache_EntriesLargerThanTheCache_AreNotCached)
+    {
+        Fixture f;
+        CanvasTextLayoutCache cache(1);
+
+        auto layout = f.Get(cache, L"hello");
+
+        Assert::IsNotNull(layout.Get());
+        Assert::AreEqual<size_t>(0, cache.GetEntryCount());
+        Assert::AreEqual<size_t>(0, cache.GetSizeInBytes());
+    }
+
+    TEST_METHOD(CanvasTextLayoutCache_Clear)
+    {
+        Fixture f;
+        CanvasTextLayoutCache cache;
+
+        auto layout = f.Get(cache, L"hello");
+        cache.Clear();
+
+        Assert::AreEqual<size_t>(0, cache.GetEntryCount());
+        Assert::AreEqual<size_t>(0, cache.GetSizeInBytes());
+        Assert::AreNotEqual(layout.Get(), f.Get(cache, L"hello").Get());
+    }
+};
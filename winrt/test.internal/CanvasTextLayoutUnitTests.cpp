@@ -0,0 +1,519 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+TEST_CLASS(CanvasTextLayoutUnitTests)
+{
+    class Fixture
+    {
+    public:
+        ComPtr<CanvasTextFormat> Format;
+
+        Fixture()
+            : Format(Make<CanvasTextFormat>())
+        {
+        }
+
+        ComPtr<CanvasTextLayout> Create(std::wstring const& text, float width = 200, float height = 100)
+        {
+            return Make<CanvasTextLayout>(
+                SharedDWriteFactory::GetOrCreate(),
+                WinString(text),
+                Format.Get(),
+                width,
+                height);
+        }
+    };
+
+    static int32_t GetLineCount(CanvasTextLayout* textLayout)
+    {
+        int32_t lineCount;
+        ThrowIfFailed(textLayout->get_LineCount(&lineCount));
+        return lineCount;
+    }
+
+    static std::wstring GetText(CanvasTextLayout* textLayout)
+    {
+        WinString text;
+        ThrowIfFailed(textLayout->get_Text(text.GetAddressOf()));
+        uint32_t length;
+        auto buffer = WindowsGetStringRawBuffer(text, &length);
+        return std::wstring(buffer, length);
+    }
+
+    static void AssertParagraph(const TextLayoutParagraph& paragraph, uint32_t start, uint32_t length, uint32_t separatorLength)
+    {
+        Assert::AreEqual(start, paragraph.Start);
+        Assert::AreEqual(length, paragraph.Length);
+        Assert::AreEqual(separatorLength, paragraph.SeparatorLength);
+    }
+
+    static DWRITE_FONT_WEIGHT GetFontWeight(CanvasTextLayout* textLayout, uint32_t characterIndex)
+    {
+        // Makes sure every paragraph has been laid out
+        GetLineCount(textLayout);
+
+        for (auto& paragraph : textLayout->GetParagraphs())
+        {
+            if (characterIndex < paragraph.Start + paragraph.Length)
+            {
+                DWRITE_FONT_WEIGHT weight;
+                ThrowIfFailed(paragraph.Layout->GetFontWeight(characterIndex - paragraph.Start, &weight));
+                return weight;
+            }
+        }
+
+        Assert::Fail(L"characterIndex isn't inside a paragraph");
+        return DWRITE_FONT_WEIGHT_NORMAL;
+    }
+
+    TEST_METHOD(CanvasTextLayout_Implements_Expected_Interfaces)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"text");
+
+        ASSERT_IMPLEMENTS_INTERFACE(textLayout, ICanvasTextLayout);
+        ASSERT_IMPLEMENTS_INTERFACE(textLayout, ABI::Windows::Foundation::IClosable);
+        ASSERT_IMPLEMENTS_INTERFACE(textLayout, ICanvasTextLayoutInternal);
+    }
+
+    TEST_METHOD(CanvasTextLayout_SplitsTextIntoParagraphs)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"a\r\nbb\rccc\n\x2029" L"dd");
+
+        auto& paragraphs = textLayout->GetParagraphs();
+        Assert::AreEqual<size_t>(5, paragraphs.size());
+        AssertParagraph(paragraphs[0], 0, 1, 2);
+        AssertParagraph(paragraphs[1], 3, 2, 1);
+        AssertParagraph(paragraphs[2], 6, 3, 1);
+        AssertParagraph(paragraphs[3], 10, 0, 1);
+        AssertParagraph(paragraphs[4], 11, 2, 0);
+
+        // Text that ends with a separator has an empty last paragraph
+        textLayout = f.Create(L"a\n");
+        Assert::AreEqual<size_t>(2, textLayout->GetParagraphs().size());
+        AssertParagraph(textLayout->GetParagraphs()[1], 2, 0, 0);
+
+        textLayout = f.Create(L"");
+        Assert::AreEqual<size_t>(1, textLayout->GetParagraphs().size());
+        Assert::AreEqual(1, GetLineCount(textLayout.Get()));
+    }
+
+    TEST_METHOD(CanvasTextLayout_ReplaceText_OnlyLaysOutTheParagraphsItTouches)
+    {
+        Fixture f;
+
+        std::wstring text;
+        for (int i = 0; i < 100; ++i)
+            text += L"A line of a log file\n";
+
+        auto textLayout = f.Create(text);
+        GetLineCount(textLayout.Get());
+
+        Assert::AreEqual<uint64_t>(101, textLayout->GetParagraphLayoutCount());
+
+        std::vector<IDWriteTextLayout*> layoutsBefore;
+        for (auto& paragraph : textLayout->GetParagraphs())
+            layoutsBefore.push_back(paragraph.Layout.Get());
+
+        auto editIndex = static_cast<int32_t>(textLayout->GetParagraphs()[50].Start + 2);
+        ThrowIfFailed(textLayout->ReplaceText(editIndex, 4, WinString(L"typed")));
+        GetLineCount(textLayout.Get());
+
+        Assert::AreEqual<uint64_t>(102, textLayout->GetParagraphLayoutCount());
+
+        auto& paragraphs = textLayout->GetParagraphs();
+        Assert::AreEqual(layoutsBefore.size(), paragraphs.size());
+
+        for (size_t i = 0; i < paragraphs.size(); ++i)
+        {
+            if (i == 50)
+                Assert::AreNotEqual(layoutsBefore[i], paragraphs[i].Layout.Get());
+            else
+                Assert::AreEqual(layoutsBefore[i], paragraphs[i].Layout.Get());
+        }
+
+        AssertParagraph(paragraphs[50], paragraphs[49].Start + 21, 21, 1);
+        AssertParagraph(paragraphs[51], paragraphs[50].Start + 22, 20, 1);
+
+        text.replace(editIndex, 4, L"typed");
+        Assert::AreEqual(text, GetText(textLayout.Get()));
+    }
+
+    TEST_METHOD(CanvasTextLayout_ReplaceText_SplitsAndJoinsParagraphs)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"ab\rx\ncd");
+
+        Assert::AreEqual<size_t>(3, textLayout->GetParagraphs().size());
+
+        // Removing the x joins the CR and LF into a single separator
+        ThrowIfFailed(textLayout->ReplaceText(3, 1, nullptr));
+
+        Assert::AreEqual<std::wstring>(L"ab\r\ncd", GetText(textLayout.Get()));
+        Assert::AreEqual<size_t>(2, textLayout->GetParagraphs().size());
+        AssertParagraph(textLayout->GetParagraphs()[0], 0, 2, 2);
+        AssertParagraph(textLayout->GetParagraphs()[1], 4, 2, 0);
+
+        // Removing the separator joins the paragraphs
+        ThrowIfFailed(textLayout->ReplaceText(2, 2, nullptr));
+
+        Assert::AreEqual<size_t>(1, textLayout->GetParagraphs().size());
+        AssertParagraph(textLayout->GetParagraphs()[0], 0, 4, 0);
+
+        // Inserting separators splits it again
+        ThrowIfFailed(textLayout->ReplaceText(1, 0, WinString(L"\n\n")));
+
+        Assert::AreEqual<std::wstring>(L"a\n\nbcd", GetText(textLayout.Get()));
+        Assert::AreEqual<size_t>(3, textLayout->GetParagraphs().size());
+        AssertParagraph(textLayout->GetParagraphs()[0], 0, 1, 1);
+        AssertParagraph(textLayout->GetParagraphs()[1], 2, 0, 1);
+        AssertParagraph(textLayout->GetParagraphs()[2], 3, 3, 0);
+
+        Assert::AreEqual(3, GetLineCount(textLayout.Get()));
+    }
+
+    TEST_METHOD(CanvasTextLayout_ReplaceText_RejectsInvalidRanges)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"text");
+
+        Assert::AreEqual(E_INVALIDARG, textLayout->ReplaceText(-1, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, textLayout->ReplaceText(0, -1, nullptr));
+        Assert::AreEqual(E_INVALIDARG, textLayout->ReplaceText(5, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, textLayout->ReplaceText(2, 3, nullptr));
+        Assert::AreEqual(E_INVALIDARG, textLayout->SetFontSize(3, 2, 10));
+
+        Assert::AreEqual(S_OK, textLayout->ReplaceText(4, 0, nullptr));
+        Assert::AreEqual(S_OK, textLayout->ReplaceText(0, 4, nullptr));
+    }
+
+    TEST_METHOD(CanvasTextLayout_Formatting_MovesWithTheText)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"hello world\nsecond");
+
+        ThrowIfFailed(textLayout->SetFontWeight(6, 5, ABI::Windows::UI::Text::FontWeight{ DWRITE_FONT_WEIGHT_BOLD }));
+
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 5));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 6));
+
+        // Text inserted before the range moves it
+        ThrowIfFailed(textLayout->ReplaceText(0, 0, WinString(L"big ")));
+
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 9));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 10));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 14));
+
+        // Text inserted at either end of the range isn't formatted
+        ThrowIfFailed(textLayout->ReplaceText(15, 0, WinString(L"!")));
+        ThrowIfFailed(textLayout->ReplaceText(10, 0, WinString(L"_")));
+
+        Assert::AreEqual<std::wstring>(L"big hello _world!\nsecond", GetText(textLayout.Get()));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 10));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 11));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 16));
+
+        // Text inserted inside the range is
+        ThrowIfFailed(textLayout->ReplaceText(13, 0, WinString(L"-")));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 13));
+
+        // Paragraphs after the edit aren't affected
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 19));
+    }
+
+    TEST_METHOD(CanvasTextLayout_Formatting_IsAppliedToParagraphsLaidOutLater)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"one\ntwo\nthree");
+
+        // Spans three paragraphs, none of which have been laid out yet
+        ThrowIfFailed(textLayout->SetFontWeight(2, 8, ABI::Windows::UI::Text::FontWeight{ DWRITE_FONT_WEIGHT_BOLD }));
+
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 1));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 2));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 5));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 9));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_NORMAL, GetFontWeight(textLayout.Get(), 10));
+
+        // Later ranges take precedence over earlier ones
+        ThrowIfFailed(textLayout->SetFontWeight(4, 3, ABI::Windows::UI::Text::FontWeight{ DWRITE_FONT_WEIGHT_LIGHT }));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_LIGHT, GetFontWeight(textLayout.Get(), 5));
+
+        Assert::AreEqual(E_INVALIDARG, textLayout->SetFontWeight(0, 1, ABI::Windows::UI::Text::FontWeight{ 0 }));
+        Assert::AreEqual(E_INVALIDARG, textLayout->SetFontSize(0, 1, 0));
+        Assert::AreEqual(E_INVALIDARG, textLayout->SetFontFamily(0, 1, nullptr));
+    }
+
+    TEST_METHOD(CanvasTextLayout_Formatting_RangesAreMergedAndSplitPerProperty)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"hello world");
+
+        auto bold = ABI::Windows::UI::Text::FontWeight{ DWRITE_FONT_WEIGHT_BOLD };
+        auto light = ABI::Windows::UI::Text::FontWeight{ DWRITE_FONT_WEIGHT_LIGHT };
+
+        // Formatting one character at a time builds a single range
+        for (int32_t i = 0; i < 11; ++i)
+            ThrowIfFailed(textLayout->SetFontWeight(i, 1, bold));
+
+        Assert::AreEqual<size_t>(1, textLayout->GetFormattingRangeCount());
+
+        // Other properties have ranges of their own
+        ThrowIfFailed(textLayout->SetUnderline(2, 3, true));
+        Assert::AreEqual<size_t>(2, textLayout->GetFormattingRangeCount());
+
+        // A different value in the middle splits the range
+        ThrowIfFailed(textLayout->SetFontWeight(4, 3, light));
+        Assert::AreEqual<size_t>(4, textLayout->GetFormattingRangeCount());
+
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 3));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_LIGHT, GetFontWeight(textLayout.Get(), 4));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_LIGHT, GetFontWeight(textLayout.Get(), 6));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_BOLD, GetFontWeight(textLayout.Get(), 7));
+
+        // Setting the same property over the whole text replaces all of its
+        // ranges, without touching the underline
+        ThrowIfFailed(textLayout->SetFontWeight(0, 11, light));
+        Assert::AreEqual<size_t>(2, textLayout->GetFormattingRangeCount());
+
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_LIGHT, GetFontWeight(textLayout.Get(), 0));
+        Assert::AreEqual<int>(DWRITE_FONT_WEIGHT_LIGHT, GetFontWeight(textLayout.Get(), 10));
+
+        // Font families are compared by name
+        ThrowIfFailed(textLayout->SetFontFamily(0, 5, WinString(L"Arial")));
+        ThrowIfFailed(textLayout->SetFontFamily(5, 6, WinString(L"Arial")));
+        Assert::AreEqual<size_t>(3, textLayout->GetFormattingRangeCount());
+    }
+
+    TEST_METHOD(CanvasTextLayout_RequestedSize_KeepsTheParagraphLayouts)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"some words that wrap\nmore words that wrap", 1000, 100);
+
+        Assert::AreEqual(2, GetLineCount(textLayout.Get()));
+
+        auto firstLayout = textLayout->GetParagraphs()[0].Layout;
+
+        ThrowIfFailed(textLayout->put_RequestedSize(ABI::Windows::Foundation::Size{ 30, 100 }));
+
+        Assert::IsTrue(GetLineCount(textLayout.Get()) > 2);
+        Assert::AreEqual(firstLayout.Get(), textLayout->GetParagraphs()[0].Layout.Get());
+        Assert::AreEqual<uint64_t>(2, textLayout->GetParagraphLayoutCount());
+        Assert::AreEqual(30.0f, firstLayout->GetMaxWidth());
+
+        Assert::AreEqual(E_INVALIDARG, textLayout->put_RequestedSize(ABI::Windows::Foundation::Size{ -1, 100 }));
+    }
+
+    TEST_METHOD(CanvasTextLayout_ParagraphsAreStackedVertically)
+    {
+        Fixture f;
+        ThrowIfFailed(f.Format->put_VerticalAlignment(CanvasVerticalAlignment::Bottom));
+
+        auto textLayout = f.Create(L"one\ntwo\nthree", 200, 500);
+
+        ABI::Windows::Foundation::Rect bounds;
+        ThrowIfFailed(textLayout->get_LayoutBounds(&bounds));
+
+        auto& paragraphs = textLayout->GetParagraphs();
+        Assert::AreEqual(0.0f, paragraphs[0].Top);
+        Assert::AreEqual(paragraphs[0].Height, paragraphs[1].Top);
+        Assert::AreEqual(paragraphs[1].Top + paragraphs[1].Height, paragraphs[2].Top);
+
+        // Vertical alignment applies to the whole stack, not each paragraph
+        Assert::AreEqual(500.0f, bounds.Y + bounds.Height, 0.01f);
+        Assert::AreEqual(paragraphs[2].Top + paragraphs[2].Height, bounds.Height, 0.01f);
+    }
+
+    TEST_METHOD(CanvasTextLayout_LineMetrics_IncludeTheSeparators)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"a\r\nbc");
+
+        uint32_t lineCount;
+        CanvasLineMetrics* lineMetrics;
+        ThrowIfFailed(textLayout->get_LineMetrics(&lineCount, &lineMetrics));
+
+        Assert::AreEqual(2u, lineCount);
+        Assert::AreEqual(3, lineMetrics[0].CharacterCount);
+        Assert::AreEqual(2, lineMetrics[0].TerminalNewlineCount);
+        Assert::AreEqual(2, lineMetrics[1].CharacterCount);
+        Assert::AreEqual(0, lineMetrics[1].TerminalNewlineCount);
+        Assert::IsTrue(lineMetrics[0].Height > 0);
+
+        CoTaskMemFree(lineMetrics);
+    }
+
+    TEST_METHOD(CanvasTextLayout_HitTest_FindsCharactersInEachParagraph)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"first\nsecond\nthird");
+
+        Numerics::Vector2 caret;
+        ThrowIfFailed(textLayout->GetCaretPosition(6, false, &caret));
+
+        auto& second = textLayout->GetParagraphs()[1];
+        Assert::AreEqual(0.0f, caret.X);
+        Assert::AreEqual(second.Top, caret.Y);
+
+        int32_t characterIndex;
+        boolean isTrailingHit;
+        boolean isInside;
+        ThrowIfFailed(textLayout->HitTest(Numerics::Vector2{ caret.X + 1, caret.Y + 1 }, &characterIndex, &isTrailingHit, &isInside));
+
+        Assert::AreEqual(6, characterIndex);
+        Assert::IsFalse(!!isTrailingHit);
+        Assert::IsTrue(!!isInside);
+
+        // Below the text
+        ThrowIfFailed(textLayout->HitTest(Numerics::Vector2{ 1, 1000 }, &characterIndex, &isTrailingHit, &isInside));
+
+        Assert::IsTrue(characterIndex >= 13);
+        Assert::IsFalse(!!isInside);
+
+        // The end of the text is a valid caret position, but past it isn't
+        ThrowIfFailed(textLayout->GetCaretPosition(18, false, &caret));
+        Assert::AreEqual(E_INVALIDARG, textLayout->GetCaretPosition(19, false, &caret));
+    }
+
+    TEST_METHOD(CanvasTextLayout_Draw_DrawsEachParagraphAtItsTop)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"one\ntwo\nthree");
+        auto deviceContext = Make<MockD2DDeviceContext>();
+        auto brush = Make<MockD2DSolidColorBrush>();
+
+        std::vector<D2D1_POINT_2F> origins;
+        std::vector<IDWriteTextLayout*> layouts;
+
+        deviceContext->MockDrawTextLayout =
+            [&](D2D1_POINT_2F origin, IDWriteTextLayout* layout, ID2D1Brush* actualBrush, D2D1_DRAW_TEXT_OPTIONS)
+            {
+                Assert::AreEqual<ID2D1Brush*>(brush.Get(), actualBrush);
+                origins.push_back(origin);
+                layouts.push_back(layout);
+            };
+
+        textLayout->Draw(deviceContext.Get(), D2D1::Point2F(10, 20), brush.Get(), nullptr);
+
+        Assert::AreEqual<size_t>(3, origins.size());
+
+        for (size_t i = 0; i < origins.size(); ++i)
+        {
+            auto& paragraph = textLayout->GetParagraphs()[i];
+            Assert::AreEqual(D2D1::Point2F(10, 20 + paragraph.Top), origins[i]);
+            Assert::AreEqual(paragraph.Layout.Get(), layouts[i]);
+        }
+
+        // Culled paragraphs aren't drawn
+        origins.clear();
+        int culledCount = 0;
+
+        textLayout->Draw(deviceContext.Get(), D2D1::Point2F(10, 20), brush.Get(),
+            [&](const D2D1_RECT_F& inkBounds)
+            {
+                Assert::IsTrue(inkBounds.bottom > inkBounds.top);
+                return culledCount++ != 1;
+            });
+
+        Assert::AreEqual(3, culledCount);
+        Assert::AreEqual<size_t>(1, origins.size());
+        Assert::AreEqual(D2D1::Point2F(10, 20 + textLayout->GetParagraphs()[1].Top), origins[0]);
+    }
+
+    TEST_METHOD(CanvasTextLayout_Draw_ClipsTheWholeLayoutToTheRequestedSize)
+    {
+        Fixture f;
+        ThrowIfFailed(f.Format->put_Options(CanvasDrawTextOptions::Clip));
+
+        auto textLayout = f.Create(L"one\ntwo", 30, 40);
+        auto deviceContext = Make<MockD2DDeviceContext>();
+        auto brush = Make<MockD2DSolidColorBrush>();
+
+        int pushCount = 0;
+        int popCount = 0;
+        int drawCount = 0;
+
+        deviceContext->MockPushAxisAlignedClip =
+            [&](const D2D1_RECT_F* clipRect, D2D1_ANTIALIAS_MODE)
+            {
+                Assert::AreEqual(D2D1::RectF(1, 2, 31, 42), *clipRect);
+                ++pushCount;
+            };
+
+        deviceContext->MockPopAxisAlignedClip =
+            [&]
+            {
+                Assert::AreEqual(2, drawCount);
+                ++popCount;
+            };
+
+        deviceContext->MockDrawTextLayout =
+            [&](D2D1_POINT_2F, IDWriteTextLayout*, ID2D1Brush*, D2D1_DRAW_TEXT_OPTIONS options)
+            {
+                Assert::AreEqual(1, pushCount);
+                Assert::AreEqual(D2D1_DRAW_TEXT_OPTIONS_NONE, options);
+                ++drawCount;
+            };
+
+        textLayout->Draw(deviceContext.Get(), D2D1::Point2F(1, 2), brush.Get(), nullptr);
+
+        Assert::AreEqual(1, popCount);
+    }
+
+    TEST_METHOD(CanvasTextLayout_CapturesTheFormatWhenCreated)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"text");
+
+        ThrowIfFailed(f.Format->put_FontSize(100));
+
+        ABI::Windows::Foundation::Rect bounds;
+        ThrowIfFailed(textLayout->get_LayoutBounds(&bounds));
+
+        Assert::IsTrue(bounds.Height < 50);
+    }
+
+    TEST_METHOD(CanvasTextLayout_Closed)
+    {
+        Fixture f;
+        auto textLayout = f.Create(L"text");
+
+        ThrowIfFailed(textLayout->Close());
+
+        WinString text;
+        ABI::Windows::Foundation::Size size;
+        ABI::Windows::Foundation::Rect rect;
+        int32_t i;
+        uint32_t u;
+        CanvasLineMetrics* lineMetrics;
+        boolean b;
+        Numerics::Vector2 point;
+
+        Assert::AreEqual(RO_E_CLOSED, textLayout->get_Text(text.GetAddressOf()));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->ReplaceText(0, 0, nullptr));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->get_RequestedSize(&size));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->put_RequestedSize(size));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->SetFontSize(0, 0, 10));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->get_LayoutBounds(&rect));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->get_LineCount(&i));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->get_LineMetrics(&u, &lineMetrics));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->HitTest(point, &i, &b, &b));
+        Assert::AreEqual(RO_E_CLOSED, textLayout->GetCaretPosition(0, false, &point));
+
+        auto deviceContext = Make<MockD2DDeviceContext>();
+        auto brush = Make<MockD2DSolidColorBrush>();
+        Assert::ExpectException<ObjectDisposedException>([&] { textLayout->Draw(deviceContext.Get(), D2D1_POINT_2F{}, brush.Get(), nullptr); });
+    }
+};
@@ -0,0 +1,291 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+using namespace ABI::Windows::Foundation;
+
+TEST_CLASS(CanvasTextMeasurementUnitTests)
+{
+    static const int waitTimeout = 5000;
+
+    static ComPtr<ICanvasTextMeasurement> Measure(CanvasTextFormat* format, std::wstring const& text, float requestedWidth)
+    {
+        ComPtr<ICanvasTextMeasurement> measurement;
+        ThrowIfFailed(format->MeasureText(WinString(text), requestedWidth, &measurement));
+        return measurement;
+    }
+
+    static std::shared_ptr<const TextMeasurement> GetMeasurement(ICanvasTextMeasurement* measurement)
+    {
+        return static_cast<CanvasTextMeasurement*>(measurement)->GetMeasurement();
+    }
+
+    static std::vector<CanvasLineMetrics> GetLineMetrics(ICanvasTextMeasurement* measurement)
+    {
+        uint32_t count;
+        CanvasLineMetrics* elements;
+        ThrowIfFailed(measurement->get_LineMetrics(&count, &elements));
+
+        std::vector<CanvasLineMetrics> lineMetrics(elements, elements + count);
+        CoTaskMemFree(elements);
+
+        return lineMetrics;
+    }
+
+    static Rect GetLayoutBounds(ICanvasTextMeasurement* measurement)
+    {
+        Rect bounds;
+        ThrowIfFailed(measurement->get_LayoutBounds(&bounds));
+        return bounds;
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_MeasureText_ReturnsLineMetricsThatAddUpToTheLayoutBounds)
+    {
+        auto format = Make<CanvasTextFormat>();
+
+        std::wstring text = L"first line\nsecond line";
+        auto measurement = Measure(format.Get(), text, 0);
+
+        int32_t lineCount;
+        ThrowIfFailed(measurement->get_LineCount(&lineCount));
+        Assert::AreEqual(2, lineCount);
+
+        auto lineMetrics = GetLineMetrics(measurement.Get());
+        Assert::AreEqual<size_t>(2, lineMetrics.size());
+
+        Assert::AreEqual<int32_t>(11, lineMetrics[0].CharacterCount);
+        Assert::AreEqual<int32_t>(1, lineMetrics[0].TerminalNewlineCount);
+        Assert::AreEqual<int32_t>(11, lineMetrics[1].CharacterCount);
+        Assert::AreEqual<int32_t>(0, lineMetrics[1].TerminalNewlineCount);
+
+        auto bounds = GetLayoutBounds(measurement.Get());
+        Assert::AreEqual(0.0f, bounds.Y);
+        Assert::AreEqual(lineMetrics[0].Height + lineMetrics[1].Height, bounds.Height, 0.01f);
+        Assert::IsTrue(bounds.Width > 0);
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_MeasureText_WrapsToTheRequestedWidth)
+    {
+        auto format = Make<CanvasTextFormat>();
+
+        std::wstring text = L"the quick brown fox jumps over the lazy dog";
+
+        auto unwrapped = Measure(format.Get(), text, 0);
+        auto wrapped = Measure(format.Get(), text, 60);
+
+        int32_t unwrappedLineCount;
+        int32_t wrappedLineCount;
+        ThrowIfFailed(unwrapped->get_LineCount(&unwrappedLineCount));
+        ThrowIfFailed(wrapped->get_LineCount(&wrappedLineCount));
+
+        Assert::AreEqual(1, unwrappedLineCount);
+        Assert::IsTrue(wrappedLineCount > 1);
+        Assert::IsTrue(GetLayoutBounds(wrapped.Get()).Height > GetLayoutBounds(unwrapped.Get()).Height);
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_MeasureText_IgnoresVerticalAlignment)
+    {
+        auto format = Make<CanvasTextFormat>();
+        ThrowIfFailed(format->put_VerticalAlignment(CanvasVerticalAlignment::Bottom));
+
+        auto bounds = GetLayoutBounds(Measure(format.Get(), L"bottom aligned", 200).Get());
+
+        Assert::AreEqual(0.0f, bounds.Y);
+        Assert::IsTrue(bounds.Height > 0);
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_Overhang_IsRelativeToTheLayoutBounds)
+    {
+        auto format = Make<CanvasTextFormat>();
+        ThrowIfFailed(format->put_FontSize(40));
+
+        auto measurement = Measure(format.Get(), L"x", 200);
+
+        CanvasTextOverhang overhang;
+        ThrowIfFailed(measurement->get_Overhang(&overhang));
+
+        //
+        // A lower case x has no ascender or descender, so its ink is well
+        // inside the line vertically, and roughly fills the line's width.
+        //
+        Assert::IsTrue(overhang.Top < 0);
+        Assert::IsTrue(overhang.Bottom < 0);
+        Assert::IsTrue(fabs(overhang.Left) < 10);
+        Assert::IsTrue(fabs(overhang.Right) < 10);
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_FormatsWithTheSameProperties_ShareCachedMeasurements)
+    {
+        auto format1 = Make<CanvasTextFormat>();
+        auto format2 = Make<CanvasTextFormat>();
+
+        std::wstring text = L"CanvasTextMeasurement_FormatsWithTheSameProperties_ShareCachedMeasurements";
+
+        auto measurement1 = Measure(format1.Get(), text, 100);
+        auto measurement2 = Measure(format2.Get(), text, 100);
+
+        Assert::IsFalse(measurement1 == measurement2);
+        Assert::IsTrue(GetMeasurement(measurement1.Get()) == GetMeasurement(measurement2.Get()));
+
+        // A different width is a different measurement
+        auto measurement3 = Measure(format1.Get(), text, 101);
+        Assert::IsFalse(GetMeasurement(measurement1.Get()) == GetMeasurement(measurement3.Get()));
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_ChangingTheFormat_MeasuresAgain)
+    {
+        auto format = Make<CanvasTextFormat>();
+
+        std::wstring text = L"CanvasTextMeasurement_ChangingTheFormat_MeasuresAgain";
+
+        auto before = Measure(format.Get(), text, 0);
+
+        float fontSize;
+        ThrowIfFailed(format->get_FontSize(&fontSize));
+        ThrowIfFailed(format->put_FontSize(fontSize * 2));
+
+        auto after = Measure(format.Get(), text, 0);
+
+        Assert::IsFalse(GetMeasurement(before.Get()) == GetMeasurement(after.Get()));
+        Assert::IsTrue(GetLayoutBounds(after.Get()).Height > GetLayoutBounds(before.Get()).Height);
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_MeasureTextAsync_MatchesMeasureTextAsItWasWhenCalled)
+    {
+        auto format = Make<CanvasTextFormat>();
+
+        std::wstring text = L"CanvasTextMeasurement_MeasureTextAsync_MatchesMeasureTextAsItWasWhenCalled";
+
+        auto expected = Measure(format.Get(), text, 150);
+
+        ComPtr<IAsyncOperation<CanvasTextMeasurement*>> asyncOperation;
+        ThrowIfFailed(format->MeasureTextAsync(WinString(text), 150, &asyncOperation));
+
+        // Changes after the call shouldn't affect the measurement
+        ThrowIfFailed(format->put_FontSize(72));
+
+        ComPtr<IAsyncInfo> asyncInfo;
+        ThrowIfFailed(asyncOperation.As(&asyncInfo));
+
+        auto startTime = GetTickCount64();
+        AsyncStatus status = AsyncStatus::Started;
+
+        while (status == AsyncStatus::Started)
+        {
+            Assert::IsTrue(GetTickCount64() < startTime + waitTimeout);
+            ThrowIfFailed(asyncInfo->get_Status(&status));
+        }
+
+        Assert::AreEqual(AsyncStatus::Completed, status);
+
+        ComPtr<ICanvasTextMeasurement> actual;
+        ThrowIfFailed(asyncOperation->GetResults(&actual));
+
+        Assert::IsTrue(GetMeasurement(expected.Get()) == GetMeasurement(actual.Get()));
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_MeasureText_InvalidArguments)
+    {
+        auto format = Make<CanvasTextFormat>();
+
+        ComPtr<ICanvasTextMeasurement> measurement;
+        ComPtr<IAsyncOperation<CanvasTextMeasurement*>> asyncOperation;
+
+        Assert::AreEqual(E_INVALIDARG, format->MeasureText(WinString(L"text"), -1, &measurement));
+        Assert::AreEqual(E_INVALIDARG, format->MeasureText(WinString(L"text"), nanf(""), &measurement));
+        Assert::AreEqual(E_INVALIDARG, format->MeasureTextAsync(WinString(L"text"), -1, &asyncOperation));
+        Assert::AreEqual(E_INVALIDARG, format->MeasureText(WinString(L"text"), 0, nullptr));
+    }
+
+    TEST_METHOD(CanvasTextMeasurement_MeasureText_FailsWhenTheFormatIsClosed)
+    {
+        auto format = Make<CanvasTextFormat>();
+        ThrowIfFailed(format->Close());
+
+        ComPtr<ICanvasTextMeasurement> measurement;
+        ComPtr<IAsyncOperation<CanvasTextMeasurement*>> asyncOperation;
+
+        Assert::AreEqual(RO_E_CLOSED, format->MeasureText(WinString(L"text"), 0, &measurement));
+        Assert::AreEqual(RO_E_CLOSED, format->MeasureTextAsync(WinString(L"text"), 0, &asyncOperation));
+    }
+
+    TEST_METHOD(CanvasTextMeasurementCache_CountsHitsAndMisses)
+    {
+        auto format = Make<CanvasTextFormat>();
+        auto snapshot = format->GetSnapshot();
+
+        CanvasTextMeasurementCache cache;
+
+        auto get = [&](std::wstring const& text, float requestedWidth)
+        {
+            return cache.GetOrCreate(
+                snapshot->Format.Get(),
+                snapshot->RealizationId,
+                text.c_str(),
+                static_cast<uint32_t>(text.size()),
+                requestedWidth);
+        };
+
+        auto measurement1 = get(L"hello", 100);
+        auto measurement2 = get(L"hello", 100);
+        auto measurement3 = get(L"hello", 200);
+        auto measurement4 = get(L"world", 100);
+
+        Assert::IsTrue(measurement1 == measurement2);
+        Assert::IsFalse(measurement1 == measurement3);
+        Assert::IsFalse(measurement1 == measurement4);
+
+        Assert::AreEqual<uint64_t>(1, cache.GetHitCount());
+        Assert::AreEqual<uint64_t>(3, cache.GetMissCount());
+        Assert::AreEqual<size_t>(3, cache.GetEntryCount());
+
+        cache.Clear();
+        Assert::AreEqual<size_t>(0, cache.GetEntryCount());
+        Assert::AreEqual<size_t>(0, cache.GetSizeInBytes());
+    }
+
+    TEST_METHOD(CanvasTextMeasurementCache_EvictsTheLeastRecentlyUsedEntries)
+    {
+        auto format = Make<CanvasTextFormat>();
+        auto snapshot = format->GetSnapshot();
+
+        CanvasTextMeasurementCache cache(1024);
+
+        auto get = [&](std::wstring const& text)
+        {
+            return cache.GetOrCreate(
+                snapshot->Format.Get(),
+                snapshot->RealizationId,
+                text.c_str(),
+                static_cast<uint32_t>(text.size()),
+                0);
+        };
+
+        for (int i = 0; i < 100; ++i)
+        {
+            get(std::to_wstring(i));
+            Assert::IsTrue(cache.GetSizeInBytes() <= 1024);
+        }
+
+        Assert::IsTrue(cache.GetEntryCount() < 100);
+
+        // The most recently measured string is still there
+        auto missCount = cache.GetMissCount();
+        get(L"99");
+        Assert::AreEqual(missCount, cache.GetMissCount());
+
+        // ...but the first one isn't
+        get(L"0");
+        Assert::AreEqual(missCount + 1, cache.GetMissCount());
+    }
+};
@@ -147,12 +147,15 @@ namespace Microsoft
             TO_STRING(ID2D1Device1);
             TO_STRING(ID2D1DeviceContext1);
             TO_STRING(ID2D1Factory);
+            TO_STRING(IDWriteFontFace);
             TO_STRING(IDWriteTextFormat);
             TO_STRING(IDXGIDevice);
             TO_STRING(IDirect3DDevice);
             TO_STRING(IInspectable);
             TO_STRING(IUnknown);
             TO_STRING(ID2D1StrokeStyle1);
+            TO_STRING(ID2D1Geometry);
+            TO_STRING(ID2D1GeometryRealization);
 
 #undef TO_STRING
 
@@ -603,6 +606,54 @@ namespace Microsoft
                 END_ENUM(D2D1_INTERPOLATION_MODE);
             }
 
+            template<>
+            static inline std::wstring ToString<D2D1_SIZE_F>(const D2D1_SIZE_F& value)
+            {
+                wchar_t buf[256];
+                ThrowIfFailed(StringCchPrintf(
+                    buf,
+                    _countof(buf),
+                    L"D2D1_SIZE_F{%f,%f}",
+                    value.width,
+                    value.height));
+                return buf;
+            }
+
+            ENUM_TO_STRING(D2D1_FILL_MODE)
+            {
+                ENUM_VALUE(D2D1_FILL_MODE_ALTERNATE);
+                ENUM_VALUE(D2D1_FILL_MODE_WINDING);
+                END_ENUM(D2D1_FILL_MODE);
+            }
+
+            ENUM_TO_STRING(D2D1_FIGURE_BEGIN)
+            {
+                ENUM_VALUE(D2D1_FIGURE_BEGIN_FILLED);
+                ENUM_VALUE(D2D1_FIGURE_BEGIN_HOLLOW);
+                END_ENUM(D2D1_FIGURE_BEGIN);
+            }
+
+            ENUM_TO_STRING(D2D1_FIGURE_END)
+            {
+                ENUM_VALUE(D2D1_FIGURE_END_OPEN);
+                ENUM_VALUE(D2D1_FIGURE_END_CLOSED);
+                END_ENUM(D2D1_FIGURE_END);
+            }
+
+            ENUM_TO_STRING(D2D1_SWEEP_DIRECTION)
+            {
+                ENUM_VALUE(D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE);
+                ENUM_VALUE(D2D1_SWEEP_DIRECTION_CLOCKWISE);
+                END_ENUM(D2D1_SWEEP_DIRECTION);
+            }
+
+            ENUM_TO_STRING(D2D1_ARC_SIZE)
+            {
+                ENUM_VALUE(D2D1_ARC_SIZE_SMALL);
+                ENUM_VALUE(D2D1_ARC_SIZE_LARGE);
+                END_ENUM(D2D1_ARC_SIZE);
+            }
+
             template<typename T>
             static inline std::wstring ToStringAsInt(T value)
             {
@@ -639,6 +690,12 @@ namespace Microsoft
                 a.y == b.y;
         }
 
+        inline bool operator==(const D2D1_SIZE_F& a, const D2D1_SIZE_F& b)
+        {
+            return a.width == b.width &&
+                a.height == b.height;
+        }
+
         inline bool operator==(const D2D1_RECT_F& a, const D2D1_RECT_F& b)
         {
             return a.left == b.left &&
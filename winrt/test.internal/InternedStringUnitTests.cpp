@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+TEST_CLASS(InternedStringTests)
+{
+    TEST_METHOD(InternedString_EqualStrings_ShareAnEntry)
+    {
+        InternedString a(L"InternedString_EqualStrings_ShareAnEntry");
+        InternedString b(WinString(L"InternedString_EqualStrings_ShareAnEntry"));
+        InternedString c(L"InternedString_EqualStrings_ShareAnEntry_", 40);
+        InternedString d(L"something else");
+
+        Assert::IsTrue(a == b);
+        Assert::IsTrue(a == c);
+        Assert::IsTrue(a != d);
+
+        // Sharing an entry means sharing the characters too
+        Assert::IsTrue(a.GetBuffer() == b.GetBuffer());
+        Assert::AreEqual(a.GetHash(), c.GetHash());
+
+        Assert::AreEqual(L"InternedString_EqualStrings_ShareAnEntry", a.GetBuffer());
+        Assert::AreEqual(40U, a.GetLength());
+    }
+
+    TEST_METHOD(InternedString_EmptyStrings)
+    {
+        InternedString a;
+        InternedString b(L"");
+        InternedString c(static_cast<HSTRING>(nullptr));
+
+        Assert::IsTrue(a == b);
+        Assert::IsTrue(a == c);
+        Assert::AreEqual(L"", a.GetBuffer());
+        Assert::AreEqual(0U, a.GetLength());
+
+        WinString value;
+        a.CopyTo(value.GetAddressOf());
+        Assert::IsTrue(static_cast<HSTRING>(value) == nullptr);
+    }
+
+    TEST_METHOD(InternedString_CopyTo_SharesTheHString)
+    {
+        InternedString a(L"InternedString_CopyTo_SharesTheHString");
+
+        WinString value1;
+        WinString value2;
+        a.CopyTo(value1.GetAddressOf());
+        a.CopyTo(value2.GetAddressOf());
+
+        Assert::IsTrue(static_cast<HSTRING>(value1) == static_cast<HSTRING>(value2));
+        Assert::IsTrue(a.Equals(value1));
+    }
+
+    TEST_METHOD(InternedString_Equals_ComparesContents)
+    {
+        InternedString a(L"abc");
+
+        Assert::IsTrue(a.Equals(WinString(L"abc")));
+        Assert::IsFalse(a.Equals(WinString(L"abcd")));
+        Assert::IsFalse(a.Equals(WinString(L"ab")));
+        Assert::IsFalse(a.Equals(nullptr));
+
+        Assert::IsTrue(InternedString().Equals(nullptr));
+        Assert::IsTrue(InternedString().Equals(WinString(L"")));
+    }
+
+    TEST_METHOD(InternedString_FromAStringWithAnEmbeddedNull_StopsAtTheNull)
+    {
+        InternedString a(L"abc\0def");
+
+        Assert::IsTrue(a == InternedString(L"abc"));
+    }
+
+    TEST_METHOD(InternedString_EntriesAreRemovedWhenNoLongerUsed)
+    {
+        auto initialSize = InternedString::GetPoolSize();
+
+        {
+            InternedString a(L"InternedString_EntriesAreRemovedWhenNoLongerUsed");
+            auto b = a;
+
+            Assert::AreEqual(initialSize + 1, InternedString::GetPoolSize());
+
+            a = InternedString();
+            Assert::AreEqual(initialSize + 1, InternedString::GetPoolSize());
+        }
+
+        Assert::AreEqual(initialSize, InternedString::GetPoolSize());
+
+        // Interning the string again after its entry has gone works
+        InternedString c(L"InternedString_EntriesAreRemovedWhenNoLongerUsed");
+        Assert::AreEqual(initialSize + 1, InternedString::GetPoolSize());
+        Assert::AreEqual(L"InternedString_EntriesAreRemovedWhenNoLongerUsed", c.GetBuffer());
+    }
+
+    TEST_METHOD(InternedString_InterningFromManyThreads_GivesOneEntry)
+    {
+        std::vector<InternedString> results(8);
+        std::vector<std::future<void>> threads;
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            threads.push_back(std::async(std::launch::async,
+                [&results, i]
+                {
+                    for (int j = 0; j < 1000; ++j)
+                    {
+                        // Dropping the string each time keeps removing and
+                        // re-adding the entry while the other threads race.
+                        results[i] = InternedString();
+                        results[i] = InternedString(L"InternedString_InterningFromManyThreads_GivesOneEntry");
+                    }
+                }));
+        }
+
+        for (auto& thread : threads)
+            thread.get();
+
+        for (auto const& result : results)
+            Assert::IsTrue(result == results[0]);
+    }
+
+    TEST_METHOD(CanvasTextFormat_FormatsWithTheSameFamily_ShareItsInternedString)
+    {
+        auto ctf1 = Make<CanvasTextFormat>();
+        auto ctf2 = Make<CanvasTextFormat>();
+
+        ThrowIfFailed(ctf1->put_FontFamily(WinString(L"CanvasTextFormat_FormatsWithTheSameFamily")));
+        ThrowIfFailed(ctf2->put_FontFamily(WinString(L"CanvasTextFormat_FormatsWithTheSameFamily")));
+
+        WinString family1;
+        WinString family2;
+        ThrowIfFailed(ctf1->get_FontFamily(family1.GetAddressOf()));
+        ThrowIfFailed(ctf2->get_FontFamily(family2.GetAddressOf()));
+
+        Assert::IsTrue(static_cast<HSTRING>(family1) == static_cast<HSTRING>(family2));
+    }
+};
@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#include "pch.h"
+
+#include <LruCache.h>
+
+namespace
+{
+    struct TestParameters
+    {
+        int Value;
+
+        bool operator==(const TestParameters& other) const
+        {
+            return Value == other.Value;
+        }
+
+        size_t GetHash() const
+        {
+            return std::hash<int>()(Value);
+        }
+    };
+
+    typedef TextKeyPolicy<TestParameters> TestKeyPolicy;
+    typedef LruCache<TestKeyPolicy, int> TestCache;
+
+    TestKeyPolicy::LookupKey MakeKey(const wchar_t* text, int value = 0)
+    {
+        TestKeyPolicy::LookupKey key;
+        key.Text = text;
+        key.TextLength = static_cast<uint32_t>(wcslen(text));
+        key.Parameters.Value = value;
+        return key;
+    }
+}
+
+TEST_CLASS(LruCacheTests)
+{
+    TEST_METHOD(LruCache_EntriesAreFoundByTextAndParameters)
+    {
+        TestCache cache(100);
+
+        cache.Add(MakeKey(L"a", 1), 10, 1);
+        cache.Add(MakeKey(L"a", 2), 20, 1);
+        cache.Add(MakeKey(L"b", 1), 30, 1);
+
+        int value;
+        Assert::IsTrue(cache.TryGet(MakeKey(L"a", 1), &value));
+        Assert::AreEqual(10, value);
+        Assert::IsTrue(cache.TryGet(MakeKey(L"a", 2), &value));
+        Assert::AreEqual(20, value);
+        Assert::IsTrue(cache.TryGet(MakeKey(L"b", 1), &value));
+        Assert::AreEqual(30, value);
+        Assert::IsFalse(cache.TryGet(MakeKey(L"b", 2), &value));
+
+        // The text is compared by content, not by address
+        wchar_t text[] = L"a";
+        Assert::IsTrue(cache.TryGet(MakeKey(text, 1), &value));
+
+        Assert::AreEqual<uint64_t>(4, cache.GetHitCount());
+        Assert::AreEqual<uint64_t>(1, cache.GetMissCount());
+    }
+
+    TEST_METHOD(LruCache_AddingAnExistingEntry_KeepsTheFirstValue)
+    {
+        TestCache cache(100);
+
+        cache.Add(MakeKey(L"a"), 1, 10);
+        cache.Add(MakeKey(L"a"), 2, 10);
+
+        int value;
+        Assert::IsTrue(cache.TryGet(MakeKey(L"a"), &value));
+        Assert::AreEqual(1, value);
+        Assert::AreEqual<size_t>(1, cache.GetEntryCount());
+        Assert::AreEqual<size_t>(10, cache.GetSizeInBytes());
+    }
+
+    TEST_METHOD(LruCache_EvictsTheLeastRecentlyUsedEntries)
+    {
+        TestCache cache(30);
+
+        cache.Add(MakeKey(L"a"), 1, 10);
+        cache.Add(MakeKey(L"b"), 2, 10);
+        cache.Add(MakeKey(L"c"), 3, 10);
+
+        // Using "a" makes "b" the least recently used
+        int value;
+        Assert::IsTrue(cache.TryGet(MakeKey(L"a"), &value));
+
+        cache.Add(MakeKey(L"d"), 4, 10);
+
+        Assert::AreEqual<size_t>(3, cache.GetEntryCount());
+        Assert::AreEqual<size_t>(30, cache.GetSizeInBytes());
+        Assert::IsFalse(cache.TryGet(MakeKey(L"b"), &value));
+        Assert::IsTrue(cache.TryGet(MakeKey(L"a"), &value));
+        Assert::IsTrue(cache.TryGet(MakeKey(L"c"), &value));
+        Assert::IsTrue(cache.TryGet(MakeKey(L"d"), &value));
+
+        cache.SetMaxSizeInBytes(10);
+
+        Assert::AreEqual<size_t>(1, cache.GetEntryCount());
+        Assert::IsTrue(cache.TryGet(MakeKey(L"d"), &value));
+    }
+
+    TEST_METHOD(LruCache_EntriesLargerThanTheCacheAreNotAdded)
+    {
+        TestCache cache(10);
+
+        cache.Add(MakeKey(L"a"), 1, 10);
+        cache.Add(MakeKey(L"b"), 2, 11);
+
+        int value;
+        Assert::IsTrue(cache.TryGet(MakeKey(L"a"), &value));
+        Assert::IsFalse(cache.TryGet(MakeKey(L"b"), &value));
+    }
+
+    TEST_METHOD(LruCache_Clear)
+    {
+        TestCache cache(100);
+
+        cache.Add(MakeKey(L"a"), 1, 10);
+        cache.Add(MakeKey(L"b"), 2, 10);
+        cache.Clear();
+
+        Assert::AreEqual<size_t>(0, cache.GetEntryCount());
+        Assert::AreEqual<size_t>(0, cache.GetSizeInBytes());
+        Assert::AreEqual<size_t>(100, cache.GetMaxSizeInBytes());
+    }
+
+    TEST_METHOD(HashString_DependsOnlyOnTheCharacters)
+    {
+        wchar_t text[] = L"hello world";
+
+        Assert::AreEqual(HashString(L"hello", 5), HashString(text, 5));
+        Assert::AreNotEqual(HashString(L"hello", 5), HashString(L"hellp", 5));
+        Assert::AreNotEqual(HashString(L"hello", 5), HashString(text, 6));
+    }
+};
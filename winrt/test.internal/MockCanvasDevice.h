@@ -27,6 +27,8 @@ namespace canvas
         std::function<ComPtr<ID2D1ImageBrush>(ID2D1Image* image)> MockCreateImageBrush;
         std::function<ComPtr<ID2D1BitmapBrush1>(ID2D1Bitmap1* bitmap)> MockCreateBitmapBrush;
         std::function<ComPtr<ID2D1Bitmap1>()> MockCreateBitmap;
+        std::function<ComPtr<ID2D1PathGeometry1>()> MockCreatePathGeometry;
+        std::function<ComPtr<ID2D1DeviceContext1>()> MockCreateDeviceContext;
         
         //
         // ICanvasDevice
@@ -123,6 +125,28 @@ namespace canvas
             Assert::Fail(L"Unexpected call to GetD2DImage");
             return nullptr;
         }
+
+        virtual ComPtr<ID2D1PathGeometry1> CreatePathGeometry() override
+        {
+            if (!MockCreatePathGeometry)
+            {
+                Assert::Fail(L"Unexpected call to CreatePathGeometry");
+                return nullptr;
+            }
+
+            return MockCreatePathGeometry();
+        }
+
+        virtual ComPtr<ID2D1DeviceContext1> CreateDeviceContext() override
+        {
+            if (!MockCreateDeviceContext)
+            {
+                Assert::Fail(L"Unexpected call to CreateDeviceContext");
+                return nullptr;
+            }
+
+            return MockCreateDeviceContext();
+        }
     };
 }
 
@@ -40,6 +40,9 @@ namespace canvas
         DONT_EXPECT(DrawImageAtCoords , ICanvasImage*, float, float);
         DONT_EXPECT(DrawImageAtOrigin , ICanvasImage*);
 
+        DONT_EXPECT(DrawSprites               , ICanvasBitmap*, uint32_t, Rect*, uint32_t, Rect*, uint32_t, float*);
+        DONT_EXPECT(DrawSpritesWithTransforms , ICanvasBitmap*, uint32_t, Numerics::Matrix3x2*, uint32_t, Rect*, uint32_t, float*);
+
         DONT_EXPECT(DrawLineWithBrush                                     , Vector2, Vector2, ICanvasBrush*);
         DONT_EXPECT(DrawLineAtCoordsWithBrush                             , float, float, float, float, ICanvasBrush*);
         DONT_EXPECT(DrawLineWithColor                                     , Vector2, Vector2, Color);
@@ -125,6 +128,33 @@ namespace canvas
         DONT_EXPECT(FillCircleWithColor         , Vector2, float, Color);
         DONT_EXPECT(FillCircleAtCoordsWithColor , float, float, float, Color);
 
+        DONT_EXPECT(DrawGeometryWithBrush                             , ICanvasGeometry*, ICanvasBrush*);
+        DONT_EXPECT(DrawGeometryWithColor                             , ICanvasGeometry*, Color);
+        DONT_EXPECT(DrawGeometryWithBrushAndStrokeWidth               , ICanvasGeometry*, ICanvasBrush*, float);
+        DONT_EXPECT(DrawGeometryWithColorAndStrokeWidth               , ICanvasGeometry*, Color, float);
+        DONT_EXPECT(DrawGeometryWithBrushAndStrokeWidthAndStrokeStyle , ICanvasGeometry*, ICanvasBrush*, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawGeometryWithColorAndStrokeWidthAndStrokeStyle , ICanvasGeometry*, Color, float, ICanvasStrokeStyle*);
+
+        DONT_EXPECT(FillGeometryWithBrush , ICanvasGeometry*, ICanvasBrush*);
+        DONT_EXPECT(FillGeometryWithColor , ICanvasGeometry*, Color);
+
+        DONT_EXPECT(DrawPolylineWithBrush                             , uint32_t, Vector2*, ICanvasBrush*);
+        DONT_EXPECT(DrawPolylineWithColor                             , uint32_t, Vector2*, Color);
+        DONT_EXPECT(DrawPolylineWithBrushAndStrokeWidth               , uint32_t, Vector2*, ICanvasBrush*, float);
+        DONT_EXPECT(DrawPolylineWithColorAndStrokeWidth               , uint32_t, Vector2*, Color, float);
+        DONT_EXPECT(DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle , uint32_t, Vector2*, ICanvasBrush*, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawPolylineWithColorAndStrokeWidthAndStrokeStyle , uint32_t, Vector2*, Color, float, ICanvasStrokeStyle*);
+
+        DONT_EXPECT(DrawPolygonWithBrush                             , uint32_t, Vector2*, ICanvasBrush*);
+        DONT_EXPECT(DrawPolygonWithColor                             , uint32_t, Vector2*, Color);
+        DONT_EXPECT(DrawPolygonWithBrushAndStrokeWidth               , uint32_t, Vector2*, ICanvasBrush*, float);
+        DONT_EXPECT(DrawPolygonWithColorAndStrokeWidth               , uint32_t, Vector2*, Color, float);
+        DONT_EXPECT(DrawPolygonWithBrushAndStrokeWidthAndStrokeStyle , uint32_t, Vector2*, ICanvasBrush*, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawPolygonWithColorAndStrokeWidthAndStrokeStyle , uint32_t, Vector2*, Color, float, ICanvasStrokeStyle*);
+
+        DONT_EXPECT(FillPolygonWithBrush , uint32_t, Vector2*, ICanvasBrush*);
+        DONT_EXPECT(FillPolygonWithColor , uint32_t, Vector2*, Color);
+
         DONT_EXPECT(DrawTextAtPointWithColor                , HSTRING, Vector2, Color);
         DONT_EXPECT(DrawTextAtPointCoordsWithColor          , HSTRING, float, float, Color);
         DONT_EXPECT(DrawTextAtPointWithBrushAndFormat       , HSTRING, Vector2, ICanvasBrush*, ICanvasTextFormat*);
@@ -135,6 +165,12 @@ namespace canvas
         DONT_EXPECT(DrawTextAtRectWithColorAndFormat        , HSTRING, Rect, Color, ICanvasTextFormat*);
         DONT_EXPECT(DrawTextAtPointCoordsWithColorAndFormat , HSTRING, float, float, Color, ICanvasTextFormat*);
         DONT_EXPECT(DrawTextAtRectCoordsWithColorAndFormat  , HSTRING, float, float, float, float, Color, ICanvasTextFormat*);
+        DONT_EXPECT(DrawTextLayoutWithBrush                 , ICanvasTextLayout*, Vector2, ICanvasBrush*);
+        DONT_EXPECT(DrawTextLayoutWithColor                 , ICanvasTextLayout*, Vector2, Color);
+        DONT_EXPECT(DrawTextBatch                           , uint32_t, HSTRING*, uint32_t, Vector2*, uint32_t, Color*, ICanvasTextFormat*);
+        DONT_EXPECT(DrawTextBatchFromBuffer                 , HSTRING, uint32_t, int32_t*, uint32_t, Vector2*, uint32_t, Color*, ICanvasTextFormat*);
+        DONT_EXPECT(DrawTextDocumentWithBrush               , ICanvasTextDocument*, Rect, float, ICanvasBrush*);
+        DONT_EXPECT(DrawTextDocumentWithColor               , ICanvasTextDocument*, Rect, float, Color);
 
         DONT_EXPECT(get_Antialiasing     , CanvasAntialiasing*);
         DONT_EXPECT(put_Antialiasing     , CanvasAntialiasing);
@@ -147,6 +183,28 @@ namespace canvas
         DONT_EXPECT(get_Units            , CanvasUnits*);
         DONT_EXPECT(put_Units            , CanvasUnits);
 
+        DONT_EXPECT(PushTransform , ABI::Microsoft::Graphics::Canvas::Numerics::Matrix3x2);
+        DONT_EXPECT(PopTransform  );
+        DONT_EXPECT(Translate     , float, float);
+        DONT_EXPECT(Scale         , float, float);
+        DONT_EXPECT(Rotate        , float);
+
+        DONT_EXPECT(PushClipRectangle                         , Rect);
+        DONT_EXPECT(PopClip                                   );
+        DONT_EXPECT(PushLayerWithOpacity                      , float);
+        DONT_EXPECT(PushLayerWithOpacityAndClipRectangle      , float, Rect);
+        DONT_EXPECT(PushLayerWithOpacityBrush                 , ICanvasBrush*);
+        DONT_EXPECT(PushLayerWithOpacityBrushAndClipRectangle , ICanvasBrush*, Rect);
+        DONT_EXPECT(PushLayerWithOpacityAndClipGeometry       , float, ICanvasGeometry*);
+        DONT_EXPECT(PopLayer                                  );
+
+        DONT_EXPECT(get_IsCullingEnabled , boolean*);
+        DONT_EXPECT(put_IsCullingEnabled , boolean);
+        DONT_EXPECT(get_IsBatchingEnabled , boolean*);
+        DONT_EXPECT(put_IsBatchingEnabled , boolean);
+        DONT_EXPECT(get_IsPixelAlignedAliasingEnabled , boolean*);
+        DONT_EXPECT(put_IsPixelAlignedAliasingEnabled , boolean);
+
 #undef DONT_EXPECT
     };
 }
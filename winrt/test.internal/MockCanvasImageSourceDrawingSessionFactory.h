@@ -18,6 +18,7 @@ namespace canvas
     {
     public:
         std::function<ComPtr<ICanvasDrawingSession>(ICanvasDevice*, ISurfaceImageSourceNativeWithD2D*, const Rect&, float dpi)> MockCreate;
+        std::function<void(ICanvasDrawingSessionInternal*, ISurfaceImageSourceNativeWithD2D*, const Rect&, float dpi)> MockReopen;
 
         virtual ComPtr<ICanvasDrawingSession> Create(
             ICanvasDevice* owner,
@@ -33,5 +34,20 @@ namespace canvas
 
             return MockCreate(owner, sisNative, updateRect, dpi);
         }
+
+        virtual void Reopen(
+            ICanvasDrawingSessionInternal* drawingSession,
+            ISurfaceImageSourceNativeWithD2D* sisNative,
+            const Rect& updateRect,
+            float dpi) const override
+        {
+            if (!MockReopen)
+            {
+                Assert::Fail(L"Unexpected call to Reopen");
+                ThrowHR(E_NOTIMPL);
+            }
+
+            MockReopen(drawingSession, sisNative, updateRect, dpi);
+        }
     };
 }
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+namespace canvas
+{
+    class MockD2DCommandList : public RuntimeClass<
+        RuntimeClassFlags<ClassicCom>,
+        ChainInterfaces<ID2D1CommandList, ID2D1Image, ID2D1Resource>>
+    {
+    public:
+        std::function<HRESULT()> MockClose;
+
+        //
+        // ID2D1CommandList
+        //
+
+        IFACEMETHODIMP Stream(ID2D1CommandSink*) override
+        {
+            Assert::Fail(L"Unexpected call to Stream");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP Close() override
+        {
+            if (!MockClose)
+            {
+                Assert::Fail(L"Unexpected call to Close");
+                return E_NOTIMPL;
+            }
+
+            return MockClose();
+        }
+
+        //
+        // ID2D1Resource
+        //
+
+        IFACEMETHODIMP_(void) GetFactory(ID2D1Factory**) const override
+        {
+            Assert::Fail(L"Unexpected call to GetFactory");
+        }
+    };
+}
@@ -36,6 +36,7 @@ namespace canvas
         std::function<D2D1_UNIT_MODE()> MockGetUnitMode;
         std::function<void(const D2D1_UNIT_MODE)> MockSetUnitMode;
         std::function<void(float dpiX, float dpiY)> MockSetDpi;
+        std::function<void(float* dpiX, float* dpiY)> MockGetDpi;
         std::function<void(D2D1_POINT_2F,D2D1_POINT_2F,ID2D1Brush*,float,ID2D1StrokeStyle*)> MockDrawLine;
         std::function<void(const D2D1_RECT_F*,ID2D1Brush*,float,ID2D1StrokeStyle*)> MockDrawRectangle;
         std::function<void(const D2D1_RECT_F*,ID2D1Brush*)> MockFillRectangle;
@@ -43,8 +44,25 @@ namespace canvas
         std::function<void(const D2D1_ROUNDED_RECT*,ID2D1Brush*)> MockFillRoundedRectangle;
         std::function<void(const D2D1_ELLIPSE*,ID2D1Brush*,float,ID2D1StrokeStyle*)> MockDrawEllipse;
         std::function<void(const D2D1_ELLIPSE*,ID2D1Brush*)> MockFillEllipse;
+        std::function<void(ID2D1Geometry*,ID2D1Brush*,float,ID2D1StrokeStyle*)> MockDrawGeometry;
+        std::function<void(ID2D1Geometry*,ID2D1Brush*,ID2D1Brush*)> MockFillGeometry;
+        std::function<HRESULT(ID2D1Geometry*,float,ID2D1GeometryRealization**)> MockCreateFilledGeometryRealization;
+        std::function<HRESULT(ID2D1Geometry*,float,float,ID2D1StrokeStyle*,ID2D1GeometryRealization**)> MockCreateStrokedGeometryRealization;
+        std::function<void(ID2D1GeometryRealization*,ID2D1Brush*)> MockDrawGeometryRealization;
         std::function<void(const wchar_t*,uint32_t,IDWriteTextFormat*,D2D1_RECT_F,ID2D1Brush*,D2D1_DRAW_TEXT_OPTIONS,DWRITE_MEASURING_MODE)> MockDrawText;
+        std::function<void(D2D1_POINT_2F,IDWriteTextLayout*,ID2D1Brush*,D2D1_DRAW_TEXT_OPTIONS)> MockDrawTextLayout;
         std::function<void(ID2D1Image*)> MockDrawImage;
+        std::function<void(ID2D1Bitmap*,const D2D1_RECT_F*,float,D2D1_INTERPOLATION_MODE,const D2D1_RECT_F*,const D2D1_MATRIX_4X4_F*)> MockDrawBitmap;
+        std::function<void(const D2D1_RECT_F*,D2D1_ANTIALIAS_MODE)> MockPushAxisAlignedClip;
+        std::function<void()> MockPopAxisAlignedClip;
+        std::function<void(const D2D1_LAYER_PARAMETERS1*,ID2D1Layer*)> MockPushLayer;
+        std::function<void()> MockPopLayer;
+        std::function<void(ID2D1Image**)> MockGetTarget;
+        std::function<void(ID2D1Image*)> MockSetTarget;
+        std::function<void()> MockBeginDraw;
+        std::function<HRESULT()> MockEndDraw;
+        std::function<HRESULT(ID2D1CommandList**)> MockCreateCommandList;
+        std::function<HRESULT(ID2D1Image*,D2D1_RECT_F*)> MockGetImageLocalBounds;
         std::function<void(ID2D1Device**)> MockGetDevice;
         std::function<HRESULT(ID2D1Effect **)> MockCreateEffect;
         std::function<HRESULT(const D2D1_COLOR_F* color, const D2D1_BRUSH_PROPERTIES* brushProperties, ID2D1SolidColorBrush** solidColorBrush)> MockCreateSolidColorBrush;
@@ -212,14 +230,26 @@ namespace canvas
             MockFillEllipse(ellipse, brush);
         }
 
-        IFACEMETHODIMP_(void) DrawGeometry(ID2D1Geometry *,ID2D1Brush *,FLOAT,ID2D1StrokeStyle *) override
+        IFACEMETHODIMP_(void) DrawGeometry(ID2D1Geometry *geometry,ID2D1Brush *brush,FLOAT strokeWidth,ID2D1StrokeStyle *strokeStyle) override
         {
-            Assert::Fail(L"Unexpected call to DrawGeometry");
+            if (!MockDrawGeometry)
+            {
+                Assert::Fail(L"Unexpected call to DrawGeometry");
+                return;
+            }
+
+            MockDrawGeometry(geometry, brush, strokeWidth, strokeStyle);
         }
 
-        IFACEMETHODIMP_(void) FillGeometry(ID2D1Geometry *,ID2D1Brush *,ID2D1Brush *) override
+        IFACEMETHODIMP_(void) FillGeometry(ID2D1Geometry *geometry,ID2D1Brush *brush,ID2D1Brush *opacityBrush) override
         {
-            Assert::Fail(L"Unexpected call to FillGeometry");
+            if (!MockFillGeometry)
+            {
+                Assert::Fail(L"Unexpected call to FillGeometry");
+                return;
+            }
+
+            MockFillGeometry(geometry, brush, opacityBrush);
         }
 
         IFACEMETHODIMP_(void) FillMesh(ID2D1Mesh *,ID2D1Brush *) override
@@ -248,9 +278,15 @@ namespace canvas
             MockDrawText(text, textLength, format, *rect, brush, options, measuringMode);
         }
 
-        IFACEMETHODIMP_(void) DrawTextLayout(D2D1_POINT_2F,IDWriteTextLayout *,ID2D1Brush *,D2D1_DRAW_TEXT_OPTIONS) override
+        IFACEMETHODIMP_(void) DrawTextLayout(D2D1_POINT_2F origin, IDWriteTextLayout* textLayout, ID2D1Brush* brush, D2D1_DRAW_TEXT_OPTIONS options) override
         {
-            Assert::Fail(L"Unexpected call to DrawTextLayout");
+            if (!MockDrawTextLayout)
+            {
+                Assert::Fail(L"Unexpected call to DrawTextLayout");
+                return;
+            }
+
+            MockDrawTextLayout(origin, textLayout, brush, options);
         }
 
         IFACEMETHODIMP_(void) DrawGlyphRun(D2D1_POINT_2F,const DWRITE_GLYPH_RUN *,ID2D1Brush *,DWRITE_MEASURING_MODE) override
@@ -363,7 +399,13 @@ namespace canvas
 
         IFACEMETHODIMP_(void) PopLayer() override
         {
-            Assert::Fail(L"Unexpected call to PopLayer");
+            if (!MockPopLayer)
+            {
+                Assert::Fail(L"Unexpected call to PopLayer");
+                return;
+            }
+
+            MockPopLayer();
         }
 
         IFACEMETHODIMP Flush(D2D1_TAG *,D2D1_TAG *) override
@@ -382,14 +424,26 @@ namespace canvas
             Assert::Fail(L"Unexpected call to RestoreDrawingState");
         }
 
-        IFACEMETHODIMP_(void) PushAxisAlignedClip(const D2D1_RECT_F *,D2D1_ANTIALIAS_MODE) override
+        IFACEMETHODIMP_(void) PushAxisAlignedClip(const D2D1_RECT_F* clipRect, D2D1_ANTIALIAS_MODE antialiasMode) override
         {
-            Assert::Fail(L"Unexpected call to PushAxisAlignedClip");
+            if (!MockPushAxisAlignedClip)
+            {
+                Assert::Fail(L"Unexpected call to PushAxisAlignedClip");
+                return;
+            }
+
+            MockPushAxisAlignedClip(clipRect, antialiasMode);
         }
 
         IFACEMETHODIMP_(void) PopAxisAlignedClip() override
         {
-            Assert::Fail(L"Unexpected call to PopAxisAlignedClip");
+            if (!MockPopAxisAlignedClip)
+            {
+                Assert::Fail(L"Unexpected call to PopAxisAlignedClip");
+                return;
+            }
+
+            MockPopAxisAlignedClip();
         }
 
         IFACEMETHODIMP_(void) Clear(const D2D1_COLOR_F* color) override
@@ -405,13 +459,24 @@ namespace canvas
 
         IFACEMETHODIMP_(void) BeginDraw() override
         {
-            Assert::Fail(L"Unexpected call to BeginDraw");
+            if (!MockBeginDraw)
+            {
+                Assert::Fail(L"Unexpected call to BeginDraw");
+                return;
+            }
+
+            MockBeginDraw();
         }
 
         IFACEMETHODIMP EndDraw(D2D1_TAG *,D2D1_TAG *) override
         {
-            Assert::Fail(L"Unexpected call to EndDraw");
-            return E_NOTIMPL;
+            if (!MockEndDraw)
+            {
+                Assert::Fail(L"Unexpected call to EndDraw");
+                return E_NOTIMPL;
+            }
+
+            return MockEndDraw();
         }
 
         IFACEMETHODIMP_(D2D1_PIXEL_FORMAT) GetPixelFormat() const override
@@ -431,9 +496,15 @@ namespace canvas
             MockSetDpi(dpiX, dpiY);
         }
 
-        IFACEMETHODIMP_(void) GetDpi(FLOAT *,FLOAT *) const override
+        IFACEMETHODIMP_(void) GetDpi(FLOAT *dpiX,FLOAT *dpiY) const override
         {
-            Assert::Fail(L"Unexpected call to GetDpi");
+            if (!MockGetDpi)
+            {
+                Assert::Fail(L"Unexpected call to GetDpi");
+                return;
+            }
+
+            MockGetDpi(dpiX, dpiY);
         }
 
         IFACEMETHODIMP_(D2D1_SIZE_F) GetSize() const override
@@ -527,10 +598,15 @@ namespace canvas
             return E_NOTIMPL;
         }
 
-        IFACEMETHODIMP CreateCommandList(ID2D1CommandList **) override
+        IFACEMETHODIMP CreateCommandList(ID2D1CommandList ** commandList) override
         {
-            Assert::Fail(L"Unexpected call to CreateCommandList");
-            return E_NOTIMPL;
+            if (!MockCreateCommandList)
+            {
+                Assert::Fail(L"Unexpected call to CreateCommandList");
+                return E_NOTIMPL;
+            }
+
+            return MockCreateCommandList(commandList);
         }
 
         IFACEMETHODIMP_(BOOL) IsDxgiFormatSupported(DXGI_FORMAT) const override
@@ -545,10 +621,15 @@ namespace canvas
             return FALSE;
         }
 
-        IFACEMETHODIMP GetImageLocalBounds(ID2D1Image *,D2D1_RECT_F *) const override
+        IFACEMETHODIMP GetImageLocalBounds(ID2D1Image* image, D2D1_RECT_F* bounds) const override
         {
-            Assert::Fail(L"Unexpected call to GetImageLocalBounds");
-            return E_NOTIMPL;
+            if (!MockGetImageLocalBounds)
+            {
+                Assert::Fail(L"Unexpected call to GetImageLocalBounds");
+                return E_NOTIMPL;
+            }
+
+            return MockGetImageLocalBounds(image, bounds);
         }
 
         IFACEMETHODIMP GetImageWorldBounds(ID2D1Image *,D2D1_RECT_F *) const override
@@ -574,14 +655,26 @@ namespace canvas
             MockGetDevice(device);
         }
 
-        IFACEMETHODIMP_(void) SetTarget(ID2D1Image *) override
+        IFACEMETHODIMP_(void) SetTarget(ID2D1Image * target) override
         {
-            Assert::Fail(L"Unexpected call to SetTarget");
+            if (!MockSetTarget)
+            {
+                Assert::Fail(L"Unexpected call to SetTarget");
+                return;
+            }
+
+            MockSetTarget(target);
         }
 
-        IFACEMETHODIMP_(void) GetTarget(ID2D1Image **) const override
+        IFACEMETHODIMP_(void) GetTarget(ID2D1Image** target) const override
         {
-            Assert::Fail(L"Unexpected call to GetTarget");
+            if (!MockGetTarget)
+            {
+                Assert::Fail(L"Unexpected call to GetTarget");
+                return;
+            }
+
+            MockGetTarget(target);
         }
 
         IFACEMETHODIMP_(void) SetRenderingControls(const D2D1_RENDERING_CONTROLS *) override
@@ -648,14 +741,26 @@ namespace canvas
             Assert::Fail(L"Unexpected call to DrawGdiMetafile");
         }
 
-        IFACEMETHODIMP_(void) DrawBitmap(ID2D1Bitmap *,const D2D1_RECT_F *,FLOAT,D2D1_INTERPOLATION_MODE,const D2D1_RECT_F *,const D2D1_MATRIX_4X4_F *) override
+        IFACEMETHODIMP_(void) DrawBitmap(ID2D1Bitmap* bitmap,const D2D1_RECT_F* destinationRectangle,FLOAT opacity,D2D1_INTERPOLATION_MODE interpolationMode,const D2D1_RECT_F* sourceRectangle,const D2D1_MATRIX_4X4_F* perspectiveTransform) override
         {
-            Assert::Fail(L"Unexpected call to DrawBitmap");
+            if (!MockDrawBitmap)
+            {
+                Assert::Fail(L"Unexpected call to DrawBitmap");
+                return;
+            }
+
+            MockDrawBitmap(bitmap, destinationRectangle, opacity, interpolationMode, sourceRectangle, perspectiveTransform);
         }
 
-        IFACEMETHODIMP_(void) PushLayer(const D2D1_LAYER_PARAMETERS1 *,ID2D1Layer *) override
+        IFACEMETHODIMP_(void) PushLayer(const D2D1_LAYER_PARAMETERS1* layerParameters, ID2D1Layer* layer) override
         {
-            Assert::Fail(L"Unexpected call to PushLayer");
+            if (!MockPushLayer)
+            {
+                Assert::Fail(L"Unexpected call to PushLayer");
+                return;
+            }
+
+            MockPushLayer(layerParameters, layer);
         }
 
         IFACEMETHODIMP InvalidateEffectInputRectangle(ID2D1Effect *,UINT32,const D2D1_RECT_F *) override
@@ -689,21 +794,37 @@ namespace canvas
 
         // ID2D1DeviceContext1
 
-        IFACEMETHODIMP CreateFilledGeometryRealization(ID2D1Geometry *,FLOAT,ID2D1GeometryRealization **) override
+        IFACEMETHODIMP CreateFilledGeometryRealization(ID2D1Geometry *geometry,FLOAT flatteningTolerance,ID2D1GeometryRealization **realization) override
         {
-            Assert::Fail(L"Unexpected call to CreateFilledGeometryRealization");
-            return E_NOTIMPL;
+            if (!MockCreateFilledGeometryRealization)
+            {
+                Assert::Fail(L"Unexpected call to CreateFilledGeometryRealization");
+                return E_NOTIMPL;
+            }
+
+            return MockCreateFilledGeometryRealization(geometry, flatteningTolerance, realization);
         }
 
-        IFACEMETHODIMP CreateStrokedGeometryRealization(ID2D1Geometry *,FLOAT,FLOAT,ID2D1StrokeStyle *,ID2D1GeometryRealization **) override
+        IFACEMETHODIMP CreateStrokedGeometryRealization(ID2D1Geometry *geometry,FLOAT flatteningTolerance,FLOAT strokeWidth,ID2D1StrokeStyle *strokeStyle,ID2D1GeometryRealization **realization) override
         {
-            Assert::Fail(L"Unexpected call to CreateStrokedGeometryRealization");
-            return E_NOTIMPL;
+            if (!MockCreateStrokedGeometryRealization)
+            {
+                Assert::Fail(L"Unexpected call to CreateStrokedGeometryRealization");
+                return E_NOTIMPL;
+            }
+
+            return MockCreateStrokedGeometryRealization(geometry, flatteningTolerance, strokeWidth, strokeStyle, realization);
         }
 
-        IFACEMETHODIMP_(void) DrawGeometryRealization(ID2D1GeometryRealization *,ID2D1Brush *) override
+        IFACEMETHODIMP_(void) DrawGeometryRealization(ID2D1GeometryRealization *realization,ID2D1Brush *brush) override
         {
-            Assert::Fail(L"Unexpected call to DrawGeometryRealization");
+            if (!MockDrawGeometryRealization)
+            {
+                Assert::Fail(L"Unexpected call to DrawGeometryRealization");
+                return;
+            }
+
+            MockDrawGeometryRealization(realization, brush);
         }
     };
 }
@@ -20,6 +20,7 @@ namespace canvas
     {
     public:
         std::function<void(IDXGIDevice *dxgiDevice, ID2D1Device1 **d2dDevice1)> MockCreateDevice;
+        std::function<HRESULT(ID2D1PathGeometry **pathGeometry)> MockCreatePathGeometry;
 
         STDMETHOD(ReloadSystemMetrics)(
             )
@@ -81,7 +82,10 @@ namespace canvas
             _Outptr_ ID2D1PathGeometry **pathGeometry
             )
         {
-            return E_NOTIMPL;
+            if (!MockCreatePathGeometry)
+                return E_NOTIMPL;
+
+            return MockCreatePathGeometry(pathGeometry);
         }
 
         STDMETHOD(CreateStrokeStyle)(
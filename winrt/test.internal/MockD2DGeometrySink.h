@@ -0,0 +1,154 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+namespace canvas
+{
+    class MockD2DGeometrySink : public RuntimeClass<
+        RuntimeClassFlags<ClassicCom>,
+        ChainInterfaces<ID2D1GeometrySink, ID2D1SimplifiedGeometrySink>>
+    {
+    public:
+        std::function<void(D2D1_FILL_MODE)> MockSetFillMode;
+        std::function<void(D2D1_POINT_2F, D2D1_FIGURE_BEGIN)> MockBeginFigure;
+        std::function<void(D2D1_FIGURE_END)> MockEndFigure;
+        std::function<HRESULT()> MockClose;
+        std::function<void(D2D1_POINT_2F)> MockAddLine;
+        std::function<void(const D2D1_POINT_2F*, UINT32)> MockAddLines;
+        std::function<void(const D2D1_BEZIER_SEGMENT*)> MockAddBezier;
+        std::function<void(const D2D1_QUADRATIC_BEZIER_SEGMENT*)> MockAddQuadraticBezier;
+        std::function<void(const D2D1_ARC_SEGMENT*)> MockAddArc;
+
+        //
+        // ID2D1SimplifiedGeometrySink
+        //
+
+        IFACEMETHODIMP_(void) SetFillMode(D2D1_FILL_MODE fillMode) override
+        {
+            if (!MockSetFillMode)
+            {
+                Assert::Fail(L"Unexpected call to SetFillMode");
+                return;
+            }
+
+            MockSetFillMode(fillMode);
+        }
+
+        IFACEMETHODIMP_(void) SetSegmentFlags(D2D1_PATH_SEGMENT) override
+        {
+            Assert::Fail(L"Unexpected call to SetSegmentFlags");
+        }
+
+        IFACEMETHODIMP_(void) BeginFigure(D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN figureBegin) override
+        {
+            if (!MockBeginFigure)
+            {
+                Assert::Fail(L"Unexpected call to BeginFigure");
+                return;
+            }
+
+            MockBeginFigure(startPoint, figureBegin);
+        }
+
+        IFACEMETHODIMP_(void) AddLines(const D2D1_POINT_2F* points, UINT32 pointsCount) override
+        {
+            if (!MockAddLines)
+            {
+                Assert::Fail(L"Unexpected call to AddLines");
+                return;
+            }
+
+            MockAddLines(points, pointsCount);
+        }
+
+        IFACEMETHODIMP_(void) AddBeziers(const D2D1_BEZIER_SEGMENT*, UINT32) override
+        {
+            Assert::Fail(L"Unexpected call to AddBeziers");
+        }
+
+        IFACEMETHODIMP_(void) EndFigure(D2D1_FIGURE_END figureEnd) override
+        {
+            if (!MockEndFigure)
+            {
+                Assert::Fail(L"Unexpected call to EndFigure");
+                return;
+            }
+
+            MockEndFigure(figureEnd);
+        }
+
+        IFACEMETHODIMP Close() override
+        {
+            if (!MockClose)
+            {
+                Assert::Fail(L"Unexpected call to Close");
+                return E_NOTIMPL;
+            }
+
+            return MockClose();
+        }
+
+        //
+        // ID2D1GeometrySink
+        //
+
+        IFACEMETHODIMP_(void) AddLine(D2D1_POINT_2F point) override
+        {
+            if (!MockAddLine)
+            {
+                Assert::Fail(L"Unexpected call to AddLine");
+                return;
+            }
+
+            MockAddLine(point);
+        }
+
+        IFACEMETHODIMP_(void) AddBezier(const D2D1_BEZIER_SEGMENT* bezier) override
+        {
+            if (!MockAddBezier)
+            {
+                Assert::Fail(L"Unexpected call to AddBezier");
+                return;
+            }
+
+            MockAddBezier(bezier);
+        }
+
+        IFACEMETHODIMP_(void) AddQuadraticBezier(const D2D1_QUADRATIC_BEZIER_SEGMENT* bezier) override
+        {
+            if (!MockAddQuadraticBezier)
+            {
+                Assert::Fail(L"Unexpected call to AddQuadraticBezier");
+                return;
+            }
+
+            MockAddQuadraticBezier(bezier);
+        }
+
+        IFACEMETHODIMP_(void) AddQuadraticBeziers(const D2D1_QUADRATIC_BEZIER_SEGMENT*, UINT32) override
+        {
+            Assert::Fail(L"Unexpected call to AddQuadraticBeziers");
+        }
+
+        IFACEMETHODIMP_(void) AddArc(const D2D1_ARC_SEGMENT* arc) override
+        {
+            if (!MockAddArc)
+            {
+                Assert::Fail(L"Unexpected call to AddArc");
+                return;
+            }
+
+            MockAddArc(arc);
+        }
+    };
+}
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+namespace canvas
+{
+    class MockD2DPathGeometry : public RuntimeClass<
+        RuntimeClassFlags<ClassicCom>,
+        ChainInterfaces<ID2D1PathGeometry1, ID2D1PathGeometry, ID2D1Geometry, ID2D1Resource>>
+    {
+    public:
+        std::function<void(const D2D1_MATRIX_3X2_F*, D2D1_RECT_F*)> MockGetBounds;
+        std::function<void(ID2D1GeometrySink**)> MockOpen;
+
+        //
+        // ID2D1Resource
+        //
+
+        IFACEMETHODIMP_(void) GetFactory(ID2D1Factory**) const override
+        {
+            Assert::Fail(L"Unexpected call to GetFactory");
+        }
+
+        //
+        // ID2D1Geometry
+        //
+
+        IFACEMETHODIMP GetBounds(const D2D1_MATRIX_3X2_F* worldTransform, D2D1_RECT_F* bounds) const override
+        {
+            if (!MockGetBounds)
+            {
+                Assert::Fail(L"Unexpected call to GetBounds");
+                return E_NOTIMPL;
+            }
+
+            MockGetBounds(worldTransform, bounds);
+            return S_OK;
+        }
+
+        IFACEMETHODIMP GetWidenedBounds(FLOAT, ID2D1StrokeStyle*, const D2D1_MATRIX_3X2_F*, FLOAT, D2D1_RECT_F*) const override
+        {
+            Assert::Fail(L"Unexpected call to GetWidenedBounds");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP StrokeContainsPoint(D2D1_POINT_2F, FLOAT, ID2D1StrokeStyle*, const D2D1_MATRIX_3X2_F*, FLOAT, BOOL*) const override
+        {
+            Assert::Fail(L"Unexpected call to StrokeContainsPoint");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP FillContainsPoint(D2D1_POINT_2F, const D2D1_MATRIX_3X2_F*, FLOAT, BOOL*) const override
+        {
+            Assert::Fail(L"Unexpected call to FillContainsPoint");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP CompareWithGeometry(ID2D1Geometry*, const D2D1_MATRIX_3X2_F*, FLOAT, D2D1_GEOMETRY_RELATION*) const override
+        {
+            Assert::Fail(L"Unexpected call to CompareWithGeometry");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP Simplify(D2D1_GEOMETRY_SIMPLIFICATION_OPTION, const D2D1_MATRIX_3X2_F*, FLOAT, ID2D1SimplifiedGeometrySink*) const override
+        {
+            Assert::Fail(L"Unexpected call to Simplify");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP Tessellate(const D2D1_MATRIX_3X2_F*, FLOAT, ID2D1TessellationSink*) const override
+        {
+            Assert::Fail(L"Unexpected call to Tessellate");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP CombineWithGeometry(ID2D1Geometry*, D2D1_COMBINE_MODE, const D2D1_MATRIX_3X2_F*, FLOAT, ID2D1SimplifiedGeometrySink*) const override
+        {
+            Assert::Fail(L"Unexpected call to CombineWithGeometry");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP Outline(const D2D1_MATRIX_3X2_F*, FLOAT, ID2D1SimplifiedGeometrySink*) const override
+        {
+            Assert::Fail(L"Unexpected call to Outline");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP ComputeArea(const D2D1_MATRIX_3X2_F*, FLOAT, FLOAT*) const override
+        {
+            Assert::Fail(L"Unexpected call to ComputeArea");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP ComputeLength(const D2D1_MATRIX_3X2_F*, FLOAT, FLOAT*) const override
+        {
+            Assert::Fail(L"Unexpected call to ComputeLength");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP ComputePointAtLength(FLOAT, const D2D1_MATRIX_3X2_F*, FLOAT, D2D1_POINT_2F*, D2D1_POINT_2F*) const override
+        {
+            Assert::Fail(L"Unexpected call to ComputePointAtLength");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP Widen(FLOAT, ID2D1StrokeStyle*, const D2D1_MATRIX_3X2_F*, FLOAT, ID2D1SimplifiedGeometrySink*) const override
+        {
+            Assert::Fail(L"Unexpected call to Widen");
+            return E_NOTIMPL;
+        }
+
+        //
+        // ID2D1PathGeometry
+        //
+
+        IFACEMETHODIMP Open(ID2D1GeometrySink** geometrySink) override
+        {
+            if (!MockOpen)
+            {
+                Assert::Fail(L"Unexpected call to Open");
+                return E_NOTIMPL;
+            }
+
+            MockOpen(geometrySink);
+            return S_OK;
+        }
+
+        IFACEMETHODIMP Stream(ID2D1GeometrySink*) const override
+        {
+            Assert::Fail(L"Unexpected call to Stream");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP GetSegmentCount(UINT32*) const override
+        {
+            Assert::Fail(L"Unexpected call to GetSegmentCount");
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHODIMP GetFigureCount(UINT32*) const override
+        {
+            Assert::Fail(L"Unexpected call to GetFigureCount");
+            return E_NOTIMPL;
+        }
+
+        //
+        // ID2D1PathGeometry1
+        //
+
+        IFACEMETHODIMP ComputePointAndSegmentAtLength(FLOAT, UINT32, const D2D1_MATRIX_3X2_F*, FLOAT, D2D1_POINT_DESCRIPTION*) const override
+        {
+            Assert::Fail(L"Unexpected call to ComputePointAndSegmentAtLength");
+            return E_NOTIMPL;
+        }
+    };
+}
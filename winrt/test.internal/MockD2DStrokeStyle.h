@@ -19,6 +19,7 @@ namespace canvas
         ChainInterfaces<ID2D1StrokeStyle1, ID2D1StrokeStyle, ID2D1Resource >>
     {
     public:
+        std::function<D2D1_STROKE_TRANSFORM_TYPE()> MockGetStrokeTransformType;
 
         //
         // ID2D1StrokeStyle
@@ -88,8 +89,13 @@ namespace canvas
 
         IFACEMETHODIMP_(D2D1_STROKE_TRANSFORM_TYPE) GetStrokeTransformType() CONST
         {
-            Assert::Fail(L"Unexpected call to GetStrokeTransformType");
-            return static_cast<D2D1_STROKE_TRANSFORM_TYPE>(0);
+            if (!MockGetStrokeTransformType)
+            {
+                Assert::Fail(L"Unexpected call to GetStrokeTransformType");
+                return static_cast<D2D1_STROKE_TRANSFORM_TYPE>(0);
+            }
+
+            return MockGetStrokeTransformType();
         }
 
         //
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may
+// not use these files except in compliance with the License. You may obtain
+// a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include "MockD2DBitmap.h"
+
+namespace canvas
+{
+    class StubCanvasBitmap : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ICanvasBitmap,
+        ICanvasBitmapInternal>
+    {
+        ComPtr<MockD2DBitmap> m_bitmap;
+
+    public:
+        StubCanvasBitmap(float width = 64, float height = 32)
+            : m_bitmap(Make<MockD2DBitmap>())
+        {
+            m_bitmap->MockGetSize =
+                [=](float* w, float* h)
+                {
+                    *w = width;
+                    *h = height;
+                };
+        }
+
+        //
+        // ICanvasBitmapInternal
+        //
+
+        virtual ComPtr<ID2D1Bitmap1> GetD2DBitmap() override
+        {
+            return m_bitmap;
+        }
+
+        IFACEMETHOD(get_SizeInPixels)(_Out_ ABI::Windows::Foundation::Size* size) override
+        {
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHOD(get_SizeInDips)(_Out_ ABI::Windows::Foundation::Size* size) override
+        {
+            return E_NOTIMPL;
+        }
+
+        IFACEMETHOD(get_Bounds)(_Out_ ABI::Windows::Foundation::Rect* bounds) override
+        {
+            return E_NOTIMPL;
+        }
+    };
+}
@@ -55,15 +55,22 @@
 #include <Microsoft.Graphics.Canvas.native.h>
 
 // winrt.lib
+#include <CanvasBitmap.h>
+#include <CanvasCommandList.h>
+#include <CanvasDisplayList.h>
 #include <CanvasDevice.h>
 #include <CanvasDrawingSession.h>
+#include <CanvasGeometry.h>
 #include <CanvasImageSource.h>
 #include <CanvasImageSourceDrawingSessionAdapter.h>
 #include <CanvasBrush.h>
 #include <CanvasStrokeStyle.h>
 #include <CanvasControl.h>
 #include <Conversion.h>
+#include <CanvasTextDocument.h>
 #include <CanvasTextFormat.h>
+#include <CanvasTextLayout.h>
+#include <CanvasTextMeasurement.h>
 #include <ResourceManager.h>
 #include <ResourceTracker.h>
 #include <ResourceWrapper.h>
@@ -83,9 +90,13 @@ using namespace ABI::Microsoft::Graphics::Canvas::Effects;
 #include "MockCanvasDrawingSession.h"
 #include "MockCanvasImageSourceDrawingSessionFactory.h"
 #include "MockCoreApplication.h"
+#include "MockD2DCommandList.h"
 #include "MockD2DDevice.h"
 #include "MockD2DDeviceContext.h"
 #include "MockD2DFactory.h"
+#include "MockD2DGeometryRealization.h"
+#include "MockD2DGeometrySink.h"
+#include "MockD2DPathGeometry.h"
 #include "MockD2DSolidColorBrush.h"
 #include "MockD2DStrokeStyle.h"
 #include "MockD2DBitmapBrush.h"
@@ -94,6 +105,7 @@ using namespace ABI::Microsoft::Graphics::Canvas::Effects;
 #include "MockWICFormatConverter.h"
 #include "MockSurfaceImageSource.h"
 #include "MockSurfaceImageSourceFactory.h"
+#include "StubCanvasBitmap.h"
 #include "StubCanvasBrush.h"
 #include "StubCanvasDevice.h"
 #include "StubCanvasDrawingSessionAdapter.h"